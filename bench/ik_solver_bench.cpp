@@ -0,0 +1,139 @@
+// Warm-started inverse kinematics per frame: generic IkSolver versus the
+// compile-time StaticIkSolver, on a synthetic full-body trial.
+//
+//   ik_solver_bench [frames] [repeats]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "motionmetrics/kinematics/ik_solver.hpp"
+#include "motionmetrics/kinematics/skeleton_definitions.hpp"
+#include "motionmetrics/kinematics/static_ik_solver.hpp"
+
+using mm::Vec3d;
+using mm::kinematics::FullBodySkeleton;
+using mm::kinematics::IkSolver;
+using mm::kinematics::SegmentPose;
+using mm::kinematics::StaticIkSolver;
+using mm::kinematics::StaticSkeleton;
+
+namespace {
+
+using Skeleton = StaticSkeleton<FullBodySkeleton>;
+constexpr int kDofs = Skeleton::kDofs;
+
+/// Adult proportions in metres, segment frames as in skeleton_definitions.
+Skeleton make_skeleton() {
+    const std::array<Vec3d, Skeleton::kSegments> offsets{{
+        {0.0, 0.0, 1.0},      // pelvis
+        {0.09, 0.0, -0.05},   // l_thigh
+        {0.0, 0.0, -0.42},    // l_shank
+        {0.0, 0.0, -0.41},    // l_foot
+        {-0.09, 0.0, -0.05},  // r_thigh
+        {0.0, 0.0, -0.42},    // r_shank
+        {0.0, 0.0, -0.41},    // r_foot
+        {0.0, 0.0, 0.1},      // trunk
+        {0.18, 0.0, 0.42},    // l_upper_arm
+        {0.0, 0.0, -0.29},    // l_forearm
+        {0.0, 0.0, -0.26},    // l_hand
+        {-0.18, 0.0, 0.42},   // r_upper_arm
+        {0.0, 0.0, -0.29},    // r_forearm
+        {0.0, 0.0, -0.26},    // r_hand
+    }};
+    Skeleton skeleton(offsets);
+    // Three non-collinear markers per segment, as in a typical cluster set.
+    for (int s = 0; s < Skeleton::kSegments; ++s) {
+        const std::string name = mm::kinematics::FullBodySkeleton::joints[s].segment;
+        skeleton.add_marker(name + "_a", s, {0.05, 0.0, -0.1});
+        skeleton.add_marker(name + "_b", s, {-0.05, 0.03, -0.15});
+        skeleton.add_marker(name + "_c", s, {0.0, 0.06, -0.05});
+    }
+    return skeleton;
+}
+
+/// Marker rows of a smooth movement through the joint ranges, with 1 mm
+/// measurement noise.
+std::vector<float> make_trial(const Skeleton& skeleton, int frames, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> phase(0.0, 6.283);
+    std::normal_distribution<double> noise(0.0, 0.001);
+    std::array<double, kDofs> offset;
+    for (double& p : offset) p = phase(rng);
+
+    const int markers = skeleton.num_markers();
+    std::vector<float> xyz(static_cast<std::size_t>(frames) * markers * 3);
+    std::array<SegmentPose, Skeleton::kSegments> poses;
+    std::array<double, kDofs> q;
+    for (int f = 0; f < frames; ++f) {
+        const double t = f / 240.0;
+        for (int d = 0; d < kDofs; ++d) {
+            const auto& dof = FullBodySkeleton::dofs[d];
+            const double lo = std::isfinite(dof.min) ? dof.min : -0.5;
+            const double hi = std::isfinite(dof.max) ? dof.max : 0.5;
+            q[d] = 0.5 * (lo + hi) + 0.35 * (hi - lo) * std::sin(2.0 * t + offset[d]);
+        }
+        skeleton.forward(q.data(), poses.data());
+        for (int m = 0; m < markers; ++m) {
+            const Vec3d p = skeleton.marker_position(poses.data(), m);
+            for (int axis = 0; axis < 3; ++axis)
+                xyz[(static_cast<std::size_t>(f) * markers + m) * 3 + axis] = static_cast<float>(p[axis] + noise(rng));
+        }
+    }
+    return xyz;
+}
+
+/// Solves every frame warm-started from the previous one (the first cold)
+/// and returns microseconds per frame; `angles` receives the poses.
+template <typename Solver>
+double solve_us(Solver& solver, const std::vector<float>& xyz, int markers, int frames, int repeats,
+                std::vector<double>& angles) {
+    angles.assign(static_cast<std::size_t>(frames) * kDofs, 0.0);
+    double best = 1e300;
+    for (int r = 0; r < repeats; ++r) {
+        std::array<double, kDofs> q{};
+        const auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; ++f) {
+            solver.solve(xyz.data() + static_cast<std::size_t>(f) * markers * 3, q.data(), f > 0);
+            std::copy(q.begin(), q.end(), angles.begin() + static_cast<std::size_t>(f) * kDofs);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::micro>(stop - start).count() / frames);
+    }
+    return best;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 2400;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    const Skeleton skeleton = make_skeleton();
+    const int markers = skeleton.num_markers();
+    const std::vector<float> xyz = make_trial(skeleton, frames, 42);
+
+    IkSolver generic(skeleton.to_model());
+    StaticIkSolver<FullBodySkeleton> specialised(skeleton);
+    std::vector<double> generic_angles;
+    std::vector<double> static_angles;
+    const double generic_us = solve_us(generic, xyz, markers, frames, repeats, generic_angles);
+    const double static_us = solve_us(specialised, xyz, markers, frames, repeats, static_angles);
+
+    double max_diff = 0.0;
+    for (std::size_t i = 0; i < generic_angles.size(); ++i)
+        max_diff = std::max(max_diff, std::abs(generic_angles[i] - static_angles[i]));
+
+    std::printf("full-body IK, %d dofs, %d markers, %d frames, best of %d\n", kDofs, markers, frames, repeats);
+    std::printf("%-10s %10s %8s\n", "solver", "us/frame", "speedup");
+    std::printf("%-10s %10.2f %8s\n", "generic", generic_us, "1.0x");
+    std::printf("%-10s %10.2f %7.2fx\n", "static", static_us, generic_us / static_us);
+    std::printf("max pose difference %.2e%s\n", max_diff, max_diff < 1e-6 ? "" : "  MISMATCH");
+    return 0;
+}
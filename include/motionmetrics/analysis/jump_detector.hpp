@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "motionmetrics/core/types.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+
+namespace mm::analysis {
+
+struct JumpDetectorParams {
+    double gravity = 9.81;
+    /// Downward centre-of-mass speed (m/s) that starts a countermovement.
+    double movement_velocity = 0.10;
+    /// Centre-of-mass speed (m/s) below which the athlete counts as still.
+    double still_velocity = 0.05;
+    /// Stillness (s) after a landing before the athlete is standing again
+    /// and the standing height is re-measured.
+    double settle_time = 0.5;
+    /// Height (m) the lowest foot marker must rise above its ground-contact
+    /// level to count as airborne.
+    double contact_threshold = 0.03;
+    /// Shorter flights are discarded (steps, marker noise), longer ones too.
+    double min_flight_time = 0.08;
+    double max_flight_time = 1.5;
+    /// A take-off this soon (s) after a landing is a rebound, and the time
+    /// on the ground is reported as its contact time.
+    double max_contact_time = 1.0;
+    /// Per-frame weight of the running standing-height and ground-level
+    /// averages.
+    double baseline_smoothing = 0.05;
+};
+
+/// One frame of input. Centre-of-mass data should already be low-pass
+/// filtered (causally when live); a NaN velocity is replaced by the
+/// difference of consecutive heights. `foot_height` is the height of the
+/// lowest foot marker, NaN when none is visible (the frame then only
+/// updates the centre of mass).
+struct JumpSample {
+    TimestampNs timestamp = 0;
+    double com_height = 0.0;
+    double com_velocity = 0.0;
+    double foot_height = 0.0;
+};
+
+/// Events and metrics of one jump. Event times are interpolated between
+/// frames at the threshold crossings.
+struct Jump {
+    /// Start of the countermovement; unset for a rebound or a jump without
+    /// a preceding standing phase.
+    std::optional<TimestampNs> movement_start;
+    TimestampNs takeoff = 0;
+    TimestampNs apex = 0;
+    TimestampNs landing = 0;
+
+    double flight_time = 0.0;       // s
+    /// g t^2 / 8 from the flight time.
+    double height_flight_time = 0.0;
+    /// Apex minus standing centre-of-mass height (NaN without a standing
+    /// reference).
+    double height_com = 0.0;
+    double takeoff_velocity = 0.0;  // m/s, vertical
+    /// Ground contact before a rebound take-off, NaN otherwise.
+    double contact_time = 0.0;
+    /// Countermovement start to take-off, NaN without one.
+    double movement_time = 0.0;
+    /// Standing height minus the lowest centre-of-mass height before
+    /// take-off, NaN without a countermovement.
+    double countermovement_depth = 0.0;
+};
+
+/// Streaming jump detector: one pass, constant memory, O(1) per frame.
+///
+/// A state machine over the centre-of-mass height and velocity and the
+/// lowest foot marker:
+///  standing    - still on the ground; the standing height and the foot
+///                marker's contact level are tracked;
+///  moving      - the centre of mass dropped faster than
+///                `movement_velocity` (countermovement start);
+///  airborne    - the foot marker rose `contact_threshold` above its contact
+///                level (take-off); the velocity's zero crossing is the apex;
+///  landed      - the foot marker is back down (landing); the jump is
+///                reported. A quick take-off from here is a rebound, and
+///                `settle_time` of stillness returns to standing.
+class JumpDetector {
+public:
+    explicit JumpDetector(JumpDetectorParams params = {});
+
+    /// Feeds one frame; frames must come in time order. Returns true when
+    /// the frame completed a jump, which `last_jump()` then holds.
+    bool push(const JumpSample& sample);
+
+    const Jump& last_jump() const { return last_jump_; }
+    std::uint64_t jumps() const { return jumps_; }
+    /// Flights rejected by the flight-time limits.
+    std::uint64_t rejected() const { return rejected_; }
+    void reset();
+
+private:
+    enum class State : std::uint8_t { unknown, standing, moving, airborne, landed };
+
+    /// Starts the flight at the frame where the foot marker crossed
+    /// `level` between `previous_` and `sample`.
+    void take_off(const JumpSample& sample, double level);
+    /// Closes the flight; returns false if its duration is out of range.
+    bool finish_jump(TimestampNs landing);
+
+    JumpDetectorParams params_;
+    State state_ = State::unknown;
+    bool has_previous_ = false;
+    JumpSample previous_{};
+    TimestampNs still_since_ = 0;
+    TimestampNs landed_at_ = 0;
+
+    double standing_height_ = 0.0;
+    bool standing_known_ = false;
+    double ground_level_ = 0.0;
+    bool ground_known_ = false;
+
+    Jump current_{};
+    double lowest_com_ = 0.0;
+    double takeoff_height_ = 0.0;
+    double apex_height_ = 0.0;
+    bool apex_seen_ = false;
+    bool rebound_ = false;
+
+    Jump last_jump_{};
+    std::uint64_t jumps_ = 0;
+    std::uint64_t rejected_ = 0;
+};
+
+/// Input columns of one trial for batch detection (any of the float columns
+/// of a TrajectorySet-like layout). `com_velocity` may be null.
+struct JumpSeries {
+    const TimestampNs* timestamps = nullptr;
+    const float* com_height = nullptr;
+    const float* com_velocity = nullptr;
+    const float* foot_height = nullptr;
+    std::int64_t frames = 0;
+};
+
+/// Runs the streaming detector over a whole trial.
+std::vector<Jump> detect_jumps(const JumpSeries& series, const JumpDetectorParams& params = {});
+
+/// Detects jumps in many trials (a season of sessions) in parallel; one
+/// result per series. `pool` may be null to run on the calling thread only.
+std::vector<std::vector<Jump>> detect_jumps(const std::vector<JumpSeries>& series, const JumpDetectorParams& params,
+                                            WorkStealingPool* pool);
+
+}  // namespace mm::analysis
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/calibration/camera_model.hpp"
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+
+namespace mm::calibration {
+
+struct BundleAdjustmentOptions {
+    int max_iterations = 10;
+    double initial_lambda = 1e-3;
+    /// Huber threshold on the reprojection error, px.
+    double huber_delta_px = 2.0;
+    /// Sliding window: the oldest landmarks are retired beyond this count,
+    /// keeping each refinement bounded during a session.
+    int max_landmarks = 2000;
+    /// Cameras whose extrinsics are held constant (gauge). Defaults to the
+    /// first camera.
+    std::vector<int> fixed_cameras{0};
+    /// Weight of the wand length residual, px per metre of length error.
+    /// Wands fix the metric scale that reprojection alone leaves free.
+    double wand_length_weight = 1000.0;
+    /// Stop when the relative cost decrease of an accepted step falls below.
+    double relative_tolerance = 1e-6;
+    /// Optional pool for multithreaded linearisation; null runs serially.
+    WorkStealingPool* pool = nullptr;
+    /// Landmarks per linearisation task.
+    int grain = 32;
+};
+
+struct BundleAdjustmentSummary {
+    int iterations = 0;
+    double initial_cost = 0.0;
+    double final_cost = 0.0;
+    /// RMS reprojection error after refinement, px.
+    double rms_px = 0.0;
+    int observations = 0;
+};
+
+/// One sighting of a landmark point: undistorted pixel coordinates.
+struct PointView {
+    int camera = 0;
+    Vec2d pixel{};
+};
+
+/// Incremental sparse bundle adjustment of camera extrinsics.
+///
+/// Wand or marker sightings are added as landmarks while a session runs;
+/// `refine()` then runs Levenberg-Marquardt over the extrinsics of all free
+/// cameras and the landmarks currently in the window, warm-started from the
+/// previous solution. Landmarks are eliminated with the Schur complement, so
+/// each iteration only factors the reduced camera system (6 unknowns per
+/// camera) with a block-sparse Cholesky whose pattern follows camera
+/// co-visibility. Jacobians are evaluated analytically per landmark on the
+/// work-stealing pool with per-worker accumulators. Intrinsics are held
+/// fixed and observations are expected to be undistorted.
+class BundleAdjuster {
+public:
+    BundleAdjuster(std::vector<CameraModel> cameras, BundleAdjustmentOptions options = {});
+
+    /// Adds a single marker seen by two or more cameras. Returns false if it
+    /// could not be triangulated from the current extrinsics.
+    bool add_marker(const std::vector<PointView>& views);
+
+    /// Adds a two-marker calibration wand of known `length` (metres).
+    bool add_wand(const std::vector<PointView>& end_a, const std::vector<PointView>& end_b, double length);
+
+    BundleAdjustmentSummary refine();
+
+    const std::vector<CameraModel>& cameras() const { return cameras_; }
+    int num_landmarks() const { return static_cast<int>(landmarks_.size()); }
+
+private:
+    struct Observation {
+        int camera;
+        int point;  // 0, or 1 for the second end of a wand
+        Vec2d pixel;
+    };
+
+    struct Landmark {
+        int points = 1;       // 1 marker, 2 wand ends
+        double x[6] = {};     // point coordinates, 3 per point
+        double length = 0.0;  // wand length, 0 for markers
+        std::vector<Observation> observations;
+    };
+
+    /// Per-landmark pieces of the Schur complement kept for back-substitution.
+    struct LandmarkSystem {
+        double v_inv[36];
+        double g[6];
+        std::vector<std::pair<int, std::vector<double>>> w;  // (variable camera, 6 x dim block)
+    };
+
+    /// Per-worker accumulators, reduced after each linearisation.
+    struct WorkerAccum {
+        std::vector<double> s;      // reduced camera matrix, 6n x 6n
+        std::vector<double> rhs;    // reduced right-hand side
+        std::vector<double> u_diag; // diagonal of the camera blocks, for damping
+        std::vector<char> pattern;  // n x n block occupancy
+        double cost = 0.0;
+
+        void reset(int num_variables);
+    };
+
+    using PointState = std::array<double, 6>;
+
+    bool initialise_point(const std::vector<PointView>& views, double* x) const;
+    void push_landmark(Landmark landmark);
+    double linearise(double lambda);
+    void linearise_landmark(int index, double lambda, WorkerAccum& acc);
+    double landmark_cost(const Landmark& landmark, const double* x, const std::vector<Pose>& poses,
+                         double* squared_error, int* count) const;
+    double evaluate_cost(const std::vector<Pose>& poses, const std::vector<PointState>& points) const;
+    bool solve_reduced(std::vector<double>& delta);
+
+    std::vector<CameraModel> cameras_;
+    BundleAdjustmentOptions options_;
+    std::vector<int> variable_index_;  // camera -> variable slot, -1 if fixed
+    int num_variables_ = 0;
+
+    std::deque<Landmark> landmarks_;
+    std::vector<LandmarkSystem> systems_;
+    std::vector<WorkerAccum> accums_;
+    WorkerAccum total_;
+};
+
+}  // namespace mm::calibration
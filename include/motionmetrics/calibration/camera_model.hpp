@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cmath>
+
+#include "motionmetrics/core/math.hpp"
+
+namespace mm::calibration {
+
+/// Pinhole intrinsics with Brown-Conrady radial/tangential distortion.
+struct Intrinsics {
+    double fx = 1.0;
+    double fy = 1.0;
+    double cx = 0.0;
+    double cy = 0.0;
+    double k1 = 0.0;
+    double k2 = 0.0;
+    double k3 = 0.0;
+    double p1 = 0.0;
+    double p2 = 0.0;
+    int width = 0;
+    int height = 0;
+
+    bool has_distortion() const { return k1 != 0.0 || k2 != 0.0 || k3 != 0.0 || p1 != 0.0 || p2 != 0.0; }
+};
+
+/// World-to-camera rigid transform: x_cam = rotation * x_world + translation.
+struct Pose {
+    Mat3d rotation = Mat3d::identity();
+    Vec3d translation{};
+
+    Vec3d transform(const Vec3d& x) const { return rotation * x + translation; }
+    Vec3d centre() const { return -(transpose(rotation) * translation); }
+};
+
+struct CameraModel {
+    Intrinsics intrinsics{};
+    Pose pose{};
+
+    /// P = K [R | t] for undistorted pixel coordinates.
+    Mat34d projection() const {
+        const Intrinsics& k = intrinsics;
+        const Mat3d& r = pose.rotation;
+        const Vec3d& t = pose.translation;
+        Mat34d p;
+        for (int c = 0; c < 3; ++c) {
+            p(0, c) = k.fx * r(0, c) + k.cx * r(2, c);
+            p(1, c) = k.fy * r(1, c) + k.cy * r(2, c);
+            p(2, c) = r(2, c);
+        }
+        p(0, 3) = k.fx * t.x + k.cx * t.z;
+        p(1, 3) = k.fy * t.y + k.cy * t.z;
+        p(2, 3) = t.z;
+        return p;
+    }
+};
+
+/// Applies the distortion model to normalised image coordinates (x/z, y/z).
+inline Vec2d distort_normalized(const Intrinsics& k, const Vec2d& p) {
+    const double r2 = p.x * p.x + p.y * p.y;
+    const double radial = 1.0 + r2 * (k.k1 + r2 * (k.k2 + r2 * k.k3));
+    return {p.x * radial + 2.0 * k.p1 * p.x * p.y + k.p2 * (r2 + 2.0 * p.x * p.x),
+            p.y * radial + k.p1 * (r2 + 2.0 * p.y * p.y) + 2.0 * k.p2 * p.x * p.y};
+}
+
+/// Inverts `distort_normalized` by fixed-point iteration. Converges in a
+/// few steps for the mild distortion of machine-vision lenses; too slow to
+/// run per pixel per frame, which is what the undistortion maps are for.
+inline Vec2d undistort_normalized(const Intrinsics& k, const Vec2d& d, int iterations = 20) {
+    Vec2d p = d;
+    for (int i = 0; i < iterations; ++i) {
+        const double r2 = p.x * p.x + p.y * p.y;
+        const double radial = 1.0 + r2 * (k.k1 + r2 * (k.k2 + r2 * k.k3));
+        const double dx = 2.0 * k.p1 * p.x * p.y + k.p2 * (r2 + 2.0 * p.x * p.x);
+        const double dy = k.p1 * (r2 + 2.0 * p.y * p.y) + 2.0 * k.p2 * p.x * p.y;
+        const Vec2d next{(d.x - dx) / radial, (d.y - dy) / radial};
+        const double step = std::abs(next.x - p.x) + std::abs(next.y - p.y);
+        p = next;
+        if (step < 1e-12) break;
+    }
+    return p;
+}
+
+/// Undistorts a pixel position of camera `k` into ideal pinhole pixels.
+inline Vec2d undistort_pixel(const Intrinsics& k, const Vec2d& px) {
+    const Vec2d n = undistort_normalized(k, Vec2d{(px.x - k.cx) / k.fx, (px.y - k.cy) / k.fy});
+    return {n.x * k.fx + k.cx, n.y * k.fy + k.cy};
+}
+
+/// Distorts an ideal pinhole pixel position into camera `k`'s image.
+inline Vec2d distort_pixel(const Intrinsics& k, const Vec2d& px) {
+    const Vec2d d = distort_normalized(k, Vec2d{(px.x - k.cx) / k.fx, (px.y - k.cy) / k.fy});
+    return {d.x * k.fx + k.cx, d.y * k.fy + k.cy};
+}
+
+}  // namespace mm::calibration
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "motionmetrics/calibration/camera_model.hpp"
+#include "motionmetrics/core/image.hpp"
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/simd.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+
+namespace mm::calibration {
+
+/// Per-camera image undistortion by table lookup.
+///
+/// Built once per camera. Each output pixel stores where it samples the
+/// distorted image as packed fixed point: integer source position (2 x
+/// int16) and 8-bit sub-pixel fractions, 6 bytes per pixel in total. Remap
+/// is then a bilinear gather with integer arithmetic, vectorised with AVX2 /
+/// AVX-512 gathers; all levels produce identical bytes. Output pixels whose
+/// source lies outside the image are written as 0.
+class UndistortionMap {
+public:
+    /// `pool` only speeds up construction and may be null.
+    explicit UndistortionMap(const Intrinsics& intrinsics, SimdLevel level = detect_simd_level(),
+                             WorkStealingPool* pool = nullptr);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    SimdLevel simd_level() const { return level_; }
+
+    /// Remaps a distorted frame of the map's size into `out`, which holds
+    /// height() rows of width() bytes spaced `out_stride` apart.
+    void remap(const ImageView& distorted, std::uint8_t* out, std::ptrdiff_t out_stride) const;
+
+    /// Fixed-point sample position of output pixel (x, y), for inspection.
+    bool source(int x, int y, double& sx, double& sy) const;
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    SimdLevel level_;
+    std::vector<std::uint32_t> position_;  // int16 x | int16 y << 16; x = -1 if invalid
+    std::vector<std::uint16_t> fraction_;  // x fraction | y fraction << 8, 1/256 px
+    /// Rows that sample the right end of the last source row pair. A 32-bit
+    /// gather reads up to two bytes past the pair, which can run off the end
+    /// of a tightly packed image, so these rows take the scalar path.
+    std::vector<char> scalar_row_;
+};
+
+/// Undistortion of marker centroids through a coarse lookup grid.
+///
+/// Undistorted positions are tabulated on a `cell`-pixel grid over the
+/// distorted image and bilinearly interpolated, replacing the iterative
+/// inversion of the distortion polynomial with four loads and a lerp. With
+/// the default 8 px cells the interpolation error stays below 0.02 px even in
+/// the corners of a strongly distorted wide-angle lens, well under centroid
+/// noise; smaller cells trade memory for accuracy. Positions outside the
+/// image fall back to the exact iteration.
+class PointUndistorter {
+public:
+    explicit PointUndistorter(const Intrinsics& intrinsics, int cell = 8);
+
+    const Intrinsics& intrinsics() const { return intrinsics_; }
+
+    Vec2d undistort(const Vec2d& distorted) const;
+    void undistort(const Vec2d* distorted, Vec2d* out, std::size_t n) const;
+
+private:
+    Intrinsics intrinsics_;
+    double inv_cell_;
+    int cols_ = 0;  // grid nodes per row
+    int rows_ = 0;
+    std::vector<float> grid_;  // (dx, dy) per node: undistorted minus distorted, px
+};
+
+}  // namespace mm::calibration
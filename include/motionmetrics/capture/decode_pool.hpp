@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "motionmetrics/capture/frame_ring.hpp"
+#include "motionmetrics/capture/frame_synchronizer.hpp"
+#include "motionmetrics/capture/video_decoder.hpp"
+
+namespace mm::capture {
+
+struct DecodePoolConfig {
+    /// Decoder threads per camera file, each with its own decoder instance.
+    /// 0 spreads the hardware threads evenly over the cameras.
+    int decoders_per_camera = 0;
+    /// Minimum frames per decode chunk. Chunks start on keyframes, so with
+    /// long GOPs a chunk spans at least one whole GOP.
+    int chunk_frames = 32;
+    /// Decoded chunks a camera may hold ahead of the consumer. Decoded frames
+    /// wait in ring slots, so the ring's free slots bound this as well.
+    int chunks_ahead = 4;
+    /// Ring slots per camera left to readers for pinned frames (synchronizer
+    /// windows, pipeline stages). Decoders never hold more than
+    /// `slots_per_camera - reader_slots` writers of one camera, and a decoder
+    /// that finds no free slot fails the run, so this must cover every pin
+    /// readers hold at once. `next_set` needs `reader_slots_for(sync)`; the
+    /// default covers the default synchronizer.
+    int reader_slots = 6;
+    /// Pin decoder threads to consecutive logical CPUs (or to `cpus`).
+    bool pin_threads = true;
+    std::vector<int> cpus;
+};
+
+struct DecodePoolStats {
+    std::uint64_t frames_decoded = 0;
+    std::uint64_t frames_delivered = 0;
+    std::uint64_t chunks = 0;
+    /// Times the consumer had to wait for a chunk to finish decoding.
+    std::uint64_t consumer_waits = 0;
+};
+
+/// Parallel decoder for offline reprocessing of a recorded session.
+///
+/// Every camera file is cut into chunks at keyframes. Each camera gets its
+/// own pinned decoder threads (one decoder instance per thread), which claim
+/// chunks in order, seek to them and decode them independently, so a single
+/// long recording is decoded on several cores at once. A bounded reorder
+/// window per camera restores frame order, and `next` merges the cameras by
+/// timestamp so that frames reach the ring and synchronizer exactly as a
+/// live rig would deliver them.
+///
+/// Decoders write straight into claimed ring slots (camera i -> ring camera
+/// i), so decoded pixels are never copied. Slots are claimed by CAS, which
+/// lets several decoder threads hold writers for one camera; only the
+/// consumer publishes them, keeping ring sequences in timestamp order. The
+/// ring therefore needs `reader_slots` plus the longest chunk's frames per
+/// camera, and more to decode several chunks ahead.
+class DecodePool {
+public:
+    /// Throws std::invalid_argument when `ring` has too few cameras, a
+    /// different frame size, or too few slots for the longest chunk. The
+    /// ring must outlive the pool.
+    DecodePool(std::vector<std::string> paths, FrameRing& ring, DecodePoolConfig config = {},
+               DecoderFactory factory = open_raw_video);
+    ~DecodePool();
+
+    DecodePool(const DecodePool&) = delete;
+    DecodePool& operator=(const DecodePool&) = delete;
+
+    int num_cameras() const { return static_cast<int>(cameras_.size()); }
+    int width(int camera) const { return cameras_[camera]->width; }
+    int height(int camera) const { return cameras_[camera]->height; }
+    std::int64_t frame_count(int camera) const { return cameras_[camera]->frame_count; }
+
+    /// Publishes the earliest undelivered frame of any camera into the ring
+    /// and pins it into `out`. Returns false once every file is exhausted.
+    /// Rethrows decoder errors, including ring overruns. Single consumer.
+    bool next(FramePin& out);
+
+    /// Feeds `sync` from `next` until it emits a frame set, using capture
+    /// timestamps as the arrival clock. Returns false after the final flush.
+    /// Throws std::invalid_argument if `reader_slots` is below
+    /// `reader_slots_for(sync.config())`.
+    bool next_set(FrameSynchronizer& sync, FrameSet& out);
+
+    /// Pins per camera held while `next_set` runs: the synchronizer's queue,
+    /// the frame being handed to it and the set last returned in `out`.
+    static int reader_slots_for(const FrameSynchronizerConfig& sync) { return sync.max_pending_per_camera + 2; }
+
+    DecodePoolStats stats() const;
+
+private:
+    struct Chunk {
+        int index = 0;
+        int frames = 0;
+        std::vector<FrameWriter> writers;  // decoded, unpublished ring slots
+        std::vector<TimestampNs> timestamps;
+    };
+
+    struct Camera {
+        std::string path;
+        int width = 0;
+        int height = 0;
+        std::int64_t frame_count = 0;
+        std::vector<std::int64_t> chunk_starts;  // plus a final end marker
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        int next_claim = 0;
+        int next_emit = 0;
+        int slots_held = 0;  // ring slots of claimed, not yet consumed chunks
+        std::map<int, std::unique_ptr<Chunk>> ready;
+        std::vector<std::unique_ptr<Chunk>> free;
+
+        // Consumer-side cursor.
+        std::unique_ptr<Chunk> current;
+        int position = 0;
+        bool exhausted = false;
+    };
+
+    int num_chunks(const Camera& cam) const { return static_cast<int>(cam.chunk_starts.size()) - 1; }
+    int chunk_size(const Camera& cam, int chunk) const {
+        return static_cast<int>(cam.chunk_starts[chunk + 1] - cam.chunk_starts[chunk]);
+    }
+    void worker(int camera, std::unique_ptr<VideoDecoder> decoder, int cpu);
+    /// Makes `current` hold an undelivered frame; false when exhausted.
+    bool advance(Camera& cam);
+    void fail(std::exception_ptr error);
+
+    FrameRing& ring_;
+    DecodePoolConfig config_;
+    int slot_budget_ = 0;  // writers decoders may hold per camera
+    std::vector<std::unique_ptr<Camera>> cameras_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<bool> stop_{false};
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+    std::atomic<std::uint64_t> frames_decoded_{0};
+    std::atomic<std::uint64_t> chunks_{0};
+    std::uint64_t frames_delivered_ = 0;  // consumer only
+    std::uint64_t consumer_waits_ = 0;    // consumer only
+
+    TimestampNs stream_clock_ = 0;
+    bool flushing_ = false;
+};
+
+}  // namespace mm::capture
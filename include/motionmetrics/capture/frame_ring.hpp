@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "motionmetrics/core/aligned_buffer.hpp"
+#include "motionmetrics/core/image.hpp"
+#include "motionmetrics/core/types.hpp"
+
+namespace mm::capture {
+
+/// Geometry of a frame ring. Every camera gets `slots_per_camera` slots of
+/// `width` x `height` 8-bit grayscale pixels; rows are padded to a cache line.
+struct FrameRingConfig {
+    int num_cameras = 0;
+    int slots_per_camera = 8;
+    int width = 0;
+    int height = 0;
+};
+
+/// Per-camera producer counters.
+struct FrameRingStats {
+    std::uint64_t published = 0;
+    /// Frames dropped because every slot of the camera was pinned by readers.
+    std::uint64_t overruns = 0;
+};
+
+namespace detail {
+
+struct alignas(kCacheLineSize) SlotHeader {
+    /// Reader pin count in the low bits, `kWriting` while a producer owns it.
+    std::atomic<std::uint32_t> state{0};
+    /// Publication sequence of the frame in the slot; 0 while empty.
+    std::atomic<std::uint64_t> sequence{0};
+    TimestampNs timestamp = 0;
+};
+
+struct alignas(kCacheLineSize) CameraState {
+    std::atomic<std::uint64_t> next_sequence{1};
+    std::atomic<std::uint64_t> published{0};
+    std::atomic<std::uint64_t> overruns{0};
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+}  // namespace detail
+
+class FrameRing;
+
+/// Exclusive producer access to one slot. Decoders write pixels straight into
+/// `data()` and then call `publish()`; dropping the writer unpublished returns
+/// the slot untouched.
+class FrameWriter {
+public:
+    FrameWriter() = default;
+    FrameWriter(FrameWriter&& other) noexcept;
+    FrameWriter& operator=(FrameWriter&& other) noexcept;
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+    ~FrameWriter();
+
+    /// False when the ring had no free slot for this camera (overrun).
+    explicit operator bool() const { return slot_ != nullptr; }
+
+    std::uint8_t* data() const { return pixels_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    std::ptrdiff_t stride() const { return stride_; }
+    CameraId camera() const { return camera_; }
+
+    /// Makes the frame visible to readers under `timestamp` and releases the slot.
+    void publish(TimestampNs timestamp);
+
+private:
+    friend class FrameRing;
+    void release();
+
+    detail::SlotHeader* slot_ = nullptr;
+    detail::CameraState* camera_state_ = nullptr;
+    std::uint8_t* pixels_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+    std::ptrdiff_t stride_ = 0;
+    CameraId camera_ = 0;
+};
+
+/// Shared, read-only pin on a published frame. While any pin on a slot is
+/// alive the producer will not reuse it, so the pixels can be consumed in
+/// place by every pipeline stage without copying.
+class FramePin {
+public:
+    FramePin() = default;
+    FramePin(FramePin&& other) noexcept;
+    FramePin& operator=(FramePin&& other) noexcept;
+    FramePin(const FramePin&) = delete;
+    FramePin& operator=(const FramePin&) = delete;
+    ~FramePin();
+
+    explicit operator bool() const { return slot_ != nullptr; }
+
+    /// Takes an additional pin on the same frame.
+    FramePin share() const;
+
+    ImageView view() const { return view_; }
+    TimestampNs timestamp() const { return timestamp_; }
+    std::uint64_t sequence() const { return sequence_; }
+    CameraId camera() const { return camera_; }
+
+private:
+    friend class FrameRing;
+    void release();
+
+    detail::SlotHeader* slot_ = nullptr;
+    ImageView view_{};
+    TimestampNs timestamp_ = 0;
+    std::uint64_t sequence_ = 0;
+    CameraId camera_ = 0;
+};
+
+/// Preallocated multi-camera frame store between capture and tracking.
+///
+/// Any number of readers may pin frames concurrently. Writers claim slots by
+/// CAS and take their sequence when they publish, so several threads may
+/// hold writers for one camera at once. Sequences then follow publication
+/// order: a camera whose frames must stay in capture order (for `latest`)
+/// should publish from one thread, as a live camera thread or DecodePool's
+/// consumer does. Slot headers and pixel rows are cache-line aligned and
+/// all memory is allocated once, either on the heap or in a POSIX shared
+/// memory object so a capture process and an analysis process can share it.
+class FrameRing {
+public:
+    explicit FrameRing(const FrameRingConfig& config);
+
+    /// Creates a named shared-memory ring, replacing any stale object of the
+    /// same name. The object is unlinked when the creating ring is destroyed.
+    static FrameRing create_shared(const std::string& name, const FrameRingConfig& config);
+
+    /// Attaches to a ring created by another process with `create_shared`.
+    static FrameRing open_shared(const std::string& name);
+
+    FrameRing(FrameRing&& other) noexcept;
+    FrameRing& operator=(FrameRing&& other) noexcept;
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+    ~FrameRing();
+
+    const FrameRingConfig& config() const { return config_; }
+    std::ptrdiff_t stride() const { return stride_; }
+
+    /// Claims a free slot for `camera`; safe to call from several threads
+    /// for the same camera. Returns an empty writer (and counts an overrun)
+    /// when every slot of the camera is pinned by readers or other writers.
+    FrameWriter begin_write(CameraId camera);
+
+    /// Pins the most recently published frame of `camera`, if any.
+    FramePin latest(CameraId camera) const;
+
+    /// Pins the frame of `camera` whose timestamp is closest to `timestamp`,
+    /// provided it lies within `tolerance`. Pass 0 for an exact match.
+    FramePin find(CameraId camera, TimestampNs timestamp, TimestampNs tolerance = 0) const;
+
+    FrameRingStats stats(CameraId camera) const;
+
+private:
+    struct Layout;
+
+    FrameRing() = default;
+    void bind(std::byte* base, const FrameRingConfig& config);
+    void reset();
+    void initialise_slots();
+    std::size_t slot_index(CameraId camera, int slot) const;
+    FramePin try_pin(CameraId camera, int slot, std::uint64_t expected_sequence) const;
+    void check_camera(CameraId camera) const;
+
+    FrameRingConfig config_{};
+    std::ptrdiff_t stride_ = 0;
+    std::size_t slot_bytes_ = 0;
+
+    detail::CameraState* cameras_ = nullptr;
+    detail::SlotHeader* slots_ = nullptr;
+    std::byte* pixels_ = nullptr;
+
+    AlignedBuffer heap_;
+    void* mapping_ = nullptr;
+    std::size_t mapping_size_ = 0;
+    std::string shm_name_;
+    bool owns_shm_name_ = false;
+};
+
+}  // namespace mm::capture
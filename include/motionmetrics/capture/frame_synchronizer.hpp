@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "motionmetrics/capture/frame_ring.hpp"
+#include "motionmetrics/core/types.hpp"
+
+namespace mm::capture {
+
+struct FrameSynchronizerConfig {
+    int num_cameras = 0;
+    /// Maximum distance between a member's capture timestamp and the earliest
+    /// frame of its set. Should stay below half the frame interval.
+    TimestampNs tolerance_ns = 1'000'000;
+    /// How long a set may wait for missing cameras, measured on the caller's
+    /// monotonic clock from the arrival of the set's earliest frame.
+    TimestampNs max_wait_ns = 8'000'000;
+    /// Frames buffered per camera before the oldest is discarded. Queued
+    /// frames stay pinned, so keep this below the ring's slots_per_camera.
+    int max_pending_per_camera = 4;
+    /// Optional per-camera hardware clock offsets, subtracted from each
+    /// frame's timestamp before matching. Empty means all zero.
+    std::vector<TimestampNs> clock_offsets_ns;
+};
+
+/// Frames captured at (approximately) the same instant, indexed by camera.
+/// Missing cameras have an empty pin.
+struct FrameSet {
+    /// Mean corrected capture timestamp of the members.
+    TimestampNs timestamp = 0;
+    std::vector<FramePin> frames;
+    int present = 0;
+    /// True when the set was emitted because its deadline expired.
+    bool timed_out = false;
+
+    bool complete() const { return present == static_cast<int>(frames.size()); }
+};
+
+struct CameraSyncStats {
+    std::uint64_t received = 0;
+    std::uint64_t matched = 0;
+    /// Frames that arrived after their set had already been emitted.
+    std::uint64_t dropped_late = 0;
+    /// Frames discarded because the camera's pending queue was full.
+    std::uint64_t dropped_overflow = 0;
+    /// Emitted sets this camera was absent from.
+    std::uint64_t missing = 0;
+    /// Sets that had to wait out their deadline for this camera.
+    std::uint64_t deadline_stalls = 0;
+    /// Signed offset from the set timestamp, over matched frames.
+    double mean_skew_ns = 0.0;
+    TimestampNs max_abs_skew_ns = 0;
+    TimestampNs last_skew_ns = 0;
+};
+
+/// Groups frames from N cameras into frame sets by capture timestamp.
+///
+/// A set is emitted as soon as every camera has contributed a frame within
+/// the tolerance window, as soon as every missing camera has provably moved
+/// past it, or when `max_wait_ns` has elapsed — whichever comes first. A
+/// stalled camera therefore delays reconstruction by at most `max_wait_ns`.
+///
+/// `push` may be called from the camera threads concurrently; `poll` is
+/// meant for a single consumer.
+class FrameSynchronizer {
+public:
+    explicit FrameSynchronizer(FrameSynchronizerConfig config);
+
+    const FrameSynchronizerConfig& config() const { return config_; }
+
+    /// Queues a frame. `arrival_ns` is the consumer clock at hand-off and
+    /// starts the deadline of the set the frame ends up anchoring.
+    void push(FramePin frame, TimestampNs arrival_ns);
+
+    /// Emits the next ready set into `out`, reusing its storage. Returns
+    /// false when nothing is ready at `now_ns`.
+    bool poll(TimestampNs now_ns, FrameSet& out);
+
+    /// Emits whatever is pending regardless of deadlines (end of stream).
+    bool flush(FrameSet& out);
+
+    /// Consumer clock time at which the current head set times out, if any
+    /// frames are pending.
+    std::optional<TimestampNs> next_deadline() const;
+
+    CameraSyncStats stats(CameraId camera) const;
+    std::uint64_t sets_emitted() const;
+
+private:
+    struct Pending {
+        FramePin frame;
+        TimestampNs timestamp = 0;
+        TimestampNs arrival = 0;
+    };
+
+    /// Fixed-capacity FIFO so steady-state operation never allocates.
+    struct CameraQueue {
+        std::vector<Pending> items;
+        int head = 0;
+        int size = 0;
+        TimestampNs last_timestamp = 0;
+        bool seen = false;
+
+        Pending& front() { return items[head]; }
+        const Pending& front() const { return items[head]; }
+        void pop();
+    };
+
+    bool emit_locked(TimestampNs now_ns, bool force, FrameSet& out);
+    std::optional<TimestampNs> anchor_locked(TimestampNs* arrival) const;
+
+    FrameSynchronizerConfig config_;
+    mutable std::mutex mutex_;
+    std::vector<CameraQueue> queues_;
+    std::vector<CameraSyncStats> stats_;
+    std::vector<char> member_;
+    std::optional<TimestampNs> last_emitted_;
+    std::uint64_t sets_emitted_ = 0;
+};
+
+}  // namespace mm::capture
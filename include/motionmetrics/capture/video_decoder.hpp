@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "motionmetrics/core/atomic_file.hpp"
+#include "motionmetrics/core/image.hpp"
+#include "motionmetrics/core/mapped_file.hpp"
+#include "motionmetrics/core/types.hpp"
+
+namespace mm::capture {
+
+/// Sequential decoder for one recorded camera file.
+///
+/// Implementations wrap a codec library or a container format. The frame
+/// index (timestamps and keyframe flags) must be available without decoding,
+/// since the decode pool plans its parallel chunks from it. Instances are used
+/// by one thread at a time; the pool opens several per file to decode
+/// different chunks concurrently.
+class VideoDecoder {
+public:
+    virtual ~VideoDecoder() = default;
+
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+    virtual std::int64_t frame_count() const = 0;
+    virtual TimestampNs timestamp(std::int64_t frame) const = 0;
+    /// Whether decoding can start at `frame` without earlier frames.
+    virtual bool is_keyframe(std::int64_t frame) const = 0;
+
+    /// Positions the decoder so that the next `decode` returns `frame`.
+    virtual void seek(std::int64_t frame) = 0;
+    /// Decodes the next frame as 8-bit grayscale into `out`. Returns false
+    /// at the end of the stream.
+    virtual bool decode(std::uint8_t* out, std::ptrdiff_t stride) = 0;
+};
+
+using DecoderFactory = std::function<std::unique_ptr<VideoDecoder>(const std::string& path)>;
+
+/// Decoder for the uncompressed recording format written by RawVideoWriter:
+/// a header, the frames back to back, then the timestamp index. Every frame
+/// is a keyframe and decoding is a copy out of a read-only mapping.
+class RawVideoDecoder final : public VideoDecoder {
+public:
+    /// Throws std::system_error if the file cannot be mapped and
+    /// std::runtime_error if it is not a raw recording.
+    explicit RawVideoDecoder(const std::string& path);
+
+    int width() const override { return width_; }
+    int height() const override { return height_; }
+    std::int64_t frame_count() const override { return static_cast<std::int64_t>(timestamps_.size()); }
+    TimestampNs timestamp(std::int64_t frame) const override { return timestamps_[frame]; }
+    bool is_keyframe(std::int64_t) const override { return true; }
+
+    void seek(std::int64_t frame) override;
+    bool decode(std::uint8_t* out, std::ptrdiff_t stride) override;
+
+private:
+    MappedFile file_;
+    int width_ = 0;
+    int height_ = 0;
+    const std::byte* frames_ = nullptr;
+    std::vector<TimestampNs> timestamps_;
+    std::int64_t position_ = 0;
+};
+
+std::unique_ptr<VideoDecoder> open_raw_video(const std::string& path);
+
+/// Records 8-bit grayscale frames in the raw format. The file is published
+/// by `close()`; until then it lives under a temporary name.
+class RawVideoWriter {
+public:
+    RawVideoWriter(std::string path, int width, int height);
+    RawVideoWriter(const RawVideoWriter&) = delete;
+    RawVideoWriter& operator=(const RawVideoWriter&) = delete;
+
+    /// Appends a frame of the writer's size. Timestamps must not decrease.
+    void append(const ImageView& frame, TimestampNs timestamp);
+    void close();
+
+private:
+    AtomicFile file_;
+    int width_;
+    int height_;
+    std::vector<TimestampNs> timestamps_;
+};
+
+}  // namespace mm::capture
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#include "motionmetrics/core/types.hpp"
+
+namespace mm {
+
+/// Owning, move-only block of raw memory aligned to `kCacheLineSize`.
+/// Contents are uninitialised; callers construct what they store in it.
+class AlignedBuffer {
+public:
+    AlignedBuffer() = default;
+
+    explicit AlignedBuffer(std::size_t size) : size_(align_up(size, kCacheLineSize)) {
+        if (size_ == 0) return;
+        data_ = static_cast<std::byte*>(std::aligned_alloc(kCacheLineSize, size_));
+        if (data_ == nullptr) throw std::bad_alloc();
+    }
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        if (this != &other) {
+            std::free(data_);
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    ~AlignedBuffer() { std::free(data_); }
+
+    std::byte* data() { return data_; }
+    const std::byte* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+    template <typename T>
+    T* as() {
+        return reinterpret_cast<T*>(data_);
+    }
+    template <typename T>
+    const T* as() const {
+        return reinterpret_cast<const T*>(data_);
+    }
+
+private:
+    std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+}  // namespace mm
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+
+namespace mm {
+
+/// Mass and centre-of-mass location of one model segment.
+struct SegmentParameters {
+    /// Model segment name.
+    std::string segment;
+    /// Fraction of body mass.
+    double mass_fraction = 0.0;
+    /// Segment endpoints in the segment frame; the centre of mass lies
+    /// `com_fraction` of the way from `proximal` to `distal`.
+    Vec3d proximal{};
+    Vec3d distal{};
+    double com_fraction = 0.5;
+};
+
+/// Segment parameters of one athlete. Several entries may name the same
+/// model segment (e.g. head and upper trunk on a rigid trunk segment).
+/// Consumed by kinematics::CenterOfMassCalculator and persisted per athlete
+/// id by storage::AnthropometricsStore.
+struct AthleteAnthropometrics {
+    std::uint64_t athlete_id = 0;
+    double body_mass_kg = 0.0;
+    std::vector<SegmentParameters> segments;
+};
+
+}  // namespace mm
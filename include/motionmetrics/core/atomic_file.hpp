@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mm {
+
+/// Write-only file published atomically under its final name.
+///
+/// Data goes to a temporary file next to `path` whose name is unique to this
+/// writer (process id and a counter), so concurrent writers of the same path
+/// never share or truncate each other's temporaries. `commit()` syncs the
+/// data, renames it into place and syncs the directory, so the new file
+/// survives a crash once it returns; the last writer to commit wins and
+/// readers only ever see a complete file. Move-only.
+class AtomicFile {
+public:
+    AtomicFile() = default;
+    /// Creates the temporary file. Throws std::system_error on failure.
+    explicit AtomicFile(std::string path);
+
+    AtomicFile(AtomicFile&& other) noexcept;
+    AtomicFile& operator=(AtomicFile&& other) noexcept;
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+    /// Abandons the temporary file if `commit()` was never called.
+    ~AtomicFile();
+
+    bool is_open() const { return fd_ >= 0; }
+    const std::string& path() const { return path_; }
+
+    /// Appends at the current end of the sequential stream.
+    void write(const void* data, std::size_t size);
+    /// Writes at `offset` without moving the sequential position.
+    void write_at(const void* data, std::size_t size, std::uint64_t offset);
+    /// Flushes the data written so far to stable storage.
+    void sync();
+    /// Syncs, closes and renames the file into place, then syncs its
+    /// directory. All members throw std::system_error on I/O failure.
+    void commit();
+
+private:
+    void abandon();
+
+    std::string path_;
+    std::string temp_path_;
+    int fd_ = -1;
+};
+
+/// Writes `size` bytes to `path` through an AtomicFile.
+void write_file_atomic(const std::string& path, const void* data, std::size_t size);
+
+}  // namespace mm
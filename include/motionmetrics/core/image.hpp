@@ -0,0 +1,32 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace mm {
+
+/// Non-owning view of an 8-bit grayscale image. Rows may be padded; `stride`
+/// is the distance in bytes between the starts of consecutive rows.
+struct ImageView {
+    const std::uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    std::ptrdiff_t stride = 0;
+
+    bool empty() const { return data == nullptr || width <= 0 || height <= 0; }
+
+    const std::uint8_t* row(int y) const { return data + static_cast<std::ptrdiff_t>(y) * stride; }
+
+    /// Returns the sub-view covering [x, x+w) x [y, y+h), clipped to the
+    /// image. The result shares storage with this view.
+    ImageView crop(int x, int y, int w, int h) const {
+        const int x0 = std::clamp(x, 0, width);
+        const int y0 = std::clamp(y, 0, height);
+        const int x1 = std::clamp(x + w, x0, width);
+        const int y1 = std::clamp(y + h, y0, height);
+        return ImageView{data + static_cast<std::ptrdiff_t>(y0) * stride + x0, x1 - x0, y1 - y0, stride};
+    }
+};
+
+}  // namespace mm
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace mm {
+
+/// Percentile summary of a latency distribution, nanoseconds.
+struct LatencySummary {
+    std::uint64_t count = 0;
+    std::int64_t mean_ns = 0;
+    std::int64_t p50_ns = 0;
+    std::int64_t p90_ns = 0;
+    std::int64_t p99_ns = 0;
+    std::int64_t max_ns = 0;
+};
+
+/// Log-linear latency histogram: 16 sub-buckets per power of two, so
+/// reported percentiles are within ~6% of the true value. Recording is a
+/// relaxed atomic increment and may happen concurrently with reads.
+class LatencyHistogram {
+public:
+    void record(std::int64_t ns);
+    void reset();
+
+    std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    /// Upper bound of the bucket holding the q-quantile (0 <= q <= 1).
+    std::int64_t percentile(double q) const;
+    LatencySummary summary() const;
+
+private:
+    static constexpr int kSubBits = 4;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kBuckets = 64 * kSub;
+
+    static int bucket_of(std::uint64_t v);
+    static std::uint64_t bucket_upper(int bucket);
+
+    std::array<std::atomic<std::uint64_t>, kBuckets> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::int64_t> max_{0};
+};
+
+}  // namespace mm
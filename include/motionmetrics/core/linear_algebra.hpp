@@ -0,0 +1,20 @@
+#pragma once
+
+namespace mm {
+
+/// Eigen-decomposition of the symmetric n x n row-major matrix `a` by cyclic
+/// Jacobi sweeps. On return the diagonal of `a` holds the eigenvalues (in no
+/// particular order) and the columns of the n x n matrix `v` the matching
+/// eigenvectors.
+void jacobi_eigen(double* a, int n, double* v);
+
+/// In-place lower Cholesky factorisation of the symmetric positive-definite
+/// n x n row-major block `a` with leading dimension `ld`. Only the lower
+/// triangle is read and written. Returns false if the block is not
+/// positive definite.
+bool cholesky(double* a, int n, int ld);
+
+/// Solves L L^T x = b in place for a factor produced by `cholesky`.
+void cholesky_solve(const double* l, int n, int ld, double* b);
+
+}  // namespace mm
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace mm {
+
+/// Read-only, move-only memory mapping of a whole file.
+class MappedFile {
+public:
+    enum class Access { normal, sequential, random, will_need, dont_need };
+
+    MappedFile() = default;
+    /// Maps `path` read-only. Throws std::system_error on failure.
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const std::byte* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /// Paging hint for [offset, offset + length); rounded out to whole pages.
+    /// Purely advisory, errors are ignored.
+    void advise(std::size_t offset, std::size_t length, Access access) const;
+
+private:
+    void reset();
+
+    const std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+}  // namespace mm
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+
+namespace mm {
+
+/// Image-plane point or 2-vector.
+struct Vec2d {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+/// Plain 3-vector for geometry outside the batched kernels.
+struct Vec3d {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+
+    double operator[](int i) const { return i == 0 ? x : (i == 1 ? y : z); }
+    double& operator[](int i) { return i == 0 ? x : (i == 1 ? y : z); }
+
+    Vec3d& operator+=(const Vec3d& o) { x += o.x; y += o.y; z += o.z; return *this; }
+    Vec3d& operator-=(const Vec3d& o) { x -= o.x; y -= o.y; z -= o.z; return *this; }
+    Vec3d& operator*=(double s) { x *= s; y *= s; z *= s; return *this; }
+};
+
+inline Vec3d operator+(Vec3d a, const Vec3d& b) { return a += b; }
+inline Vec3d operator-(Vec3d a, const Vec3d& b) { return a -= b; }
+inline Vec3d operator-(const Vec3d& a) { return {-a.x, -a.y, -a.z}; }
+inline Vec3d operator*(Vec3d a, double s) { return a *= s; }
+inline Vec3d operator*(double s, Vec3d a) { return a *= s; }
+
+inline double dot(const Vec3d& a, const Vec3d& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3d cross(const Vec3d& a, const Vec3d& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+inline double norm(const Vec3d& a) { return std::sqrt(dot(a, a)); }
+inline Vec3d normalized(const Vec3d& a) {
+    const double n = norm(a);
+    return n > 0.0 ? a * (1.0 / n) : a;
+}
+
+/// Row-major 3x3 matrix.
+struct Mat3d {
+    std::array<double, 9> m{};
+
+    static Mat3d identity() { return Mat3d{{1, 0, 0, 0, 1, 0, 0, 0, 1}}; }
+
+    double operator()(int r, int c) const { return m[r * 3 + c]; }
+    double& operator()(int r, int c) { return m[r * 3 + c]; }
+
+    Vec3d row(int r) const { return {m[r * 3], m[r * 3 + 1], m[r * 3 + 2]}; }
+    Vec3d col(int c) const { return {m[c], m[3 + c], m[6 + c]}; }
+};
+
+inline Vec3d operator*(const Mat3d& a, const Vec3d& v) {
+    return {a.m[0] * v.x + a.m[1] * v.y + a.m[2] * v.z, a.m[3] * v.x + a.m[4] * v.y + a.m[5] * v.z,
+            a.m[6] * v.x + a.m[7] * v.y + a.m[8] * v.z};
+}
+
+inline Mat3d operator*(const Mat3d& a, const Mat3d& b) {
+    Mat3d r;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j) r(i, j) = a(i, 0) * b(0, j) + a(i, 1) * b(1, j) + a(i, 2) * b(2, j);
+    return r;
+}
+
+inline Mat3d transpose(const Mat3d& a) {
+    return Mat3d{{a.m[0], a.m[3], a.m[6], a.m[1], a.m[4], a.m[7], a.m[2], a.m[5], a.m[8]}};
+}
+
+/// Skew-symmetric matrix such that skew(a) * b == cross(a, b).
+inline Mat3d skew(const Vec3d& a) { return Mat3d{{0, -a.z, a.y, a.z, 0, -a.x, -a.y, a.x, 0}}; }
+
+/// Rotation matrix from an axis-angle vector (Rodrigues).
+inline Mat3d rotation_from_axis_angle(const Vec3d& w) {
+    const double theta = norm(w);
+    if (theta < 1e-12) {
+        Mat3d r = Mat3d::identity();
+        const Mat3d k = skew(w);
+        for (int i = 0; i < 9; ++i) r.m[i] += k.m[i];
+        return r;
+    }
+    const Vec3d k = w * (1.0 / theta);
+    const double c = std::cos(theta);
+    const double s = std::sin(theta);
+    const double t = 1.0 - c;
+    return Mat3d{{t * k.x * k.x + c, t * k.x * k.y - s * k.z, t * k.x * k.z + s * k.y,
+                  t * k.x * k.y + s * k.z, t * k.y * k.y + c, t * k.y * k.z - s * k.x,
+                  t * k.x * k.z - s * k.y, t * k.y * k.z + s * k.x, t * k.z * k.z + c}};
+}
+
+/// Rotation matrix from a unit quaternion (w, x, y, z).
+inline Mat3d rotation_from_quaternion(double qw, double qx, double qy, double qz) {
+    return Mat3d{{qw * qw + qx * qx - qy * qy - qz * qz, 2.0 * (qx * qy - qw * qz), 2.0 * (qx * qz + qw * qy),
+                  2.0 * (qx * qy + qw * qz), qw * qw - qx * qx + qy * qy - qz * qz, 2.0 * (qy * qz - qw * qx),
+                  2.0 * (qx * qz - qw * qy), 2.0 * (qy * qz + qw * qx), qw * qw - qx * qx - qy * qy + qz * qz}};
+}
+
+/// Row-major 3x4 camera projection matrix P = K [R | t].
+struct Mat34d {
+    std::array<double, 12> m{};
+
+    double operator()(int r, int c) const { return m[r * 4 + c]; }
+    double& operator()(int r, int c) { return m[r * 4 + c]; }
+};
+
+/// Projects a world point; returns false when it lies behind the camera.
+inline bool project(const Mat34d& p, const Vec3d& x, double& u, double& v) {
+    const double w = p.m[8] * x.x + p.m[9] * x.y + p.m[10] * x.z + p.m[11];
+    if (w <= 0.0) return false;
+    u = (p.m[0] * x.x + p.m[1] * x.y + p.m[2] * x.z + p.m[3]) / w;
+    v = (p.m[4] * x.x + p.m[5] * x.y + p.m[6] * x.z + p.m[7]) / w;
+    return true;
+}
+
+}  // namespace mm
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "motionmetrics/core/math.hpp"
+
+namespace mm {
+
+/// Proper rigid motion x -> R x + t.
+struct RigidTransform {
+    Mat3d rotation = Mat3d::identity();
+    Vec3d translation{};
+
+    Vec3d apply(const Vec3d& x) const { return rotation * x + translation; }
+    RigidTransform inverse() const {
+        const Mat3d rt = transpose(rotation);
+        return {rt, -(rt * translation)};
+    }
+};
+
+/// Least-squares rigid transform taking `from[i]` onto `to[i]` (Horn's
+/// closed-form quaternion method, so the result is never a reflection).
+/// `weights` may be null for uniform weights. Returns false when fewer than
+/// three points carry weight or they are collinear.
+bool fit_rigid_transform(const Vec3d* from, const Vec3d* to, const double* weights, int n, RigidTransform& out);
+
+}  // namespace mm
@@ -0,0 +1,64 @@
+#pragma once
+
+// Runtime instruction-set dispatch. Kernels are compiled per ISA with GCC/Clang
+// target attributes, so the library itself builds without -mavx flags and
+// picks the widest supported path on the machine it runs on.
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MM_HAVE_X86_DISPATCH 1
+#define MM_TARGET_AVX2 __attribute__((target("avx2,fma,bmi,bmi2,popcnt")))
+#define MM_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,fma,bmi,bmi2,popcnt")))
+#else
+#define MM_HAVE_X86_DISPATCH 0
+#define MM_TARGET_AVX2
+#define MM_TARGET_AVX512
+#endif
+
+// Portable kernels written as plain loops are marked always-inline and
+// wrapped once per target, letting the compiler auto-vectorise each copy for
+// that ISA.
+#if defined(__GNUC__) || defined(__clang__)
+#define MM_ALWAYS_INLINE inline __attribute__((always_inline))
+#define MM_RESTRICT __restrict__
+#else
+#define MM_ALWAYS_INLINE inline
+#define MM_RESTRICT
+#endif
+
+namespace mm {
+
+enum class SimdLevel { scalar, avx2, avx512 };
+
+/// Widest instruction set supported by the running CPU.
+inline SimdLevel detect_simd_level() {
+#if MM_HAVE_X86_DISPATCH
+    __builtin_cpu_init();
+    // The target attributes above also enable FMA, BMI1/2 and POPCNT, so the
+    // compiler may emit them anywhere in those kernels; require all of them.
+    const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+                      __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2") &&
+                      __builtin_cpu_supports("popcnt");
+    if (avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl"))
+        return SimdLevel::avx512;
+    if (avx2) return SimdLevel::avx2;
+#endif
+    return SimdLevel::scalar;
+}
+
+/// Clamps a requested level to what the CPU supports.
+inline SimdLevel clamp_simd_level(SimdLevel requested) {
+    const SimdLevel available = detect_simd_level();
+    return static_cast<int>(requested) < static_cast<int>(available) ? requested : available;
+}
+
+inline const char* to_string(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::avx512: return "avx512";
+        case SimdLevel::avx2: return "avx2";
+        case SimdLevel::scalar: break;
+    }
+    return "scalar";
+}
+
+}  // namespace mm
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "motionmetrics/core/types.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace mm {
+
+/// Bounded lock-free single-producer / single-consumer ring.
+///
+/// Head and tail live on separate cache lines, and each side keeps a cached
+/// copy of the other side's index so that the shared line is only re-read
+/// when the queue looks full (producer) or empty (consumer).
+template <typename T>
+class SpscQueue {
+public:
+    /// Capacity is rounded up to a power of two.
+    explicit SpscQueue(std::size_t capacity) {
+        if (capacity == 0) throw std::invalid_argument("SpscQueue: capacity must be positive");
+        std::size_t n = 1;
+        while (n < capacity) n <<= 1;
+        mask_ = n - 1;
+        slots_.reset(new Slot[n]);
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    ~SpscQueue() {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i) slots_[i & mask_].ptr()->~T();
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    /// Producer side. Returns false, leaving `item` untouched, when full.
+    bool try_push(T&& item) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) return false;
+        }
+        new (slots_[tail & mask_].ptr()) T(std::move(item));
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. Returns false when empty.
+    bool try_pop(T& out) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return false;
+        }
+        T* slot = slots_[head & mask_].ptr();
+        out = std::move(*slot);
+        slot->~T();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Approximate occupancy; exact only when both sides are quiescent.
+    std::size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t mask_ = 0;
+
+    alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_ = 0;  // consumer's view of tail_
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_ = 0;  // producer's view of head_
+};
+
+/// Spin, then yield, then sleep: for threads polling a queue where the
+/// common wait is a few microseconds but idle periods can be long.
+class Backoff {
+public:
+    void pause() {
+        if (count_ < kSpins) {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#endif
+        } else if (count_ < kSpins + kYields) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        ++count_;
+    }
+    void reset() { count_ = 0; }
+
+private:
+    static constexpr int kSpins = 64;
+    static constexpr int kYields = 64;
+    int count_ = 0;
+};
+
+}  // namespace mm
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace mm {
+
+/// Pins the calling thread to one logical CPU. Returns false if the CPU
+/// does not exist or the platform refuses; the thread then keeps running
+/// unpinned.
+bool pin_current_thread(int cpu);
+
+/// Sets the calling thread's name as shown by debuggers and profilers
+/// (truncated to 15 characters on Linux).
+void set_current_thread_name(const std::string& name);
+
+}  // namespace mm
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "motionmetrics/core/clock.hpp"
+#include "motionmetrics/core/latency_histogram.hpp"
+
+namespace mm {
+
+/// Lightweight scoped-timer tracing.
+///
+/// Each thread records complete events (name, start, duration, frame) into
+/// its own fixed-size ring, so recording is a handful of relaxed stores with
+/// no locks or shared cache lines; when a ring fills, the oldest events are
+/// overwritten. A ring outlives its thread, so the trace can be exported at
+/// any time; once the thread has exited, its ring is handed to the next
+/// thread that starts recording (dropping the old events), so memory stays
+/// bounded by the number of threads recording at once. Tracing is off until enabled, and a
+/// disabled scope costs one relaxed load. Define MM_DISABLE_TRACING to
+/// compile the macros out entirely.
+
+namespace detail {
+extern std::atomic<bool> g_tracing_enabled;
+void trace_record(const char* name, std::int64_t begin_ns, std::int64_t end_ns, std::int64_t frame);
+}  // namespace detail
+
+inline bool tracing_enabled() { return detail::g_tracing_enabled.load(std::memory_order_relaxed); }
+void set_tracing_enabled(bool enabled);
+
+/// Events kept per thread; applies to threads that record their first
+/// event after the call.
+void set_trace_buffer_capacity(std::size_t events);
+
+/// Returns a pointer with static lifetime for a name built at run time, for
+/// use as an event name.
+const char* trace_intern(const std::string& name);
+
+/// Discards all recorded events. Only call while no thread is recording.
+void clear_trace();
+
+/// Writes all recorded events in the Chrome trace-event JSON format, which
+/// chrome://tracing and the Perfetto UI both open directly.
+void write_chrome_trace(std::ostream& out);
+/// Same, to a file. Throws std::runtime_error if it cannot be written.
+void write_chrome_trace(const std::string& path);
+
+/// Duration statistics of every recorded event name, sorted by total time.
+struct TraceEventSummary {
+    std::string name;
+    std::int64_t total_ns = 0;
+    LatencySummary duration;
+};
+std::vector<TraceEventSummary> summarize_trace();
+
+/// Records the lifetime of the enclosing scope. `name` must outlive the
+/// trace (a string literal or `trace_intern`). `frame` tags the event with
+/// a frame number, or -1 for none.
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, std::int64_t frame = -1)
+        : name_(tracing_enabled() ? name : nullptr), frame_(frame), begin_ns_(name_ != nullptr ? steady_now_ns() : 0) {}
+    ~TraceScope() {
+        if (name_ != nullptr) detail::trace_record(name_, begin_ns_, steady_now_ns(), frame_);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    std::int64_t frame_;
+    std::int64_t begin_ns_;
+};
+
+}  // namespace mm
+
+#define MM_TRACE_CONCAT_INNER(a, b) a##b
+#define MM_TRACE_CONCAT(a, b) MM_TRACE_CONCAT_INNER(a, b)
+
+#if defined(MM_DISABLE_TRACING)
+#define MM_TRACE_SCOPE(name) ((void)0)
+#define MM_TRACE_SCOPE_FRAME(name, frame) ((void)0)
+#else
+#define MM_TRACE_SCOPE(name) ::mm::TraceScope MM_TRACE_CONCAT(mm_trace_scope_, __LINE__)(name)
+#define MM_TRACE_SCOPE_FRAME(name, frame) ::mm::TraceScope MM_TRACE_CONCAT(mm_trace_scope_, __LINE__)(name, frame)
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mm {
+
+/// Index of a camera within a calibrated rig (0-based, dense).
+using CameraId = std::uint16_t;
+
+/// Capture timestamps are nanoseconds on the rig's hardware clock.
+using TimestampNs = std::int64_t;
+
+/// Cache line size assumed for alignment and false-sharing padding.
+inline constexpr std::size_t kCacheLineSize = 64;
+
+/// Rounds `n` up to the next multiple of `alignment` (a power of two).
+constexpr std::size_t align_up(std::size_t n, std::size_t alignment) {
+    return (n + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace mm
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace mm {
+
+/// Fork-join thread pool with per-worker deques and work stealing.
+///
+/// `parallel_for` hands the whole range to one deque; whoever runs a range
+/// larger than the grain splits it, keeps the lower half and pushes the
+/// upper half onto its own deque, where idle workers steal it from the
+/// opposite end. Irregular per-item costs therefore balance themselves
+/// without up-front partitioning. The calling thread participates, and
+/// nested `parallel_for` calls from inside a task are allowed. Any number of
+/// outside threads may call `parallel_for` at once; while waiting, a caller
+/// only runs tasks of its own call.
+class WorkStealingPool {
+public:
+    /// `num_threads` <= 0 uses the hardware concurrency minus one (the
+    /// caller makes up the difference).
+    explicit WorkStealingPool(int num_threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /// Worker threads, not counting callers.
+    int size() const { return static_cast<int>(threads_.size()); }
+
+    /// Index of the calling worker in [0, size()), or size() for any other
+    /// thread. Within one `parallel_for` call no two tasks run on the same
+    /// slot at the same time, so scratch storage sized `size() + 1` and
+    /// owned by that call (or by an object not used concurrently) can be
+    /// indexed by it. Scratch shared between concurrent calls cannot.
+    int current_slot() const;
+
+    /// Calls `fn(i)` for every i in [begin, end), at most `grain` indices per
+    /// task, and returns once all have run. The first exception thrown by
+    /// `fn` is rethrown here after the remaining tasks finish.
+    template <typename Fn>
+    void parallel_for(int begin, int end, int grain, Fn&& fn) {
+        using F = std::remove_reference_t<Fn>;
+        run(begin, end, grain, [](void* ctx, int b, int e) {
+            F& f = *static_cast<F*>(ctx);
+            for (int i = b; i < e; ++i) f(i);
+        }, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+    /// Process-wide pool sized to the machine, created on first use.
+    static WorkStealingPool& shared();
+
+private:
+    using RangeFn = void (*)(void* ctx, int begin, int end);
+
+    struct Job {
+        RangeFn fn;
+        void* ctx;
+        int grain;
+        std::atomic<int> remaining;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+
+    struct Task {
+        Job* job;
+        int begin;
+        int end;
+    };
+
+    struct alignas(64) Deque {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(int begin, int end, int grain, RangeFn fn, void* ctx);
+    void push(int slot, const Task& task);
+    bool pop_local(int slot, const Job* job, Task& task);
+    bool steal(int slot, const Job* job, Task& task);
+    void execute(int slot, Task task);
+    void worker_loop(int slot);
+
+    std::vector<std::unique_ptr<Deque>> deques_;
+    std::vector<std::thread> threads_;
+    std::atomic<int> queued_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+};
+
+}  // namespace mm
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/types.hpp"
+#include "motionmetrics/gaze/gaze_scene.hpp"
+#include "motionmetrics/gaze/head_pose.hpp"
+
+namespace mm::gaze {
+
+struct GazeEventParams {
+    /// Angular gaze speed (deg/s) above which the gaze is in a saccade.
+    /// Head-referenced gaze moves more slowly than the eyes, so this is
+    /// lower than eye-tracking defaults.
+    double saccade_velocity = 30.0;
+    /// The speed must stay above the threshold this long (s) to start a
+    /// saccade; shorter spikes are noise within the fixation.
+    double min_saccade = 0.02;
+    /// A fixation ends when a sample strays further than this (deg) from
+    /// its mean direction, even at low speed (drift, pursuit).
+    double max_dispersion = 2.0;
+    /// Shorter fixations are dropped (s).
+    double min_fixation = 0.1;
+    /// A longer run of missing samples (s) ends the current event.
+    double max_gap = 0.1;
+};
+
+enum class GazeEventType : std::uint8_t { fixation, saccade };
+
+/// One frame of input; a NaN direction marks a frame without gaze.
+struct GazeSample {
+    TimestampNs timestamp = 0;
+    Vec3d direction{};
+    /// Scene target hit, -1 for none.
+    int target = -1;
+};
+
+struct GazeEvent {
+    GazeEventType type = GazeEventType::fixation;
+    /// First and last sample of the event.
+    TimestampNs start = 0;
+    TimestampNs end = 0;
+    /// Fixations: the target looked at longest during it, -1 for none.
+    /// Saccades: -1.
+    int target = -1;
+    /// Fixations: mean direction. Saccades: direction at the end.
+    Vec3d direction{};
+    /// Fixations: largest deviation of a sample from the running mean
+    /// direction. Saccades: angle from start to end direction. Degrees.
+    double amplitude = 0.0;
+    double peak_velocity = 0.0;  // deg/s
+};
+
+/// Running totals over all events.
+struct GazeSummary {
+    std::uint64_t fixations = 0;
+    std::uint64_t saccades = 0;
+    /// Seconds in accepted fixations, in saccades, and with gaze data at
+    /// all (intervals between samples no more than max_gap apart).
+    double fixation_time = 0.0;
+    double saccade_time = 0.0;
+    double tracked_time = 0.0;
+    double saccade_amplitude_sum = 0.0;  // deg
+    double peak_velocity = 0.0;          // deg/s
+
+    double mean_fixation_duration() const { return fixations ? fixation_time / fixations : 0.0; }
+    double mean_saccade_amplitude() const { return saccades ? saccade_amplitude_sum / saccades : 0.0; }
+};
+
+/// Dwell statistics of one scene target.
+struct TargetDwell {
+    /// Fixations whose longest-viewed target this is.
+    std::uint64_t fixations = 0;
+    /// Seconds on the target within accepted fixations, and in total.
+    double fixation_time = 0.0;
+    double gaze_time = 0.0;
+    double longest_fixation = 0.0;  // s
+    /// Start of the first fixation on the target, -1 if none.
+    TimestampNs first_fixation = -1;
+};
+
+/// Streaming fixation and saccade segmentation with per-target dwell
+/// statistics: one pass, O(1) per frame, memory independent of recording
+/// length (one dwell entry per scene target).
+///
+/// A velocity threshold (I-VT) separates saccades from fixations, with the
+/// angular speed taken over the last two sample intervals and required to
+/// persist for `min_saccade`, so marker noise does not break fixations up.
+/// Within a low-speed run a dispersion test (I-DT) splits the run
+/// whenever a sample strays from the running mean direction of the current
+/// fixation, so slow drift does not merge distinct fixations. Interval time
+/// between consecutive samples is credited to the earlier sample's target.
+class GazeEventClassifier {
+public:
+    /// Throws std::invalid_argument for negative `num_targets` or
+    /// non-positive thresholds.
+    explicit GazeEventClassifier(int num_targets, GazeEventParams params = {});
+
+    /// Feeds one frame; frames must come in time order. Returns true when
+    /// the frame completed an event, which `last_event()` then holds.
+    bool push(const GazeSample& sample);
+    /// Closes the event in progress (end of the recording); returns true if
+    /// that produced an event.
+    bool finish();
+
+    const GazeEvent& last_event() const { return last_event_; }
+    const GazeSummary& summary() const { return summary_; }
+    const std::vector<TargetDwell>& dwell() const { return dwell_; }
+    void reset();
+
+private:
+    enum class State : std::uint8_t { idle, fixation, saccade };
+
+    void start_event(State state, const GazeSample& at);
+    /// Adds `dt` seconds on `target` to the current fixation.
+    void credit_fixation(int target, double dt);
+    /// Closes the current event at the last sample; returns true if it was
+    /// reported.
+    bool close_event();
+
+    GazeEventParams params_;
+    double cos_dispersion_;
+    State state_ = State::idle;
+
+    // Last two samples with gaze, newest first.
+    GazeSample history_[2];
+    int history_size_ = 0;
+
+    GazeEvent current_{};
+    // Fixations: sum of the sample directions. Saccades: start direction.
+    Vec3d direction_sum_{};
+    double cos_spread_ = 1.0;
+    // Unconfirmed saccade onset within a fixation: the sample it started
+    // from, its peak speed and the time since.
+    bool onset_ = false;
+    GazeSample onset_sample_{};
+    double onset_peak_ = 0.0;
+    double onset_time_ = 0.0;
+    // Time on each target within the current fixation; only the touched
+    // entries are non-zero.
+    std::vector<double> fixation_time_;
+    std::vector<int> touched_;
+
+    GazeEvent last_event_{};
+    GazeSummary summary_{};
+    std::vector<TargetDwell> dwell_;
+};
+
+/// Events and statistics of a whole recording.
+struct GazeAnalysis {
+    std::vector<GazeEvent> events;
+    GazeSummary summary;
+    std::vector<TargetDwell> dwell;
+};
+
+/// Runs the classifier over a head-pose track. `hits` (may be null) gives
+/// each frame's target among `num_targets`; `timestamps` has one entry per
+/// frame.
+GazeAnalysis classify_gaze(const HeadPoseTrack& track, const std::vector<TimestampNs>& timestamps,
+                           const GazeHitTrack* hits, int num_targets, const GazeEventParams& params = {});
+
+}  // namespace mm::gaze
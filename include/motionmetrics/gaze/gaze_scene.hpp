@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/gaze/head_pose.hpp"
+#include "motionmetrics/trajectory/trajectory_set.hpp"
+
+namespace mm::gaze {
+
+enum class TargetShape : std::uint8_t { sphere, disc, box };
+
+/// Something the athlete may look at: a ball (sphere), a hoop or plate
+/// (disc, hit from either side) or a zone (axis-aligned box).
+struct GazeTarget {
+    std::string name;
+    TargetShape shape = TargetShape::sphere;
+    /// World position, or the offset from `marker` for a tracked target.
+    Vec3d centre{};
+    /// Disc only; unit.
+    Vec3d normal{0.0, 0.0, 1.0};
+    /// Sphere and disc.
+    double radius = 0.0;
+    /// Box only, along the world axes.
+    Vec3d half_extents{};
+    /// Marker the target moves with; empty for a fixed target.
+    std::string marker;
+};
+
+struct GazeHit {
+    /// Index of the nearest target hit, -1 for none.
+    int target = -1;
+    /// Along the gaze ray, m.
+    double distance = std::numeric_limits<double>::infinity();
+};
+
+/// Per-frame gaze hits over a trial.
+struct GazeHitTrack {
+    std::int64_t frames = 0;
+    /// -1 where nothing is hit or the frame has no head pose.
+    std::vector<std::int32_t> target;
+    /// m; NaN where `target` is -1.
+    std::vector<float> distance;
+};
+
+/// Scene targets with a bounding volume hierarchy over the fixed ones.
+///
+/// Fixed targets (courts, hoops, zones) are indexed once in a BVH built
+/// top-down by median split along the widest axis of the target centres;
+/// a gaze ray descends it nearest child first and stops descending once a
+/// node lies beyond the closest hit so far. Tracked targets (a ball) move
+/// every frame, are few, and are tested directly. The hierarchy is rebuilt
+/// as targets are added, so the scene is meant to be set up once and then
+/// queried, which is safe from several threads.
+class GazeScene {
+public:
+    /// Each returns the target index. Throws std::invalid_argument for a
+    /// duplicate or empty name or a non-positive size.
+    int add_sphere(std::string name, const Vec3d& centre, double radius);
+    int add_disc(std::string name, const Vec3d& centre, const Vec3d& normal, double radius);
+    int add_box(std::string name, const Vec3d& min, const Vec3d& max);
+    /// Sphere centred at `offset` from `marker`'s position each frame.
+    int add_tracked_sphere(std::string name, std::string marker, double radius, const Vec3d& offset = {});
+
+    int num_targets() const { return static_cast<int>(targets_.size()); }
+    const GazeTarget& target(int index) const { return targets_[index]; }
+    int target_index(const std::string& name) const;
+    /// Tracked target indices, in the order `intersect` expects their
+    /// marker positions.
+    const std::vector<int>& tracked_targets() const { return tracked_; }
+
+    /// Nearest target along the ray within `max_distance`. `tracked` holds
+    /// one marker position per tracked target (NaN to skip it) and may be
+    /// null when there are none.
+    GazeHit intersect(const Vec3d& origin, const Vec3d& direction, const Vec3d* tracked = nullptr,
+                      double max_distance = std::numeric_limits<double>::infinity()) const;
+
+    /// Gaze hits for every frame of a head pose track; tracked target
+    /// markers are read from `set`. Throws std::invalid_argument if `set`
+    /// lacks one of them or has a different frame count.
+    GazeHitTrack intersect(const HeadPoseTrack& track, const trajectory::TrajectorySet& set,
+                           WorkStealingPool* pool = nullptr) const;
+
+private:
+    struct Node {
+        Vec3d lo;
+        Vec3d hi;
+        /// Leaves: items [first, first + count). Inner nodes (count 0):
+        /// children at this index + 1 and at `first`.
+        int first = 0;
+        int count = 0;
+    };
+
+    int add(GazeTarget target);
+    void rebuild();
+    int build_node(int begin, int end);
+
+    std::vector<GazeTarget> targets_;
+    std::vector<int> tracked_;
+    std::vector<int> items_;  // fixed target indices in leaf order
+    std::vector<Node> nodes_;
+};
+
+}  // namespace mm::gaze
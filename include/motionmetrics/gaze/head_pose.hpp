@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/rigid_transform.hpp"
+#include "motionmetrics/core/simd.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/trajectory/trajectory_set.hpp"
+
+namespace mm::gaze {
+
+/// Head marker cluster treated as one rigid body, with the gaze ray it
+/// carries. Gaze is head-referenced: the eyes are assumed to look along
+/// `gaze_direction` in the head frame.
+struct HeadModel {
+    struct Marker {
+        std::string name;
+        /// Position in the head frame, m.
+        Vec3d local;
+        double weight = 1.0;
+    };
+
+    std::vector<Marker> markers;
+    /// Ray origin (e.g. between the eyes) and unit direction, head frame.
+    Vec3d gaze_origin{};
+    Vec3d gaze_direction{0.0, 1.0, 0.0};
+};
+
+/// Head model from a calibration frame in which the subject looks at a
+/// known point. The head frame is the world frame translated to
+/// `eye_centre`. Throws std::invalid_argument if a marker is unknown or
+/// missing in `frame`, or `look_at` coincides with `eye_centre`.
+HeadModel calibrate_head_model(const trajectory::TrajectorySet& set, std::int64_t frame,
+                               const std::vector<std::string>& marker_names, const Vec3d& eye_centre,
+                               const Vec3d& look_at);
+
+struct HeadPoseParams {
+    /// Frames with fewer markers present have no pose.
+    int min_markers = 3;
+    /// Frames whose weighted RMS residual exceeds this (a swapped or
+    /// displaced marker) have no pose, m.
+    double max_rms_error = 0.01;
+};
+
+/// Head pose and gaze ray over a trial, one float column per component.
+struct HeadPoseTrack {
+    std::int64_t frames = 0;
+    /// Head-to-world rotation as a unit quaternion (w, x, y, z), w >= 0.
+    std::array<std::vector<float>, 4> orientation;
+    /// Head frame origin, m.
+    std::array<std::vector<float>, 3> position;
+    std::array<std::vector<float>, 3> gaze_origin;
+    /// Unit vectors.
+    std::array<std::vector<float>, 3> gaze_direction;
+    /// Weighted RMS marker residual, m; NaN where the frame has no pose.
+    std::vector<float> rms_error;
+    std::vector<std::uint8_t> markers_used;
+
+    bool valid(std::int64_t f) const { return rms_error[f] == rms_error[f]; }
+    RigidTransform pose(std::int64_t f) const;
+    Vec3d origin(std::int64_t f) const { return {gaze_origin[0][f], gaze_origin[1][f], gaze_origin[2][f]}; }
+    Vec3d direction(std::int64_t f) const {
+        return {gaze_direction[0][f], gaze_direction[1][f], gaze_direction[2][f]};
+    }
+};
+
+/// Per-frame rigid fit of a head model to its markers.
+///
+/// Each frame is an absolute-orientation problem solved in closed form with
+/// Horn's quaternion method, taking the largest eigenvalue of the 4x4 key
+/// matrix by Newton iteration on its characteristic polynomial (Theobald's
+/// QCP) and the quaternion from the adjugate of the shifted matrix, so there
+/// is no per-frame SVD or iterative eigensolver. Frames are processed in
+/// blocks with every intermediate laid out structure-of-arrays, and each
+/// stage (covariance accumulation over markers, polynomial set-up, Newton
+/// steps, quaternion recovery) is a branch-free loop across the frames of
+/// the block, compiled per instruction set like the triangulation kernels.
+/// Missing markers get zero weight in their frame. Blocks run in parallel.
+class HeadPoseEstimator {
+public:
+    /// Throws std::invalid_argument for a model with fewer than three
+    /// markers, a non-positive weight or a zero gaze direction.
+    explicit HeadPoseEstimator(HeadModel model, HeadPoseParams params = {}, SimdLevel level = detect_simd_level(),
+                               WorkStealingPool* pool = nullptr);
+
+    const HeadModel& model() const { return model_; }
+    SimdLevel simd_level() const { return level_; }
+
+    /// Throws std::invalid_argument if a model marker is not in `set`.
+    HeadPoseTrack estimate(const trajectory::TrajectorySet& set) const;
+
+private:
+    HeadModel model_;
+    HeadPoseParams params_;
+    SimdLevel level_;
+    WorkStealingPool* pool_;
+};
+
+}  // namespace mm::gaze
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "motionmetrics/core/anthropometrics.hpp"
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/types.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/kinematics/ik_solver.hpp"
+#include "motionmetrics/kinematics/skeleton_model.hpp"
+
+namespace mm::kinematics {
+
+enum class Sex : std::uint8_t { male, female };
+
+/// One row of de Leva's (1996) adjusted Zatsiorsky-Seluyanov parameters.
+struct DeLevaRow {
+    const char* name;
+    double mass_fraction;
+    /// Centre of mass from the proximal landmark, fraction of length.
+    double com_fraction;
+};
+
+/// Rows: head (vertex to cervicale), trunk (cervicale to mid-hip),
+/// upper_trunk, middle_trunk, lower_trunk, upper_arm, forearm, hand,
+/// thigh, shank, foot (heel to toe tip). Limb rows are per side.
+const std::vector<DeLevaRow>& de_leva_table(Sex sex);
+
+/// Entry for model segment `segment` from the de Leva row `row`, with the
+/// row's proximal and distal landmarks at the given segment-frame points.
+/// Throws std::invalid_argument for an unknown row.
+SegmentParameters de_leva_segment(const std::string& row, Sex sex, std::string segment, const Vec3d& proximal,
+                                  const Vec3d& distal);
+
+/// Whole-body centre of mass over a trial, one float column per axis.
+struct CenterOfMassTrajectory {
+    std::int64_t frames = 0;
+    std::array<std::vector<float>, 3> position;      // m
+    std::array<std::vector<float>, 3> velocity;      // m/s
+    std::array<std::vector<float>, 3> acceleration;  // m/s^2
+};
+
+/// Whole-body centre of mass from IK poses.
+///
+/// The anthropometrics are resolved once into a flat per-segment table
+/// (mass fraction and local centre of mass, zero for massless segments).
+/// Trials are processed in blocks of frames with the pose state laid out
+/// structure-of-arrays, so forward kinematics and the weighted sum run as
+/// loops across frames for each segment and degree of freedom. Velocity and
+/// acceleration are central differences over the timestamps (one-sided at
+/// the ends), so the poses should come from filtered markers. Frames without
+/// an IK solution are NaN.
+class CenterOfMassCalculator {
+public:
+    /// Throws std::invalid_argument if an entry names an unknown segment or
+    /// the mass fractions do not sum to a positive value.
+    CenterOfMassCalculator(const SkeletonModel& model, const AthleteAnthropometrics& anthropometrics);
+
+    /// Centre of mass of one pose.
+    Vec3d position(const double* q) const;
+
+    /// `timestamps` has one entry per trial frame. `pool` may be null to
+    /// run on the calling thread only.
+    CenterOfMassTrajectory compute(const IkTrial& trial, const std::vector<TimestampNs>& timestamps,
+                                   WorkStealingPool* pool = nullptr) const;
+
+    /// Sum of the entries' mass fractions (ideally 1).
+    double total_mass_fraction() const { return total_fraction_; }
+
+private:
+    struct BlockPose;
+
+    void compute_block(const IkTrial& trial, std::int64_t first, int count, BlockPose* poses,
+                       CenterOfMassTrajectory& out) const;
+
+    SkeletonModel model_;
+    std::vector<double> mass_;       // per segment, normalised to sum 1
+    std::vector<Vec3d> local_com_;   // per segment
+    double total_fraction_ = 0.0;
+};
+
+}  // namespace mm::kinematics
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/kinematics/skeleton_model.hpp"
+#include "motionmetrics/trajectory/trajectory_set.hpp"
+
+namespace mm::kinematics {
+
+struct IkParams {
+    /// Gauss-Newton iterations per warm-started frame.
+    int max_iterations = 10;
+    /// Iterations for a frame solved without a previous pose.
+    int cold_iterations = 100;
+    /// Converged once no parameter moves more than this (radians or metres).
+    double tolerance = 1e-6;
+    /// Initial Levenberg-Marquardt damping, relative to the normal matrix
+    /// diagonal; adapted per frame.
+    double damping = 1e-4;
+    /// Frames per parallel task in `solve_trial`.
+    int chunk_frames = 256;
+    /// Frames solved before each chunk (and discarded) so that its first
+    /// frame is warm-started like every other.
+    int warmup_frames = 16;
+};
+
+struct IkResult {
+    int iterations = 0;
+    /// Weighted RMS marker distance, metres.
+    double rms_error = 0.0;
+    int markers_used = 0;
+    bool converged = false;
+};
+
+/// Joint angles of a whole trial, one row of num_dofs values per frame.
+/// Frames without a usable marker have NaN angles and rms_error.
+struct IkTrial {
+    int num_dofs = 0;
+    std::int64_t frames = 0;
+    std::vector<double> angles;
+    std::vector<float> rms_error;  // per frame, NaN where no solve was possible
+    std::vector<std::uint8_t> converged;
+
+    const double* pose(std::int64_t frame) const { return angles.data() + frame * num_dofs; }
+};
+
+/// Global-optimisation inverse kinematics: per frame, the pose minimising
+/// the weighted squared distances between model and measured markers, all
+/// degrees of freedom at once, subject to the joint limits.
+///
+/// Each iteration runs forward kinematics once and builds the normal
+/// equations from analytic Jacobians (axis x (marker - pivot) for a
+/// rotation, the axis for a translation), visiting only the degrees of
+/// freedom on each marker's chain. Steps are damped Levenberg-Marquardt
+/// style and projected onto the limits. Frames start from the previous
+/// frame's pose, so a few iterations usually suffice; a cold start first
+/// places the root by a rigid fit of its markers when the root joint is
+/// three translations and three rotations about distinct axes.
+class IkSolver {
+public:
+    explicit IkSolver(SkeletonModel model, IkParams params = {});
+
+    const SkeletonModel& model() const { return model_; }
+
+    /// Refines `q` (num_dofs values) against one frame. `xyz` holds the
+    /// model markers' measured positions in model marker order, three
+    /// floats each, NaN where missing. With `warm` false, `q` is ignored and
+    /// the solve starts from the neutral pose.
+    IkResult solve(const float* xyz, double* q, bool warm = true);
+
+    /// Solves every frame of a trial; markers are matched by name. Frames
+    /// are split into chunks solved in parallel, each warm-starting frame
+    /// to frame. `pool` may be null to run on the calling thread only.
+    IkTrial solve_trial(const trajectory::TrajectorySet& trial, WorkStealingPool* pool = nullptr) const;
+
+private:
+    void place_root(const float* xyz, double* q) const;
+    /// Weighted squared residual of pose `q`; fills `residual_`.
+    double evaluate(const float* xyz, const double* q);
+
+    SkeletonModel model_;
+    IkParams params_;
+    std::vector<std::vector<int>> chains_;  // per segment
+    bool root_placeable_ = false;
+
+    std::vector<SegmentPose> poses_;
+    std::vector<Vec3d> axes_;
+    std::vector<Vec3d> pivots_;
+    std::vector<Vec3d> residual_;  // per marker, measured - model
+    std::vector<double> normal_;
+    std::vector<double> factor_;
+    std::vector<double> gradient_;
+    std::vector<double> step_;
+    std::vector<Vec3d> columns_;  // Jacobian of one marker, per chain entry
+    std::vector<double> trial_;
+};
+
+namespace detail {
+
+/// Keeps degrees of freedom no marker constrains (and the damped system)
+/// positive definite.
+inline constexpr double kRegularisation = 1e-9;
+/// Damping beyond which no step can reduce the cost.
+inline constexpr double kMaxDamping = 1e12;
+inline constexpr double kMinDamping = 1e-12;
+
+/// Levenberg-Marquardt step acceptance shared by the IK solvers, run once
+/// per iteration after the normal equations are built.
+///
+/// `factor(lambda)` factors the normal matrix with its diagonal scaled by
+/// 1 + lambda plus kRegularisation, returning false if that is not positive
+/// definite; `solve()` then writes the step into `step`. The clamped trial
+/// pose q + step replaces `q` if `evaluate` finds it no worse; otherwise the
+/// kinematics of `q` are restored and the damping raised, until the step is
+/// too small to matter. Returns false once the damping saturates.
+template <typename Factor, typename Solve, typename Clamp, typename Evaluate>
+bool damped_step(int n, double* q, double* trial, const double* step, double tolerance, double& lambda,
+                 double& cost, bool& converged, Factor&& factor, Solve&& solve, Clamp&& clamp,
+                 Evaluate&& evaluate) {
+    while (lambda < kMaxDamping) {
+        if (!factor(lambda)) {
+            lambda *= 10.0;
+            continue;
+        }
+        solve();
+        double moved = 0.0;
+        for (int d = 0; d < n; ++d) trial[d] = q[d] + step[d];
+        clamp(trial);
+        for (int d = 0; d < n; ++d) moved = std::max(moved, std::abs(trial[d] - q[d]));
+
+        const double trial_cost = evaluate(static_cast<const double*>(trial));
+        if (trial_cost <= cost) {
+            std::copy(trial, trial + n, q);
+            cost = trial_cost;
+            lambda = std::max(lambda * 0.1, kMinDamping);
+            converged = moved < tolerance;
+            return true;
+        }
+        cost = evaluate(static_cast<const double*>(q));
+        lambda *= 10.0;
+        if (moved < tolerance) {
+            converged = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Shifts unlimited rotations of each chunk after the first by whole turns
+/// to continue from the previous chunk, since chunks start cold. A chunk is
+/// shifted as a whole, or left alone if the limits do not allow the shift.
+void unwrap_chunks(const SkeletonModel& model, std::int64_t chunk, IkTrial& out);
+
+/// Chunked trial solve shared by the IK solvers. `Solver` is copied once per
+/// pool slot and must provide `IkResult solve(const float*, double*, bool)`
+/// taking marker rows in `model`'s marker order.
+template <typename Solver>
+IkTrial solve_trial(const Solver& prototype, const SkeletonModel& model, const IkParams& params,
+                    const trajectory::TrajectorySet& trial, WorkStealingPool* pool) {
+    const int n = model.num_dofs();
+    const int markers = model.num_markers();
+    IkTrial out;
+    out.num_dofs = n;
+    out.frames = trial.frames();
+    out.angles.assign(static_cast<std::size_t>(out.frames) * n, 0.0);
+    out.rms_error.assign(out.frames, std::numeric_limits<float>::quiet_NaN());
+    out.converged.assign(out.frames, 0);
+
+    std::vector<int> source(markers);
+    for (int m = 0; m < markers; ++m) source[m] = trial.marker_index(model.marker(m).name);
+
+    const int slots = pool ? pool->size() + 1 : 1;
+    std::vector<Solver> solvers(slots, prototype);
+    std::vector<std::vector<float>> rows(slots, std::vector<float>(static_cast<std::size_t>(markers) * 3));
+    const std::int64_t chunk = params.chunk_frames;
+    const int chunks = static_cast<int>((out.frames + chunk - 1) / chunk);
+
+    auto run = [&](int c) {
+        const int slot = pool ? pool->current_slot() : 0;
+        Solver& solver = solvers[slot];
+        float* row = rows[slot].data();
+        const std::int64_t begin = c * chunk;
+        const std::int64_t end = std::min(out.frames, begin + chunk);
+        std::vector<double> q(n);
+        bool warm = false;
+        for (std::int64_t f = std::max<std::int64_t>(0, begin - params.warmup_frames); f < end; ++f) {
+            for (int m = 0; m < markers; ++m)
+                for (int axis = 0; axis < 3; ++axis)
+                    row[m * 3 + axis] = source[m] >= 0 ? trial.column(source[m], axis)[f]
+                                                       : std::numeric_limits<float>::quiet_NaN();
+            const IkResult r = solver.solve(row, q.data(), warm);
+            warm = warm || r.markers_used > 0;
+            if (f < begin) continue;
+            // `q` still holds the last solved pose for the next warm start,
+            // but it is not this frame's pose.
+            if (r.markers_used == 0) {
+                std::fill_n(out.angles.begin() + f * n, n, std::numeric_limits<double>::quiet_NaN());
+                continue;
+            }
+            std::copy(q.begin(), q.end(), out.angles.begin() + f * n);
+            out.rms_error[f] = static_cast<float>(r.rms_error);
+            out.converged[f] = r.converged;
+        }
+    };
+    if (pool)
+        pool->parallel_for(0, chunks, 1, run);
+    else
+        for (int c = 0; c < chunks; ++c) run(c);
+    unwrap_chunks(model, chunk, out);
+    return out;
+}
+
+}  // namespace detail
+
+}  // namespace mm::kinematics
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "motionmetrics/kinematics/static_skeleton.hpp"
+
+namespace mm::kinematics {
+
+/// Joint tables for the skeletons used in the lab, for StaticSkeleton.
+///
+/// Segment frames in the reference pose: x to the subject's left, y
+/// forward, z up. The pelvis carries the global position and orientation
+/// (yaw, roll, pitch order). Rotations about x are flexion (positive moves
+/// the distal end forward), so knees flex negative. Limits are generous
+/// anatomical ranges in radians, shared by both sides.
+namespace joint_tables {
+
+inline constexpr std::array<JointDof, 6> kRoot{{
+    {DofType::translate_x},
+    {DofType::translate_y},
+    {DofType::translate_z},
+    {DofType::rotate_z},
+    {DofType::rotate_x},
+    {DofType::rotate_y},
+}};
+
+// Per leg: hip (flexion, ab/adduction, rotation), knee, ankle (dorsiflexion,
+// inversion).
+inline constexpr std::array<JointDof, 6> kLeg{{
+    {DofType::rotate_x, -0.6, 2.2},
+    {DofType::rotate_y, -0.8, 0.8},
+    {DofType::rotate_z, -0.8, 0.8},
+    {DofType::rotate_x, -2.6, 0.1},
+    {DofType::rotate_x, -0.9, 0.6},
+    {DofType::rotate_y, -0.6, 0.6},
+}};
+
+// Trunk on pelvis (flexion, lateral bend, axial rotation).
+inline constexpr std::array<JointDof, 3> kTrunk{{
+    {DofType::rotate_x, -0.6, 1.6},
+    {DofType::rotate_y, -0.7, 0.7},
+    {DofType::rotate_z, -0.9, 0.9},
+}};
+
+// Per arm: shoulder (flexion, ab/adduction, rotation), elbow (flexion,
+// pronation), wrist (flexion, deviation).
+inline constexpr std::array<JointDof, 7> kArm{{
+    {DofType::rotate_x, -1.2, 3.2},
+    {DofType::rotate_y, -3.2, 3.2},
+    {DofType::rotate_z, -1.6, 1.6},
+    {DofType::rotate_x, 0.0, 2.7},
+    {DofType::rotate_z, -1.6, 1.6},
+    {DofType::rotate_x, -1.4, 1.4},
+    {DofType::rotate_y, -0.6, 0.6},
+}};
+
+// Head on trunk (flexion, lateral bend, axial rotation).
+inline constexpr std::array<JointDof, 3> kHead{{
+    {DofType::rotate_x, -1.0, 1.2},
+    {DofType::rotate_y, -0.7, 0.7},
+    {DofType::rotate_z, -1.4, 1.4},
+}};
+
+template <std::size_t... N>
+constexpr auto concat(const std::array<JointDof, N>&... parts) {
+    std::array<JointDof, (N + ...)> out{};
+    std::size_t at = 0;
+    ((void)[&] {
+        for (const JointDof& d : parts) out[at++] = d;
+    }(), ...);
+    return out;
+}
+
+}  // namespace joint_tables
+
+/// Pelvis and legs; 7 segments, 18 degrees of freedom.
+struct LowerBodySkeleton {
+    static constexpr std::array<JointDef, 7> joints{{
+        {"pelvis", -1, 0, 6},
+        {"l_thigh", 0, 6, 3},
+        {"l_shank", 1, 9, 1},
+        {"l_foot", 2, 10, 2},
+        {"r_thigh", 0, 12, 3},
+        {"r_shank", 4, 15, 1},
+        {"r_foot", 5, 16, 2},
+    }};
+    static constexpr auto dofs =
+        joint_tables::concat(joint_tables::kRoot, joint_tables::kLeg, joint_tables::kLeg);
+};
+
+/// Lower body plus trunk (with the head rigidly on it) and arms;
+/// 14 segments, 35 degrees of freedom.
+struct FullBodySkeleton {
+    static constexpr std::array<JointDef, 14> joints{{
+        {"pelvis", -1, 0, 6},
+        {"l_thigh", 0, 6, 3},
+        {"l_shank", 1, 9, 1},
+        {"l_foot", 2, 10, 2},
+        {"r_thigh", 0, 12, 3},
+        {"r_shank", 4, 15, 1},
+        {"r_foot", 5, 16, 2},
+        {"trunk", 0, 18, 3},
+        {"l_upper_arm", 7, 21, 3},
+        {"l_forearm", 8, 24, 2},
+        {"l_hand", 9, 26, 2},
+        {"r_upper_arm", 7, 28, 3},
+        {"r_forearm", 11, 31, 2},
+        {"r_hand", 12, 33, 2},
+    }};
+    static constexpr auto dofs = joint_tables::concat(joint_tables::kRoot, joint_tables::kLeg, joint_tables::kLeg,
+                                                      joint_tables::kTrunk, joint_tables::kArm, joint_tables::kArm);
+};
+
+/// Full body with an articulated head, for gaze; 15 segments, 38 degrees
+/// of freedom.
+struct FullBodyHeadSkeleton {
+    static constexpr std::array<JointDef, 15> joints{{
+        {"pelvis", -1, 0, 6},
+        {"l_thigh", 0, 6, 3},
+        {"l_shank", 1, 9, 1},
+        {"l_foot", 2, 10, 2},
+        {"r_thigh", 0, 12, 3},
+        {"r_shank", 4, 15, 1},
+        {"r_foot", 5, 16, 2},
+        {"trunk", 0, 18, 3},
+        {"l_upper_arm", 7, 21, 3},
+        {"l_forearm", 8, 24, 2},
+        {"l_hand", 9, 26, 2},
+        {"r_upper_arm", 7, 28, 3},
+        {"r_forearm", 11, 31, 2},
+        {"r_hand", 12, 33, 2},
+        {"head", 7, 35, 3},
+    }};
+    static constexpr auto dofs =
+        joint_tables::concat(joint_tables::kRoot, joint_tables::kLeg, joint_tables::kLeg, joint_tables::kTrunk,
+                             joint_tables::kArm, joint_tables::kArm, joint_tables::kHead);
+};
+
+}  // namespace mm::kinematics
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+
+namespace mm::kinematics {
+
+/// Single-axis degree of freedom, about or along an axis of the segment
+/// frame as left by the segment's previous degrees of freedom.
+enum class DofType : std::uint8_t { rotate_x, rotate_y, rotate_z, translate_x, translate_y, translate_z };
+
+struct Dof {
+    std::string name;
+    int segment = 0;
+    DofType type = DofType::rotate_x;
+    /// Joint limits, radians or metres.
+    double min = -std::numeric_limits<double>::infinity();
+    double max = std::numeric_limits<double>::infinity();
+
+    bool is_rotation() const { return type <= DofType::rotate_z; }
+    int axis() const { return static_cast<int>(type) % 3; }
+};
+
+struct Segment {
+    std::string name;
+    /// Parent segment, or -1 for the root.
+    int parent = -1;
+    /// Joint centre in the parent's frame (in the world for the root).
+    Vec3d offset{};
+    /// Degrees of freedom of the joint, applied in order.
+    std::vector<int> dofs;
+};
+
+/// Marker rigidly attached to a segment.
+struct ModelMarker {
+    std::string name;
+    int segment = 0;
+    /// Position in the segment frame, metres.
+    Vec3d local{};
+    double weight = 1.0;
+};
+
+/// World pose of a segment frame.
+struct SegmentPose {
+    Mat3d rotation = Mat3d::identity();
+    Vec3d origin{};
+};
+
+/// Parametric skeleton: a tree of segments joined by limited single-axis
+/// degrees of freedom, with markers attached to the segments.
+///
+/// Segments are stored parents first (a parent must exist before its
+/// children are added), so forward kinematics is one pass in index order.
+/// The pose vector q holds one value per degree of freedom; q = 0 is the
+/// reference pose in which the segment frames are parallel to the world.
+class SkeletonModel {
+public:
+    /// Adds a segment and returns its index. The first segment is the root
+    /// and must have parent -1; every later one needs an existing parent.
+    /// Throws std::invalid_argument otherwise or for a duplicate name.
+    int add_segment(std::string name, int parent, const Vec3d& offset);
+
+    /// Adds a degree of freedom to `segment`'s joint and returns its index.
+    int add_dof(int segment, DofType type, double min = -std::numeric_limits<double>::infinity(),
+                double max = std::numeric_limits<double>::infinity(), std::string name = {});
+
+    /// Attaches a marker and returns its index. Throws
+    /// std::invalid_argument for an unknown segment or a duplicate name.
+    int add_marker(std::string name, int segment, const Vec3d& local, double weight = 1.0);
+
+    int num_segments() const { return static_cast<int>(segments_.size()); }
+    int num_dofs() const { return static_cast<int>(dofs_.size()); }
+    int num_markers() const { return static_cast<int>(markers_.size()); }
+    const Segment& segment(int index) const { return segments_[index]; }
+    const Dof& dof(int index) const { return dofs_[index]; }
+    const ModelMarker& marker(int index) const { return markers_[index]; }
+    /// Indices by name, or -1.
+    int segment_index(const std::string& name) const;
+    int marker_index(const std::string& name) const;
+
+    /// Degrees of freedom that move `segment`, root first.
+    std::vector<int> chain_dofs(int segment) const;
+
+    /// Reference pose clamped into the joint limits.
+    std::vector<double> neutral_pose() const;
+    void clamp(double* q) const;
+
+    /// World pose of every segment for pose `q`. When given, `dof_axes` and
+    /// `dof_pivots` receive each degree of freedom's world axis and, for
+    /// rotations, the point it turns about (num_dofs() entries each).
+    void forward(const double* q, SegmentPose* poses, Vec3d* dof_axes = nullptr, Vec3d* dof_pivots = nullptr) const;
+
+    Vec3d marker_position(const SegmentPose* poses, int marker) const {
+        const ModelMarker& m = markers_[marker];
+        return poses[m.segment].rotation * m.local + poses[m.segment].origin;
+    }
+
+private:
+    std::vector<Segment> segments_;
+    std::vector<Dof> dofs_;
+    std::vector<ModelMarker> markers_;
+};
+
+}  // namespace mm::kinematics
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/core/trace.hpp"
+#include "motionmetrics/kinematics/ik_solver.hpp"
+#include "motionmetrics/kinematics/static_skeleton.hpp"
+
+namespace mm::kinematics {
+
+/// IkSolver specialised on a compile-time skeleton.
+///
+/// Warm-started frames, the per-frame cost of a trial, run entirely on
+/// fixed-size arrays: forward kinematics is unrolled, and each marker's
+/// Jacobian is accumulated by a function instantiated for its segment,
+/// iterating a constexpr chain with dof indices and types known at compile
+/// time. The normal matrix is factored along the tree, without the fill of
+/// a dense Cholesky. Cold starts are rare and go through the generic solver
+/// on the equivalent SkeletonModel. Results match IkSolver up to rounding.
+template <typename Def>
+class StaticIkSolver {
+public:
+    using Skeleton = StaticSkeleton<Def>;
+    static constexpr int kDofs = Skeleton::kDofs;
+    static constexpr int kSegments = Skeleton::kSegments;
+
+    explicit StaticIkSolver(Skeleton skeleton, IkParams params = {})
+        : skeleton_(std::move(skeleton)), params_(params), cold_(skeleton_.to_model(), params) {
+        residual_.resize(skeleton_.num_markers());
+    }
+
+    const Skeleton& skeleton() const { return skeleton_; }
+    const SkeletonModel& model() const { return cold_.model(); }
+
+    /// As IkSolver::solve.
+    IkResult solve(const float* xyz, double* q, bool warm = true) {
+        if (!warm) return cold_.solve(xyz, q, false);
+        MM_TRACE_SCOPE("ik_solve_static");
+        IkResult result;
+        double weight_sum = 0.0;
+        for (int m = 0; m < skeleton_.num_markers(); ++m) {
+            if (xyz[m * 3] != xyz[m * 3]) continue;
+            ++result.markers_used;
+            weight_sum += skeleton_.marker(m).weight;
+        }
+        if (result.markers_used == 0) {
+            result.rms_error = std::numeric_limits<double>::quiet_NaN();
+            return result;
+        }
+        Skeleton::clamp(q);
+
+        double cost = evaluate(xyz, q);
+        double lambda = params_.damping;
+        for (int it = 0; it < params_.max_iterations && !result.converged; ++it) {
+            result.iterations = it + 1;
+            normal_.fill(0.0);
+            gradient_.fill(0.0);
+            for (int m = 0; m < skeleton_.num_markers(); ++m)
+                if (xyz[m * 3] == xyz[m * 3]) kAccumulate[skeleton_.marker(m).segment](*this, m);
+
+            const auto factor_damped = [&](double damping) {
+                factor_ = normal_;
+                for (int d = 0; d < kDofs; ++d)
+                    factor_[d * kDofs + d] = normal_[d * kDofs + d] * (1.0 + damping) + detail::kRegularisation;
+                return factor(std::make_integer_sequence<int, kDofs>{});
+            };
+            const auto solve = [&] {
+                step_ = gradient_;
+                substitute(std::make_integer_sequence<int, kDofs>{});
+            };
+            if (!detail::damped_step(
+                    kDofs, q, trial_.data(), step_.data(), params_.tolerance, lambda, cost, result.converged,
+                    factor_damped, solve, [](double* pose) { Skeleton::clamp(pose); },
+                    [&](const double* pose) { return evaluate(xyz, pose); }))
+                break;
+        }
+        result.rms_error = std::sqrt(cost / weight_sum);
+        return result;
+    }
+
+    /// As IkSolver::solve_trial.
+    IkTrial solve_trial(const trajectory::TrajectorySet& trial, WorkStealingPool* pool = nullptr) const {
+        MM_TRACE_SCOPE("ik_solve_trial_static");
+        return detail::solve_trial(*this, model(), params_, trial, pool);
+    }
+
+private:
+    using AccumulateFn = void (*)(StaticIkSolver&, int);
+
+    double evaluate(const float* xyz, const double* q) {
+        skeleton_.forward(q, poses_.data(), axes_.data(), pivots_.data());
+        double cost = 0.0;
+        for (int m = 0; m < skeleton_.num_markers(); ++m) {
+            const float* z = xyz + m * 3;
+            if (z[0] != z[0]) continue;
+            residual_[m] = Vec3d{z[0], z[1], z[2]} - skeleton_.marker_position(poses_.data(), m);
+            cost += skeleton_.marker(m).weight * dot(residual_[m], residual_[m]);
+        }
+        return cost;
+    }
+
+    /// Adds marker `m` (on segment S) to the normal equations. Chains list
+    /// dofs in increasing order, so every entry lands in the lower triangle.
+    template <int S>
+    static void accumulate(StaticIkSolver& self, int m) {
+        static constexpr auto chain = Skeleton::template chain<S>();
+        const double w = self.skeleton_.marker(m).weight;
+        const Vec3d p = self.skeleton_.marker_position(self.poses_.data(), m);
+        const Vec3d& r = self.residual_[m];
+        std::array<Vec3d, chain.size()> columns;
+        for (std::size_t a = 0; a < chain.size(); ++a) {
+            const int d = chain[a];
+            columns[a] = Def::dofs[d].type <= DofType::rotate_z ? cross(self.axes_[d], p - self.pivots_[d])
+                                                                 : self.axes_[d];
+            self.gradient_[d] += w * dot(columns[a], r);
+            for (std::size_t b = 0; b <= a; ++b) self.normal_[d * kDofs + chain[b]] += w * dot(columns[a], columns[b]);
+        }
+    }
+
+    template <int... S>
+    static constexpr std::array<AccumulateFn, kSegments> accumulate_table(std::integer_sequence<int, S...>) {
+        return {{&accumulate<S>...}};
+    }
+    static constexpr std::array<AccumulateFn, kSegments> kAccumulate =
+        accumulate_table(std::make_integer_sequence<int, kSegments>{});
+
+    /// Degrees of freedom that move dof D's segment and precede D, i.e.
+    /// the only ones D couples with in the normal matrix, root first.
+    template <int D>
+    static constexpr auto ancestors() {
+        constexpr int segment = segment_of(D);
+        constexpr auto chain = Skeleton::template chain<segment>();
+        constexpr int count = chain_position(chain, D);
+        std::array<int, count> out{};
+        for (int a = 0; a < count; ++a) out[a] = chain[a];
+        return out;
+    }
+    static constexpr int segment_of(int d) {
+        int s = 0;
+        while (Def::joints[s].first_dof + Def::joints[s].num_dofs <= d) ++s;
+        return s;
+    }
+    template <std::size_t N>
+    static constexpr int chain_position(const std::array<int, N>& chain, int d) {
+        int a = 0;
+        while (chain[a] != d) ++a;
+        return a;
+    }
+
+    /// Factors `factor_` as L^T L, eliminating dofs from the last to the
+    /// first. Children come after their ancestors, so eliminating a dof only
+    /// updates entries among its own ancestors, which are already nonzero:
+    /// the tree structure is kept and the cost is the sum of squared chain
+    /// lengths rather than kDofs^3.
+    template <int... I>
+    bool factor(std::integer_sequence<int, I...>) {
+        return (... && factor_step<kDofs - 1 - I>());
+    }
+    template <int K>
+    bool factor_step() {
+        static constexpr auto up = ancestors<K>();
+        double* h = factor_.data();
+        double d = h[K * kDofs + K];
+        if (!(d > 0.0)) return false;
+        d = std::sqrt(d);
+        h[K * kDofs + K] = d;
+        for (std::size_t a = 0; a < up.size(); ++a) h[K * kDofs + up[a]] /= d;
+        for (std::size_t a = 0; a < up.size(); ++a)
+            for (std::size_t b = 0; b <= a; ++b) h[up[a] * kDofs + up[b]] -= h[K * kDofs + up[a]] * h[K * kDofs + up[b]];
+        return true;
+    }
+
+    /// Solves L^T L x = step_ in place.
+    template <int... I>
+    void substitute(std::integer_sequence<int, I...>) {
+        (back_step<kDofs - 1 - I>(), ...);
+        (forward_step<I>(), ...);
+    }
+    template <int K>
+    void back_step() {
+        static constexpr auto up = ancestors<K>();
+        step_[K] /= factor_[K * kDofs + K];
+        for (std::size_t a = 0; a < up.size(); ++a) step_[up[a]] -= factor_[K * kDofs + up[a]] * step_[K];
+    }
+    template <int K>
+    void forward_step() {
+        static constexpr auto up = ancestors<K>();
+        for (std::size_t a = 0; a < up.size(); ++a) step_[K] -= factor_[K * kDofs + up[a]] * step_[up[a]];
+        step_[K] /= factor_[K * kDofs + K];
+    }
+
+    Skeleton skeleton_;
+    IkParams params_;
+    IkSolver cold_;
+
+    std::array<SegmentPose, kSegments> poses_;
+    std::array<Vec3d, kDofs> axes_;
+    std::array<Vec3d, kDofs> pivots_;
+    std::vector<Vec3d> residual_;  // per marker, sized once
+    std::array<double, kDofs * kDofs> normal_;
+    std::array<double, kDofs * kDofs> factor_;
+    std::array<double, kDofs> gradient_;
+    std::array<double, kDofs> step_;
+    std::array<double, kDofs> trial_;
+};
+
+}  // namespace mm::kinematics
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/kinematics/skeleton_model.hpp"
+
+namespace mm::kinematics {
+
+/// Degree of freedom in a compile-time joint table.
+struct JointDof {
+    DofType type = DofType::rotate_x;
+    double min = -std::numeric_limits<double>::infinity();
+    double max = std::numeric_limits<double>::infinity();
+};
+
+/// Segment in a compile-time joint table; its degrees of freedom are
+/// dofs[first_dof, first_dof + num_dofs).
+struct JointDef {
+    const char* segment = "";
+    int parent = -1;
+    int first_dof = 0;
+    int num_dofs = 0;
+};
+
+/// Skeleton whose topology is fixed at build time.
+///
+/// `Def` supplies `static constexpr std::array<JointDef, S> joints` (parents
+/// first) and `static constexpr std::array<JointDof, D> dofs` (grouped by
+/// segment, in segment order). Segment offsets and markers stay runtime
+/// values, since they are measured per subject. Forward kinematics is
+/// expanded per segment and per degree of freedom, with the axis of each
+/// rotation known at compile time, and every chain is a constexpr table,
+/// so nothing is looked up or allocated per call. Semantics match
+/// SkeletonModel, which `to_model()` produces for the generic code paths.
+template <typename Def>
+class StaticSkeleton {
+public:
+    static constexpr int kSegments = static_cast<int>(Def::joints.size());
+    static constexpr int kDofs = static_cast<int>(Def::dofs.size());
+
+    static constexpr bool valid_table() {
+        int next_dof = 0;
+        for (int s = 0; s < kSegments; ++s) {
+            const JointDef& j = Def::joints[s];
+            if (s == 0 ? j.parent != -1 : (j.parent < 0 || j.parent >= s)) return false;
+            if (j.first_dof != next_dof || j.num_dofs < 0) return false;
+            next_dof += j.num_dofs;
+        }
+        for (int d = 0; d < kDofs; ++d)
+            if (!(Def::dofs[d].min <= Def::dofs[d].max)) return false;
+        return next_dof == kDofs;
+    }
+    static_assert(kSegments > 0 && valid_table(), "joint table must list parents first and cover every dof in order");
+
+    /// Number of degrees of freedom moving segment `s`.
+    static constexpr int chain_length(int s) {
+        int n = 0;
+        for (; s >= 0; s = Def::joints[s].parent) n += Def::joints[s].num_dofs;
+        return n;
+    }
+
+    /// Degrees of freedom moving segment `S`, root first.
+    template <int S>
+    static constexpr std::array<int, chain_length(S)> chain() {
+        std::array<int, chain_length(S)> out{};
+        int at = chain_length(S);
+        for (int s = S; s >= 0; s = Def::joints[s].parent)
+            for (int k = Def::joints[s].num_dofs - 1; k >= 0; --k) out[--at] = Def::joints[s].first_dof + k;
+        return out;
+    }
+
+    /// `offsets[s]` is segment s's joint centre in its parent's frame.
+    explicit StaticSkeleton(const std::array<Vec3d, kSegments>& offsets) : offsets_(offsets) {}
+
+    /// Attaches a marker and returns its index.
+    int add_marker(std::string name, int segment, const Vec3d& local, double weight = 1.0) {
+        if (segment < 0 || segment >= kSegments) throw std::invalid_argument("StaticSkeleton: unknown segment");
+        if (!(weight > 0.0)) throw std::invalid_argument("StaticSkeleton: marker weight must be positive");
+        for (const ModelMarker& m : markers_)
+            if (m.name == name) throw std::invalid_argument("StaticSkeleton: duplicate marker " + name);
+        markers_.push_back({std::move(name), segment, local, weight});
+        return num_markers() - 1;
+    }
+
+    static constexpr int segment_index(const char* name) {
+        for (int s = 0; s < kSegments; ++s) {
+            const char* a = Def::joints[s].segment;
+            const char* b = name;
+            while (*a && *a == *b) {
+                ++a;
+                ++b;
+            }
+            if (*a == *b) return s;
+        }
+        return -1;
+    }
+
+    int num_markers() const { return static_cast<int>(markers_.size()); }
+    const ModelMarker& marker(int index) const { return markers_[index]; }
+    const std::array<Vec3d, kSegments>& offsets() const { return offsets_; }
+
+    static void clamp(double* q) {
+        for (int d = 0; d < kDofs; ++d) {
+            if (q[d] < Def::dofs[d].min) q[d] = Def::dofs[d].min;
+            if (q[d] > Def::dofs[d].max) q[d] = Def::dofs[d].max;
+        }
+    }
+
+    /// As SkeletonModel::forward.
+    void forward(const double* q, SegmentPose* poses, Vec3d* dof_axes = nullptr, Vec3d* dof_pivots = nullptr) const {
+        forward_segments(q, poses, dof_axes, dof_pivots, std::make_integer_sequence<int, kSegments>{});
+    }
+
+    Vec3d marker_position(const SegmentPose* poses, int marker) const {
+        const ModelMarker& m = markers_[marker];
+        return poses[m.segment].rotation * m.local + poses[m.segment].origin;
+    }
+
+    /// Equivalent runtime model, with the same segment, dof and marker
+    /// indices.
+    SkeletonModel to_model() const {
+        SkeletonModel model;
+        for (int s = 0; s < kSegments; ++s) {
+            const JointDef& j = Def::joints[s];
+            model.add_segment(j.segment, j.parent, offsets_[s]);
+            for (int k = 0; k < j.num_dofs; ++k) {
+                const JointDof& d = Def::dofs[j.first_dof + k];
+                model.add_dof(s, d.type, d.min, d.max);
+            }
+        }
+        for (const ModelMarker& m : markers_) model.add_marker(m.name, m.segment, m.local, m.weight);
+        return model;
+    }
+
+private:
+    template <int... S>
+    void forward_segments(const double* q, SegmentPose* poses, Vec3d* axes, Vec3d* pivots,
+                          std::integer_sequence<int, S...>) const {
+        (forward_segment<S>(q, poses, axes, pivots, std::make_integer_sequence<int, Def::joints[S].num_dofs>{}), ...);
+    }
+
+    template <int S, int... K>
+    void forward_segment(const double* q, SegmentPose* poses, Vec3d* axes, Vec3d* pivots,
+                         std::integer_sequence<int, K...>) const {
+        constexpr int parent = Def::joints[S].parent;
+        SegmentPose pose;
+        if constexpr (parent >= 0) {
+            pose.rotation = poses[parent].rotation;
+            pose.origin = poses[parent].origin + poses[parent].rotation * offsets_[S];
+        } else {
+            pose.origin = offsets_[S];
+        }
+        (apply_dof<Def::joints[S].first_dof + K>(q, pose, axes, pivots), ...);
+        poses[S] = pose;
+    }
+
+    template <int D>
+    static void apply_dof(const double* q, SegmentPose& pose, Vec3d* axes, Vec3d* pivots) {
+        constexpr DofType type = Def::dofs[D].type;
+        constexpr int k = static_cast<int>(type) % 3;
+        Mat3d& r = pose.rotation;
+        if (axes) axes[D] = r.col(k);
+        if (pivots) pivots[D] = pose.origin;
+        if constexpr (type <= DofType::rotate_z) {
+            // Right-multiplying by a rotation about local axis k mixes only
+            // the other two columns.
+            constexpr int i = (k + 1) % 3;
+            constexpr int j = (k + 2) % 3;
+            const double c = std::cos(q[D]);
+            const double s = std::sin(q[D]);
+            for (int row = 0; row < 3; ++row) {
+                const double a = r(row, i);
+                const double b = r(row, j);
+                r(row, i) = c * a + s * b;
+                r(row, j) = c * b - s * a;
+            }
+        } else {
+            pose.origin += r.col(k) * q[D];
+        }
+    }
+
+    std::array<Vec3d, kSegments> offsets_;
+    std::vector<ModelMarker> markers_;
+};
+
+}  // namespace mm::kinematics
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+namespace mm::labeling {
+
+/// Dense minimum-cost assignment (Hungarian method with row and column
+/// potentials, O(rows^2 * cols)). Keeps its work arrays between calls, so
+/// solving many small problems per frame does not allocate.
+class AssignmentSolver {
+public:
+    /// Assigns every row of the row-major `rows` x `cols` matrix `cost`
+    /// (rows <= cols) to a distinct column, minimising the total cost.
+    /// Writes the column of each row to `row_to_col` and returns the total.
+    double solve(const double* cost, int rows, int cols, std::vector<int>& row_to_col);
+
+private:
+    std::vector<double> u_;
+    std::vector<double> v_;
+    std::vector<double> min_slack_;
+    std::vector<int> match_;
+    std::vector<int> way_;
+    std::vector<char> used_;
+};
+
+}  // namespace mm::labeling
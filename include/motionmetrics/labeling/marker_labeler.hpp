@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/types.hpp"
+#include "motionmetrics/labeling/assignment.hpp"
+#include "motionmetrics/labeling/skeleton_template.hpp"
+#include "motionmetrics/reconstruction/triangulation.hpp"
+
+namespace mm::labeling {
+
+struct MarkerLabelerParams {
+    /// Search radius around a marker's predicted position, metres.
+    double gate = 0.03;
+    /// Radius added per frame a marker has gone unlabelled, metres.
+    double gate_growth = 0.01;
+    /// Frames a marker may go unlabelled before it loses its prediction and
+    /// can only be recovered through its segment constraints.
+    int max_missed = 10;
+    /// A frame with fewer labels than this after the warm start and
+    /// recovery is relabelled from scratch against the template.
+    int min_labelled = 3;
+    /// Seed triangles evaluated per cold start.
+    int max_seeds = 512;
+    /// Largest RMS residual, metres, of a cold-start hypothesis's rigid fit
+    /// to the rest pose. Components spanning several segments are not rigid
+    /// and need a larger value.
+    double max_fit_residual = 0.02;
+    /// Fewest markers a cold-start hypothesis must label (capped at the size
+    /// of its component). Three only asks for a matching triangle, which
+    /// ghost points readily provide.
+    int min_support = 4;
+    /// Frames a component waits after a cold start found no acceptable
+    /// hypothesis for it before it is tried again.
+    int cold_start_retry_frames = 10;
+};
+
+/// Labels of one frame.
+struct LabelingResult {
+    /// Point index of each template marker, or -1.
+    std::vector<int> point_of_marker;
+    /// Template marker of each input point, or -1 for unlabelled points.
+    std::vector<int> marker_of_point;
+    int labelled = 0;
+    /// Labels dropped by the segment-length check this frame.
+    int rejected = 0;
+    bool cold_start = false;
+};
+
+struct MarkerLabelerStats {
+    std::uint64_t frames = 0;
+    std::uint64_t cold_starts = 0;
+    /// Components a cold start left unlabelled because no hypothesis passed
+    /// the residual and support checks.
+    std::uint64_t cold_start_failures = 0;
+    /// Labels carried over from the previous frame by the gated assignment.
+    std::uint64_t warm_labels = 0;
+    /// Labels found through segment constraints from labelled neighbours.
+    std::uint64_t recovered_labels = 0;
+    std::uint64_t rejected_labels = 0;
+    /// Ambiguous gate clusters that needed a Hungarian solve.
+    std::uint64_t assignment_problems = 0;
+};
+
+/// Assigns template marker names to unlabelled 3D points, frame by frame.
+///
+/// Warm start: every marker labelled recently predicts its position with a
+/// constant-velocity model, and points are gathered from a hash grid within
+/// its gate. The marker/point candidate graph splits into connected
+/// clusters; isolated pairs are taken directly and only clusters with a
+/// real conflict go through a Hungarian solve (with a per-marker "missing"
+/// column), so the steady-state cost is close to linear in the marker count.
+/// Every label is then checked against the segment-length constraints,
+/// repeatedly dropping the marker involved in the most violations. Markers
+/// still missing are recovered from unassigned points that satisfy the
+/// lengths to their labelled neighbours.
+///
+/// Cold start (first frame, too few labels, or a constraint component with
+/// no label left): point triples matching a constraint triangle of the
+/// template seed hypotheses, each grown over the segment graph. Per
+/// component, the hypothesis labelling the most markers wins; ties go to the
+/// smallest rigid-fit residual against the rest pose, which also separates
+/// mirror-image (left/right swapped) labellings. Hypotheses with too few
+/// markers or too large a residual are rejected, so a hidden segment is not
+/// labelled on ghost points; a component with no acceptable hypothesis is
+/// retried after `cold_start_retry_frames`.
+class MarkerLabeler {
+public:
+    /// Throws std::invalid_argument if the template has no constraint
+    /// triangle to seed a cold start from or a parameter is out of range.
+    explicit MarkerLabeler(SkeletonTemplate skeleton, MarkerLabelerParams params = {});
+
+    const SkeletonTemplate& skeleton() const { return skeleton_; }
+
+    /// Labels `points` (NaN coordinates are ignored) captured at
+    /// `timestamp`. The returned reference stays valid until the next call.
+    const LabelingResult& label(const std::vector<Vec3d>& points, TimestampNs timestamp);
+    const LabelingResult& label(const reconstruction::TriangulatedPoints& points, TimestampNs timestamp);
+
+    /// Writes the labelled positions of the last frame in marker order as
+    /// x, y, z triples (NaN for unlabelled markers), the layout
+    /// SessionWriter::append expects.
+    void gather(float* xyz) const;
+
+    const MarkerLabelerStats& stats() const { return stats_; }
+    /// Forgets all marker history and statistics; the next frame is a cold
+    /// start.
+    void reset();
+
+private:
+    struct Track {
+        Vec3d position{};
+        Vec3d velocity{};
+        TimestampNs last_seen = 0;
+        int missed = 0;
+        bool active = false;
+    };
+
+    /// Uniform hash grid over the valid points, stored sorted by cell key.
+    struct PointGrid {
+        double cell = 1.0;
+        std::vector<std::pair<std::uint64_t, int>> entries;  // cell key, point
+
+        void build(const std::vector<Vec3d>& points, double cell_size);
+        /// Calls fn(index) for every point in the cells within `radius` of p.
+        template <typename Fn>
+        void for_each_near(const Vec3d& p, double radius, Fn&& fn) const;
+    };
+
+    void warm_start(TimestampNs timestamp);
+    void solve_cluster();
+    void enforce_segments();
+    /// Grows the labelling outwards from the markers in `queue`.
+    void propagate(std::vector<int>& queue, bool record);
+    bool try_recover(int marker);
+    /// Relabels every constraint component from scratch (`all`), or only
+    /// those with no label left.
+    void cold_start(bool all);
+    double rigid_residual(int component);
+    void clear_labels();
+    void assign(int marker, int point);
+    void unassign(int marker);
+    void update_tracks(TimestampNs timestamp);
+
+    SkeletonTemplate skeleton_;
+    MarkerLabelerParams params_;
+    /// Segment constraints touching each marker, CSR.
+    std::vector<int> adjacency_start_;
+    std::vector<int> adjacency_;
+    /// Constraint index for each marker pair, or -1.
+    std::vector<int> pair_segment_;
+    /// Connected component of each marker in the constraint graph.
+    std::vector<int> component_;
+    std::vector<int> component_size_;
+    int num_components_ = 0;
+    /// Frame count from which each component may be cold started again.
+    std::vector<std::uint64_t> retry_after_;
+    std::vector<std::array<int, 3>> triangles_;
+
+    std::vector<Track> tracks_;
+    const std::vector<Vec3d>* points_ = nullptr;
+    std::vector<Vec3d> point_scratch_;
+    LabelingResult result_;
+    PointGrid grid_;
+    AssignmentSolver solver_;
+
+    std::vector<Vec3d> predicted_;
+    std::vector<double> radius_;
+    std::vector<double> residual_;
+    std::vector<std::array<int, 3>> edges_;  // cluster root, marker, point
+    std::vector<int> parent_;
+    std::vector<int> cluster_markers_;
+    std::vector<int> cluster_points_;
+    std::vector<double> cost_;
+    std::vector<int> row_to_col_;
+    std::vector<int> violations_;
+    std::vector<int> queue_;
+    std::vector<int> component_labels_;
+    std::vector<int> snapshot_markers_;
+    std::vector<int> snapshot_points_;
+    std::vector<int> best_labels_;
+    std::vector<Vec3d> fit_from_;
+    std::vector<Vec3d> fit_to_;
+
+    MarkerLabelerStats stats_;
+};
+
+}  // namespace mm::labeling
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+
+namespace mm::labeling {
+
+/// Two markers on the same body segment, whose distance stays within
+/// `tolerance` of `length` (metres) in every pose.
+struct SegmentConstraint {
+    int a = 0;
+    int b = 0;
+    double length = 0.0;
+    double tolerance = 0.0;
+};
+
+/// Named marker set with rest positions and segment-length constraints.
+///
+/// Rest positions describe a neutral pose in any body-fixed frame; they seed
+/// the segment lengths and break left/right symmetry during a cold start.
+/// Markers on one rigid segment should be connected pairwise, since the
+/// labeler seeds cold starts from constraint triangles.
+class SkeletonTemplate {
+public:
+    /// Adds a marker and returns its index. Throws std::invalid_argument for
+    /// a duplicate name.
+    int add_marker(std::string name, const Vec3d& rest_position);
+
+    /// Constrains the distance between two markers to its rest length
+    /// within `tolerance`. Throws std::invalid_argument for unknown names.
+    void connect(const std::string& a, const std::string& b, double tolerance = 0.015);
+    void connect(int a, int b, double tolerance = 0.015);
+
+    /// Replaces segment lengths with those measured in a labelled static
+    /// trial (`positions` in marker order); constraints with a NaN endpoint
+    /// keep their length.
+    void calibrate(const std::vector<Vec3d>& positions);
+
+    int num_markers() const { return static_cast<int>(names_.size()); }
+    const std::vector<std::string>& names() const { return names_; }
+    const std::string& name(int marker) const { return names_[marker]; }
+    /// Index of the named marker, or -1.
+    int marker_index(const std::string& name) const;
+    const Vec3d& rest_position(int marker) const { return rest_[marker]; }
+    const std::vector<SegmentConstraint>& segments() const { return segments_; }
+
+private:
+    std::vector<std::string> names_;
+    std::vector<Vec3d> rest_;
+    std::vector<SegmentConstraint> segments_;
+};
+
+}  // namespace mm::labeling
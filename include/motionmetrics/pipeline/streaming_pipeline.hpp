@@ -0,0 +1,239 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/core/clock.hpp"
+#include "motionmetrics/core/latency_histogram.hpp"
+#include "motionmetrics/core/spsc_queue.hpp"
+#include "motionmetrics/core/thread_affinity.hpp"
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::pipeline {
+
+struct PipelineConfig {
+    /// Slots in each inter-stage queue. Small queues keep latency bounded: a
+    /// full queue stalls the stage feeding it rather than letting work pile
+    /// up, and the stall propagates back to `submit`, which sheds the frame.
+    int queue_capacity = 4;
+    /// Optional CPU for each stage thread, by stage index; -1 leaves a stage
+    /// unpinned.
+    std::vector<int> stage_cpus;
+    /// Items whose capture-to-completion latency exceeds this are counted as
+    /// over budget by every stage they pass.
+    std::int64_t latency_budget_ns = 50'000'000;
+};
+
+struct StageStats {
+    std::string name;
+    std::uint64_t processed = 0;
+    /// Items the stage dropped by returning false (or throwing).
+    std::uint64_t discarded = 0;
+    /// Items that had to wait for room in the next stage's queue.
+    std::uint64_t stalled = 0;
+    std::uint64_t over_budget = 0;
+    /// Latency from capture to the end of this stage; the last stage's is
+    /// the end-to-end latency.
+    LatencySummary latency;
+};
+
+struct PipelineStats {
+    std::uint64_t submitted = 0;
+    /// Frames refused by `submit` because the first stage was saturated.
+    std::uint64_t shed = 0;
+    std::vector<StageStats> stages;
+};
+
+/// Real-time pipeline with one thread per stage.
+///
+/// Stages are linked by bounded lock-free SPSC queues and run in the order
+/// they were added, e.g. tracking -> reconstruction -> skeleton -> render,
+/// with capture calling `submit` from its own thread. Each item carries its
+/// capture time on the host monotonic clock (`steady_now_ns`), and every
+/// stage records how long after capture it finished with it. Back-pressure
+/// is applied by blocking inside the pipeline and shedding at the source, so
+/// queueing delay never exceeds `queue_capacity` items per stage. With
+/// tracing enabled, each stage call is recorded under the stage name and
+/// tagged with the item's submission number.
+///
+/// `T` must be default-constructible and movable. A stage returns false to
+/// drop an item (for example an empty frame set).
+template <typename T>
+class StreamingPipeline {
+public:
+    using StageFn = std::function<bool(T&)>;
+
+    explicit StreamingPipeline(PipelineConfig config = {}) : config_(std::move(config)) {
+        if (config_.queue_capacity <= 0) throw std::invalid_argument("StreamingPipeline: queue_capacity must be positive");
+    }
+
+    ~StreamingPipeline() {
+        try {
+            stop();
+        } catch (...) {
+        }
+    }
+
+    StreamingPipeline(const StreamingPipeline&) = delete;
+    StreamingPipeline& operator=(const StreamingPipeline&) = delete;
+
+    void add_stage(std::string name, StageFn fn) {
+        if (running_) throw std::logic_error("StreamingPipeline: add_stage while running");
+        auto stage = std::make_unique<Stage>();
+        stage->name = std::move(name);
+        stage->trace_name = trace_intern(stage->name);
+        stage->fn = std::move(fn);
+        stage->input = std::make_unique<SpscQueue<Envelope>>(static_cast<std::size_t>(config_.queue_capacity));
+        stages_.push_back(std::move(stage));
+    }
+
+    void start() {
+        if (running_) return;
+        if (stages_.empty()) throw std::logic_error("StreamingPipeline: no stages");
+        error_ = nullptr;
+        for (auto& stage : stages_) stage->upstream_done.store(false, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < stages_.size(); ++i)
+            stages_[i]->thread = std::thread([this, i] { run_stage(static_cast<int>(i)); });
+        running_ = true;
+    }
+
+    /// Hands a captured item to the first stage. Must be called from a
+    /// single producer thread. Returns false (and drops the item) if the
+    /// first stage's queue is full.
+    bool submit(T item, std::int64_t capture_ns) {
+        if (!running_) throw std::logic_error("StreamingPipeline: submit before start");
+        const auto sequence = static_cast<std::int64_t>(submitted_.fetch_add(1, std::memory_order_relaxed));
+        Envelope env{std::move(item), capture_ns, sequence};
+        if (stages_.front()->input->try_push(std::move(env))) return true;
+        shed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /// Drains the items already submitted, joins the stage threads and
+    /// rethrows the first exception a stage raised, if any.
+    void stop() {
+        if (!running_) return;
+        stages_.front()->upstream_done.store(true, std::memory_order_release);
+        for (auto& stage : stages_) stage->thread.join();
+        running_ = false;
+        if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+    bool running() const { return running_; }
+
+    /// Safe to call while running.
+    PipelineStats stats() const {
+        PipelineStats out;
+        out.submitted = submitted_.load(std::memory_order_relaxed);
+        out.shed = shed_.load(std::memory_order_relaxed);
+        for (const auto& stage : stages_) {
+            StageStats s;
+            s.name = stage->name;
+            s.processed = stage->processed.load(std::memory_order_relaxed);
+            s.discarded = stage->discarded.load(std::memory_order_relaxed);
+            s.stalled = stage->stalled.load(std::memory_order_relaxed);
+            s.over_budget = stage->over_budget.load(std::memory_order_relaxed);
+            s.latency = stage->latency.summary();
+            out.stages.push_back(std::move(s));
+        }
+        return out;
+    }
+
+    void reset_stats() {
+        submitted_.store(0, std::memory_order_relaxed);
+        shed_.store(0, std::memory_order_relaxed);
+        for (auto& stage : stages_) {
+            stage->processed.store(0, std::memory_order_relaxed);
+            stage->discarded.store(0, std::memory_order_relaxed);
+            stage->stalled.store(0, std::memory_order_relaxed);
+            stage->over_budget.store(0, std::memory_order_relaxed);
+            stage->latency.reset();
+        }
+    }
+
+private:
+    struct Envelope {
+        T item{};
+        std::int64_t capture_ns = 0;
+        std::int64_t sequence = 0;  // submission order, tags trace events
+    };
+
+    struct Stage {
+        std::string name;
+        const char* trace_name = nullptr;
+        StageFn fn;
+        std::unique_ptr<SpscQueue<Envelope>> input;
+        std::atomic<bool> upstream_done{false};
+        std::atomic<std::uint64_t> processed{0};
+        std::atomic<std::uint64_t> discarded{0};
+        std::atomic<std::uint64_t> stalled{0};
+        std::atomic<std::uint64_t> over_budget{0};
+        LatencyHistogram latency;
+        std::thread thread;
+    };
+
+    void run_stage(int index) {
+        Stage& stage = *stages_[index];
+        Stage* next = index + 1 < static_cast<int>(stages_.size()) ? stages_[index + 1].get() : nullptr;
+        if (index < static_cast<int>(config_.stage_cpus.size()) && config_.stage_cpus[index] >= 0)
+            pin_current_thread(config_.stage_cpus[index]);
+        set_current_thread_name("mm-" + stage.name);
+
+        Envelope env;
+        Backoff idle;
+        for (;;) {
+            if (!stage.input->try_pop(env)) {
+                // Check the flag before re-checking the queue: anything pushed
+                // before upstream finished is then guaranteed to be seen.
+                if (stage.upstream_done.load(std::memory_order_acquire) && stage.input->empty()) break;
+                idle.pause();
+                continue;
+            }
+            idle.reset();
+
+            bool keep = false;
+            try {
+                MM_TRACE_SCOPE_FRAME(stage.trace_name, env.sequence);
+                keep = stage.fn(env.item);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                if (!error_) error_ = std::current_exception();
+            }
+            if (!keep) {
+                stage.discarded.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            const std::int64_t latency = steady_now_ns() - env.capture_ns;
+            stage.latency.record(latency);
+            if (latency > config_.latency_budget_ns) stage.over_budget.fetch_add(1, std::memory_order_relaxed);
+            stage.processed.fetch_add(1, std::memory_order_relaxed);
+
+            if (next != nullptr && !next->input->try_push(std::move(env))) {
+                stage.stalled.fetch_add(1, std::memory_order_relaxed);
+                Backoff full;
+                while (!next->input->try_push(std::move(env))) full.pause();
+            }
+        }
+        if (next != nullptr) next->upstream_done.store(true, std::memory_order_release);
+    }
+
+    PipelineConfig config_;
+    std::vector<std::unique_ptr<Stage>> stages_;
+    bool running_ = false;
+    std::atomic<std::uint64_t> submitted_{0};
+    std::atomic<std::uint64_t> shed_{0};
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
+
+}  // namespace mm::pipeline
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/reconstruction/triangulation.hpp"
+
+namespace mm::reconstruction {
+
+/// Fundamental matrix F with x_b^T F x_a = 0 for points imaged by
+/// projections `a` and `b`.
+Mat3d fundamental_from_projections(const Mat34d& a, const Mat34d& b);
+
+struct CorrespondenceParams {
+    /// Maximum point-to-epipolar-line distance for a pair hypothesis, px.
+    double epipolar_tolerance_px = 2.0;
+    /// Maximum reprojection error for a view to support a marker, px.
+    double reprojection_tolerance_px = 3.0;
+    /// Views required before a marker is reported.
+    int min_views = 3;
+    /// Anchor points per scheduler task before it is split further.
+    int grain = 8;
+};
+
+/// Matched markers of one frame set.
+struct CorrespondenceResult {
+    int num_cameras = 0;
+    /// Markers x cameras, row-major: index of the 2D point of each camera
+    /// that belongs to the marker, or -1.
+    std::vector<int> assignment;
+    TriangulatedPoints points;
+
+    int size() const { return num_cameras == 0 ? 0 : static_cast<int>(assignment.size()) / num_cameras; }
+    int point_index(int marker, int camera) const { return assignment[marker * num_cameras + camera]; }
+};
+
+struct CorrespondenceStats {
+    std::uint64_t pair_hypotheses = 0;
+    std::uint64_t candidates = 0;
+};
+
+/// Solves which 2D point in each camera belongs to which 3D marker.
+///
+/// Each camera's points are bucketed into a uniform grid. For every anchor
+/// point in camera a and every later camera b, only the grid cells crossed
+/// by the epipolar band F_ab x_a are visited, which keeps pair generation
+/// close to linear in the number of points even for dense marker clusters.
+/// Each pair is triangulated and reprojected into the remaining cameras to
+/// collect support. Anchors are processed in parallel on a work-stealing
+/// pool, since their cost varies wildly with local marker density; the
+/// surviving candidates are then accepted greedily by view count and
+/// residual so that every 2D point is used at most once, and the final
+/// positions come from one batched triangulation.
+class CorrespondenceSolver {
+public:
+    /// `pool` may be null to run on the calling thread only.
+    explicit CorrespondenceSolver(std::vector<Mat34d> projections, CorrespondenceParams params = {},
+                                  WorkStealingPool* pool = nullptr);
+
+    int num_cameras() const { return static_cast<int>(projections_.size()); }
+
+    /// `points[c]` holds the (undistorted) 2D marker centroids of camera c.
+    void solve(const std::vector<std::vector<Vec2d>>& points, CorrespondenceResult& out);
+
+    const CorrespondenceStats& stats() const { return stats_; }
+
+private:
+    /// Uniform bucket grid over one camera's points, stored CSR.
+    struct PointGrid {
+        const std::vector<Vec2d>* points = nullptr;
+        double x0 = 0.0;
+        double y0 = 0.0;
+        double cell = 1.0;
+        int cols = 0;
+        int rows = 0;
+        std::vector<int> cell_start;
+        std::vector<int> items;
+
+        void build(const std::vector<Vec2d>& pts, double cell_size);
+        /// Calls fn(index) for points within `tol` of the line ax + by + c = 0
+        /// (a^2 + b^2 = 1).
+        template <typename Fn>
+        void for_each_near_line(double a, double b, double c, double tol, Fn&& fn) const;
+        /// Closest point within `radius` of p, or -1.
+        int nearest(const Vec2d& p, double radius) const;
+    };
+
+    struct Candidate {
+        double residual;
+        int views;
+        int anchor;
+        int offset;  // into the anchor's member list, num_cameras entries
+    };
+
+    struct AnchorOutput {
+        std::vector<Candidate> candidates;
+        std::vector<int> members;
+        std::uint64_t pairs = 0;
+    };
+
+    struct Scratch {
+        std::vector<int> members;
+        std::vector<const Mat34d*> projections;
+        std::vector<Vec2d> observations;
+    };
+
+    void process_anchor(int anchor, const std::vector<std::vector<Vec2d>>& points);
+    bool refine(const std::vector<std::vector<Vec2d>>& points, Scratch& scratch, Vec3d& x, double& residual,
+                int& views) const;
+
+    std::vector<Mat34d> projections_;
+    std::vector<Mat3d> fundamentals_;  // [a * num_cameras + b]
+    CorrespondenceParams params_;
+    WorkStealingPool* pool_;
+    BatchTriangulator triangulator_;
+    ObservationBatch batch_;
+
+    std::vector<PointGrid> grids_;
+    std::vector<int> anchor_camera_start_;
+    std::vector<AnchorOutput> anchors_;
+    std::vector<Scratch> scratch_;
+    std::vector<Candidate> ranked_;
+    std::vector<std::vector<char>> used_;
+    CorrespondenceStats stats_;
+};
+
+}  // namespace mm::reconstruction
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/simd.hpp"
+
+namespace mm::reconstruction {
+
+/// 2D observations of the markers of one frame set, stored camera-major
+/// structure-of-arrays: `u(c)[m]` is the x coordinate of marker `m` in
+/// camera `c`. A weight of zero marks a missing observation.
+class ObservationBatch {
+public:
+    ObservationBatch() = default;
+    ObservationBatch(int num_cameras, int capacity);
+
+    int num_cameras() const { return num_cameras_; }
+    int capacity() const { return capacity_; }
+    int size() const { return size_; }
+
+    /// Sets the marker count and clears every observation. Grows storage
+    /// only when `num_markers` exceeds the capacity.
+    void reset(int num_markers);
+
+    void set(int camera, int marker, double u, double v, double weight = 1.0) {
+        const std::size_t i = index(camera, marker);
+        u_[i] = u;
+        v_[i] = v;
+        w_[i] = weight;
+    }
+
+    const double* u(int camera) const { return u_.data() + index(camera, 0); }
+    const double* v(int camera) const { return v_.data() + index(camera, 0); }
+    const double* w(int camera) const { return w_.data() + index(camera, 0); }
+
+private:
+    std::size_t index(int camera, int marker) const {
+        return static_cast<std::size_t>(camera) * capacity_ + marker;
+    }
+
+    int num_cameras_ = 0;
+    int capacity_ = 0;
+    int size_ = 0;
+    std::vector<double> u_;
+    std::vector<double> v_;
+    std::vector<double> w_;
+};
+
+/// Triangulated markers, structure-of-arrays. Markers seen by fewer than
+/// `min_views` cameras (or with a degenerate solve) are NaN.
+struct TriangulatedPoints {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    /// RMS reprojection error over the contributing views, pixels.
+    std::vector<double> residual;
+    std::vector<int> num_views;
+
+    std::size_t size() const { return x.size(); }
+    bool valid(std::size_t i) const { return x[i] == x[i]; }
+    Vec3d point(std::size_t i) const { return {x[i], y[i], z[i]}; }
+};
+
+struct TriangulationParams {
+    int min_views = 2;
+    /// Reweighting passes after the algebraic solve. Each pass rescales
+    /// every view by its inverse projective depth from the previous
+    /// estimate, moving the linear solution toward the geometric optimum.
+    int reweight_iterations = 1;
+};
+
+/// Linear triangulation of a single point from `n` views, for callers that
+/// need one-off solves (hypothesis testing, initialisation). Returns false
+/// for a degenerate configuration.
+bool triangulate_point(const Mat34d* const* projections, const Vec2d* points, int n, Vec3d& out);
+
+/// Linear multi-view triangulation of every marker of a frame set in one
+/// call. For each camera the kernel streams over all markers, accumulating
+/// the 3x3 normal equations of the inhomogeneous DLT in per-marker lanes,
+/// then solves all markers with closed-form cofactor inverses. Every loop is
+/// branch-free over markers and is compiled per ISA for auto-vectorisation;
+/// scratch lanes are reused, so steady-state calls do not allocate.
+class BatchTriangulator {
+public:
+    explicit BatchTriangulator(std::vector<Mat34d> projections, TriangulationParams params = {},
+                               SimdLevel level = detect_simd_level());
+
+    int num_cameras() const { return static_cast<int>(projections_.size()); }
+    const Mat34d& projection(int camera) const { return projections_[camera]; }
+    const TriangulationParams& params() const { return params_; }
+    SimdLevel simd_level() const { return level_; }
+
+    void triangulate(const ObservationBatch& observations, TriangulatedPoints& out);
+
+private:
+    std::vector<Mat34d> projections_;
+    TriangulationParams params_;
+    SimdLevel level_;
+    /// Normal-equation lanes a00 a01 a02 a11 a12 a22 b0 b1 b2, then the
+    /// residual accumulator and view count.
+    std::vector<double> lanes_;
+};
+
+}  // namespace mm::reconstruction
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+#include "motionmetrics/core/anthropometrics.hpp"
+#include "motionmetrics/core/mapped_file.hpp"
+
+namespace mm::storage {
+
+class AnthropometricsStore;
+
+/// Collects per-athlete segment parameters and writes a store file.
+///
+/// Athletes are sorted by id, each pointing at a contiguous run of segment
+/// records, with segment names in a trailing string block. The file is
+/// written under a temporary name and renamed into place, so readers never
+/// see a partial store.
+class AnthropometricsStoreWriter {
+public:
+    AnthropometricsStoreWriter() = default;
+    /// Starts from the athletes of an existing store, to add or replace some.
+    explicit AnthropometricsStoreWriter(const AnthropometricsStore& existing);
+
+    /// Adds an athlete, replacing any entry with the same id.
+    void add(AthleteAnthropometrics athlete);
+    std::size_t size() const { return athletes_.size(); }
+
+    /// Throws std::system_error on I/O failure.
+    void write(const std::string& path) const;
+
+private:
+    std::map<std::uint64_t, AthleteAnthropometrics> athletes_;
+};
+
+/// Read-only, memory-mapped store of athlete segment parameters, looked up
+/// by athlete id with a binary search over the sorted id column. Lookups
+/// are const and thread-safe.
+class AnthropometricsStore {
+public:
+    /// Throws std::system_error if the file cannot be mapped and
+    /// std::runtime_error if it is not a valid store.
+    explicit AnthropometricsStore(const std::string& path);
+
+    std::size_t size() const { return athletes_; }
+    std::uint64_t athlete_id(std::size_t row) const;
+    /// Materialises the athlete at `row`.
+    AthleteAnthropometrics athlete(std::size_t row) const;
+
+    /// Segment parameters of `athlete_id`, if stored.
+    std::optional<AthleteAnthropometrics> find(std::uint64_t athlete_id) const;
+
+private:
+    MappedFile file_;
+    std::size_t athletes_ = 0;
+    std::size_t segments_ = 0;
+    const std::byte* athlete_records_ = nullptr;
+    const std::byte* segment_records_ = nullptr;
+    const char* names_ = nullptr;
+};
+
+}  // namespace mm::storage
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/core/aligned_buffer.hpp"
+#include "motionmetrics/core/atomic_file.hpp"
+#include "motionmetrics/core/mapped_file.hpp"
+#include "motionmetrics/core/types.hpp"
+
+namespace mm::storage {
+
+/// Session-level metadata stored in the file header.
+struct SessionInfo {
+    std::uint64_t session_id = 0;
+    std::uint64_t athlete_id = 0;
+    /// Marker labels; their order defines the marker indices.
+    std::vector<std::string> marker_names;
+    /// Frames per chunk. Each chunk stores every column contiguously, so
+    /// larger chunks mean longer sequential scans per column.
+    int chunk_frames = 4096;
+};
+
+/// One chunk of a mapped session: a timestamp column and one float column
+/// per marker per axis, each `frames` long. Missing samples are NaN.
+struct SessionChunk {
+    std::int64_t first_frame = 0;
+    int frames = 0;
+    const TimestampNs* timestamps = nullptr;
+    const float* columns = nullptr;
+    std::size_t column_stride = 0;  // floats between consecutive columns
+
+    /// Column of `axis` (0 = x, 1 = y, 2 = z) of `marker`.
+    const float* column(int marker, int axis) const { return columns + (marker * 3 + axis) * column_stride; }
+};
+
+/// Streams reconstructed frames into a columnar session file.
+///
+/// Frames are buffered one chunk at a time and transposed into columns, so
+/// the file never holds row-major data. The file is written under a
+/// temporary name and renamed into place by `close()`, so readers never see
+/// a partial session.
+class SessionWriter {
+public:
+    SessionWriter(std::string path, SessionInfo info);
+    SessionWriter(SessionWriter&&) noexcept;
+    SessionWriter& operator=(SessionWriter&&) = delete;
+    SessionWriter(const SessionWriter&) = delete;
+    SessionWriter& operator=(const SessionWriter&) = delete;
+    /// Abandons the temporary file if `close()` was never called.
+    ~SessionWriter() = default;
+
+    /// Appends one frame. `xyz` holds num_markers * 3 coordinates (x, y, z
+    /// per marker); NaN marks a missing marker. Timestamps must not decrease.
+    void append(TimestampNs timestamp, const float* xyz);
+
+    /// Flushes the last chunk, writes the index and publishes the file.
+    void close();
+
+    std::int64_t frames() const { return frames_; }
+    int num_markers() const { return static_cast<int>(info_.marker_names.size()); }
+
+private:
+    struct IndexEntry {
+        std::uint64_t offset;
+        std::uint32_t frames;
+        std::uint32_t column_stride;
+        TimestampNs first_timestamp;
+        TimestampNs last_timestamp;
+    };
+
+    void flush_chunk();
+
+    AtomicFile file_;
+    SessionInfo info_;
+    std::uint64_t end_offset_ = 0;
+    std::int64_t frames_ = 0;
+    TimestampNs last_timestamp_ = 0;
+
+    int buffered_ = 0;
+    std::size_t column_stride_ = 0;  // floats, for a full chunk
+    AlignedBuffer timestamps_;
+    AlignedBuffer columns_;
+    std::vector<IndexEntry> index_;
+};
+
+/// Read-only view of a session file mapped into memory.
+///
+/// Opening reads only the header, marker names and chunk index; column data
+/// is paged in on first touch, so a scan over one marker's vertical axis
+/// reads roughly 1 / (3 * markers) of the file.
+class SessionReader {
+public:
+    /// Throws std::system_error if the file cannot be mapped and
+    /// std::runtime_error if it is not a valid session file.
+    explicit SessionReader(const std::string& path);
+
+    std::uint64_t session_id() const { return session_id_; }
+    std::uint64_t athlete_id() const { return athlete_id_; }
+    int num_markers() const { return static_cast<int>(marker_names_.size()); }
+    const std::vector<std::string>& marker_names() const { return marker_names_; }
+    /// Index of the named marker, or -1.
+    int marker_index(const std::string& name) const;
+
+    std::int64_t frames() const { return frames_; }
+    int num_chunks() const { return static_cast<int>(chunks_.size()); }
+    const SessionChunk& chunk(int index) const { return chunks_[index]; }
+    TimestampNs first_timestamp() const;
+    TimestampNs last_timestamp() const;
+
+    /// Chunks [first, last) overlapping the time range [begin, end].
+    std::pair<int, int> chunk_range(TimestampNs begin, TimestampNs end) const;
+
+    /// Frame shown at `timestamp`: the last frame at or before it (the first
+    /// frame before the session starts), -1 for an empty session. Reads the
+    /// in-memory chunk index and one chunk's timestamps only.
+    std::int64_t frame_at(TimestampNs timestamp) const;
+    /// Chunk holding `frame`, -1 if out of range.
+    int chunk_of(std::int64_t frame) const;
+    /// Copies the frame's positions (num_markers() * 3 floats, NaN when
+    /// missing) into `xyz`.
+    void read_frame(std::int64_t frame, float* xyz) const;
+
+    /// Copies one column of the whole session into `out` (frames() floats).
+    void read_column(int marker, int axis, float* out) const;
+
+    /// Asks the kernel to read ahead the given marker's columns.
+    void prefetch(int marker) const;
+    /// Paging hint for a whole chunk, e.g. will_need ahead of playback and
+    /// dont_need once it is far behind.
+    void advise_chunk(int chunk, MappedFile::Access access) const;
+
+private:
+    MappedFile file_;
+    std::uint64_t session_id_ = 0;
+    std::uint64_t athlete_id_ = 0;
+    std::int64_t frames_ = 0;
+    std::vector<std::string> marker_names_;
+    std::vector<SessionChunk> chunks_;
+    std::vector<std::int64_t> chunk_first_frame_;
+    std::vector<TimestampNs> chunk_first_;  // from the index, so range
+    std::vector<TimestampNs> chunk_last_;   // queries touch no column pages
+};
+
+}  // namespace mm::storage
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/core/mapped_file.hpp"
+#include "motionmetrics/core/types.hpp"
+
+namespace mm::storage {
+
+/// Precomputed per-trial metrics. Each is NaN when the trial does not
+/// measure it.
+enum class TrialMetric : std::uint8_t {
+    jump_height,       // best jump, flight-time method, m
+    flight_time,       // longest flight, s
+    contact_time,      // shortest rebound ground contact, s
+    takeoff_velocity,  // fastest take-off, m/s
+    jumps,             // number of jumps
+    fixation_time,     // total gaze fixation time, s
+    target_dwell,      // fixation time on scene targets, s
+};
+inline constexpr int kNumTrialMetrics = 7;
+
+const char* to_string(TrialMetric metric);
+
+/// Days since 1970-01-01 of a proleptic Gregorian date.
+constexpr std::int32_t civil_day(int year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int32_t>(doe) - 719468;
+}
+
+/// One row of the index: a trial, its key and its summaries.
+struct TrialSummary {
+    std::uint64_t athlete_id = 0;
+    std::uint64_t session_id = 0;
+    /// Trial number within the session; (session_id, trial) is unique.
+    std::uint32_t trial = 0;
+    /// Day of the session, see civil_day.
+    std::int32_t date = 0;
+    TimestampNs start = 0;
+    std::string trial_type;
+    /// Session file holding the trajectories.
+    std::string path;
+    std::array<float, kNumTrialMetrics> metrics;
+
+    TrialSummary() { metrics.fill(std::numeric_limits<float>::quiet_NaN()); }
+    float metric(TrialMetric m) const { return metrics[static_cast<int>(m)]; }
+    void set_metric(TrialMetric m, double value) { metrics[static_cast<int>(m)] = static_cast<float>(value); }
+};
+
+/// Row filter. Unset fields match everything; dates are inclusive.
+struct TrialQuery {
+    std::optional<std::uint64_t> athlete_id;
+    std::int32_t first_date = std::numeric_limits<std::int32_t>::min();
+    std::int32_t last_date = std::numeric_limits<std::int32_t>::max();
+    std::string trial_type;
+};
+
+enum class Rank : std::uint8_t { highest, lowest };
+
+class TrialIndex;
+
+/// Collects trial summaries and writes an index file.
+///
+/// Rows are sorted by (athlete, date, trial type, session, trial) and stored
+/// column by column, each column cache-line aligned, followed by one row
+/// order per metric sorted by value. The file is written under a temporary
+/// name and renamed into place, so readers never see a partial index.
+class TrialIndexWriter {
+public:
+    TrialIndexWriter() = default;
+    /// Starts from the rows of an existing index, to add or replace trials.
+    explicit TrialIndexWriter(const TrialIndex& existing);
+
+    /// Adds a trial, replacing any row with the same session and trial.
+    void add(TrialSummary summary);
+    std::size_t size() const { return rows_.size(); }
+
+    /// Throws std::system_error on I/O failure.
+    void write(const std::string& path) const;
+
+private:
+    std::vector<TrialSummary> rows_;
+    std::unordered_map<std::uint64_t, std::vector<std::size_t>> by_session_;
+};
+
+/// Read-only, memory-mapped trial index.
+///
+/// Opening checks every offset the queries follow and the sort order they
+/// rely on; queries then read the mapped columns directly. An athlete's trials are one contiguous run of
+/// the sorted key columns, found by binary search, with their dates sorted
+/// within it, so per-athlete queries touch only that athlete's rows. Top-k
+/// queries without an athlete walk the metric's sorted order from the best
+/// end until k rows pass the filter. Queries are const and thread-safe.
+class TrialIndex {
+public:
+    /// Throws std::system_error if the file cannot be mapped and
+    /// std::runtime_error if it is not a valid index.
+    explicit TrialIndex(const std::string& path);
+
+    std::size_t size() const { return rows_; }
+    const std::vector<std::string>& trial_types() const { return types_; }
+
+    std::uint64_t athlete_id(std::size_t row) const { return athletes_[row]; }
+    std::int32_t date(std::size_t row) const { return dates_[row]; }
+    const std::string& trial_type(std::size_t row) const { return types_[type_ids_[row]]; }
+    float metric(std::size_t row, TrialMetric m) const { return metrics_[static_cast<int>(m)][row]; }
+    /// Materialises a whole row.
+    TrialSummary summary(std::size_t row) const;
+
+    /// Matching rows in key order.
+    std::vector<std::uint32_t> find(const TrialQuery& query) const;
+    /// Up to `k` matching rows with the best values of `metric`, best first;
+    /// rows without the metric are skipped.
+    std::vector<std::uint32_t> top(const TrialQuery& query, TrialMetric metric, std::size_t k,
+                                   Rank rank = Rank::highest) const;
+
+private:
+    /// Rows [first, last) of the query's athlete and dates, or all rows.
+    std::pair<std::size_t, std::size_t> key_range(const TrialQuery& query) const;
+    /// Trial type id of the query, -1 for any, -2 for a type not present.
+    int type_filter(const TrialQuery& query) const;
+
+    MappedFile file_;
+    std::size_t rows_ = 0;
+    const std::uint64_t* athletes_ = nullptr;
+    const std::uint64_t* sessions_ = nullptr;
+    const TimestampNs* starts_ = nullptr;
+    const std::int32_t* dates_ = nullptr;
+    const std::uint32_t* trials_ = nullptr;
+    const std::uint32_t* type_ids_ = nullptr;
+    const std::uint64_t* path_offsets_ = nullptr;  // rows + 1 entries
+    const char* paths_ = nullptr;
+    std::array<const float*, kNumTrialMetrics> metrics_{};
+    /// Rows with the metric, ascending by value.
+    std::array<const std::uint32_t*, kNumTrialMetrics> orders_{};
+    std::array<std::size_t, kNumTrialMetrics> order_sizes_{};
+    std::vector<std::string> types_;
+};
+
+}  // namespace mm::storage
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "motionmetrics/core/image.hpp"
+#include "motionmetrics/core/types.hpp"
+#include "motionmetrics/tracking/blob_detector.hpp"
+
+namespace mm::tracking {
+
+struct MarkerTrackerParams {
+    BlobDetectorParams detector{};
+    /// White-acceleration noise of the constant-velocity predictor, px^2/s^3.
+    float process_noise = 2.0e5f;
+    /// Centroid measurement variance, px^2.
+    float measurement_noise = 0.25f;
+    /// Squared Mahalanobis gate for associating a blob with a track.
+    float gate = 16.0f;
+    /// Pixels added around the predicted blob extent and uncertainty.
+    int window_margin = 4;
+    int max_window = 160;
+    /// Frames a track may go unobserved before it is dropped.
+    int max_missed = 5;
+    /// If positive, a full-frame scan also runs every N frames to pick up
+    /// markers entering the view.
+    int full_scan_interval = 0;
+    /// If positive, a full-frame scan runs whenever fewer tracks are alive.
+    int expected_markers = 0;
+};
+
+/// 2D state of one marker in one camera.
+struct TrackedMarker {
+    int id = 0;
+    /// Filtered position and velocity (px, px/s).
+    float x = 0.0f;
+    float y = 0.0f;
+    float vx = 0.0f;
+    float vy = 0.0f;
+    /// Detection this frame; meaningful only when `observed` is true.
+    Blob blob{};
+    bool observed = false;
+    int missed = 0;
+};
+
+struct MarkerTrackerStats {
+    std::uint64_t frames = 0;
+    std::uint64_t full_scans = 0;
+    std::uint64_t pixels_scanned = 0;
+};
+
+/// Per-camera marker tracker that only searches predicted windows.
+///
+/// Each marker carries a constant-velocity Kalman filter. Once markers are
+/// acquired, the detector runs on the merged windows around their
+/// predictions, sized from the filter's innovation variance and the last
+/// blob extent. A full-frame scan runs on the first frame, whenever a track
+/// finds no blob in its window, and on the optional periodic/expected-count
+/// triggers; the scan also re-acquires lost tracks and spawns new ones.
+class MarkerTracker {
+public:
+    explicit MarkerTracker(MarkerTrackerParams params = {}, SimdLevel level = detect_simd_level());
+
+    /// Tracks markers in `frame` captured at `timestamp`. The returned
+    /// reference stays valid until the next call.
+    const std::vector<TrackedMarker>& track(const ImageView& frame, TimestampNs timestamp);
+
+    const std::vector<TrackedMarker>& markers() const { return markers_; }
+    bool last_was_full_scan() const { return last_full_scan_; }
+    const MarkerTrackerStats& stats() const { return stats_; }
+    void reset();
+
+private:
+    struct Filter {
+        // Shared per-axis covariance of the [position, velocity] state.
+        float p00 = 0.0f;
+        float p01 = 0.0f;
+        float p11 = 0.0f;
+        float half_extent = 0.0f;
+    };
+
+    struct Window {
+        int x0, y0, x1, y1;  // half-open
+    };
+
+    void predict(float dt);
+    void scan_windows(const ImageView& frame);
+    void scan_full(const ImageView& frame);
+    void associate();
+    void update_tracks();
+    void spawn_tracks();
+
+    MarkerTrackerParams params_;
+    BlobDetector detector_;
+    std::vector<TrackedMarker> markers_;
+    std::vector<Filter> filters_;
+
+    std::vector<Window> windows_;
+    std::vector<Blob> blobs_;
+    std::vector<Blob> scratch_;
+    std::vector<int> blob_owner_;
+    std::vector<int> assignment_;
+
+    std::optional<TimestampNs> last_timestamp_;
+    int next_id_ = 0;
+    int frames_since_full_scan_ = 0;
+    bool last_full_scan_ = false;
+    MarkerTrackerStats stats_;
+};
+
+}  // namespace mm::tracking
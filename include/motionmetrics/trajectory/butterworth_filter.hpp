@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+
+#include "motionmetrics/core/simd.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/trajectory/trajectory_set.hpp"
+
+namespace mm::trajectory {
+
+/// Second-order section in transposed direct form II:
+/// y = b0 x + z1, z1' = b1 x - a1 y + z2, z2' = b2 x - a2 y.
+struct Biquad {
+    double b0 = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double a1 = 0.0;
+    double a2 = 0.0;
+};
+
+/// Low-pass Butterworth of even `order` as order / 2 cascaded sections
+/// (bilinear transform with pre-warping, unity DC gain per section). With
+/// `zero_phase` the cutoff is corrected so that a forward-backward pass,
+/// rather than each single pass, is 3 dB down at `cutoff_hz`.
+std::vector<Biquad> design_butterworth_lowpass(int order, double cutoff_hz, double sample_rate_hz,
+                                               bool zero_phase = true);
+
+struct ButterworthParams {
+    /// Order of each pass; the zero-phase result has twice the order.
+    int order = 4;
+    /// 0 derives the rate from the median timestamp spacing.
+    double sample_rate_hz = 0.0;
+};
+
+/// Winter's residual analysis over a sweep of cutoffs.
+struct ResidualAnalysisParams {
+    double min_hz = 1.0;
+    double max_hz = 20.0;
+    double step_hz = 0.5;
+    /// The noise line is fitted to the residuals of cutoffs from here up;
+    /// 0 uses the upper half of the sweep.
+    double noise_fit_from_hz = 0.0;
+};
+
+/// Zero-phase (forward-backward) Butterworth low-pass over every
+/// coordinate column of a trial.
+///
+/// Columns are processed in groups of eight, interleaved into one buffer so
+/// that sample t of all eight channels is contiguous; the biquad cascade
+/// then advances eight trajectories per step (one AVX-512 or two AVX2
+/// vectors, each lane with its own coefficients so markers may have
+/// different cutoffs). Groups run in parallel. Ends are padded by odd
+/// reflection and the section states start at their steady state to keep
+/// edge transients small. Missing samples are bridged linearly for the
+/// filter and stay NaN in the output, so gaps should be filled first.
+class ButterworthFilterBank {
+public:
+    /// `pool` may be null to run on the calling thread only.
+    explicit ButterworthFilterBank(ButterworthParams params = {}, SimdLevel level = detect_simd_level(),
+                                   WorkStealingPool* pool = nullptr);
+
+    SimdLevel simd_level() const { return level_; }
+
+    /// Sample rate used for `set`: the configured one, or one derived from
+    /// its timestamps. Throws std::invalid_argument if neither is usable.
+    double sample_rate(const TrajectorySet& set) const;
+
+    /// Filters every marker of `set` in place at its own cutoff.
+    void filter(TrajectorySet& set, const std::vector<double>& cutoffs_hz) const;
+    void filter(TrajectorySet& set, double cutoff_hz) const;
+
+    /// Per-marker cutoff from residual analysis: the residual between raw
+    /// and filtered data is computed over the sweep for all markers at once
+    /// (axes pooled), a line is fitted to its noise-dominated tail, and the
+    /// chosen cutoff is where the residual falls to the line's intercept,
+    /// the estimated noise level.
+    std::vector<double> residual_analysis(const TrajectorySet& set, const ResidualAnalysisParams& params = {}) const;
+
+private:
+    struct Group;
+
+    /// Runs `fn(group index, Group&)` over all eight-column groups.
+    template <typename Fn>
+    void for_each_group(const TrajectorySet& set, Fn&& fn) const;
+
+    ButterworthParams params_;
+    SimdLevel level_;
+    WorkStealingPool* pool_;
+};
+
+}  // namespace mm::trajectory
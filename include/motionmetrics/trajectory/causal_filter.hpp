@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/types.hpp"
+
+namespace mm::trajectory {
+
+enum class CausalFilterMode : std::uint8_t { one_euro, kalman };
+
+struct CausalFilterParams {
+    CausalFilterMode mode = CausalFilterMode::kalman;
+
+    /// One-euro: cutoff at rest, Hz.
+    double min_cutoff_hz = 1.5;
+    /// One-euro: cutoff added per m/s of filtered speed, so fast motion
+    /// trades smoothing for less lag.
+    double beta = 20.0;
+    /// One-euro: cutoff of the velocity and acceleration estimates, Hz.
+    double derivative_cutoff_hz = 10.0;
+
+    /// Kalman: white-jerk spectral density of the constant-acceleration
+    /// model, m^2/s^5.
+    double process_noise = 5.0e3;
+    /// Kalman: measurement variance per axis, m^2.
+    double measurement_noise = 1.0e-6;
+    /// Kalman: initial variances of a newly acquired marker.
+    double initial_velocity_variance = 4.0;
+    double initial_acceleration_variance = 400.0;
+
+    /// Frames a marker may go unobserved before its state is dropped. In
+    /// Kalman mode the prediction is reported while it coasts; one-euro
+    /// reports the marker as missing.
+    int max_missed = 5;
+};
+
+/// Causal per-marker smoothing for the live pipeline.
+///
+/// Every marker axis is one channel; state lives in flat arrays indexed by
+/// channel (marker * 3 + axis, the layout of a session row), so an update
+/// walks each array once. Unlike the offline zero-phase filter no future
+/// samples are used: the output at frame t depends on frames <= t only,
+/// which adds lag but lets velocities feed real-time feedback.
+///  - one-euro: an exponential smoother whose cutoff rises with the
+///    marker's filtered speed; velocity and acceleration are low-passed
+///    derivatives of the smoothed position.
+///  - kalman: constant-acceleration model per axis, position measured. The
+///    three axes of a marker share one covariance, since they see the same
+///    noise and the same observation pattern.
+class CausalMarkerFilter {
+public:
+    explicit CausalMarkerFilter(int num_markers, CausalFilterParams params = {});
+
+    /// Feeds one frame. `xyz` holds num_markers * 3 coordinates, metres,
+    /// NaN for a missing marker. Frames with a timestamp not after the
+    /// previous one are ignored.
+    void update(TimestampNs timestamp, const float* xyz);
+
+    int num_markers() const { return num_markers_; }
+    /// Estimates of the last frame in the `xyz` layout; NaN where a marker
+    /// has no state.
+    const float* positions() const { return out_position_.data(); }
+    const float* velocities() const { return out_velocity_.data(); }
+    const float* accelerations() const { return out_acceleration_.data(); }
+
+    bool valid(int marker) const { return active_[marker] != 0; }
+    Vec3d position(int marker) const { return read(out_position_, marker); }
+    Vec3d velocity(int marker) const { return read(out_velocity_, marker); }
+    Vec3d acceleration(int marker) const { return read(out_acceleration_, marker); }
+
+    void reset();
+
+private:
+    static Vec3d read(const std::vector<float>& v, int marker) {
+        return {v[marker * 3], v[marker * 3 + 1], v[marker * 3 + 2]};
+    }
+
+    void update_one_euro(double dt, const float* xyz);
+    void update_kalman(double dt, const float* xyz);
+    void publish(int marker, bool observed);
+
+    int num_markers_;
+    CausalFilterParams params_;
+    std::optional<TimestampNs> last_timestamp_;
+
+    // Per channel.
+    std::vector<double> x_;
+    std::vector<double> v_;
+    std::vector<double> a_;
+    // Per marker: Kalman covariance of [position, velocity, acceleration]
+    // (upper triangle, shared by the axes), missed-frame count, seconds
+    // since the last observation and state flag.
+    std::vector<double> p00_, p01_, p02_, p11_, p12_, p22_;
+    std::vector<int> missed_;
+    std::vector<double> elapsed_;
+    std::vector<std::uint8_t> active_;
+
+    std::vector<float> out_position_;
+    std::vector<float> out_velocity_;
+    std::vector<float> out_acceleration_;
+};
+
+}  // namespace mm::trajectory
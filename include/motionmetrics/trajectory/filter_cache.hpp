@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "motionmetrics/core/simd.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/trajectory/butterworth_filter.hpp"
+#include "motionmetrics/trajectory/trajectory_set.hpp"
+
+namespace mm::trajectory {
+
+/// How a session is filtered.
+struct FilterSpec {
+    ButterworthParams butterworth;
+    /// Picks each marker's cutoff by residual analysis; otherwise every
+    /// marker uses `cutoff_hz`.
+    bool residual_analysis = true;
+    double cutoff_hz = 6.0;
+    ResidualAnalysisParams residual;
+};
+
+struct FilteredSession {
+    TrajectorySet trajectories;
+    std::vector<double> cutoffs_hz;  // per marker
+};
+
+/// Filters each session once and shares the result between analyses.
+///
+/// Results are persisted next to each other in `directory` as a session
+/// file of the filtered trajectories plus a small cutoffs file, named after
+/// the session id and a key over the spec and the source file's size and
+/// modification time, so a re-recorded session or a different spec never
+/// hits a stale entry. Recently used results are also kept in memory, up to
+/// `max_memory_bytes`, least recently used first out; a memory hit costs
+/// one stat of the source and no other I/O. Concurrent requests for the
+/// same uncached session wait for the first one to compute it; caches in
+/// other processes sharing `directory` may publish the same entry at the
+/// same time, and the last complete write wins.
+class FilteredSessionCache {
+public:
+    /// `pool` may be null to filter on the calling thread only. The most
+    /// recently used entry is kept even if it alone exceeds
+    /// `max_memory_bytes`.
+    explicit FilteredSessionCache(std::string directory, SimdLevel level = detect_simd_level(),
+                                  WorkStealingPool* pool = nullptr, std::size_t max_memory_bytes = kDefaultMemoryBytes);
+
+    static constexpr std::size_t kDefaultMemoryBytes = std::size_t{1} << 30;
+
+    /// Filtered trajectories of the session at `session_path`. Throws
+    /// std::system_error if the session cannot be read or the result cannot
+    /// be persisted.
+    std::shared_ptr<const FilteredSession> get(const std::string& session_path, const FilterSpec& spec = {});
+
+    /// Drops the in-memory entries; persisted results stay.
+    void clear();
+
+    /// Approximate size of the in-memory entries.
+    std::size_t memory_bytes() const;
+
+    std::int64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    std::int64_t disk_hits() const { return disk_hits_.load(std::memory_order_relaxed); }
+    std::int64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<const FilteredSession> load(const std::string& base, std::uint64_t key) const;
+    void store(const std::string& base, std::uint64_t key, const storage::SessionReader& source,
+               const FilteredSession& session) const;
+
+    std::string directory_;
+    SimdLevel level_;
+    WorkStealingPool* pool_;
+    struct Entry {
+        std::uint64_t key;
+        std::shared_ptr<const FilteredSession> session;
+        std::size_t bytes;
+    };
+
+    std::size_t max_memory_bytes_;
+    mutable std::mutex mutex_;
+    std::condition_variable computed_;
+    /// Keyed by the source file's identity and the spec, most recent first.
+    std::list<Entry> lru_;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> entries_;
+    std::size_t memory_bytes_ = 0;
+    std::unordered_set<std::uint64_t> in_flight_;  // keys being loaded or computed
+    std::atomic<std::int64_t> hits_{0};
+    std::atomic<std::int64_t> disk_hits_{0};
+    std::atomic<std::int64_t> misses_{0};
+};
+
+}  // namespace mm::trajectory
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/trajectory/trajectory_set.hpp"
+
+namespace mm::trajectory {
+
+struct GapFillParams {
+    /// Gaps up to this many frames are bridged with a cubic Hermite spline.
+    int max_spline_gap = 10;
+    /// Longer gaps are left unfilled.
+    int max_gap = 600;
+    /// Markers of each rigid body segment. A gap can be filled from the
+    /// motion of at least three other markers of its segment.
+    std::vector<std::vector<int>> segments;
+    /// Markers present in fewer than this fraction of frames are left out
+    /// of the PCA model (they can still be filled from it).
+    double pca_min_presence = 0.5;
+    /// Principal components kept: enough to explain this variance fraction.
+    double pca_variance = 0.999;
+    /// Training frames are subsampled evenly down to this count.
+    int pca_max_training_frames = 2000;
+    /// Gaps per scheduler task.
+    int grain = 4;
+};
+
+enum class FillMethod : std::uint8_t { none, spline, rigid, pca };
+
+/// A run of missing samples [begin, end) of one marker, and how it was
+/// filled. Runs touching the start or end of the trial are never filled.
+struct TrajectoryGap {
+    int marker = 0;
+    std::int64_t begin = 0;
+    std::int64_t end = 0;
+    FillMethod method = FillMethod::none;
+
+    std::int64_t length() const { return end - begin; }
+};
+
+struct GapFillReport {
+    std::vector<TrajectoryGap> gaps;
+    std::int64_t frames_missing = 0;
+    std::int64_t frames_filled = 0;
+    /// Principal components of the PCA model, 0 if it could not be built.
+    int pca_components = 0;
+};
+
+/// Fills occluded marker samples of a trial in batched passes.
+///
+/// One scan over the x columns lists every gap of every marker. Each
+/// strategy then runs over all remaining gaps at once on the work-stealing
+/// pool, cheapest first:
+///  - short gaps: cubic Hermite spline between the neighbouring samples;
+///  - rigid segments: per frame, the motion of three or more other markers
+///    of the segment (Horn fit) carries the marker's position from both gap
+///    edges, cross-faded over the gap;
+///  - everything else: a PCA model of the whole-body marker configuration,
+///    learnt from the frames where every modelled marker is present, is
+///    fitted to the frame's observed coordinates (frames with the same
+///    missing pattern share one factorisation) and offset-corrected to meet
+///    the real samples at both edges.
+/// Within a pass, estimates only read samples that were present before the
+/// pass, so the result does not depend on scheduling.
+class GapFiller {
+public:
+    /// `pool` may be null to run on the calling thread only. Throws
+    /// std::invalid_argument if a parameter is out of range.
+    explicit GapFiller(GapFillParams params = {}, WorkStealingPool* pool = nullptr);
+
+    GapFillReport fill(TrajectorySet& trajectories);
+
+private:
+    struct PcaModel;
+
+    void find_gaps(const TrajectorySet& set, GapFillReport& report);
+    bool fill_spline(TrajectorySet& set, const TrajectoryGap& gap) const;
+    bool fill_rigid(TrajectorySet& set, const TrajectoryGap& gap) const;
+    void build_pca(const TrajectorySet& set, PcaModel& model) const;
+    /// Runs `fn(gap)` over every unfilled gap in parallel and marks the
+    /// gaps it filled with `method`.
+    template <typename Fn>
+    void run_pass(TrajectorySet& set, GapFillReport& report, FillMethod method, Fn&& fn);
+
+    GapFillParams params_;
+    WorkStealingPool* pool_;
+    /// Segment of each marker, or -1.
+    std::vector<int> segment_of_;
+    /// Marker x frame presence before the current pass, row per marker.
+    std::vector<std::uint8_t> present_;
+    std::vector<char> filled_;
+};
+
+}  // namespace mm::trajectory
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "motionmetrics/core/aligned_buffer.hpp"
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/types.hpp"
+#include "motionmetrics/storage/session_store.hpp"
+
+namespace mm::trajectory {
+
+/// Marker trajectories of a whole trial in memory, one contiguous
+/// cache-aligned float column per marker and axis (the session file layout
+/// without the chunking). Missing samples are NaN.
+class TrajectorySet {
+public:
+    TrajectorySet() = default;
+    TrajectorySet(std::vector<std::string> marker_names, std::int64_t frames);
+
+    /// Reads every column and the timestamps of a session.
+    static TrajectorySet from_session(const storage::SessionReader& reader);
+
+    int num_markers() const { return static_cast<int>(marker_names_.size()); }
+    std::int64_t frames() const { return frames_; }
+    const std::vector<std::string>& marker_names() const { return marker_names_; }
+    /// Index of the named marker, or -1.
+    int marker_index(const std::string& name) const;
+
+    std::vector<TimestampNs>& timestamps() { return timestamps_; }
+    const std::vector<TimestampNs>& timestamps() const { return timestamps_; }
+
+    /// Column of `axis` (0 = x, 1 = y, 2 = z) of `marker`.
+    float* column(int marker, int axis) { return columns_.as<float>() + (marker * 3 + axis) * stride_; }
+    const float* column(int marker, int axis) const {
+        return columns_.as<float>() + (marker * 3 + axis) * stride_;
+    }
+
+    bool present(int marker, std::int64_t frame) const {
+        const float x = column(marker, 0)[frame];
+        return x == x;
+    }
+    Vec3d position(int marker, std::int64_t frame) const {
+        return {column(marker, 0)[frame], column(marker, 1)[frame], column(marker, 2)[frame]};
+    }
+    void set_position(int marker, std::int64_t frame, const Vec3d& p) {
+        column(marker, 0)[frame] = static_cast<float>(p.x);
+        column(marker, 1)[frame] = static_cast<float>(p.y);
+        column(marker, 2)[frame] = static_cast<float>(p.z);
+    }
+
+private:
+    std::vector<std::string> marker_names_;
+    std::int64_t frames_ = 0;
+    std::size_t stride_ = 0;  // floats between consecutive columns
+    AlignedBuffer columns_;
+    std::vector<TimestampNs> timestamps_;
+};
+
+}  // namespace mm::trajectory
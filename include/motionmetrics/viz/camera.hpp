@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+
+#include "motionmetrics/core/math.hpp"
+
+namespace mm::viz {
+
+/// Pinhole view camera for the interactive display.
+///
+/// Screen coordinates are pixels with y down and the pixel centre at +0.5;
+/// depth is the distance along the viewing direction. World z is up.
+class Camera {
+public:
+    Camera() = default;
+    /// Looks from `eye` at `target`. Throws std::invalid_argument for a
+    /// degenerate view (eye on target, `up` along the view, non-positive
+    /// size, field of view or near distance).
+    Camera(const Vec3d& eye, const Vec3d& target, double vertical_fov, int width, int height,
+           double near = 0.05, double far = 200.0, const Vec3d& up = {0.0, 0.0, 1.0});
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    const Vec3d& eye() const { return eye_; }
+    /// Focal length, pixels.
+    double focal() const { return focal_; }
+
+    /// Camera-space point: x right, y up, z along the view.
+    Vec3d to_view(const Vec3d& p) const { return {dot(right_, p - eye_), dot(up_, p - eye_), dot(forward_, p - eye_)}; }
+    /// Projects a camera-space point in front of the near plane.
+    void to_screen(const Vec3d& v, float& x, float& y) const {
+        x = static_cast<float>(cx_ + focal_ * v.x / v.z);
+        y = static_cast<float>(cy_ - focal_ * v.y / v.z);
+    }
+    /// Projects a world point; false when it lies before the near plane.
+    bool project(const Vec3d& p, float& x, float& y, float& depth) const;
+
+    /// World length covered by one pixel at `depth`; converts screen-space
+    /// tolerances (trail simplification) into world units.
+    double pixel_size(double depth) const { return depth / focal_; }
+    /// False when the sphere lies entirely outside the view frustum.
+    bool sphere_visible(const Vec3d& centre, double radius) const;
+
+    /// OpenGL-convention view-projection matrix, column-major, for GPU
+    /// back ends drawing the same batches.
+    std::array<float, 16> view_projection() const;
+
+    double near() const { return near_; }
+    double far() const { return far_; }
+
+private:
+    Vec3d eye_{};
+    Vec3d right_{1.0, 0.0, 0.0};
+    Vec3d up_{0.0, 0.0, 1.0};
+    Vec3d forward_{0.0, 1.0, 0.0};
+    int width_ = 0;
+    int height_ = 0;
+    double focal_ = 1.0;
+    double cx_ = 0.0;
+    double cy_ = 0.0;
+    double near_ = 0.05;
+    double far_ = 200.0;
+    // Unit inward normals of the side planes in camera space.
+    std::array<Vec3d, 4> planes_{};
+};
+
+}  // namespace mm::viz
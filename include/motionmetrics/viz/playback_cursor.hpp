@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "motionmetrics/capture/video_decoder.hpp"
+#include "motionmetrics/core/aligned_buffer.hpp"
+#include "motionmetrics/core/types.hpp"
+#include "motionmetrics/storage/session_store.hpp"
+
+namespace mm::viz {
+
+struct PlaybackConfig {
+    /// Chunks kept resident ahead of the playhead in the direction it last
+    /// moved, and behind it.
+    int chunks_ahead = 3;
+    int chunks_behind = 1;
+};
+
+struct PlaybackStats {
+    std::uint64_t seeks = 0;
+    std::uint64_t chunks_prefetched = 0;
+    std::uint64_t chunks_released = 0;
+    /// Video frames decoded, including those decoded only to reach a target
+    /// frame from its keyframe.
+    std::uint64_t video_frames_decoded = 0;
+};
+
+/// Random-access playhead over a session and its overlaid camera videos.
+///
+/// Seeking goes through the session's chunk index, so a jump to any
+/// timestamp reads the index (in memory) and the one chunk holding the
+/// frame, never the file before it. A prefetch thread follows the playhead:
+/// after each seek it pages in the current chunk and the next
+/// `chunks_ahead` in the direction of travel, nearest first, abandoning the
+/// plan as soon as the playhead moves again, and releases chunks that have
+/// fallen out of the window. Videos seek to the nearest keyframe at or
+/// before the target and decode forward from there, or simply continue when
+/// the target lies just ahead of the previous one (normal playback).
+///
+/// seek() and the read functions are called from one thread (the UI).
+class PlaybackCursor {
+public:
+    /// `session` must outlive the cursor. Throws std::invalid_argument for
+    /// negative window sizes.
+    explicit PlaybackCursor(const storage::SessionReader& session, PlaybackConfig config = {});
+    ~PlaybackCursor();
+
+    PlaybackCursor(const PlaybackCursor&) = delete;
+    PlaybackCursor& operator=(const PlaybackCursor&) = delete;
+
+    /// Adds a camera video to overlay; builds its keyframe index from the
+    /// decoder's frame index without decoding. Returns the video index.
+    int add_video(std::unique_ptr<capture::VideoDecoder> decoder);
+    int num_videos() const { return static_cast<int>(videos_.size()); }
+
+    /// Moves the playhead to the session frame shown at `timestamp` and
+    /// returns it (-1 for an empty session).
+    std::int64_t seek(TimestampNs timestamp);
+    std::int64_t frame() const { return frame_; }
+    TimestampNs timestamp() const { return timestamp_; }
+
+    /// Marker positions at the playhead (num_markers() * 3 floats, NaN when
+    /// missing).
+    void read_pose(float* xyz) const;
+    /// Decodes the video frame shown at the playhead (the last one at or
+    /// before it) into `out`. Returns false when the video has no frame
+    /// there yet.
+    bool read_video(int video, std::uint8_t* out, std::ptrdiff_t stride);
+
+    PlaybackStats stats() const;
+
+private:
+    struct Video {
+        std::unique_ptr<capture::VideoDecoder> decoder;
+        std::vector<TimestampNs> timestamps;
+        std::vector<std::int64_t> keyframes;
+        /// Frame the next decode() returns, -1 when unknown.
+        std::int64_t next = -1;
+        /// Last decoded frame, kept so a playhead that stays within one
+        /// video frame costs a copy, not a decode.
+        AlignedBuffer image;
+        std::ptrdiff_t stride = 0;
+        std::int64_t current = -1;
+    };
+
+    void prefetch_loop();
+
+    const storage::SessionReader& session_;
+    PlaybackConfig config_;
+    std::vector<Video> videos_;
+    std::int64_t frame_ = -1;
+    TimestampNs timestamp_ = 0;
+    std::uint64_t seeks_ = 0;
+    std::uint64_t video_frames_decoded_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    int target_chunk_ = -1;    // guarded by mutex_
+    int direction_ = 1;        // guarded by mutex_
+    std::uint64_t request_ = 0;  // guarded by mutex_, bumped per move
+    bool stop_ = false;        // guarded by mutex_
+    std::atomic<std::uint64_t> chunks_prefetched_{0};
+    std::atomic<std::uint64_t> chunks_released_{0};
+    std::thread thread_;
+};
+
+}  // namespace mm::viz
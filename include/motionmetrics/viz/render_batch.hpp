@@ -0,0 +1,217 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "motionmetrics/core/aligned_buffer.hpp"
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/core/types.hpp"
+
+namespace mm::viz {
+
+/// 0xAARRGGBB.
+constexpr std::uint32_t rgba(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a = 255) {
+    return std::uint32_t{a} << 24 | std::uint32_t{r} << 16 | std::uint32_t{g} << 8 | b;
+}
+
+/// Per-instance records, laid out for direct use as GPU vertex attributes.
+struct MarkerInstance {
+    float position[3];
+    float radius;
+    std::uint32_t colour;
+};
+static_assert(sizeof(MarkerInstance) == 20, "marker instance layout");
+
+struct BoneInstance {
+    float from[3];
+    float to[3];
+    float radius;
+    std::uint32_t colour;
+};
+static_assert(sizeof(BoneInstance) == 32, "bone instance layout");
+
+struct TrailVertex {
+    float position[3];
+    std::uint32_t colour;
+};
+static_assert(sizeof(TrailVertex) == 16, "trail vertex layout");
+
+/// A line strip of `count` trail vertices starting at `first`.
+struct TrailStrip {
+    std::uint32_t first;
+    std::uint32_t count;
+};
+
+/// Fixed element capacity of one frame's batch.
+struct BatchCapacity {
+    std::uint32_t markers = 4096;
+    std::uint32_t bones = 4096;
+    std::uint32_t trail_vertices = 1u << 18;
+    std::uint32_t trail_strips = 4096;
+};
+
+/// Everything drawn in one frame: one instance array per primitive type,
+/// so a back end issues one instanced draw per type however many skeletons
+/// are shown. The arrays live in preallocated ring storage; adding past
+/// capacity drops the element and counts it in `overflow()`.
+class RenderBatch {
+public:
+    void clear() {
+        num_markers_ = num_bones_ = num_trail_vertices_ = num_trail_strips_ = 0;
+        strip_open_ = false;
+        overflow_ = 0;
+    }
+
+    void add_marker(const Vec3d& p, float radius, std::uint32_t colour) {
+        if (num_markers_ == capacity_.markers) {
+            ++overflow_;
+            return;
+        }
+        MarkerInstance& m = markers_[num_markers_++];
+        store(m.position, p);
+        m.radius = radius;
+        m.colour = colour;
+    }
+    void add_bone(const Vec3d& a, const Vec3d& b, float radius, std::uint32_t colour) {
+        if (num_bones_ == capacity_.bones) {
+            ++overflow_;
+            return;
+        }
+        BoneInstance& bone = bones_[num_bones_++];
+        store(bone.from, a);
+        store(bone.to, b);
+        bone.radius = radius;
+        bone.colour = colour;
+    }
+    /// Opens a trail strip; vertices added next belong to it. Returns false
+    /// (and drops the strip) when the batch is full.
+    bool begin_strip();
+    void add_trail_vertex(float x, float y, float z, std::uint32_t colour) {
+        if (!strip_open_) return;
+        if (num_trail_vertices_ == capacity_.trail_vertices) {
+            ++overflow_;
+            return;
+        }
+        trail_vertices_[num_trail_vertices_++] = {{x, y, z}, colour};
+        ++trail_strips_[num_trail_strips_ - 1].count;
+    }
+    /// Closes the open strip, discarding it if it has fewer than two vertices.
+    void end_strip();
+
+    const MarkerInstance* markers() const { return markers_; }
+    const BoneInstance* bones() const { return bones_; }
+    const TrailVertex* trail_vertices() const { return trail_vertices_; }
+    const TrailStrip* trail_strips() const { return trail_strips_; }
+    std::uint32_t num_markers() const { return num_markers_; }
+    std::uint32_t num_bones() const { return num_bones_; }
+    std::uint32_t num_trail_vertices() const { return num_trail_vertices_; }
+    std::uint32_t num_trail_strips() const { return num_trail_strips_; }
+    std::uint64_t overflow() const { return overflow_; }
+
+    /// Byte offsets of the arrays within the ring storage, for back ends
+    /// that draw straight from a mapped buffer holding it.
+    std::size_t markers_offset() const { return offset_ + layout_.markers; }
+    std::size_t bones_offset() const { return offset_ + layout_.bones; }
+    std::size_t trail_vertices_offset() const { return offset_ + layout_.trail_vertices; }
+
+    /// Publication sequence, starting at 1.
+    std::uint64_t sequence() const { return sequence_; }
+
+private:
+    friend class BatchRing;
+
+    struct Layout {
+        std::size_t markers = 0;
+        std::size_t bones = 0;
+        std::size_t trail_vertices = 0;
+        std::size_t trail_strips = 0;
+        std::size_t bytes = 0;
+    };
+    static Layout layout_for(const BatchCapacity& capacity);
+    static void store(float* out, const Vec3d& p) {
+        out[0] = static_cast<float>(p.x);
+        out[1] = static_cast<float>(p.y);
+        out[2] = static_cast<float>(p.z);
+    }
+
+    BatchCapacity capacity_{};
+    Layout layout_{};
+    std::size_t offset_ = 0;
+    MarkerInstance* markers_ = nullptr;
+    BoneInstance* bones_ = nullptr;
+    TrailVertex* trail_vertices_ = nullptr;
+    TrailStrip* trail_strips_ = nullptr;
+    std::uint32_t num_markers_ = 0;
+    std::uint32_t num_bones_ = 0;
+    std::uint32_t num_trail_vertices_ = 0;
+    std::uint32_t num_trail_strips_ = 0;
+    bool strip_open_ = false;
+    std::uint64_t overflow_ = 0;
+    std::uint64_t sequence_ = 0;
+};
+
+/// Preallocated ring of frame batches between the thread that builds frames
+/// and the one that draws them (one of each).
+///
+/// All slots live in one block allocated once, either owned by the ring or
+/// supplied by the caller, e.g. a persistently mapped GPU buffer, so each
+/// frame's instances are written exactly once to where they are drawn from
+/// and nothing is allocated per frame. With three slots the builder never
+/// waits: one slot is being drawn, one holds the newest frame, and the third
+/// (or a stale unread frame) is free to fill.
+class BatchRing {
+public:
+    /// Bytes of storage `slots` batches need; a multiple of the cache line.
+    static std::size_t storage_bytes(const BatchCapacity& capacity, int slots);
+
+    /// Throws std::invalid_argument for fewer than two slots.
+    explicit BatchRing(const BatchCapacity& capacity, int slots = 3);
+    /// Uses `storage` (storage_bytes() long, cache-line aligned), which must
+    /// outlive the ring.
+    BatchRing(const BatchCapacity& capacity, int slots, std::byte* storage);
+
+    BatchRing(const BatchRing&) = delete;
+    BatchRing& operator=(const BatchRing&) = delete;
+
+    int num_slots() const { return static_cast<int>(batches_.size()); }
+    const std::byte* storage() const { return storage_; }
+
+    /// Builder side: a cleared batch to fill, or null when every slot is in
+    /// use (only possible with two slots).
+    RenderBatch* begin_frame();
+    /// Makes a batch from begin_frame() the newest frame.
+    void publish(RenderBatch* batch);
+
+    /// Drawing side: takes the newest published frame, or null when nothing
+    /// new has been published since the last acquire. Release it after
+    /// drawing (and, for GPU storage, after the GPU is done reading it).
+    const RenderBatch* acquire();
+    void release(const RenderBatch* batch);
+
+    /// Published frames replaced before they were drawn.
+    std::uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+
+private:
+    enum State : std::uint32_t { kFree, kWriting, kReady, kReading };
+
+    struct alignas(kCacheLineSize) Slot {
+        std::atomic<std::uint32_t> state{kFree};
+        std::atomic<std::uint64_t> sequence{0};
+    };
+
+    void bind(const BatchCapacity& capacity, int slots, std::byte* storage);
+    int slot_of(const RenderBatch* batch) const;
+
+    AlignedBuffer owned_;
+    std::byte* storage_ = nullptr;
+    std::vector<RenderBatch> batches_;
+    std::unique_ptr<Slot[]> slots_;
+    std::uint64_t next_sequence_ = 1;  // builder only
+    std::uint64_t last_acquired_ = 0;  // drawing side only
+    std::atomic<std::uint64_t> skipped_{0};
+};
+
+}  // namespace mm::viz
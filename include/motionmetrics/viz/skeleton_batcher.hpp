@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/core/math.hpp"
+#include "motionmetrics/trajectory/trajectory_set.hpp"
+#include "motionmetrics/viz/camera.hpp"
+#include "motionmetrics/viz/render_batch.hpp"
+#include "motionmetrics/viz/trail_lod.hpp"
+
+namespace mm::viz {
+
+/// How a marker set is drawn: markers as spheres and the named pairs as
+/// bones between them.
+struct StickFigure {
+    std::vector<std::pair<std::string, std::string>> bones;
+    float marker_radius = 0.012f;  // m
+    float bone_radius = 0.006f;    // m
+};
+
+struct TrailOptions {
+    /// Trail length behind the current frame, in frames; 0 draws none.
+    std::int64_t frames = 400;
+    /// Largest on-screen deviation of a simplified trail, pixels.
+    double pixel_tolerance = 0.75;
+};
+
+struct BatchStats {
+    /// Layers whose pose was inside and outside the view.
+    int layers_drawn = 0;
+    int layers_culled = 0;
+    std::uint32_t trail_vertices = 0;
+};
+
+/// Builds one frame's instance batch from several trials drawn over each
+/// other, e.g. ten athletes' jumps aligned at take-off.
+///
+/// Each layer is a trial with its own frame offset, placement and colour.
+/// Per frame, a layer's markers are bounded by a sphere and the pose is
+/// culled against the view frustum; visible poses append their markers
+/// and bones to the shared instance arrays, so the frame is drawn with one
+/// instanced draw per primitive type whatever the layer count. Trails use
+/// TrailLod with the pixel tolerance converted to world units at the
+/// layer's depth.
+class SkeletonBatcher {
+public:
+    /// Adds a trial drawn with `figure`; `set` must outlive the batcher.
+    /// Throws std::invalid_argument if a bone or trail names a marker the
+    /// trial lacks. Returns the layer index.
+    int add_layer(const trajectory::TrajectorySet& set, const StickFigure& figure, std::uint32_t colour,
+                  const std::vector<std::string>& trail_markers = {});
+
+    int num_layers() const { return static_cast<int>(layers_.size()); }
+    /// Layer frame shown at display frame f is f + offset (align events).
+    void set_frame_offset(int layer, std::int64_t offset) { layers_.at(layer).frame_offset = offset; }
+    /// World translation applied to the layer (side-by-side comparison).
+    void set_translation(int layer, const Vec3d& translation) { layers_.at(layer).translation = translation; }
+    void set_visible(int layer, bool visible) { layers_.at(layer).visible = visible; }
+
+    /// Appends display frame `frame` of every visible layer to `batch`.
+    BatchStats build(std::int64_t frame, const Camera& camera, const TrailOptions& trails, RenderBatch& batch);
+
+private:
+    struct Layer {
+        const trajectory::TrajectorySet* set = nullptr;
+        std::vector<std::pair<int, int>> bones;
+        float marker_radius = 0.0f;
+        float bone_radius = 0.0f;
+        std::uint32_t colour = 0;
+        std::int64_t frame_offset = 0;
+        bool visible = true;
+        Vec3d translation{};
+        std::vector<TrailLod> trails;
+    };
+
+    std::vector<Layer> layers_;
+    // Marker positions of the frame being built.
+    std::vector<Vec3d> positions_;
+    std::vector<char> present_;
+};
+
+}  // namespace mm::viz
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "motionmetrics/core/aligned_buffer.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/viz/camera.hpp"
+#include "motionmetrics/viz/render_batch.hpp"
+
+namespace mm::viz {
+
+/// CPU renderer for render batches, for machines without a GPU.
+///
+/// A frame runs in three passes over flat arrays. Every marker, bone and
+/// trail segment is projected to a screen-space disc or capsule (in
+/// parallel, by chunks of instances); the primitives are binned into
+/// 64x64-pixel tiles; and the tiles are rasterised in parallel, each with
+/// its colour and depth in cache and no locking, since tiles never share
+/// pixels. Markers and bones are opaque and depth tested; trails blend over
+/// them without writing depth. Output is 0xAARRGGBB, rows padded to a cache
+/// line.
+class SoftwareRasterizer {
+public:
+    /// Throws std::invalid_argument for a non-positive size.
+    SoftwareRasterizer(int width, int height, WorkStealingPool* pool = nullptr);
+
+    void set_background(std::uint32_t colour) { background_ = colour; }
+
+    /// Draws `batch` as seen by `camera`, whose viewport must match.
+    void render(const RenderBatch& batch, const Camera& camera);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    /// Pixels between consecutive rows.
+    std::ptrdiff_t stride() const { return stride_; }
+    const std::uint32_t* pixels() const { return colour_.as<std::uint32_t>(); }
+    const std::uint32_t* row(int y) const { return pixels() + y * stride_; }
+
+private:
+    static constexpr int kTileShift = 6;
+
+    enum class Kind : std::uint8_t { none, disc, capsule, line };
+
+    struct Primitive {
+        float x0, y0, x1, y1;
+        /// Disc radius or capsule half width, pixels.
+        float radius;
+        /// Depth at each end; discs: centre depth and world radius.
+        float depth0, depth1;
+        std::uint32_t colour;
+        Kind kind;
+    };
+
+    void project(const RenderBatch& batch, const Camera& camera, std::size_t first, std::size_t last);
+    void bin();
+    void raster_tile(int tile);
+
+    int width_;
+    int height_;
+    std::ptrdiff_t stride_;
+    int tiles_x_;
+    int tiles_y_;
+    WorkStealingPool* pool_;
+    std::uint32_t background_ = 0xff202020u;
+    AlignedBuffer colour_;
+    AlignedBuffer depth_;
+    std::vector<Primitive> primitives_;
+    /// Primitive indices of tile t: bins_[bin_start_[t], bin_start_[t + 1]).
+    std::vector<std::uint32_t> bin_start_;
+    std::vector<std::uint32_t> bins_;
+    std::vector<std::uint32_t> bin_fill_;
+    /// Per trail vertex: last of its strip.
+    std::vector<char> strip_end_;
+};
+
+}  // namespace mm::viz
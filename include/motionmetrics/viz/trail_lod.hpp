@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/trajectory/trajectory_set.hpp"
+#include "motionmetrics/viz/render_batch.hpp"
+
+namespace mm::viz {
+
+/// Level-of-detail marker trail: any time window of a trajectory as a
+/// polyline simplified to a given tolerance, without re-simplifying per
+/// frame.
+///
+/// Douglas-Peucker runs once over each gap-free run of the trajectory and
+/// records for every vertex the tolerance below which it is kept (capped by
+/// its parent split's, so the levels nest). A view then keeps the vertices
+/// above its tolerance, skipping whole blocks whose largest level is below
+/// it, so a zoomed-out trail costs little more than the vertices it draws.
+/// Windows cut through the recorded hierarchy keep their end points and are
+/// otherwise approximate.
+///
+/// The trail reads the set's columns in place; the set must outlive it and
+/// its positions must not change.
+class TrailLod {
+public:
+    TrailLod(const trajectory::TrajectorySet& set, int marker);
+
+    std::int64_t frames() const { return frames_; }
+
+    /// Appends frames [first, last] simplified to `tolerance` (world units),
+    /// moved by `translation`, as one strip per gap-free run. Returns the
+    /// vertices added.
+    std::size_t emit(std::int64_t first, std::int64_t last, double tolerance, std::uint32_t colour,
+                     RenderBatch& batch, const Vec3d& translation = {}) const;
+    /// The frames emit() would draw, for back ends that build their own
+    /// geometry.
+    void select(std::int64_t first, std::int64_t last, double tolerance, std::vector<std::int64_t>& out) const;
+
+private:
+    static constexpr int kBlockShift = 6;
+
+    void build_run(std::int64_t a, std::int64_t b);
+    /// Calls `fn(frame)` for each kept frame of run `run` within [first, last].
+    template <typename Fn>
+    void walk(std::size_t run, std::int64_t first, std::int64_t last, float tolerance, Fn&& fn) const;
+
+    const float* x_ = nullptr;
+    const float* y_ = nullptr;
+    const float* z_ = nullptr;
+    std::int64_t frames_ = 0;
+    /// Gap-free runs [first, last], in frame order.
+    std::vector<std::pair<std::int64_t, std::int64_t>> runs_;
+    /// Per frame: largest tolerance at which it is still kept (infinite at
+    /// run ends, -1 for missing frames).
+    std::vector<float> level_;
+    /// Largest level per block of 2^kBlockShift frames.
+    std::vector<float> block_level_;
+};
+
+}  // namespace mm::viz
@@ -0,0 +1,186 @@
+#include "motionmetrics/analysis/jump_detector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::analysis {
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+/// Fraction of the way from `a` to `b` at which `level` is crossed, 1 when
+/// undefined (a missing previous value or a flat segment).
+double crossing_fraction(double a, double b, double level) {
+    const double f = (level - a) / (b - a);
+    return f >= 0.0 && f <= 1.0 ? f : 1.0;
+}
+
+TimestampNs lerp_time(TimestampNs a, TimestampNs b, double f) {
+    return a + static_cast<TimestampNs>(std::llround(f * static_cast<double>(b - a)));
+}
+
+double seconds(TimestampNs ns) { return static_cast<double>(ns) * 1e-9; }
+
+}  // namespace
+
+JumpDetector::JumpDetector(JumpDetectorParams params) : params_(params) {}
+
+void JumpDetector::reset() {
+    state_ = State::unknown;
+    has_previous_ = false;
+    standing_known_ = false;
+    ground_known_ = false;
+    jumps_ = 0;
+    rejected_ = 0;
+}
+
+bool JumpDetector::push(const JumpSample& input) {
+    if (input.com_height != input.com_height) return false;
+    if (has_previous_ && input.timestamp <= previous_.timestamp) return false;
+    JumpSample s = input;
+    if (s.com_velocity != s.com_velocity)
+        s.com_velocity = has_previous_ ? (s.com_height - previous_.com_height) / seconds(s.timestamp - previous_.timestamp)
+                                       : 0.0;
+
+    const bool foot_known = s.foot_height == s.foot_height;
+    const bool still = std::abs(s.com_velocity) < params_.still_velocity;
+    if (!still || !has_previous_) still_since_ = s.timestamp;
+    const double settled = seconds(s.timestamp - still_since_);
+    const double level = ground_level_ + params_.contact_threshold;
+    const bool airborne = foot_known && ground_known_ && s.foot_height > level;
+    const double alpha = params_.baseline_smoothing;
+    bool completed = false;
+
+    switch (state_) {
+        case State::unknown:
+            if (foot_known && still) {
+                standing_height_ = s.com_height;
+                ground_level_ = s.foot_height;
+                standing_known_ = ground_known_ = true;
+                state_ = State::standing;
+            }
+            break;
+        case State::standing:
+            if (airborne) {
+                current_ = Jump{};
+                rebound_ = false;
+                take_off(s, level);
+            } else if (s.com_velocity < -params_.movement_velocity) {
+                current_ = Jump{};
+                const double f = crossing_fraction(previous_.com_velocity, s.com_velocity, -params_.movement_velocity);
+                current_.movement_start = lerp_time(previous_.timestamp, s.timestamp, f);
+                lowest_com_ = s.com_height;
+                rebound_ = false;
+                state_ = State::moving;
+            } else if (still) {
+                standing_height_ += alpha * (s.com_height - standing_height_);
+                if (foot_known) ground_level_ += alpha * (s.foot_height - ground_level_);
+            }
+            break;
+        case State::moving:
+            lowest_com_ = std::min(lowest_com_, s.com_height);
+            if (airborne)
+                take_off(s, level);
+            else if (settled >= params_.settle_time)
+                state_ = State::standing;  // countermovement without a jump
+            break;
+        case State::airborne:
+            if (!apex_seen_ && previous_.com_velocity > 0.0 && s.com_velocity <= 0.0) {
+                current_.apex = lerp_time(previous_.timestamp, s.timestamp,
+                                          crossing_fraction(previous_.com_velocity, s.com_velocity, 0.0));
+                apex_seen_ = true;
+            }
+            apex_height_ = std::max(apex_height_, s.com_height);
+            if (foot_known && s.foot_height <= level) {
+                const TimestampNs landing = lerp_time(previous_.timestamp, s.timestamp,
+                                                      crossing_fraction(previous_.foot_height, s.foot_height, level));
+                completed = finish_jump(landing);
+                landed_at_ = landing;
+                state_ = State::landed;
+            } else if (seconds(s.timestamp - current_.takeoff) > params_.max_flight_time) {
+                // Lost the ground reference (or left the volume): start over.
+                ++rejected_;
+                state_ = State::unknown;
+            }
+            break;
+        case State::landed:
+            if (airborne) {
+                current_ = Jump{};
+                rebound_ = true;
+                take_off(s, level);
+            } else if (settled >= params_.settle_time) {
+                standing_height_ = s.com_height;
+                state_ = State::standing;
+            }
+            break;
+    }
+    previous_ = s;
+    has_previous_ = true;
+    return completed;
+}
+
+void JumpDetector::take_off(const JumpSample& s, double level) {
+    const double f = crossing_fraction(previous_.foot_height, s.foot_height, level);
+    current_.takeoff = lerp_time(previous_.timestamp, s.timestamp, f);
+    current_.takeoff_velocity = previous_.com_velocity + f * (s.com_velocity - previous_.com_velocity);
+    current_.contact_time = kNaN;
+    current_.movement_time = kNaN;
+    current_.countermovement_depth = kNaN;
+    if (current_.movement_start) {
+        current_.movement_time = seconds(current_.takeoff - *current_.movement_start);
+        current_.countermovement_depth = standing_height_ - lowest_com_;
+    }
+    if (rebound_) {
+        const double contact = seconds(current_.takeoff - landed_at_);
+        if (contact <= params_.max_contact_time) current_.contact_time = contact;
+    }
+    apex_height_ = s.com_height;
+    apex_seen_ = false;
+    state_ = State::airborne;
+}
+
+bool JumpDetector::finish_jump(TimestampNs landing) {
+    current_.landing = landing;
+    current_.flight_time = seconds(landing - current_.takeoff);
+    if (current_.flight_time < params_.min_flight_time || current_.flight_time > params_.max_flight_time) {
+        ++rejected_;
+        return false;
+    }
+    if (!apex_seen_) current_.apex = current_.takeoff + (landing - current_.takeoff) / 2;
+    current_.height_flight_time = params_.gravity * current_.flight_time * current_.flight_time / 8.0;
+    current_.height_com = standing_known_ ? apex_height_ - standing_height_ : kNaN;
+    last_jump_ = current_;
+    ++jumps_;
+    return true;
+}
+
+std::vector<Jump> detect_jumps(const JumpSeries& series, const JumpDetectorParams& params) {
+    MM_TRACE_SCOPE("detect_jumps");
+    JumpDetector detector(params);
+    std::vector<Jump> jumps;
+    for (std::int64_t f = 0; f < series.frames; ++f) {
+        JumpSample s;
+        s.timestamp = series.timestamps[f];
+        s.com_height = series.com_height[f];
+        s.com_velocity = series.com_velocity ? series.com_velocity[f] : kNaN;
+        s.foot_height = series.foot_height[f];
+        if (detector.push(s)) jumps.push_back(detector.last_jump());
+    }
+    return jumps;
+}
+
+std::vector<std::vector<Jump>> detect_jumps(const std::vector<JumpSeries>& series, const JumpDetectorParams& params,
+                                            WorkStealingPool* pool) {
+    std::vector<std::vector<Jump>> out(series.size());
+    auto run = [&](int i) { out[i] = detect_jumps(series[i], params); };
+    if (pool)
+        pool->parallel_for(0, static_cast<int>(series.size()), 1, run);
+    else
+        for (int i = 0; i < static_cast<int>(series.size()); ++i) run(i);
+    return out;
+}
+
+}  // namespace mm::analysis
@@ -0,0 +1,463 @@
+#include "motionmetrics/calibration/bundle_adjustment.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "motionmetrics/core/linear_algebra.hpp"
+#include "motionmetrics/core/trace.hpp"
+#include "motionmetrics/reconstruction/triangulation.hpp"
+
+namespace mm::calibration {
+namespace {
+
+constexpr double kMinDepth = 1e-6;
+
+/// Inverse of a small SPD matrix (n <= 6) via Cholesky.
+bool spd_inverse(const double* a, int n, double* inv) {
+    double l[36];
+    std::copy(a, a + n * n, l);
+    if (!cholesky(l, n, n)) return false;
+    for (int c = 0; c < n; ++c) {
+        double col[6] = {};
+        col[c] = 1.0;
+        cholesky_solve(l, n, n, col);
+        for (int r = 0; r < n; ++r) inv[r * n + c] = col[r];
+    }
+    return true;
+}
+
+double huber(double e, double delta, double& weight) {
+    if (e <= delta) {
+        weight = 1.0;
+        return 0.5 * e * e;
+    }
+    weight = delta / e;
+    return delta * (e - 0.5 * delta);
+}
+
+/// Reprojection residual and Jacobians of one observation. `jc` is 2x6 with
+/// respect to the camera perturbation [dw, dt] (x_cam' = exp(dw) x_cam + dt),
+/// `jp` is 2x3 with respect to the world point.
+bool project_with_jacobians(const Intrinsics& k, const Pose& pose, const double* x, const Vec2d& pixel, double r[2],
+                            double jc[12], double jp[6]) {
+    const Vec3d pw{x[0], x[1], x[2]};
+    const Vec3d pc = pose.transform(pw);
+    if (pc.z < kMinDepth) return false;
+    const double iz = 1.0 / pc.z;
+    r[0] = k.fx * pc.x * iz + k.cx - pixel.x;
+    r[1] = k.fy * pc.y * iz + k.cy - pixel.y;
+    if (jc == nullptr) return true;
+
+    // d(u,v)/d(x_cam)
+    const double a00 = k.fx * iz, a02 = -k.fx * pc.x * iz * iz;
+    const double a11 = k.fy * iz, a12 = -k.fy * pc.y * iz * iz;
+    // d(x_cam)/d(dw) = -[x_cam]_x
+    const Mat3d s = skew(pc);
+    for (int c = 0; c < 3; ++c) {
+        jc[c] = -(a00 * s(0, c) + a02 * s(2, c));
+        jc[6 + c] = -(a11 * s(1, c) + a12 * s(2, c));
+    }
+    jc[3] = a00;
+    jc[4] = 0.0;
+    jc[5] = a02;
+    jc[9] = 0.0;
+    jc[10] = a11;
+    jc[11] = a12;
+    const Mat3d& rot = pose.rotation;
+    for (int c = 0; c < 3; ++c) {
+        jp[c] = a00 * rot(0, c) + a02 * rot(2, c);
+        jp[3 + c] = a11 * rot(1, c) + a12 * rot(2, c);
+    }
+    return true;
+}
+
+Pose apply_update(const Pose& pose, const double* delta) {
+    const Mat3d dr = rotation_from_axis_angle(Vec3d{delta[0], delta[1], delta[2]});
+    Pose out;
+    out.rotation = dr * pose.rotation;
+    out.translation = dr * pose.translation + Vec3d{delta[3], delta[4], delta[5]};
+    return out;
+}
+
+}  // namespace
+
+void BundleAdjuster::WorkerAccum::reset(int num_variables) {
+    const std::size_t n = static_cast<std::size_t>(num_variables) * 6;
+    s.assign(n * n, 0.0);
+    rhs.assign(n, 0.0);
+    u_diag.assign(n, 0.0);
+    pattern.assign(static_cast<std::size_t>(num_variables) * num_variables, 0);
+    cost = 0.0;
+}
+
+BundleAdjuster::BundleAdjuster(std::vector<CameraModel> cameras, BundleAdjustmentOptions options)
+    : cameras_(std::move(cameras)), options_(std::move(options)) {
+    if (cameras_.size() < 2) throw std::invalid_argument("BundleAdjuster: need at least two cameras");
+    variable_index_.assign(cameras_.size(), 0);
+    for (int c : options_.fixed_cameras) {
+        if (c < 0 || c >= static_cast<int>(cameras_.size()))
+            throw std::invalid_argument("BundleAdjuster: fixed camera out of range");
+        variable_index_[c] = -1;
+    }
+    for (int& v : variable_index_)
+        if (v == 0) v = num_variables_++;
+    accums_.resize(options_.pool != nullptr ? options_.pool->size() + 1 : 1);
+}
+
+bool BundleAdjuster::initialise_point(const std::vector<PointView>& views, double* x) const {
+    if (views.size() < 2) return false;
+    std::vector<Mat34d> projections;
+    std::vector<const Mat34d*> pointers;
+    std::vector<Vec2d> pixels;
+    projections.reserve(views.size());
+    for (const PointView& v : views) {
+        if (v.camera < 0 || v.camera >= static_cast<int>(cameras_.size()))
+            throw std::invalid_argument("BundleAdjuster: camera index out of range");
+        projections.push_back(cameras_[v.camera].projection());
+        pixels.push_back(v.pixel);
+    }
+    for (const Mat34d& p : projections) pointers.push_back(&p);
+    Vec3d point;
+    if (!reconstruction::triangulate_point(pointers.data(), pixels.data(), static_cast<int>(views.size()), point))
+        return false;
+    for (const PointView& v : views)
+        if (cameras_[v.camera].pose.transform(point).z < kMinDepth) return false;
+    x[0] = point.x;
+    x[1] = point.y;
+    x[2] = point.z;
+    return true;
+}
+
+void BundleAdjuster::push_landmark(Landmark landmark) {
+    landmarks_.push_back(std::move(landmark));
+    while (static_cast<int>(landmarks_.size()) > options_.max_landmarks) landmarks_.pop_front();
+}
+
+bool BundleAdjuster::add_marker(const std::vector<PointView>& views) {
+    Landmark landmark;
+    if (!initialise_point(views, landmark.x)) return false;
+    for (const PointView& v : views) landmark.observations.push_back(Observation{v.camera, 0, v.pixel});
+    push_landmark(std::move(landmark));
+    return true;
+}
+
+bool BundleAdjuster::add_wand(const std::vector<PointView>& end_a, const std::vector<PointView>& end_b,
+                              double length) {
+    if (!(length > 0.0)) throw std::invalid_argument("BundleAdjuster: wand length must be positive");
+    Landmark landmark;
+    landmark.points = 2;
+    landmark.length = length;
+    if (!initialise_point(end_a, landmark.x) || !initialise_point(end_b, landmark.x + 3)) return false;
+    for (const PointView& v : end_a) landmark.observations.push_back(Observation{v.camera, 0, v.pixel});
+    for (const PointView& v : end_b) landmark.observations.push_back(Observation{v.camera, 1, v.pixel});
+    push_landmark(std::move(landmark));
+    return true;
+}
+
+double BundleAdjuster::landmark_cost(const Landmark& landmark, const double* x, const std::vector<Pose>& poses,
+                                     double* squared_error, int* count) const {
+    double cost = 0.0;
+    for (const Observation& obs : landmark.observations) {
+        double r[2];
+        if (!project_with_jacobians(cameras_[obs.camera].intrinsics, poses[obs.camera], x + 3 * obs.point, obs.pixel,
+                                    r, nullptr, nullptr))
+            continue;
+        const double e2 = r[0] * r[0] + r[1] * r[1];
+        double w;
+        cost += huber(std::sqrt(e2), options_.huber_delta_px, w);
+        if (squared_error != nullptr) *squared_error += e2;
+        if (count != nullptr) ++*count;
+    }
+    if (landmark.points == 2 && landmark.length > 0.0) {
+        const double len = std::sqrt((x[0] - x[3]) * (x[0] - x[3]) + (x[1] - x[4]) * (x[1] - x[4]) +
+                                     (x[2] - x[5]) * (x[2] - x[5]));
+        const double rl = options_.wand_length_weight * (len - landmark.length);
+        cost += 0.5 * rl * rl;
+    }
+    return cost;
+}
+
+void BundleAdjuster::linearise_landmark(int index, double lambda, WorkerAccum& acc) {
+    const Landmark& lm = landmarks_[index];
+    LandmarkSystem& sys = systems_[index];
+    const int d = 3 * lm.points;
+    const int n = 6 * num_variables_;
+    double v[36] = {};
+    std::fill(sys.g, sys.g + 6, 0.0);
+    sys.w.clear();
+
+    for (const Observation& obs : lm.observations) {
+        double r[2], jc[12], jp[6];
+        const Pose& pose = cameras_[obs.camera].pose;
+        if (!project_with_jacobians(cameras_[obs.camera].intrinsics, pose, lm.x + 3 * obs.point, obs.pixel, r, jc, jp))
+            continue;
+        double w;
+        acc.cost += huber(std::sqrt(r[0] * r[0] + r[1] * r[1]), options_.huber_delta_px, w);
+
+        const int po = 3 * obs.point;
+        for (int i = 0; i < 3; ++i) {
+            sys.g[po + i] += w * (jp[i] * r[0] + jp[3 + i] * r[1]);
+            for (int j = 0; j < 3; ++j) v[(po + i) * d + po + j] += w * (jp[i] * jp[j] + jp[3 + i] * jp[3 + j]);
+        }
+
+        const int vi = variable_index_[obs.camera];
+        if (vi < 0) continue;
+        double* s = acc.s.data();
+        for (int i = 0; i < 6; ++i) {
+            acc.rhs[6 * vi + i] -= w * (jc[i] * r[0] + jc[6 + i] * r[1]);
+            for (int j = 0; j < 6; ++j)
+                s[(6 * vi + i) * n + 6 * vi + j] += w * (jc[i] * jc[j] + jc[6 + i] * jc[6 + j]);
+            acc.u_diag[6 * vi + i] += w * (jc[i] * jc[i] + jc[6 + i] * jc[6 + i]);
+        }
+        acc.pattern[vi * num_variables_ + vi] = 1;
+
+        auto it = std::find_if(sys.w.begin(), sys.w.end(), [&](const auto& b) { return b.first == vi; });
+        if (it == sys.w.end()) {
+            sys.w.emplace_back(vi, std::vector<double>(6 * d, 0.0));
+            it = sys.w.end() - 1;
+        }
+        for (int i = 0; i < 6; ++i)
+            for (int j = 0; j < 3; ++j) it->second[i * d + po + j] += w * (jc[i] * jp[j] + jc[6 + i] * jp[3 + j]);
+    }
+
+    if (lm.points == 2 && lm.length > 0.0) {
+        double dv[3] = {lm.x[0] - lm.x[3], lm.x[1] - lm.x[4], lm.x[2] - lm.x[5]};
+        const double len = std::sqrt(dv[0] * dv[0] + dv[1] * dv[1] + dv[2] * dv[2]);
+        if (len > 0.0) {
+            const double s = options_.wand_length_weight;
+            const double rl = s * (len - lm.length);
+            acc.cost += 0.5 * rl * rl;
+            double j[6];
+            for (int i = 0; i < 3; ++i) {
+                j[i] = s * dv[i] / len;
+                j[3 + i] = -j[i];
+            }
+            for (int a = 0; a < 6; ++a) {
+                sys.g[a] += j[a] * rl;
+                for (int b = 0; b < 6; ++b) v[a * 6 + b] += j[a] * j[b];
+            }
+        }
+    }
+
+    for (int i = 0; i < d; ++i) v[i * d + i] += lambda * v[i * d + i] + 1e-12;
+    if (!spd_inverse(v, d, sys.v_inv)) {
+        // Unconstrained landmark: leave it out of this step.
+        std::fill(sys.v_inv, sys.v_inv + 36, 0.0);
+        sys.w.clear();
+        return;
+    }
+
+    // Schur complement: S -= W V^-1 W^T, rhs += W V^-1 g.
+    double* s = acc.s.data();
+    std::vector<double> wv(6 * d);
+    for (const auto& [vi, wi] : sys.w) {
+        for (int r = 0; r < 6; ++r)
+            for (int c = 0; c < d; ++c) {
+                double sum = 0.0;
+                for (int k = 0; k < d; ++k) sum += wi[r * d + k] * sys.v_inv[k * d + c];
+                wv[r * d + c] = sum;
+            }
+        for (int r = 0; r < 6; ++r) {
+            double sum = 0.0;
+            for (int k = 0; k < d; ++k) sum += wv[r * d + k] * sys.g[k];
+            acc.rhs[6 * vi + r] += sum;
+        }
+        for (const auto& [vj, wj] : sys.w) {
+            for (int r = 0; r < 6; ++r)
+                for (int c = 0; c < 6; ++c) {
+                    double sum = 0.0;
+                    for (int k = 0; k < d; ++k) sum += wv[r * d + k] * wj[c * d + k];
+                    s[(6 * vi + r) * n + 6 * vj + c] -= sum;
+                }
+            acc.pattern[vi * num_variables_ + vj] = 1;
+        }
+    }
+}
+
+double BundleAdjuster::linearise(double lambda) {
+    const int count = num_landmarks();
+    systems_.resize(count);
+    for (WorkerAccum& acc : accums_) acc.reset(num_variables_);
+
+    WorkStealingPool* pool = options_.pool;
+    if (pool != nullptr) {
+        pool->parallel_for(0, count, options_.grain,
+                           [&](int i) { linearise_landmark(i, lambda, accums_[pool->current_slot()]); });
+    } else {
+        for (int i = 0; i < count; ++i) linearise_landmark(i, lambda, accums_[0]);
+    }
+
+    total_.reset(num_variables_);
+    for (const WorkerAccum& acc : accums_) {
+        for (std::size_t i = 0; i < acc.s.size(); ++i) total_.s[i] += acc.s[i];
+        for (std::size_t i = 0; i < acc.rhs.size(); ++i) {
+            total_.rhs[i] += acc.rhs[i];
+            total_.u_diag[i] += acc.u_diag[i];
+        }
+        for (std::size_t i = 0; i < acc.pattern.size(); ++i) total_.pattern[i] |= acc.pattern[i];
+        total_.cost += acc.cost;
+    }
+    const int n = 6 * num_variables_;
+    for (int i = 0; i < n; ++i) total_.s[i * n + i] += lambda * total_.u_diag[i] + 1e-12;
+    return total_.cost;
+}
+
+bool BundleAdjuster::solve_reduced(std::vector<double>& delta) {
+    // Block Cholesky over the co-visibility pattern: blocks that are zero in
+    // the pattern (after symbolic fill-in) are never touched.
+    const int nb = num_variables_;
+    const int n = 6 * nb;
+    std::vector<char>& pat = total_.pattern;
+    for (int k = 0; k < nb; ++k)
+        for (int i = k + 1; i < nb; ++i) {
+            if (!pat[i * nb + k]) continue;
+            for (int j = k + 1; j <= i; ++j)
+                if (pat[j * nb + k]) pat[i * nb + j] = pat[j * nb + i] = 1;
+        }
+
+    double* a = total_.s.data();
+    for (int k = 0; k < nb; ++k) {
+        double* akk = a + (6 * k) * n + 6 * k;
+        if (!cholesky(akk, 6, n)) return false;
+        for (int i = k + 1; i < nb; ++i) {
+            if (!pat[i * nb + k]) continue;
+            // L_ik = A_ik L_kk^-T (row-wise forward substitution).
+            double* aik = a + (6 * i) * n + 6 * k;
+            for (int r = 0; r < 6; ++r)
+                for (int c = 0; c < 6; ++c) {
+                    double s = aik[r * n + c];
+                    for (int m = 0; m < c; ++m) s -= aik[r * n + m] * akk[c * n + m];
+                    aik[r * n + c] = s / akk[c * n + c];
+                }
+        }
+        for (int i = k + 1; i < nb; ++i) {
+            if (!pat[i * nb + k]) continue;
+            const double* lik = a + (6 * i) * n + 6 * k;
+            for (int j = k + 1; j <= i; ++j) {
+                if (!pat[j * nb + k]) continue;
+                const double* ljk = a + (6 * j) * n + 6 * k;
+                double* aij = a + (6 * i) * n + 6 * j;
+                for (int r = 0; r < 6; ++r)
+                    for (int c = 0; c < 6; ++c) {
+                        double s = 0.0;
+                        for (int m = 0; m < 6; ++m) s += lik[r * n + m] * ljk[c * n + m];
+                        aij[r * n + c] -= s;
+                    }
+            }
+        }
+    }
+
+    // Triangular solves, restricted to the pattern.
+    delta = total_.rhs;
+    for (int bi = 0; bi < nb; ++bi)
+        for (int r = 0; r < 6; ++r) {
+            const int i = 6 * bi + r;
+            double s = delta[i];
+            for (int bk = 0; bk <= bi; ++bk) {
+                if (!pat[bi * nb + bk]) continue;
+                const int end = bk == bi ? i : 6 * bk + 6;
+                for (int k = 6 * bk; k < end; ++k) s -= a[i * n + k] * delta[k];
+            }
+            delta[i] = s / a[i * n + i];
+        }
+    for (int bi = nb - 1; bi >= 0; --bi)
+        for (int r = 5; r >= 0; --r) {
+            const int i = 6 * bi + r;
+            double s = delta[i];
+            for (int bk = bi; bk < nb; ++bk) {
+                if (!pat[bk * nb + bi]) continue;
+                const int begin = bk == bi ? i + 1 : 6 * bk;
+                for (int k = begin; k < 6 * bk + 6; ++k) s -= a[k * n + i] * delta[k];
+            }
+            delta[i] = s / a[i * n + i];
+        }
+    return true;
+}
+
+double BundleAdjuster::evaluate_cost(const std::vector<Pose>& poses, const std::vector<PointState>& points) const {
+    const int count = num_landmarks();
+    WorkStealingPool* pool = options_.pool;
+    if (pool == nullptr) {
+        double cost = 0.0;
+        for (int i = 0; i < count; ++i) cost += landmark_cost(landmarks_[i], points[i].data(), poses, nullptr, nullptr);
+        return cost;
+    }
+    std::vector<double> partial(pool->size() + 1, 0.0);
+    pool->parallel_for(0, count, options_.grain, [&](int i) {
+        partial[pool->current_slot()] += landmark_cost(landmarks_[i], points[i].data(), poses, nullptr, nullptr);
+    });
+    double cost = 0.0;
+    for (double p : partial) cost += p;
+    return cost;
+}
+
+BundleAdjustmentSummary BundleAdjuster::refine() {
+    MM_TRACE_SCOPE("bundle_adjustment");
+    BundleAdjustmentSummary summary;
+    const int count = num_landmarks();
+    if (count == 0 || num_variables_ == 0) return summary;
+
+    double lambda = options_.initial_lambda;
+    double cost = linearise(lambda);
+    summary.initial_cost = cost;
+
+    std::vector<double> delta;
+    std::vector<Pose> poses(cameras_.size());
+    std::vector<PointState> points(count);
+
+    for (int iter = 0; iter < options_.max_iterations; ++iter) {
+        summary.iterations = iter + 1;
+        if (!solve_reduced(delta)) {
+            lambda *= 10.0;
+            cost = linearise(lambda);
+            continue;
+        }
+
+        for (std::size_t c = 0; c < cameras_.size(); ++c) {
+            const int vi = variable_index_[c];
+            poses[c] = vi < 0 ? cameras_[c].pose : apply_update(cameras_[c].pose, delta.data() + 6 * vi);
+        }
+        // Back-substitute the landmarks: dp = V^-1 (-g - W^T dc).
+        for (int l = 0; l < count; ++l) {
+            const Landmark& lm = landmarks_[l];
+            const LandmarkSystem& sys = systems_[l];
+            const int d = 3 * lm.points;
+            double b[6];
+            for (int k = 0; k < d; ++k) b[k] = -sys.g[k];
+            for (const auto& [vi, w] : sys.w)
+                for (int k = 0; k < d; ++k)
+                    for (int r = 0; r < 6; ++r) b[k] -= w[r * d + k] * delta[6 * vi + r];
+            for (int k = 0; k < d; ++k) {
+                double s = 0.0;
+                for (int m = 0; m < d; ++m) s += sys.v_inv[k * d + m] * b[m];
+                points[l][k] = lm.x[k] + s;
+            }
+        }
+
+        const double new_cost = evaluate_cost(poses, points);
+        if (new_cost < cost) {
+            for (std::size_t c = 0; c < cameras_.size(); ++c) cameras_[c].pose = poses[c];
+            for (int l = 0; l < count; ++l) std::copy(points[l].begin(), points[l].begin() + 6, landmarks_[l].x);
+            const double improvement = (cost - new_cost) / std::max(cost, 1e-300);
+            lambda = std::max(lambda / 3.0, 1e-12);
+            cost = linearise(lambda);
+            if (improvement < options_.relative_tolerance) break;
+        } else {
+            lambda *= 4.0;
+            cost = linearise(lambda);
+        }
+    }
+
+    summary.final_cost = cost;
+    double squared = 0.0;
+    int observations = 0;
+    std::vector<Pose> current(cameras_.size());
+    for (std::size_t c = 0; c < cameras_.size(); ++c) current[c] = cameras_[c].pose;
+    for (const Landmark& lm : landmarks_) landmark_cost(lm, lm.x, current, &squared, &observations);
+    summary.observations = observations;
+    summary.rms_px = observations > 0 ? std::sqrt(squared / observations) : 0.0;
+    return summary;
+}
+
+}  // namespace mm::calibration
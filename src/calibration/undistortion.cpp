@@ -0,0 +1,246 @@
+#include "motionmetrics/calibration/undistortion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if MM_HAVE_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::calibration {
+namespace {
+
+constexpr int kMaxDimension = 32767;
+
+MM_ALWAYS_INLINE int sample(const std::uint8_t* src, std::ptrdiff_t stride, std::uint32_t position,
+                            std::uint16_t fraction) {
+    const int sx = static_cast<std::int16_t>(position & 0xffff);
+    if (sx < 0) return 0;
+    const int sy = static_cast<std::int16_t>(position >> 16);
+    const int fx = fraction & 0xff;
+    const int fy = fraction >> 8;
+    const std::uint8_t* p = src + sy * stride + sx;
+    const int top = p[0] * 256 + (p[1] - p[0]) * fx;
+    const int bottom = p[stride] * 256 + (p[stride + 1] - p[stride]) * fx;
+    return (top * 256 + (bottom - top) * fy + 32768) >> 16;
+}
+
+void remap_row_scalar(const std::uint32_t* MM_RESTRICT position, const std::uint16_t* MM_RESTRICT fraction,
+                      const std::uint8_t* src, std::ptrdiff_t stride, std::uint8_t* MM_RESTRICT out, int x0,
+                      int x1) {
+    for (int x = x0; x < x1; ++x) out[x] = static_cast<std::uint8_t>(sample(src, stride, position[x], fraction[x]));
+}
+
+#if MM_HAVE_X86_DISPATCH
+
+// Bilinear weights in 32-bit lanes, the same integer expression as `sample`.
+MM_TARGET_AVX2 inline __m256i blend_avx2(__m256i g0, __m256i g1, __m256i frac) {
+    const __m256i lo = _mm256_set1_epi32(0xff);
+    const __m256i fx = _mm256_and_si256(frac, lo);
+    const __m256i fy = _mm256_srli_epi32(frac, 8);
+    const __m256i p00 = _mm256_and_si256(g0, lo);
+    const __m256i p01 = _mm256_and_si256(_mm256_srli_epi32(g0, 8), lo);
+    const __m256i p10 = _mm256_and_si256(g1, lo);
+    const __m256i p11 = _mm256_and_si256(_mm256_srli_epi32(g1, 8), lo);
+    const __m256i top = _mm256_add_epi32(_mm256_slli_epi32(p00, 8), _mm256_mullo_epi32(_mm256_sub_epi32(p01, p00), fx));
+    const __m256i bottom =
+        _mm256_add_epi32(_mm256_slli_epi32(p10, 8), _mm256_mullo_epi32(_mm256_sub_epi32(p11, p10), fx));
+    const __m256i v = _mm256_add_epi32(_mm256_slli_epi32(top, 8), _mm256_mullo_epi32(_mm256_sub_epi32(bottom, top), fy));
+    return _mm256_srai_epi32(_mm256_add_epi32(v, _mm256_set1_epi32(32768)), 16);
+}
+
+MM_TARGET_AVX2 void remap_row_avx2(const std::uint32_t* MM_RESTRICT position,
+                                   const std::uint16_t* MM_RESTRICT fraction, const std::uint8_t* src,
+                                   std::ptrdiff_t stride, std::uint8_t* MM_RESTRICT out, int width) {
+    const __m256i vstride = _mm256_set1_epi32(static_cast<int>(stride));
+    const __m256i minus_one = _mm256_set1_epi32(-1);
+    const auto* base0 = reinterpret_cast<const int*>(src);
+    const auto* base1 = reinterpret_cast<const int*>(src + stride);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i pos = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position + x));
+        const __m256i frac = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(fraction + x)));
+        const __m256i sx = _mm256_srai_epi32(_mm256_slli_epi32(pos, 16), 16);
+        const __m256i sy = _mm256_srai_epi32(pos, 16);
+        const __m256i valid = _mm256_cmpgt_epi32(sx, minus_one);
+        const __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(sy, vstride), _mm256_max_epi32(sx, _mm256_setzero_si256()));
+        const __m256i g0 = _mm256_i32gather_epi32(base0, idx, 1);
+        const __m256i g1 = _mm256_i32gather_epi32(base1, idx, 1);
+        const __m256i v = _mm256_and_si256(blend_avx2(g0, g1, frac), valid);
+        const __m256i w16 = _mm256_packus_epi32(v, v);
+        const __m256i w8 = _mm256_packus_epi16(w16, w16);
+        const int lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(w8));
+        const int hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(w8, 1));
+        __builtin_memcpy(out + x, &lo, 4);
+        __builtin_memcpy(out + x + 4, &hi, 4);
+    }
+    remap_row_scalar(position, fraction, src, stride, out, x, width);
+}
+
+// GCC 12 warns about the intentionally undefined pass-through operands inside
+// its own AVX-512 intrinsic wrappers (GCC PR105593).
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+MM_TARGET_AVX512 void remap_row_avx512(const std::uint32_t* MM_RESTRICT position,
+                                       const std::uint16_t* MM_RESTRICT fraction, const std::uint8_t* src,
+                                       std::ptrdiff_t stride, std::uint8_t* MM_RESTRICT out, int width) {
+    const __m512i vstride = _mm512_set1_epi32(static_cast<int>(stride));
+    const __m512i lo = _mm512_set1_epi32(0xff);
+    const __m512i round = _mm512_set1_epi32(32768);
+    const auto* base0 = reinterpret_cast<const int*>(src);
+    const auto* base1 = reinterpret_cast<const int*>(src + stride);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m512i pos = _mm512_loadu_si512(position + x);
+        const __m512i frac = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(fraction + x)));
+        const __m512i sx = _mm512_srai_epi32(_mm512_slli_epi32(pos, 16), 16);
+        const __m512i sy = _mm512_srai_epi32(pos, 16);
+        const __mmask16 valid = _mm512_cmpgt_epi32_mask(sx, _mm512_set1_epi32(-1));
+        const __m512i idx = _mm512_add_epi32(_mm512_mullo_epi32(sy, vstride), _mm512_max_epi32(sx, _mm512_setzero_si512()));
+        const __m512i g0 = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), valid, idx, base0, 1);
+        const __m512i g1 = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), valid, idx, base1, 1);
+        const __m512i fx = _mm512_and_si512(frac, lo);
+        const __m512i fy = _mm512_srli_epi32(frac, 8);
+        const __m512i p00 = _mm512_and_si512(g0, lo);
+        const __m512i p01 = _mm512_and_si512(_mm512_srli_epi32(g0, 8), lo);
+        const __m512i p10 = _mm512_and_si512(g1, lo);
+        const __m512i p11 = _mm512_and_si512(_mm512_srli_epi32(g1, 8), lo);
+        const __m512i top = _mm512_add_epi32(_mm512_slli_epi32(p00, 8), _mm512_mullo_epi32(_mm512_sub_epi32(p01, p00), fx));
+        const __m512i bottom =
+            _mm512_add_epi32(_mm512_slli_epi32(p10, 8), _mm512_mullo_epi32(_mm512_sub_epi32(p11, p10), fx));
+        const __m512i v =
+            _mm512_add_epi32(_mm512_slli_epi32(top, 8), _mm512_mullo_epi32(_mm512_sub_epi32(bottom, top), fy));
+        const __m512i r = _mm512_maskz_srai_epi32(valid, _mm512_add_epi32(v, round), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm512_cvtepi32_epi8(r));
+    }
+    remap_row_scalar(position, fraction, src, stride, out, x, width);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+}  // namespace
+
+UndistortionMap::UndistortionMap(const Intrinsics& intrinsics, SimdLevel level, WorkStealingPool* pool)
+    : width_(intrinsics.width), height_(intrinsics.height), level_(clamp_simd_level(level)) {
+    if (width_ < 2 || height_ < 2 || width_ > kMaxDimension || height_ > kMaxDimension)
+        throw std::invalid_argument("UndistortionMap: image size out of range");
+
+    const std::size_t pixels = static_cast<std::size_t>(width_) * height_;
+    position_.resize(pixels);
+    fraction_.resize(pixels);
+    scalar_row_.assign(height_, 0);
+
+    auto build_row = [&](int y) {
+        std::uint32_t* pos = position_.data() + static_cast<std::size_t>(y) * width_;
+        std::uint16_t* frac = fraction_.data() + static_cast<std::size_t>(y) * width_;
+        bool bottom = false;
+        for (int x = 0; x < width_; ++x) {
+            const Vec2d s = distort_pixel(intrinsics, Vec2d{static_cast<double>(x), static_cast<double>(y)});
+            const long qx = std::lround(s.x * 256.0);
+            const long qy = std::lround(s.y * 256.0);
+            const long sx = qx >> 8;
+            const long sy = qy >> 8;
+            if (!std::isfinite(s.x) || !std::isfinite(s.y) || qx < 0 || qy < 0 || sx > width_ - 2 ||
+                sy > height_ - 2) {
+                pos[x] = 0xffffu;
+                frac[x] = 0;
+                continue;
+            }
+            pos[x] = static_cast<std::uint32_t>(sx) | static_cast<std::uint32_t>(sy) << 16;
+            frac[x] = static_cast<std::uint16_t>((qx & 0xff) | (qy & 0xff) << 8);
+            bottom |= sy == height_ - 2 && sx > width_ - 4;
+        }
+        scalar_row_[y] = bottom;
+    };
+    if (pool != nullptr) {
+        pool->parallel_for(0, height_, 16, build_row);
+    } else {
+        for (int y = 0; y < height_; ++y) build_row(y);
+    }
+}
+
+bool UndistortionMap::source(int x, int y, double& sx, double& sy) const {
+    const std::size_t i = static_cast<std::size_t>(y) * width_ + x;
+    const std::uint32_t pos = position_[i];
+    if (static_cast<std::int16_t>(pos & 0xffff) < 0) return false;
+    sx = static_cast<std::int16_t>(pos & 0xffff) + (fraction_[i] & 0xff) / 256.0;
+    sy = static_cast<std::int16_t>(pos >> 16) + (fraction_[i] >> 8) / 256.0;
+    return true;
+}
+
+void UndistortionMap::remap(const ImageView& distorted, std::uint8_t* out, std::ptrdiff_t out_stride) const {
+    MM_TRACE_SCOPE("undistort_remap");
+    if (distorted.width != width_ || distorted.height != height_)
+        throw std::invalid_argument("UndistortionMap: image size does not match the map");
+
+    for (int y = 0; y < height_; ++y) {
+        const std::size_t offset = static_cast<std::size_t>(y) * width_;
+        const std::uint32_t* pos = position_.data() + offset;
+        const std::uint16_t* frac = fraction_.data() + offset;
+        std::uint8_t* row = out + y * out_stride;
+        const SimdLevel level = scalar_row_[y] ? SimdLevel::scalar : level_;
+        switch (level) {
+#if MM_HAVE_X86_DISPATCH
+            case SimdLevel::avx512:
+                remap_row_avx512(pos, frac, distorted.data, distorted.stride, row, width_);
+                break;
+            case SimdLevel::avx2:
+                remap_row_avx2(pos, frac, distorted.data, distorted.stride, row, width_);
+                break;
+#endif
+            default:
+                remap_row_scalar(pos, frac, distorted.data, distorted.stride, row, 0, width_);
+                break;
+        }
+    }
+}
+
+PointUndistorter::PointUndistorter(const Intrinsics& intrinsics, int cell)
+    : intrinsics_(intrinsics), inv_cell_(1.0 / cell) {
+    if (cell <= 0) throw std::invalid_argument("PointUndistorter: cell must be positive");
+    if (intrinsics.width < 2 || intrinsics.height < 2)
+        throw std::invalid_argument("PointUndistorter: image size required");
+    cols_ = (intrinsics.width - 1 + cell - 1) / cell + 1;
+    rows_ = (intrinsics.height - 1 + cell - 1) / cell + 1;
+    grid_.resize(static_cast<std::size_t>(cols_) * rows_ * 2);
+    for (int j = 0; j < rows_; ++j)
+        for (int i = 0; i < cols_; ++i) {
+            const Vec2d d{static_cast<double>(i * cell), static_cast<double>(j * cell)};
+            const Vec2d u = undistort_pixel(intrinsics, d);
+            float* node = grid_.data() + (static_cast<std::size_t>(j) * cols_ + i) * 2;
+            node[0] = static_cast<float>(u.x - d.x);
+            node[1] = static_cast<float>(u.y - d.y);
+        }
+}
+
+Vec2d PointUndistorter::undistort(const Vec2d& p) const {
+    if (!(p.x >= 0.0 && p.y >= 0.0 && p.x <= intrinsics_.width - 1 && p.y <= intrinsics_.height - 1))
+        return undistort_pixel(intrinsics_, p);
+    const double gx = p.x * inv_cell_;
+    const double gy = p.y * inv_cell_;
+    const int i = std::min(static_cast<int>(gx), cols_ - 2);
+    const int j = std::min(static_cast<int>(gy), rows_ - 2);
+    const double tx = gx - i;
+    const double ty = gy - j;
+    const float* n00 = grid_.data() + (static_cast<std::size_t>(j) * cols_ + i) * 2;
+    const float* n10 = n00 + static_cast<std::ptrdiff_t>(cols_) * 2;
+    const double w00 = (1.0 - tx) * (1.0 - ty), w01 = tx * (1.0 - ty), w10 = (1.0 - tx) * ty, w11 = tx * ty;
+    return {p.x + w00 * n00[0] + w01 * n00[2] + w10 * n10[0] + w11 * n10[2],
+            p.y + w00 * n00[1] + w01 * n00[3] + w10 * n10[1] + w11 * n10[3]};
+}
+
+void PointUndistorter::undistort(const Vec2d* distorted, Vec2d* out, std::size_t n) const {
+    for (std::size_t i = 0; i < n; ++i) out[i] = undistort(distorted[i]);
+}
+
+}  // namespace mm::calibration
@@ -0,0 +1,240 @@
+#include "motionmetrics/capture/decode_pool.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "motionmetrics/core/thread_affinity.hpp"
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::capture {
+
+DecodePool::DecodePool(std::vector<std::string> paths, FrameRing& ring, DecodePoolConfig config,
+                       DecoderFactory factory)
+    : ring_(ring), config_(std::move(config)) {
+    if (paths.empty()) throw std::invalid_argument("DecodePool: no input files");
+    if (config_.chunk_frames <= 0) throw std::invalid_argument("DecodePool: chunk_frames must be positive");
+    if (config_.chunks_ahead <= 0) throw std::invalid_argument("DecodePool: chunks_ahead must be positive");
+    if (config_.reader_slots < 0) throw std::invalid_argument("DecodePool: reader_slots must not be negative");
+    if (ring_.config().num_cameras < static_cast<int>(paths.size()))
+        throw std::invalid_argument("DecodePool: frame ring has fewer cameras than input files");
+    slot_budget_ = ring_.config().slots_per_camera - config_.reader_slots;
+    const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const int per_camera = config_.decoders_per_camera > 0
+                               ? config_.decoders_per_camera
+                               : std::max(1, hardware / static_cast<int>(paths.size()));
+
+    // Plan chunks from each file's index before any thread starts.
+    std::vector<std::unique_ptr<VideoDecoder>> planners;
+    for (std::string& path : paths) {
+        std::unique_ptr<VideoDecoder> decoder = factory(path);
+        auto cam = std::make_unique<Camera>();
+        cam->path = std::move(path);
+        cam->width = decoder->width();
+        cam->height = decoder->height();
+        if (cam->width != ring_.config().width || cam->height != ring_.config().height)
+            throw std::invalid_argument("DecodePool: ring frame size does not match " + cam->path);
+        cam->frame_count = decoder->frame_count();
+        for (std::int64_t f = 0; f < cam->frame_count; ++f) {
+            const bool boundary = cam->chunk_starts.empty() || f - cam->chunk_starts.back() >= config_.chunk_frames;
+            if (boundary && decoder->is_keyframe(f)) cam->chunk_starts.push_back(f);
+        }
+        if (!cam->chunk_starts.empty() && cam->chunk_starts.front() != 0)
+            throw std::runtime_error("DecodePool: " + cam->path + " does not start with a keyframe");
+        cam->chunk_starts.push_back(cam->frame_count);
+        for (int k = 0; k < num_chunks(*cam); ++k)
+            if (chunk_size(*cam, k) > slot_budget_)
+                throw std::invalid_argument("DecodePool: frame ring has too few slots for a chunk of " + cam->path);
+        cameras_.push_back(std::move(cam));
+        planners.push_back(std::move(decoder));
+    }
+
+    int thread_index = 0;
+    try {
+        for (int c = 0; c < num_cameras(); ++c) {
+            const int decoders = std::min(per_camera, std::max(1, num_chunks(*cameras_[c])));
+            for (int d = 0; d < decoders; ++d) {
+                std::unique_ptr<VideoDecoder> decoder = d == 0 ? std::move(planners[c]) : factory(cameras_[c]->path);
+                int cpu = -1;
+                if (config_.pin_threads)
+                    cpu = config_.cpus.empty() ? thread_index % hardware
+                                               : config_.cpus[thread_index % config_.cpus.size()];
+                threads_.emplace_back(
+                    [this, c, cpu, dec = std::move(decoder)]() mutable { worker(c, std::move(dec), cpu); });
+                ++thread_index;
+            }
+        }
+    } catch (...) {
+        stop_ = true;
+        for (auto& cam : cameras_) {
+            std::lock_guard<std::mutex> lock(cam->mutex);
+            cam->cv.notify_all();
+        }
+        for (std::thread& t : threads_) t.join();
+        throw;
+    }
+}
+
+DecodePool::~DecodePool() {
+    stop_ = true;
+    for (auto& cam : cameras_) {
+        std::lock_guard<std::mutex> lock(cam->mutex);
+        cam->cv.notify_all();
+    }
+    for (std::thread& t : threads_) t.join();
+}
+
+void DecodePool::fail(std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_) error_ = error;
+    }
+    stop_ = true;
+    for (auto& cam : cameras_) {
+        std::lock_guard<std::mutex> lock(cam->mutex);
+        cam->cv.notify_all();
+    }
+}
+
+void DecodePool::worker(int camera, std::unique_ptr<VideoDecoder> decoder, int cpu) {
+    if (cpu >= 0) pin_current_thread(cpu);
+    set_current_thread_name("mm-decode-" + std::to_string(camera));
+    Camera& cam = *cameras_[camera];
+    const int chunks = num_chunks(cam);
+    try {
+        for (;;) {
+            std::unique_ptr<Chunk> chunk;
+            {
+                std::unique_lock<std::mutex> lock(cam.mutex);
+                cam.cv.wait(lock, [&] {
+                    return stop_ || cam.next_claim >= chunks ||
+                           (cam.next_claim < cam.next_emit + config_.chunks_ahead &&
+                            cam.slots_held + chunk_size(cam, cam.next_claim) <= slot_budget_);
+                });
+                if (stop_ || cam.next_claim >= chunks) return;
+                if (!cam.free.empty()) {
+                    chunk = std::move(cam.free.back());
+                    cam.free.pop_back();
+                } else {
+                    chunk = std::make_unique<Chunk>();
+                }
+                chunk->index = cam.next_claim++;
+                chunk->frames = chunk_size(cam, chunk->index);
+                cam.slots_held += chunk->frames;
+            }
+
+            const std::int64_t first = cam.chunk_starts[chunk->index];
+            chunk->writers.clear();
+            chunk->timestamps.resize(chunk->frames);
+            {
+                MM_TRACE_SCOPE_FRAME("decode_chunk", first);
+                decoder->seek(first);
+                for (int i = 0; i < chunk->frames; ++i) {
+                    FrameWriter writer = ring_.begin_write(static_cast<CameraId>(camera));
+                    if (!writer) throw std::runtime_error("DecodePool: frame ring overrun, too many frames pinned");
+                    if (!decoder->decode(writer.data(), writer.stride()))
+                        throw std::runtime_error("DecodePool: " + cam.path + " ended before its index");
+                    chunk->writers.push_back(std::move(writer));
+                    chunk->timestamps[i] = decoder->timestamp(first + i);
+                }
+            }
+            frames_decoded_.fetch_add(chunk->frames, std::memory_order_relaxed);
+            chunks_.fetch_add(1, std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock(cam.mutex);
+            const int index = chunk->index;
+            cam.ready.emplace(index, std::move(chunk));
+            cam.cv.notify_all();
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
+
+bool DecodePool::advance(Camera& cam) {
+    if (cam.exhausted) return false;
+    if (cam.current && cam.position < cam.current->frames) return true;
+
+    std::unique_lock<std::mutex> lock(cam.mutex);
+    if (cam.current) {
+        cam.slots_held -= cam.current->frames;
+        cam.current->writers.clear();
+        cam.free.push_back(std::move(cam.current));
+        ++cam.next_emit;
+        cam.cv.notify_all();
+    }
+    if (cam.next_emit >= num_chunks(cam)) {
+        cam.exhausted = true;
+        return false;
+    }
+    auto it = cam.ready.find(cam.next_emit);
+    if (it == cam.ready.end()) {
+        ++consumer_waits_;
+        cam.cv.wait(lock, [&] { return stop_ || cam.ready.count(cam.next_emit) != 0; });
+        it = cam.ready.find(cam.next_emit);
+        if (it == cam.ready.end()) {
+            lock.unlock();
+            std::lock_guard<std::mutex> error_lock(error_mutex_);
+            if (error_) std::rethrow_exception(error_);
+            throw std::logic_error("DecodePool: stopped");
+        }
+    }
+    cam.current = std::move(it->second);
+    cam.ready.erase(it);
+    cam.position = 0;
+    return true;
+}
+
+bool DecodePool::next(FramePin& out) {
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (error_) std::rethrow_exception(error_);
+    }
+    int best = -1;
+    TimestampNs best_ts = std::numeric_limits<TimestampNs>::max();
+    for (int c = 0; c < num_cameras(); ++c) {
+        Camera& cam = *cameras_[c];
+        if (!advance(cam)) continue;
+        const TimestampNs ts = cam.current->timestamps[cam.position];
+        if (ts < best_ts) {
+            best_ts = ts;
+            best = c;
+        }
+    }
+    if (best < 0) return false;
+
+    Camera& cam = *cameras_[best];
+    cam.current->writers[cam.position].publish(best_ts);
+    out = ring_.latest(static_cast<CameraId>(best));
+    ++cam.position;
+    ++frames_delivered_;
+    return true;
+}
+
+bool DecodePool::next_set(FrameSynchronizer& sync, FrameSet& out) {
+    if (config_.reader_slots < reader_slots_for(sync.config()))
+        throw std::invalid_argument("DecodePool: reader_slots is below what the synchronizer can pin");
+    while (!flushing_) {
+        if (sync.poll(stream_clock_, out)) return true;
+        FramePin pin;
+        if (!next(pin)) {
+            flushing_ = true;
+            break;
+        }
+        const TimestampNs ts = pin.timestamp();
+        stream_clock_ = std::max(stream_clock_, ts);
+        sync.push(std::move(pin), ts);
+    }
+    return sync.flush(out);
+}
+
+DecodePoolStats DecodePool::stats() const {
+    DecodePoolStats s;
+    s.frames_decoded = frames_decoded_.load(std::memory_order_relaxed);
+    s.chunks = chunks_.load(std::memory_order_relaxed);
+    s.frames_delivered = frames_delivered_;
+    s.consumer_waits = consumer_waits_;
+    return s;
+}
+
+}  // namespace mm::capture
@@ -0,0 +1,365 @@
+#include "motionmetrics/capture/frame_ring.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace mm::capture {
+namespace {
+
+constexpr std::uint32_t kWriting = 0x8000'0000u;
+constexpr std::uint64_t kMagic = 0x4d4d'4652'494e'4731ull;  // "MMFRING1"
+constexpr int kWriterAcquireSpins = 16;
+
+struct alignas(kCacheLineSize) RingHeader {
+    std::uint64_t magic;
+    std::uint64_t total_size;
+    FrameRingConfig config;
+};
+
+void validate(const FrameRingConfig& config) {
+    if (config.num_cameras <= 0 || config.num_cameras > std::numeric_limits<CameraId>::max())
+        throw std::invalid_argument("FrameRing: num_cameras out of range");
+    if (config.slots_per_camera <= 0)
+        throw std::invalid_argument("FrameRing: slots_per_camera must be positive");
+    if (config.width <= 0 || config.height <= 0)
+        throw std::invalid_argument("FrameRing: frame size must be positive");
+}
+
+}  // namespace
+
+struct FrameRing::Layout {
+    std::size_t cameras_offset;
+    std::size_t slots_offset;
+    std::size_t pixels_offset;
+    std::size_t stride;
+    std::size_t slot_bytes;
+    std::size_t total;
+
+    explicit Layout(const FrameRingConfig& config) {
+        const auto num_slots = static_cast<std::size_t>(config.num_cameras) * config.slots_per_camera;
+        stride = align_up(static_cast<std::size_t>(config.width), kCacheLineSize);
+        slot_bytes = align_up(stride * static_cast<std::size_t>(config.height), kCacheLineSize);
+        cameras_offset = align_up(sizeof(RingHeader), kCacheLineSize);
+        slots_offset = cameras_offset + sizeof(detail::CameraState) * config.num_cameras;
+        pixels_offset = align_up(slots_offset + sizeof(detail::SlotHeader) * num_slots, kCacheLineSize);
+        total = pixels_offset + slot_bytes * num_slots;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// FrameWriter
+
+FrameWriter::FrameWriter(FrameWriter&& other) noexcept { *this = std::move(other); }
+
+FrameWriter& FrameWriter::operator=(FrameWriter&& other) noexcept {
+    if (this != &other) {
+        release();
+        slot_ = std::exchange(other.slot_, nullptr);
+        camera_state_ = std::exchange(other.camera_state_, nullptr);
+        pixels_ = std::exchange(other.pixels_, nullptr);
+        width_ = other.width_;
+        height_ = other.height_;
+        stride_ = other.stride_;
+        camera_ = other.camera_;
+    }
+    return *this;
+}
+
+FrameWriter::~FrameWriter() { release(); }
+
+void FrameWriter::publish(TimestampNs timestamp) {
+    if (slot_ == nullptr) return;
+    const std::uint64_t sequence = camera_state_->next_sequence.fetch_add(1, std::memory_order_relaxed);
+    slot_->timestamp = timestamp;
+    slot_->sequence.store(sequence, std::memory_order_relaxed);
+    camera_state_->published.fetch_add(1, std::memory_order_relaxed);
+    release();
+}
+
+void FrameWriter::release() {
+    if (slot_ == nullptr) return;
+    // Subtract rather than store: readers that raced with us may still hold
+    // transient increments which they will remove themselves.
+    slot_->state.fetch_sub(kWriting, std::memory_order_release);
+    slot_ = nullptr;
+    camera_state_ = nullptr;
+    pixels_ = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// FramePin
+
+FramePin::FramePin(FramePin&& other) noexcept { *this = std::move(other); }
+
+FramePin& FramePin::operator=(FramePin&& other) noexcept {
+    if (this != &other) {
+        release();
+        slot_ = std::exchange(other.slot_, nullptr);
+        view_ = other.view_;
+        timestamp_ = other.timestamp_;
+        sequence_ = other.sequence_;
+        camera_ = other.camera_;
+    }
+    return *this;
+}
+
+FramePin::~FramePin() { release(); }
+
+FramePin FramePin::share() const {
+    FramePin pin;
+    if (slot_ == nullptr) return pin;
+    // Already pinned, so the slot cannot be claimed by a writer meanwhile.
+    slot_->state.fetch_add(1, std::memory_order_relaxed);
+    pin.slot_ = slot_;
+    pin.view_ = view_;
+    pin.timestamp_ = timestamp_;
+    pin.sequence_ = sequence_;
+    pin.camera_ = camera_;
+    return pin;
+}
+
+void FramePin::release() {
+    if (slot_ == nullptr) return;
+    slot_->state.fetch_sub(1, std::memory_order_release);
+    slot_ = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// FrameRing
+
+FrameRing::FrameRing(const FrameRingConfig& config) {
+    validate(config);
+    const Layout layout(config);
+    heap_ = AlignedBuffer(layout.total);
+    new (heap_.data()) RingHeader{kMagic, layout.total, config};
+    bind(heap_.data(), config);
+    initialise_slots();
+}
+
+FrameRing FrameRing::create_shared(const std::string& name, const FrameRingConfig& config) {
+    validate(config);
+    const Layout layout(config);
+
+    ::shm_unlink(name.c_str());
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+    if (::ftruncate(fd, static_cast<off_t>(layout.total)) != 0) {
+        const int err = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::system_error(err, std::generic_category(), "ftruncate " + name);
+    }
+    void* base = ::mmap(nullptr, layout.total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int err = errno;
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        throw std::system_error(err, std::generic_category(), "mmap " + name);
+    }
+
+    FrameRing ring;
+    ring.mapping_ = base;
+    ring.mapping_size_ = layout.total;
+    ring.shm_name_ = name;
+    ring.owns_shm_name_ = true;
+    auto* header = new (base) RingHeader{0, layout.total, config};
+    ring.bind(static_cast<std::byte*>(base), config);
+    ring.initialise_slots();
+    // Publish the magic last so attaching processes never see a half-built ring.
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kMagic;
+    return ring;
+}
+
+FrameRing FrameRing::open_shared(const std::string& name) {
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(RingHeader)) {
+        ::close(fd);
+        throw std::runtime_error("FrameRing: shared object " + name + " is not a frame ring");
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int err = errno;
+    ::close(fd);
+    if (base == MAP_FAILED) throw std::system_error(err, std::generic_category(), "mmap " + name);
+
+    const auto* header = static_cast<const RingHeader*>(base);
+    if (header->magic != kMagic || header->total_size != size ||
+        Layout(header->config).total != size) {
+        ::munmap(base, size);
+        throw std::runtime_error("FrameRing: shared object " + name + " is not a frame ring");
+    }
+
+    FrameRing ring;
+    ring.mapping_ = base;
+    ring.mapping_size_ = size;
+    ring.shm_name_ = name;
+    ring.bind(static_cast<std::byte*>(base), header->config);
+    return ring;
+}
+
+FrameRing::FrameRing(FrameRing&& other) noexcept { *this = std::move(other); }
+
+FrameRing& FrameRing::operator=(FrameRing&& other) noexcept {
+    if (this != &other) {
+        reset();
+        config_ = other.config_;
+        stride_ = other.stride_;
+        slot_bytes_ = other.slot_bytes_;
+        cameras_ = std::exchange(other.cameras_, nullptr);
+        slots_ = std::exchange(other.slots_, nullptr);
+        pixels_ = std::exchange(other.pixels_, nullptr);
+        heap_ = std::move(other.heap_);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        mapping_size_ = std::exchange(other.mapping_size_, 0);
+        shm_name_ = std::move(other.shm_name_);
+        owns_shm_name_ = std::exchange(other.owns_shm_name_, false);
+    }
+    return *this;
+}
+
+FrameRing::~FrameRing() { reset(); }
+
+void FrameRing::reset() {
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        if (owns_shm_name_) ::shm_unlink(shm_name_.c_str());
+        owns_shm_name_ = false;
+    }
+    heap_ = AlignedBuffer();
+}
+
+void FrameRing::bind(std::byte* base, const FrameRingConfig& config) {
+    const Layout layout(config);
+    config_ = config;
+    stride_ = static_cast<std::ptrdiff_t>(layout.stride);
+    slot_bytes_ = layout.slot_bytes;
+    cameras_ = reinterpret_cast<detail::CameraState*>(base + layout.cameras_offset);
+    slots_ = reinterpret_cast<detail::SlotHeader*>(base + layout.slots_offset);
+    pixels_ = base + layout.pixels_offset;
+}
+
+void FrameRing::initialise_slots() {
+    for (int c = 0; c < config_.num_cameras; ++c) new (&cameras_[c]) detail::CameraState();
+    const std::size_t num_slots = static_cast<std::size_t>(config_.num_cameras) * config_.slots_per_camera;
+    for (std::size_t i = 0; i < num_slots; ++i) new (&slots_[i]) detail::SlotHeader();
+}
+
+std::size_t FrameRing::slot_index(CameraId camera, int slot) const {
+    return static_cast<std::size_t>(camera) * config_.slots_per_camera + slot;
+}
+
+void FrameRing::check_camera(CameraId camera) const {
+    if (camera >= config_.num_cameras) throw std::out_of_range("FrameRing: camera id out of range");
+}
+
+FrameWriter FrameRing::begin_write(CameraId camera) {
+    check_camera(camera);
+    detail::CameraState& state = cameras_[camera];
+    const int slots = config_.slots_per_camera;
+    const auto start = static_cast<int>(state.next_sequence.load(std::memory_order_relaxed) % slots);
+
+    for (int attempt = 0; attempt < kWriterAcquireSpins; ++attempt) {
+        // Prefer the slot the sequence points at (the oldest frame), then any
+        // other slot nobody has pinned.
+        for (int k = 0; k < slots; ++k) {
+            const int slot = (start + k) % slots;
+            detail::SlotHeader& header = slots_[slot_index(camera, slot)];
+            std::uint32_t expected = 0;
+            if (!header.state.compare_exchange_strong(expected, kWriting, std::memory_order_acquire,
+                                                      std::memory_order_relaxed))
+                continue;
+            header.sequence.store(0, std::memory_order_relaxed);
+
+            FrameWriter writer;
+            writer.slot_ = &header;
+            writer.camera_state_ = &state;
+            writer.pixels_ = reinterpret_cast<std::uint8_t*>(pixels_ + slot_index(camera, slot) * slot_bytes_);
+            writer.width_ = config_.width;
+            writer.height_ = config_.height;
+            writer.stride_ = stride_;
+            writer.camera_ = camera;
+            return writer;
+        }
+    }
+    state.overruns.fetch_add(1, std::memory_order_relaxed);
+    return FrameWriter();
+}
+
+FramePin FrameRing::try_pin(CameraId camera, int slot, std::uint64_t expected_sequence) const {
+    detail::SlotHeader& header = slots_[slot_index(camera, slot)];
+    const std::uint32_t prior = header.state.fetch_add(1, std::memory_order_acquire);
+    const std::uint64_t sequence = header.sequence.load(std::memory_order_relaxed);
+    if ((prior & kWriting) != 0 || sequence == 0 ||
+        (expected_sequence != 0 && sequence != expected_sequence)) {
+        header.state.fetch_sub(1, std::memory_order_relaxed);
+        return FramePin();
+    }
+
+    FramePin pin;
+    pin.slot_ = &header;
+    pin.view_ = ImageView{reinterpret_cast<const std::uint8_t*>(pixels_ + slot_index(camera, slot) * slot_bytes_),
+                          config_.width, config_.height, stride_};
+    pin.timestamp_ = header.timestamp;
+    pin.sequence_ = sequence;
+    pin.camera_ = camera;
+    return pin;
+}
+
+FramePin FrameRing::latest(CameraId camera) const {
+    check_camera(camera);
+    // The newest slot may be reclaimed between the scan and the pin when
+    // readers lag badly; retry a bounded number of times.
+    for (int attempt = 0; attempt < config_.slots_per_camera + 1; ++attempt) {
+        int best_slot = -1;
+        std::uint64_t best_sequence = 0;
+        for (int s = 0; s < config_.slots_per_camera; ++s) {
+            const std::uint64_t seq = slots_[slot_index(camera, s)].sequence.load(std::memory_order_relaxed);
+            if (seq > best_sequence) {
+                best_sequence = seq;
+                best_slot = s;
+            }
+        }
+        if (best_slot < 0) return FramePin();
+        if (FramePin pin = try_pin(camera, best_slot, best_sequence)) return pin;
+    }
+    return FramePin();
+}
+
+FramePin FrameRing::find(CameraId camera, TimestampNs timestamp, TimestampNs tolerance) const {
+    check_camera(camera);
+    FramePin best;
+    TimestampNs best_distance = tolerance;
+    for (int s = 0; s < config_.slots_per_camera; ++s) {
+        FramePin pin = try_pin(camera, s, 0);
+        if (!pin) continue;
+        const TimestampNs distance =
+            pin.timestamp() > timestamp ? pin.timestamp() - timestamp : timestamp - pin.timestamp();
+        if (distance <= best_distance && (!best || distance < best_distance)) {
+            best_distance = distance;
+            best = std::move(pin);
+        }
+    }
+    return best;
+}
+
+FrameRingStats FrameRing::stats(CameraId camera) const {
+    check_camera(camera);
+    return FrameRingStats{cameras_[camera].published.load(std::memory_order_relaxed),
+                          cameras_[camera].overruns.load(std::memory_order_relaxed)};
+}
+
+}  // namespace mm::capture
@@ -0,0 +1,160 @@
+#include "motionmetrics/capture/frame_synchronizer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+namespace mm::capture {
+
+void FrameSynchronizer::CameraQueue::pop() {
+    items[head] = Pending();
+    head = (head + 1) % static_cast<int>(items.size());
+    --size;
+}
+
+FrameSynchronizer::FrameSynchronizer(FrameSynchronizerConfig config) : config_(std::move(config)) {
+    if (config_.num_cameras <= 0) throw std::invalid_argument("FrameSynchronizer: num_cameras must be positive");
+    if (config_.tolerance_ns < 0 || config_.max_wait_ns < 0)
+        throw std::invalid_argument("FrameSynchronizer: tolerance and max_wait must be non-negative");
+    if (config_.max_pending_per_camera <= 0)
+        throw std::invalid_argument("FrameSynchronizer: max_pending_per_camera must be positive");
+    if (config_.clock_offsets_ns.empty()) config_.clock_offsets_ns.assign(config_.num_cameras, 0);
+    if (static_cast<int>(config_.clock_offsets_ns.size()) != config_.num_cameras)
+        throw std::invalid_argument("FrameSynchronizer: clock_offsets_ns must have one entry per camera");
+
+    queues_.resize(config_.num_cameras);
+    for (CameraQueue& queue : queues_) queue.items.resize(config_.max_pending_per_camera);
+    stats_.resize(config_.num_cameras);
+    member_.resize(config_.num_cameras);
+}
+
+void FrameSynchronizer::push(FramePin frame, TimestampNs arrival_ns) {
+    if (!frame) return;
+    const CameraId camera = frame.camera();
+    if (camera >= config_.num_cameras) throw std::out_of_range("FrameSynchronizer: camera id out of range");
+    const TimestampNs timestamp = frame.timestamp() - config_.clock_offsets_ns[camera];
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    CameraQueue& queue = queues_[camera];
+    CameraSyncStats& stats = stats_[camera];
+    ++stats.received;
+
+    // Out-of-order frames, and frames whose set has already gone out, can no
+    // longer be matched.
+    if ((queue.seen && timestamp <= queue.last_timestamp) ||
+        (last_emitted_ && timestamp <= *last_emitted_ + config_.tolerance_ns)) {
+        ++stats.dropped_late;
+        return;
+    }
+    queue.seen = true;
+    queue.last_timestamp = timestamp;
+
+    const int capacity = static_cast<int>(queue.items.size());
+    if (queue.size == capacity) {
+        queue.pop();
+        ++stats.dropped_overflow;
+    }
+    queue.items[(queue.head + queue.size) % capacity] = Pending{std::move(frame), timestamp, arrival_ns};
+    ++queue.size;
+}
+
+std::optional<TimestampNs> FrameSynchronizer::anchor_locked(TimestampNs* arrival) const {
+    std::optional<TimestampNs> anchor;
+    for (const CameraQueue& queue : queues_) {
+        if (queue.size == 0) continue;
+        const Pending& head = queue.front();
+        if (!anchor || head.timestamp < *anchor) {
+            anchor = head.timestamp;
+            if (arrival != nullptr) *arrival = head.arrival;
+        }
+    }
+    return anchor;
+}
+
+bool FrameSynchronizer::emit_locked(TimestampNs now_ns, bool force, FrameSet& out) {
+    TimestampNs arrival = 0;
+    const std::optional<TimestampNs> anchor = anchor_locked(&arrival);
+    if (!anchor) return false;
+
+    const TimestampNs window_end = *anchor + config_.tolerance_ns;
+    int present = 0;
+    int waiting = 0;
+    for (int c = 0; c < config_.num_cameras; ++c) {
+        const CameraQueue& queue = queues_[c];
+        member_[c] = queue.size > 0 && queue.front().timestamp <= window_end;
+        present += member_[c];
+        // A camera whose next frame is already past the window has skipped
+        // this instant; only empty queues can still contribute.
+        waiting += queue.size == 0;
+    }
+
+    bool timed_out = false;
+    if (present < config_.num_cameras && waiting > 0) {
+        if (!force && now_ns - arrival < config_.max_wait_ns) return false;
+        timed_out = !force;
+    }
+
+    out.frames.resize(config_.num_cameras);
+    out.present = present;
+    out.timed_out = timed_out;
+
+    TimestampNs sum = 0;
+    for (int c = 0; c < config_.num_cameras; ++c) {
+        if (member_[c]) sum += queues_[c].front().timestamp - *anchor;
+    }
+    out.timestamp = *anchor + sum / present;
+
+    for (int c = 0; c < config_.num_cameras; ++c) {
+        CameraSyncStats& stats = stats_[c];
+        if (!member_[c]) {
+            out.frames[c] = FramePin();
+            ++stats.missing;
+            if (timed_out && queues_[c].size == 0) ++stats.deadline_stalls;
+            continue;
+        }
+        CameraQueue& queue = queues_[c];
+        const TimestampNs skew = queue.front().timestamp - out.timestamp;
+        out.frames[c] = std::move(queue.front().frame);
+        queue.pop();
+
+        ++stats.matched;
+        stats.last_skew_ns = skew;
+        stats.mean_skew_ns += (static_cast<double>(skew) - stats.mean_skew_ns) / static_cast<double>(stats.matched);
+        stats.max_abs_skew_ns = std::max(stats.max_abs_skew_ns, std::abs(skew));
+    }
+
+    last_emitted_ = *anchor;
+    ++sets_emitted_;
+    return true;
+}
+
+bool FrameSynchronizer::poll(TimestampNs now_ns, FrameSet& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return emit_locked(now_ns, false, out);
+}
+
+bool FrameSynchronizer::flush(FrameSet& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return emit_locked(0, true, out);
+}
+
+std::optional<TimestampNs> FrameSynchronizer::next_deadline() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TimestampNs arrival = 0;
+    if (!anchor_locked(&arrival)) return std::nullopt;
+    return arrival + config_.max_wait_ns;
+}
+
+CameraSyncStats FrameSynchronizer::stats(CameraId camera) const {
+    if (camera >= config_.num_cameras) throw std::out_of_range("FrameSynchronizer: camera id out of range");
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_[camera];
+}
+
+std::uint64_t FrameSynchronizer::sets_emitted() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sets_emitted_;
+}
+
+}  // namespace mm::capture
@@ -0,0 +1,111 @@
+#include "motionmetrics/capture/video_decoder.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace mm::capture {
+namespace {
+
+constexpr std::uint64_t kMagic = 0x4d4d'5241'5756'3031ull;  // "MMRAWV01"
+
+struct RawHeader {
+    std::uint64_t magic;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint64_t frame_count;
+    std::uint64_t frames_offset;
+    std::uint64_t timestamps_offset;
+    std::uint64_t reserved[3];
+};
+static_assert(sizeof(RawHeader) == 64, "raw video header layout");
+
+[[noreturn]] void corrupt(const std::string& path, const char* what) {
+    throw std::runtime_error("RawVideoDecoder: " + path + ": " + what);
+}
+
+}  // namespace
+
+RawVideoDecoder::RawVideoDecoder(const std::string& path) : file_(path) {
+    const std::size_t size = file_.size();
+    if (size < sizeof(RawHeader)) corrupt(path, "truncated header");
+    RawHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (header.magic != kMagic) corrupt(path, "not a raw recording");
+    if (header.width == 0 || header.height == 0 || header.width > 65535 || header.height > 65535)
+        corrupt(path, "bad frame size");
+    const std::uint64_t frame_bytes = std::uint64_t{header.width} * header.height;
+    if (header.frames_offset > size || header.frame_count > (size - header.frames_offset) / frame_bytes)
+        corrupt(path, "frames out of bounds");
+    if (header.timestamps_offset > size ||
+        header.frame_count > (size - header.timestamps_offset) / sizeof(TimestampNs))
+        corrupt(path, "timestamps out of bounds");
+
+    width_ = static_cast<int>(header.width);
+    height_ = static_cast<int>(header.height);
+    frames_ = file_.data() + header.frames_offset;
+    timestamps_.resize(header.frame_count);
+    std::memcpy(timestamps_.data(), file_.data() + header.timestamps_offset,
+                header.frame_count * sizeof(TimestampNs));
+    file_.advise(header.frames_offset, header.frame_count * frame_bytes, MappedFile::Access::sequential);
+}
+
+void RawVideoDecoder::seek(std::int64_t frame) {
+    if (frame < 0 || frame > frame_count()) throw std::out_of_range("RawVideoDecoder: seek out of range");
+    position_ = frame;
+}
+
+bool RawVideoDecoder::decode(std::uint8_t* out, std::ptrdiff_t stride) {
+    if (position_ >= frame_count()) return false;
+    const std::size_t frame_bytes = static_cast<std::size_t>(width_) * height_;
+    const auto* src = reinterpret_cast<const std::uint8_t*>(frames_) + position_ * frame_bytes;
+    if (stride == width_) {
+        std::memcpy(out, src, frame_bytes);
+    } else {
+        for (int y = 0; y < height_; ++y) std::memcpy(out + y * stride, src + y * width_, width_);
+    }
+    ++position_;
+    return true;
+}
+
+std::unique_ptr<VideoDecoder> open_raw_video(const std::string& path) {
+    return std::make_unique<RawVideoDecoder>(path);
+}
+
+RawVideoWriter::RawVideoWriter(std::string path, int width, int height) : width_(width), height_(height) {
+    if (width <= 0 || height <= 0 || width > 65535 || height > 65535)
+        throw std::invalid_argument("RawVideoWriter: frame size out of range");
+    file_ = AtomicFile(std::move(path));
+    const RawHeader blank{};
+    file_.write(&blank, sizeof(blank));
+}
+
+void RawVideoWriter::append(const ImageView& frame, TimestampNs timestamp) {
+    if (!file_.is_open()) throw std::logic_error("RawVideoWriter: append after close");
+    if (frame.width != width_ || frame.height != height_)
+        throw std::invalid_argument("RawVideoWriter: frame size mismatch");
+    if (!timestamps_.empty() && timestamp < timestamps_.back())
+        throw std::invalid_argument("RawVideoWriter: timestamps must not decrease");
+    if (frame.stride == width_) {
+        file_.write(frame.data, static_cast<std::size_t>(width_) * height_);
+    } else {
+        for (int y = 0; y < height_; ++y) file_.write(frame.row(y), static_cast<std::size_t>(width_));
+    }
+    timestamps_.push_back(timestamp);
+}
+
+void RawVideoWriter::close() {
+    if (!file_.is_open()) return;
+    RawHeader header{};
+    header.magic = kMagic;
+    header.width = static_cast<std::uint32_t>(width_);
+    header.height = static_cast<std::uint32_t>(height_);
+    header.frame_count = timestamps_.size();
+    header.frames_offset = sizeof(RawHeader);
+    header.timestamps_offset = sizeof(RawHeader) + header.frame_count * width_ * height_;
+    file_.write(timestamps_.data(), timestamps_.size() * sizeof(TimestampNs));
+    file_.write_at(&header, sizeof(header), 0);
+    file_.commit();
+}
+
+}  // namespace mm::capture
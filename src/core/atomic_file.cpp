@@ -0,0 +1,119 @@
+#include "motionmetrics/core/atomic_file.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+namespace mm {
+namespace {
+
+std::atomic<std::uint64_t> temp_counter{0};
+
+std::string parent_directory(const std::string& path) {
+    const std::size_t slash = path.rfind('/');
+    if (slash == std::string::npos) return ".";
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+/// Makes a rename in `directory` durable.
+void sync_directory(const std::string& directory) {
+    const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + directory);
+    if (::fsync(fd) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "fsync " + directory);
+    }
+    ::close(fd);
+}
+
+}  // namespace
+
+AtomicFile::AtomicFile(std::string path) : path_(std::move(path)) {
+    temp_path_ = path_ + ".partial-" + std::to_string(::getpid()) + "-" +
+                 std::to_string(temp_counter.fetch_add(1, std::memory_order_relaxed));
+    fd_ = ::open(temp_path_.c_str(), O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd_ < 0) throw std::system_error(errno, std::generic_category(), "open " + temp_path_);
+}
+
+AtomicFile::AtomicFile(AtomicFile&& other) noexcept
+    : path_(std::move(other.path_)), temp_path_(std::move(other.temp_path_)), fd_(std::exchange(other.fd_, -1)) {}
+
+AtomicFile& AtomicFile::operator=(AtomicFile&& other) noexcept {
+    if (this != &other) {
+        abandon();
+        path_ = std::move(other.path_);
+        temp_path_ = std::move(other.temp_path_);
+        fd_ = std::exchange(other.fd_, -1);
+    }
+    return *this;
+}
+
+AtomicFile::~AtomicFile() { abandon(); }
+
+void AtomicFile::abandon() {
+    if (fd_ < 0) return;
+    ::close(std::exchange(fd_, -1));
+    ::unlink(temp_path_.c_str());
+}
+
+void AtomicFile::write(const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t n = ::write(fd_, bytes, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "write " + temp_path_);
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
+
+void AtomicFile::write_at(const void* data, std::size_t size, std::uint64_t offset) {
+    const auto* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t n = ::pwrite(fd_, bytes, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "write " + temp_path_);
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+}
+
+void AtomicFile::sync() {
+    if (::fdatasync(fd_) != 0) throw std::system_error(errno, std::generic_category(), "fdatasync " + temp_path_);
+}
+
+void AtomicFile::commit() {
+    sync();
+    // Some file systems only report write-back errors on close.
+    if (::close(std::exchange(fd_, -1)) != 0) {
+        const int err = errno;
+        ::unlink(temp_path_.c_str());
+        throw std::system_error(err, std::generic_category(), "close " + temp_path_);
+    }
+    if (::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+        const int err = errno;
+        ::unlink(temp_path_.c_str());
+        throw std::system_error(err, std::generic_category(), "rename " + path_);
+    }
+    // The rename itself lives in the directory; without this a crash can
+    // bring back the old file, or none.
+    sync_directory(parent_directory(path_));
+}
+
+void write_file_atomic(const std::string& path, const void* data, std::size_t size) {
+    AtomicFile file(path);
+    file.write(data, size);
+    file.commit();
+}
+
+}  // namespace mm
@@ -0,0 +1,65 @@
+#include "motionmetrics/core/latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mm {
+
+int LatencyHistogram::bucket_of(std::uint64_t v) {
+    if (v < kSub) return static_cast<int>(v);
+    const int e = 63 - __builtin_clzll(v);
+    const int sub = static_cast<int>((v >> (e - kSubBits)) & (kSub - 1));
+    return (e - kSubBits + 1) * kSub + sub;
+}
+
+std::uint64_t LatencyHistogram::bucket_upper(int bucket) {
+    if (bucket < kSub) return static_cast<std::uint64_t>(bucket);
+    const int e = bucket / kSub + kSubBits - 1;
+    const std::uint64_t sub = static_cast<std::uint64_t>(bucket % kSub);
+    const std::uint64_t lower = (kSub + sub) << (e - kSubBits);
+    return lower + (std::uint64_t{1} << (e - kSubBits)) - 1;
+}
+
+void LatencyHistogram::record(std::int64_t ns) {
+    const std::uint64_t v = ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+    buckets_[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(v, std::memory_order_relaxed);
+    std::int64_t prev = max_.load(std::memory_order_relaxed);
+    while (ns > prev && !max_.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+std::int64_t LatencyHistogram::percentile(double q) const {
+    std::uint64_t total = 0;
+    for (const auto& b : buckets_) total += b.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+    const auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * total));
+    std::uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= std::max<std::uint64_t>(rank, 1))
+            return std::min(static_cast<std::int64_t>(bucket_upper(i)), max_.load(std::memory_order_relaxed));
+    }
+    return max_.load(std::memory_order_relaxed);
+}
+
+LatencySummary LatencyHistogram::summary() const {
+    LatencySummary s;
+    s.count = count();
+    if (s.count == 0) return s;
+    s.mean_ns = static_cast<std::int64_t>(sum_.load(std::memory_order_relaxed) / s.count);
+    s.p50_ns = percentile(0.50);
+    s.p90_ns = percentile(0.90);
+    s.p99_ns = percentile(0.99);
+    s.max_ns = max_.load(std::memory_order_relaxed);
+    return s;
+}
+
+}  // namespace mm
@@ -0,0 +1,77 @@
+#include "motionmetrics/core/linear_algebra.hpp"
+
+#include <cmath>
+
+namespace mm {
+
+void jacobi_eigen(double* a, int n, double* v) {
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j) v[i * n + j] = i == j ? 1.0 : 0.0;
+    double scale = 0.0;
+    for (int i = 0; i < n * n; ++i) scale += a[i] * a[i];
+    for (int sweep = 0; sweep < 50; ++sweep) {
+        double off = 0.0;
+        for (int p = 0; p < n; ++p)
+            for (int q = p + 1; q < n; ++q) off += a[p * n + q] * a[p * n + q];
+        if (off <= 1e-24 * scale) return;
+        for (int p = 0; p < n; ++p) {
+            for (int q = p + 1; q < n; ++q) {
+                const double apq = a[p * n + q];
+                if (apq == 0.0) continue;
+                const double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+                const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0);
+                const double s = t * c;
+                for (int k = 0; k < n; ++k) {
+                    const double akp = a[k * n + p];
+                    const double akq = a[k * n + q];
+                    a[k * n + p] = c * akp - s * akq;
+                    a[k * n + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; ++k) {
+                    const double apk = a[p * n + k];
+                    const double aqk = a[q * n + k];
+                    a[p * n + k] = c * apk - s * aqk;
+                    a[q * n + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; ++k) {
+                    const double vkp = v[k * n + p];
+                    const double vkq = v[k * n + q];
+                    v[k * n + p] = c * vkp - s * vkq;
+                    v[k * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+bool cholesky(double* a, int n, int ld) {
+    for (int j = 0; j < n; ++j) {
+        double d = a[j * ld + j];
+        for (int k = 0; k < j; ++k) d -= a[j * ld + k] * a[j * ld + k];
+        if (!(d > 0.0)) return false;
+        d = std::sqrt(d);
+        a[j * ld + j] = d;
+        for (int i = j + 1; i < n; ++i) {
+            double s = a[i * ld + j];
+            for (int k = 0; k < j; ++k) s -= a[i * ld + k] * a[j * ld + k];
+            a[i * ld + j] = s / d;
+        }
+    }
+    return true;
+}
+
+void cholesky_solve(const double* l, int n, int ld, double* b) {
+    for (int i = 0; i < n; ++i) {
+        double s = b[i];
+        for (int k = 0; k < i; ++k) s -= l[i * ld + k] * b[k];
+        b[i] = s / l[i * ld + i];
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        double s = b[i];
+        for (int k = i + 1; k < n; ++k) s -= l[k * ld + i] * b[k];
+        b[i] = s / l[i * ld + i];
+    }
+}
+
+}  // namespace mm
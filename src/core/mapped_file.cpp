@@ -0,0 +1,73 @@
+#include "motionmetrics/core/mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+namespace mm {
+
+MappedFile::MappedFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "fstat " + path);
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return;
+    }
+    void* base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    const int err = errno;
+    ::close(fd);
+    if (base == MAP_FAILED) throw std::system_error(err, std::generic_category(), "mmap " + path);
+    data_ = static_cast<const std::byte*>(base);
+    size_ = size;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        reset();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() { reset(); }
+
+void MappedFile::reset() {
+    if (data_ != nullptr) ::munmap(const_cast<std::byte*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::advise(std::size_t offset, std::size_t length, Access access) const {
+    if (data_ == nullptr || offset >= size_ || length == 0) return;
+    static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t begin = offset / page * page;
+    const std::size_t end = std::min(size_, offset + length);
+    int advice = MADV_NORMAL;
+    switch (access) {
+        case Access::normal: advice = MADV_NORMAL; break;
+        case Access::sequential: advice = MADV_SEQUENTIAL; break;
+        case Access::random: advice = MADV_RANDOM; break;
+        case Access::will_need: advice = MADV_WILLNEED; break;
+        case Access::dont_need: advice = MADV_DONTNEED; break;
+    }
+    ::madvise(const_cast<std::byte*>(data_) + begin, end - begin, advice);
+}
+
+}  // namespace mm
@@ -0,0 +1,61 @@
+#include "motionmetrics/core/rigid_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "motionmetrics/core/linear_algebra.hpp"
+
+namespace mm {
+
+bool fit_rigid_transform(const Vec3d* from, const Vec3d* to, const double* weights, int n, RigidTransform& out) {
+    double total = 0.0;
+    int count = 0;
+    Vec3d ca, cb;
+    for (int i = 0; i < n; ++i) {
+        const double w = weights ? weights[i] : 1.0;
+        if (w <= 0.0) continue;
+        ca += from[i] * w;
+        cb += to[i] * w;
+        total += w;
+        ++count;
+    }
+    if (count < 3) return false;
+    ca *= 1.0 / total;
+    cb *= 1.0 / total;
+
+    double s[3][3] = {};
+    double spread = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const double w = weights ? weights[i] : 1.0;
+        if (w <= 0.0) continue;
+        const Vec3d a = from[i] - ca;
+        const Vec3d b = to[i] - cb;
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c) s[r][c] += w * a[r] * b[c];
+        spread += w * (dot(a, a) + dot(b, b));
+    }
+
+    double m[4][4] = {
+        {s[0][0] + s[1][1] + s[2][2], s[1][2] - s[2][1], s[2][0] - s[0][2], s[0][1] - s[1][0]},
+        {s[1][2] - s[2][1], s[0][0] - s[1][1] - s[2][2], s[0][1] + s[1][0], s[2][0] + s[0][2]},
+        {s[2][0] - s[0][2], s[0][1] + s[1][0], -s[0][0] + s[1][1] - s[2][2], s[1][2] + s[2][1]},
+        {s[0][1] - s[1][0], s[2][0] + s[0][2], s[1][2] + s[2][1], -s[0][0] - s[1][1] + s[2][2]},
+    };
+    double v[4][4];
+    jacobi_eigen(&m[0][0], 4, &v[0][0]);
+    int best = 0;
+    for (int i = 1; i < 4; ++i)
+        if (m[i][i] > m[best][best]) best = i;
+    // Collinear points leave the rotation about their line undetermined,
+    // which shows up as a repeated largest eigenvalue.
+    double second = -INFINITY;
+    for (int i = 0; i < 4; ++i)
+        if (i != best) second = std::max(second, m[i][i]);
+    if (!(m[best][best] - second > 1e-9 * spread)) return false;
+
+    out.rotation = rotation_from_quaternion(v[0][best], v[1][best], v[2][best], v[3][best]);
+    out.translation = cb - out.rotation * ca;
+    return true;
+}
+
+}  // namespace mm
@@ -0,0 +1,274 @@
+#include "motionmetrics/core/trace.hpp"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+namespace mm {
+namespace detail {
+std::atomic<bool> g_tracing_enabled{false};
+}  // namespace detail
+
+namespace {
+
+/// Event fields are relaxed atomics so the exporter may read a ring while
+/// its owner keeps writing; torn events are detected through `head`.
+struct Slot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<std::int64_t> begin_ns{0};
+    std::atomic<std::int64_t> duration_ns{0};
+    std::atomic<std::int64_t> frame{-1};
+};
+
+struct ThreadBuffer {
+    explicit ThreadBuffer(std::size_t capacity) : slots(capacity) {}
+
+    std::vector<Slot> slots;
+    std::atomic<std::uint64_t> head{0};   // events ever written
+    std::atomic<std::uint64_t> start{0};  // first event of the current owner
+    // Guarded by the registry mutex.
+    int tid = 0;
+    std::string thread_name;
+    bool in_use = true;
+};
+
+/// A ring with its owner's identity, copied under the registry mutex.
+struct BufferRef {
+    std::shared_ptr<ThreadBuffer> buffer;
+    int tid;
+    std::string thread_name;
+};
+
+struct Event {
+    const char* name;
+    std::int64_t begin_ns;
+    std::int64_t duration_ns;
+    std::int64_t frame;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::size_t capacity = std::size_t{1} << 16;
+    int next_tid = 1;
+    std::set<std::string> interned;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry();  // leaked: threads may record during static destruction
+    return *r;
+}
+
+thread_local ThreadBuffer* tl_buffer = nullptr;
+
+/// Hands the thread's ring back to the registry when the thread exits.
+struct BufferLease {
+    ThreadBuffer* buffer = nullptr;
+
+    ~BufferLease() {
+        if (buffer == nullptr) return;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        buffer->in_use = false;
+        tl_buffer = nullptr;
+    }
+};
+
+thread_local BufferLease tl_lease;
+
+ThreadBuffer& local_buffer() {
+    if (tl_buffer != nullptr) return *tl_buffer;
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    ThreadBuffer* buffer = nullptr;
+    for (const auto& b : r.buffers) {
+        if (b->in_use || b->slots.size() != r.capacity) continue;
+        // Events of the exited owner end here; exporters drop them.
+        b->start.store(b->head.load(std::memory_order_relaxed), std::memory_order_release);
+        buffer = b.get();
+        break;
+    }
+    if (buffer == nullptr) {
+        r.buffers.push_back(std::make_shared<ThreadBuffer>(r.capacity));
+        buffer = r.buffers.back().get();
+    }
+    buffer->tid = r.next_tid++;
+    buffer->thread_name.clear();
+    char name[16] = {};
+    if (::pthread_getname_np(::pthread_self(), name, sizeof(name)) == 0) buffer->thread_name = name;
+    buffer->in_use = true;
+    tl_lease.buffer = buffer;
+    tl_buffer = buffer;
+    return *tl_buffer;
+}
+
+/// Copies the events of one ring that were not overwritten during the copy.
+void snapshot(const ThreadBuffer& b, std::vector<Event>& out) {
+    const std::uint64_t cap = b.slots.size();
+    const std::uint64_t start = b.start.load(std::memory_order_acquire);
+    const std::uint64_t end = b.head.load(std::memory_order_acquire);
+    const std::uint64_t begin = std::max(start, end > cap ? end - cap : 0);
+    const std::size_t first = out.size();
+    for (std::uint64_t i = begin; i < end; ++i) {
+        const Slot& s = b.slots[i % cap];
+        out.push_back(Event{s.name.load(std::memory_order_relaxed), s.begin_ns.load(std::memory_order_relaxed),
+                            s.duration_ns.load(std::memory_order_relaxed), s.frame.load(std::memory_order_relaxed)});
+    }
+    // Pairs with the writer's release fence: if any copied field came from
+    // a newer event, the head loaded below covers that event's predecessor.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::uint64_t after = b.head.load(std::memory_order_relaxed);
+    if (b.start.load(std::memory_order_relaxed) != start) {
+        // Handed to a new thread during the copy.
+        out.resize(first);
+        return;
+    }
+    // Anything the writer may have lapped while we were copying is dropped,
+    // including the slot of event `after`, which may be mid-write.
+    const std::uint64_t valid_from = after + 1 > cap ? after + 1 - cap : 0;
+    if (valid_from > begin) {
+        const auto lost = static_cast<std::size_t>(std::min(valid_from - begin, end - begin));
+        out.erase(out.begin() + static_cast<std::ptrdiff_t>(first),
+                  out.begin() + static_cast<std::ptrdiff_t>(first + lost));
+    }
+}
+
+void write_json_string(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out << buf;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+void write_us(std::ostream& out, std::int64_t ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%lld.%03lld", static_cast<long long>(ns / 1000),
+                  static_cast<long long>(ns % 1000));
+    out << buf;
+}
+
+std::vector<BufferRef> buffers() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<BufferRef> out;
+    out.reserve(r.buffers.size());
+    for (const auto& b : r.buffers) out.push_back(BufferRef{b, b->tid, b->thread_name});
+    return out;
+}
+
+}  // namespace
+
+void detail::trace_record(const char* name, std::int64_t begin_ns, std::int64_t end_ns, std::int64_t frame) {
+    ThreadBuffer& b = local_buffer();
+    const std::uint64_t head = b.head.load(std::memory_order_relaxed);
+    // Keeps the slot stores after the previous head store for snapshot().
+    std::atomic_thread_fence(std::memory_order_release);
+    Slot& s = b.slots[head % b.slots.size()];
+    s.name.store(name, std::memory_order_relaxed);
+    s.begin_ns.store(begin_ns, std::memory_order_relaxed);
+    s.duration_ns.store(end_ns - begin_ns, std::memory_order_relaxed);
+    s.frame.store(frame, std::memory_order_relaxed);
+    b.head.store(head + 1, std::memory_order_release);
+}
+
+void set_tracing_enabled(bool enabled) { detail::g_tracing_enabled.store(enabled, std::memory_order_relaxed); }
+
+void set_trace_buffer_capacity(std::size_t events) {
+    if (events == 0) throw std::invalid_argument("set_trace_buffer_capacity: capacity must be positive");
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.capacity = events;
+}
+
+const char* trace_intern(const std::string& name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return r.interned.insert(name).first->c_str();
+}
+
+void clear_trace() {
+    for (const BufferRef& b : buffers())
+        b.buffer->start.store(b.buffer->head.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void write_chrome_trace(std::ostream& out) {
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    std::vector<Event> events;
+    for (const BufferRef& b : buffers()) {
+        if (!b.thread_name.empty()) {
+            separator();
+            out << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << b.tid << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+            write_json_string(out, b.thread_name);
+            out << "}}";
+        }
+        events.clear();
+        snapshot(*b.buffer, events);
+        for (const Event& e : events) {
+            if (e.name == nullptr) continue;
+            separator();
+            out << "{\"ph\":\"X\",\"cat\":\"mm\",\"pid\":1,\"tid\":" << b.tid << ",\"name\":";
+            write_json_string(out, e.name);
+            out << ",\"ts\":";
+            write_us(out, e.begin_ns);
+            out << ",\"dur\":";
+            write_us(out, e.duration_ns);
+            if (e.frame >= 0) out << ",\"args\":{\"frame\":" << e.frame << '}';
+            out << '}';
+        }
+    }
+    out << "]}\n";
+}
+
+void write_chrome_trace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) throw std::runtime_error("write_chrome_trace: cannot open " + path);
+    write_chrome_trace(file);
+    if (!file) throw std::runtime_error("write_chrome_trace: failed writing " + path);
+}
+
+std::vector<TraceEventSummary> summarize_trace() {
+    // Keyed by content: equal literals in different translation units may
+    // have different addresses.
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms;
+    std::map<std::string, std::int64_t> totals;
+    std::vector<Event> events;
+    for (const BufferRef& b : buffers()) {
+        events.clear();
+        snapshot(*b.buffer, events);
+        for (const Event& e : events) {
+            if (e.name == nullptr) continue;
+            auto& h = histograms[e.name];
+            if (!h) h = std::make_unique<LatencyHistogram>();
+            h->record(e.duration_ns);
+            totals[e.name] += e.duration_ns;
+        }
+    }
+    std::vector<TraceEventSummary> out;
+    for (const auto& [name, h] : histograms) out.push_back(TraceEventSummary{name, totals[name], h->summary()});
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.total_ns > b.total_ns; });
+    return out;
+}
+
+}  // namespace mm
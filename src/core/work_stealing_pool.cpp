@@ -0,0 +1,133 @@
+#include "motionmetrics/core/work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace mm {
+namespace {
+
+thread_local const WorkStealingPool* tl_pool = nullptr;
+thread_local int tl_slot = -1;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(int num_threads) {
+    if (num_threads <= 0) num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    // One deque per worker plus a shared one for external callers.
+    for (int i = 0; i <= num_threads; ++i) deques_.push_back(std::make_unique<Deque>());
+    threads_.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) threads_.emplace_back([this, i] { worker_loop(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : threads_) t.join();
+}
+
+WorkStealingPool& WorkStealingPool::shared() {
+    static WorkStealingPool pool;
+    return pool;
+}
+
+int WorkStealingPool::current_slot() const { return tl_pool == this ? tl_slot : size(); }
+
+void WorkStealingPool::push(int slot, const Task& task) {
+    {
+        std::lock_guard<std::mutex> lock(deques_[slot]->mutex);
+        deques_[slot]->tasks.push_back(task);
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    wake_.notify_one();
+}
+
+// `job` restricts the search to tasks of one call; null takes any task.
+bool WorkStealingPool::pop_local(int slot, const Job* job, Task& task) {
+    Deque& d = *deques_[slot];
+    std::lock_guard<std::mutex> lock(d.mutex);
+    for (auto it = d.tasks.rbegin(); it != d.tasks.rend(); ++it) {
+        if (job != nullptr && it->job != job) continue;
+        task = *it;
+        d.tasks.erase(std::next(it).base());
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool WorkStealingPool::steal(int slot, const Job* job, Task& task) {
+    const int n = static_cast<int>(deques_.size());
+    for (int k = 1; k < n; ++k) {
+        Deque& d = *deques_[(slot + k) % n];
+        std::lock_guard<std::mutex> lock(d.mutex);
+        // Steal from the front: the oldest, hence largest, pending range.
+        for (auto it = d.tasks.begin(); it != d.tasks.end(); ++it) {
+            if (job != nullptr && it->job != job) continue;
+            task = *it;
+            d.tasks.erase(it);
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::execute(int slot, Task task) {
+    Job* job = task.job;
+    while (task.end - task.begin > job->grain) {
+        const int mid = task.begin + (task.end - task.begin) / 2;
+        push(slot, Task{job, mid, task.end});
+        task.end = mid;
+    }
+    try {
+        job->fn(job->ctx, task.begin, task.end);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(job->error_mutex);
+        if (!job->error) job->error = std::current_exception();
+    }
+    // Last access to the job: the owner may return as soon as this hits 0.
+    job->remaining.fetch_sub(task.end - task.begin, std::memory_order_acq_rel);
+}
+
+void WorkStealingPool::run(int begin, int end, int grain, RangeFn fn, void* ctx) {
+    if (end <= begin) return;
+    Job job;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.grain = std::max(1, grain);
+    job.remaining.store(end - begin, std::memory_order_relaxed);
+
+    // Outside callers share slot size(), and a nested call runs on the slot
+    // of the task that made it. Running only this call's tasks while waiting
+    // keeps two tasks of one call off the same slot, and keeps a task from
+    // reentering the scratch of the task suspended below it.
+    const int slot = current_slot();
+    execute(slot, Task{&job, begin, end});
+    while (job.remaining.load(std::memory_order_acquire) > 0) {
+        Task task;
+        if (pop_local(slot, &job, task) || steal(slot, &job, task)) execute(slot, task);
+        else std::this_thread::yield();
+    }
+    if (job.error) std::rethrow_exception(job.error);
+}
+
+void WorkStealingPool::worker_loop(int slot) {
+    tl_pool = this;
+    tl_slot = slot;
+    for (;;) {
+        Task task;
+        if (pop_local(slot, nullptr, task) || steal(slot, nullptr, task)) {
+            execute(slot, task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [&] { return stop_ || queued_.load(std::memory_order_acquire) > 0; });
+        if (stop_ && queued_.load(std::memory_order_acquire) == 0) return;
+    }
+}
+
+}  // namespace mm
@@ -0,0 +1,219 @@
+#include "motionmetrics/gaze/gaze_events.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::gaze {
+namespace {
+
+constexpr double kRadToDeg = 180.0 / 3.14159265358979323846;
+
+double seconds(TimestampNs ns) { return static_cast<double>(ns) * 1e-9; }
+
+/// Angle between unit vectors, degrees; accurate for small angles too.
+double angle_deg(const Vec3d& a, const Vec3d& b) { return std::atan2(norm(cross(a, b)), dot(a, b)) * kRadToDeg; }
+
+}  // namespace
+
+GazeEventClassifier::GazeEventClassifier(int num_targets, GazeEventParams params)
+    : params_(params), cos_dispersion_(std::cos(params.max_dispersion / kRadToDeg)) {
+    if (num_targets < 0) throw std::invalid_argument("GazeEventClassifier: negative target count");
+    if (!(params_.saccade_velocity > 0.0) || !(params_.max_dispersion > 0.0) || !(params_.max_gap > 0.0) ||
+        !(params_.min_fixation >= 0.0) || !(params_.min_saccade >= 0.0))
+        throw std::invalid_argument("GazeEventClassifier: thresholds must be positive");
+    fixation_time_.assign(num_targets, 0.0);
+    dwell_.assign(num_targets, TargetDwell{});
+}
+
+void GazeEventClassifier::reset() {
+    state_ = State::idle;
+    onset_ = false;
+    history_size_ = 0;
+    for (int t : touched_) fixation_time_[t] = 0.0;
+    touched_.clear();
+    summary_ = {};
+    std::fill(dwell_.begin(), dwell_.end(), TargetDwell{});
+}
+
+void GazeEventClassifier::start_event(State state, const GazeSample& at) {
+    state_ = state;
+    current_ = {};
+    current_.type = state == State::saccade ? GazeEventType::saccade : GazeEventType::fixation;
+    current_.start = current_.end = at.timestamp;
+    current_.direction = at.direction;
+    direction_sum_ = at.direction;
+    cos_spread_ = 1.0;
+}
+
+void GazeEventClassifier::credit_fixation(int target, double dt) {
+    if (fixation_time_[target] == 0.0) touched_.push_back(target);
+    fixation_time_[target] += dt;
+}
+
+bool GazeEventClassifier::close_event() {
+    const State state = state_;
+    state_ = State::idle;
+    onset_ = false;
+    if (state == State::idle) return false;
+    const double duration = seconds(current_.end - current_.start);
+
+    if (state == State::fixation) {
+        const bool accepted = duration >= params_.min_fixation && duration > 0.0;
+        int best = -1;
+        double best_time = 0.0;
+        for (int t : touched_) {
+            if (accepted) dwell_[t].fixation_time += fixation_time_[t];
+            if (fixation_time_[t] > best_time) {
+                best_time = fixation_time_[t];
+                best = t;
+            }
+            fixation_time_[t] = 0.0;
+        }
+        touched_.clear();
+        if (!accepted) return false;
+        current_.target = best;
+        current_.direction = normalized(direction_sum_);
+        current_.amplitude = std::acos(std::clamp(cos_spread_, -1.0, 1.0)) * kRadToDeg;
+        ++summary_.fixations;
+        summary_.fixation_time += duration;
+        if (best >= 0) {
+            TargetDwell& d = dwell_[best];
+            ++d.fixations;
+            d.longest_fixation = std::max(d.longest_fixation, duration);
+            if (d.first_fixation < 0) d.first_fixation = current_.start;
+        }
+    } else {
+        current_.amplitude = angle_deg(direction_sum_, current_.direction);
+        ++summary_.saccades;
+        summary_.saccade_time += duration;
+        summary_.saccade_amplitude_sum += current_.amplitude;
+    }
+    summary_.peak_velocity = std::max(summary_.peak_velocity, current_.peak_velocity);
+    last_event_ = current_;
+    return true;
+}
+
+bool GazeEventClassifier::push(const GazeSample& input) {
+    const Vec3d& d = input.direction;
+    if (!(d.x == d.x && d.y == d.y && d.z == d.z) || !(norm(d) > 0.0)) return false;
+    if (history_size_ > 0 && input.timestamp <= history_[0].timestamp) return false;
+    GazeSample s = input;
+    s.direction = normalized(d);
+    if (s.target >= static_cast<int>(dwell_.size())) s.target = -1;
+
+    bool completed = false;
+    double dt = 0.0;
+    if (history_size_ > 0) {
+        dt = seconds(s.timestamp - history_[0].timestamp);
+        if (dt > params_.max_gap) {
+            completed = close_event();
+            history_size_ = 0;
+        }
+    }
+    if (history_size_ == 0) {
+        start_event(State::fixation, s);
+        history_[0] = s;
+        history_size_ = 1;
+        return completed;
+    }
+
+    const GazeSample& prev = history_[0];
+    summary_.tracked_time += dt;
+    if (prev.target >= 0) dwell_[prev.target].gaze_time += dt;
+
+    const GazeSample& ref = history_[history_size_ - 1];
+    const double velocity = angle_deg(ref.direction, s.direction) / seconds(s.timestamp - ref.timestamp);
+    switch (state_) {
+        case State::fixation: {
+            const double cos_mean = dot(normalized(direction_sum_), s.direction);
+            if (velocity > params_.saccade_velocity) {
+                if (!onset_) {
+                    onset_ = true;
+                    onset_sample_ = prev;
+                    onset_peak_ = 0.0;
+                    onset_time_ = 0.0;
+                }
+                onset_peak_ = std::max(onset_peak_, velocity);
+                onset_time_ += dt;
+                if (seconds(s.timestamp - onset_sample_.timestamp) >= params_.min_saccade) {
+                    // The fixation ended where the onset began.
+                    completed = close_event();
+                    start_event(State::saccade, onset_sample_);
+                    current_.end = s.timestamp;
+                    current_.direction = s.direction;
+                    current_.peak_velocity = onset_peak_;
+                }
+            } else if (cos_mean < cos_dispersion_) {
+                completed = close_event();
+                start_event(State::fixation, s);
+            } else {
+                if (onset_) {
+                    // A noise spike: its time goes to where it started.
+                    const int t = onset_sample_.target;
+                    if (t >= 0) credit_fixation(t, onset_time_);
+                    current_.peak_velocity = std::max(current_.peak_velocity, onset_peak_);
+                    onset_ = false;
+                }
+                cos_spread_ = std::min(cos_spread_, cos_mean);
+                direction_sum_ += s.direction;
+                current_.end = s.timestamp;
+                current_.peak_velocity = std::max(current_.peak_velocity, velocity);
+                if (prev.target >= 0) credit_fixation(prev.target, dt);
+            }
+            break;
+        }
+        case State::saccade:
+            current_.end = s.timestamp;
+            current_.direction = s.direction;
+            if (velocity > params_.saccade_velocity) {
+                current_.peak_velocity = std::max(current_.peak_velocity, velocity);
+            } else {
+                completed = close_event();
+                start_event(State::fixation, s);
+            }
+            break;
+        case State::idle:
+            start_event(State::fixation, s);
+            break;
+    }
+
+    history_[1] = history_[0];
+    history_[0] = s;
+    history_size_ = 2;
+    return completed;
+}
+
+bool GazeEventClassifier::finish() {
+    const bool completed = close_event();
+    history_size_ = 0;
+    return completed;
+}
+
+GazeAnalysis classify_gaze(const HeadPoseTrack& track, const std::vector<TimestampNs>& timestamps,
+                           const GazeHitTrack* hits, int num_targets, const GazeEventParams& params) {
+    MM_TRACE_SCOPE("classify_gaze");
+    if (static_cast<std::int64_t>(timestamps.size()) != track.frames)
+        throw std::invalid_argument("classify_gaze: need one timestamp per frame");
+    if (hits && hits->frames != track.frames)
+        throw std::invalid_argument("classify_gaze: hit track and head track frame counts differ");
+    GazeEventClassifier classifier(num_targets, params);
+    GazeAnalysis out;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (std::int64_t f = 0; f < track.frames; ++f) {
+        GazeSample s;
+        s.timestamp = timestamps[f];
+        s.direction = track.valid(f) ? track.direction(f) : Vec3d{nan, nan, nan};
+        s.target = hits ? hits->target[f] : -1;
+        if (classifier.push(s)) out.events.push_back(classifier.last_event());
+    }
+    if (classifier.finish()) out.events.push_back(classifier.last_event());
+    out.summary = classifier.summary();
+    out.dwell = classifier.dwell();
+    return out;
+}
+
+}  // namespace mm::gaze
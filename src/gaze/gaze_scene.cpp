@@ -0,0 +1,291 @@
+#include "motionmetrics/gaze/gaze_scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::gaze {
+namespace {
+
+constexpr int kLeafSize = 4;
+constexpr int kMaxDepth = 64;
+constexpr std::int64_t kFramesPerTask = 1024;
+
+void target_bounds(const GazeTarget& t, Vec3d& lo, Vec3d& hi) {
+    if (t.shape == TargetShape::box) {
+        lo = t.centre - t.half_extents;
+        hi = t.centre + t.half_extents;
+        return;
+    }
+    // A disc of normal n extends r * sqrt(1 - n_k^2) along axis k.
+    Vec3d extent{t.radius, t.radius, t.radius};
+    if (t.shape == TargetShape::disc)
+        for (int k = 0; k < 3; ++k) extent[k] = t.radius * std::sqrt(std::max(0.0, 1.0 - t.normal[k] * t.normal[k]));
+    lo = t.centre - extent;
+    hi = t.centre + extent;
+}
+
+/// Entry distance of the ray into [lo, hi], clamped to 0 when the origin
+/// is inside; false if it misses or enters beyond `limit`.
+bool slab(const Vec3d& lo, const Vec3d& hi, const Vec3d& origin, const Vec3d& inv_dir, double limit, double& t) {
+    double near = 0.0;
+    double far = limit;
+    for (int k = 0; k < 3; ++k) {
+        double t0 = (lo[k] - origin[k]) * inv_dir[k];
+        double t1 = (hi[k] - origin[k]) * inv_dir[k];
+        if (t0 > t1) std::swap(t0, t1);
+        // NaN (origin on a slab face of a parallel ray) leaves the range as is.
+        near = t0 > near ? t0 : near;
+        far = t1 < far ? t1 : far;
+    }
+    t = near;
+    return near <= far;
+}
+
+/// Distance along the ray to the target centred at `centre`, if hit.
+bool hit_target(const GazeTarget& t, const Vec3d& centre, const Vec3d& origin, const Vec3d& dir,
+                const Vec3d& inv_dir, double limit, double& dist) {
+    switch (t.shape) {
+        case TargetShape::sphere: {
+            const Vec3d oc = origin - centre;
+            const double b = dot(oc, dir);
+            const double c = dot(oc, oc) - t.radius * t.radius;
+            const double disc = b * b - c;
+            if (disc < 0.0) return false;
+            const double root = std::sqrt(disc);
+            // From inside the sphere, the exit point is the one looked at.
+            dist = -b - root >= 0.0 ? -b - root : -b + root;
+            return dist >= 0.0 && dist <= limit;
+        }
+        case TargetShape::disc: {
+            const double denom = dot(t.normal, dir);
+            if (std::abs(denom) < 1e-12) return false;
+            dist = dot(centre - origin, t.normal) / denom;
+            if (!(dist >= 0.0 && dist <= limit)) return false;
+            const Vec3d r = origin + dir * dist - centre;
+            return dot(r, r) <= t.radius * t.radius;
+        }
+        case TargetShape::box:
+            return slab(centre - t.half_extents, centre + t.half_extents, origin, inv_dir, limit, dist);
+    }
+    return false;
+}
+
+}  // namespace
+
+int GazeScene::add_sphere(std::string name, const Vec3d& centre, double radius) {
+    GazeTarget t;
+    t.name = std::move(name);
+    t.shape = TargetShape::sphere;
+    t.centre = centre;
+    t.radius = radius;
+    return add(std::move(t));
+}
+
+int GazeScene::add_disc(std::string name, const Vec3d& centre, const Vec3d& normal, double radius) {
+    if (!(norm(normal) > 0.0)) throw std::invalid_argument("GazeScene: zero disc normal");
+    GazeTarget t;
+    t.name = std::move(name);
+    t.shape = TargetShape::disc;
+    t.centre = centre;
+    t.normal = normalized(normal);
+    t.radius = radius;
+    return add(std::move(t));
+}
+
+int GazeScene::add_box(std::string name, const Vec3d& min, const Vec3d& max) {
+    GazeTarget t;
+    t.name = std::move(name);
+    t.shape = TargetShape::box;
+    t.centre = (min + max) * 0.5;
+    t.half_extents = (max - min) * 0.5;
+    return add(std::move(t));
+}
+
+int GazeScene::add_tracked_sphere(std::string name, std::string marker, double radius, const Vec3d& offset) {
+    if (marker.empty()) throw std::invalid_argument("GazeScene: tracked target needs a marker");
+    GazeTarget t;
+    t.name = std::move(name);
+    t.shape = TargetShape::sphere;
+    t.centre = offset;
+    t.radius = radius;
+    t.marker = std::move(marker);
+    return add(std::move(t));
+}
+
+int GazeScene::target_index(const std::string& name) const {
+    for (int i = 0; i < num_targets(); ++i)
+        if (targets_[i].name == name) return i;
+    return -1;
+}
+
+int GazeScene::add(GazeTarget target) {
+    if (target.name.empty()) throw std::invalid_argument("GazeScene: empty target name");
+    if (target_index(target.name) >= 0) throw std::invalid_argument("GazeScene: duplicate target " + target.name);
+    const bool sized = target.shape == TargetShape::box
+                           ? target.half_extents.x > 0.0 && target.half_extents.y > 0.0 && target.half_extents.z > 0.0
+                           : target.radius > 0.0;
+    if (!sized) throw std::invalid_argument("GazeScene: target " + target.name + " has no extent");
+    targets_.push_back(std::move(target));
+    const int index = num_targets() - 1;
+    if (targets_[index].marker.empty())
+        rebuild();
+    else
+        tracked_.push_back(index);
+    return index;
+}
+
+void GazeScene::rebuild() {
+    items_.clear();
+    nodes_.clear();
+    for (int i = 0; i < num_targets(); ++i)
+        if (targets_[i].marker.empty()) items_.push_back(i);
+    if (!items_.empty()) build_node(0, static_cast<int>(items_.size()));
+}
+
+int GazeScene::build_node(int begin, int end) {
+    const int index = static_cast<int>(nodes_.size());
+    nodes_.emplace_back();
+    Vec3d lo{INFINITY, INFINITY, INFINITY};
+    Vec3d hi{-INFINITY, -INFINITY, -INFINITY};
+    Vec3d clo = lo;
+    Vec3d chi = hi;
+    for (int i = begin; i < end; ++i) {
+        const GazeTarget& t = targets_[items_[i]];
+        Vec3d tlo, thi;
+        target_bounds(t, tlo, thi);
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = std::min(lo[k], tlo[k]);
+            hi[k] = std::max(hi[k], thi[k]);
+            clo[k] = std::min(clo[k], t.centre[k]);
+            chi[k] = std::max(chi[k], t.centre[k]);
+        }
+    }
+    nodes_[index].lo = lo;
+    nodes_[index].hi = hi;
+    if (end - begin <= kLeafSize) {
+        nodes_[index].first = begin;
+        nodes_[index].count = end - begin;
+        return index;
+    }
+
+    int axis = 0;
+    for (int k = 1; k < 3; ++k)
+        if (chi[k] - clo[k] > chi[axis] - clo[axis]) axis = k;
+    const int mid = begin + (end - begin) / 2;
+    std::nth_element(items_.begin() + begin, items_.begin() + mid, items_.begin() + end,
+                     [&](int a, int b) { return targets_[a].centre[axis] < targets_[b].centre[axis]; });
+    build_node(begin, mid);
+    const int right = build_node(mid, end);
+    nodes_[index].first = right;
+    return index;
+}
+
+GazeHit GazeScene::intersect(const Vec3d& origin, const Vec3d& direction, const Vec3d* tracked,
+                             double max_distance) const {
+    GazeHit best;
+    const double length = norm(direction);
+    if (!(length > 0.0)) return best;
+    const Vec3d dir = direction * (1.0 / length);
+    const Vec3d inv_dir{1.0 / dir.x, 1.0 / dir.y, 1.0 / dir.z};
+    double limit = max_distance;
+
+    for (std::size_t i = 0; i < tracked_.size() && tracked; ++i) {
+        const Vec3d& at = tracked[i];
+        if (!(at.x == at.x)) continue;
+        const GazeTarget& t = targets_[tracked_[i]];
+        double dist;
+        if (hit_target(t, at + t.centre, origin, dir, inv_dir, limit, dist) && dist < best.distance) {
+            best = {tracked_[i], dist};
+            limit = dist;
+        }
+    }
+
+    if (nodes_.empty()) return best;
+    struct Entry {
+        int node;
+        double t;
+    };
+    Entry stack[kMaxDepth];
+    int top = 0;
+    double t0;
+    if (slab(nodes_[0].lo, nodes_[0].hi, origin, inv_dir, limit, t0)) stack[top++] = {0, t0};
+    while (top > 0) {
+        const Entry e = stack[--top];
+        if (e.t > limit) continue;
+        const Node& node = nodes_[e.node];
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                const GazeTarget& t = targets_[items_[i]];
+                double dist;
+                if (hit_target(t, t.centre, origin, dir, inv_dir, limit, dist) && dist < best.distance) {
+                    best = {items_[i], dist};
+                    limit = dist;
+                }
+            }
+            continue;
+        }
+        const int a = e.node + 1;
+        const int b = node.first;
+        double ta, tb;
+        const bool hit_a = slab(nodes_[a].lo, nodes_[a].hi, origin, inv_dir, limit, ta);
+        const bool hit_b = slab(nodes_[b].lo, nodes_[b].hi, origin, inv_dir, limit, tb);
+        // Push the farther child first so the nearer one is searched first
+        // and can tighten the limit.
+        if (hit_a && hit_b) {
+            if (ta <= tb) {
+                stack[top++] = {b, tb};
+                stack[top++] = {a, ta};
+            } else {
+                stack[top++] = {a, ta};
+                stack[top++] = {b, tb};
+            }
+        } else if (hit_a) {
+            stack[top++] = {a, ta};
+        } else if (hit_b) {
+            stack[top++] = {b, tb};
+        }
+    }
+    return best;
+}
+
+GazeHitTrack GazeScene::intersect(const HeadPoseTrack& track, const trajectory::TrajectorySet& set,
+                                  WorkStealingPool* pool) const {
+    MM_TRACE_SCOPE("gaze_intersect");
+    if (set.frames() != track.frames) throw std::invalid_argument("GazeScene: trial and head track frame counts differ");
+    std::vector<int> markers;
+    for (int index : tracked_) {
+        const int m = set.marker_index(targets_[index].marker);
+        if (m < 0) throw std::invalid_argument("GazeScene: trial has no marker " + targets_[index].marker);
+        markers.push_back(m);
+    }
+
+    GazeHitTrack out;
+    out.frames = track.frames;
+    out.target.resize(static_cast<std::size_t>(track.frames));
+    out.distance.resize(static_cast<std::size_t>(track.frames));
+    const int tasks = static_cast<int>((track.frames + kFramesPerTask - 1) / kFramesPerTask);
+    auto run = [&](int task) {
+        std::vector<Vec3d> positions(markers.size());
+        const std::int64_t first = task * kFramesPerTask;
+        const std::int64_t last = std::min(track.frames, first + kFramesPerTask);
+        for (std::int64_t f = first; f < last; ++f) {
+            GazeHit hit;
+            if (track.valid(f)) {
+                for (std::size_t i = 0; i < markers.size(); ++i) positions[i] = set.position(markers[i], f);
+                hit = intersect(track.origin(f), track.direction(f), positions.data());
+            }
+            out.target[f] = hit.target;
+            out.distance[f] = hit.target >= 0 ? static_cast<float>(hit.distance) : NAN;
+        }
+    };
+    if (pool)
+        pool->parallel_for(0, tasks, 1, run);
+    else
+        for (int task = 0; task < tasks; ++task) run(task);
+    return out;
+}
+
+}  // namespace mm::gaze
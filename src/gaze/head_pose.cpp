@@ -0,0 +1,424 @@
+#include "motionmetrics/gaze/head_pose.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::gaze {
+namespace {
+
+constexpr int kBlock = 128;
+// Newton on the quartic from the upper bound converges monotonically and
+// quadratically once near the root; eight steps reach double precision for
+// residuals well beyond max_rms_error.
+constexpr int kNewtonIterations = 8;
+constexpr double kMinWeight = 1e-300;
+
+/// Per-frame intermediates of one block, structure-of-arrays.
+struct alignas(64) BlockLanes {
+    double w[kBlock];
+    double count[kBlock];
+    double sl[3][kBlock];    // sum of w * local
+    double sx[3][kBlock];    // sum of w * measured
+    double s[9][kBlock];     // sum of w * local_r * measured_c
+    double spread[kBlock];   // sum of w * (|local|^2 + |measured|^2)
+    double key[10][kBlock];  // Horn's key matrix, upper triangle row-major
+    double c2[kBlock];
+    double c1[kBlock];
+    double c0[kBlock];
+    double lambda[kBlock];
+    double q[4][kBlock];     // unnormalised quaternion
+    double scale[kBlock];    // its inverse norm, 0 if degenerate
+    double rms[kBlock];
+};
+
+struct Job {
+    const float* const* columns;  // x, y, z per model marker
+    const HeadModel* model;
+    const HeadPoseParams* params;
+    BlockLanes* lanes;
+    HeadPoseTrack* out;
+    std::int64_t first;
+    int count;
+};
+
+/// Adds one marker to the sums of every frame; a missing sample adds
+/// nothing.
+MM_ALWAYS_INLINE void accumulate_marker(const float* MM_RESTRICT x, const float* MM_RESTRICT y,
+                                        const float* MM_RESTRICT z, const Vec3d& l, double weight, BlockLanes& b,
+                                        int n) {
+    const double ll = dot(l, l);
+    for (int i = 0; i < n; ++i) {
+        const double xi = x[i], yi = y[i], zi = z[i];
+        const bool present = !std::isnan(xi);
+        const double w = present ? weight : 0.0;
+        const double px = present ? xi : 0.0;
+        const double py = present ? yi : 0.0;
+        const double pz = present ? zi : 0.0;
+        const double wl0 = w * l.x;
+        const double wl1 = w * l.y;
+        const double wl2 = w * l.z;
+        b.w[i] += w;
+        b.count[i] += present ? 1.0 : 0.0;
+        b.sl[0][i] += wl0;
+        b.sl[1][i] += wl1;
+        b.sl[2][i] += wl2;
+        b.sx[0][i] += w * px;
+        b.sx[1][i] += w * py;
+        b.sx[2][i] += w * pz;
+        b.s[0][i] += wl0 * px;
+        b.s[1][i] += wl0 * py;
+        b.s[2][i] += wl0 * pz;
+        b.s[3][i] += wl1 * px;
+        b.s[4][i] += wl1 * py;
+        b.s[5][i] += wl1 * pz;
+        b.s[6][i] += wl2 * px;
+        b.s[7][i] += wl2 * py;
+        b.s[8][i] += wl2 * pz;
+        b.spread[i] += w * (ll + px * px + py * py + pz * pz);
+    }
+}
+
+/// Determinant of the symmetric 4x4 matrix with upper triangle
+/// a00 a01 a02 a03 a11 a12 a13 a22 a23 a33, by 2x2 minors.
+MM_ALWAYS_INLINE double det4_sym(double a00, double a01, double a02, double a03, double a11, double a12, double a13,
+                                 double a22, double a23, double a33) {
+    const double s0 = a00 * a11 - a01 * a01;
+    const double s1 = a00 * a12 - a01 * a02;
+    const double s2 = a00 * a13 - a01 * a03;
+    const double s3 = a01 * a12 - a11 * a02;
+    const double s4 = a01 * a13 - a11 * a03;
+    const double s5 = a02 * a13 - a12 * a03;
+    const double c0 = a02 * a13 - a03 * a12;
+    const double c1 = a02 * a23 - a03 * a22;
+    const double c2 = a02 * a33 - a03 * a23;
+    const double c3 = a12 * a23 - a13 * a22;
+    const double c4 = a12 * a33 - a13 * a23;
+    const double c5 = a22 * a33 - a23 * a23;
+    return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+/// Centred cross-covariance, key matrix and the coefficients of its
+/// characteristic polynomial lambda^4 + c2 lambda^2 + c1 lambda + c0
+/// (the key matrix is traceless). Newton starts from half the spread, an
+/// upper bound on the largest eigenvalue.
+MM_ALWAYS_INLINE void setup_frames(BlockLanes& b, int n) {
+    for (int i = 0; i < n; ++i) {
+        // Sums are zero where no marker is present, so any finite inverse
+        // weight will do there.
+        const double inv = 1.0 / std::max(b.w[i], kMinWeight);
+        const double l0 = b.sl[0][i], l1 = b.sl[1][i], l2 = b.sl[2][i];
+        const double x0 = b.sx[0][i], x1 = b.sx[1][i], x2 = b.sx[2][i];
+        const double sxx = b.s[0][i] - l0 * x0 * inv, sxy = b.s[1][i] - l0 * x1 * inv, sxz = b.s[2][i] - l0 * x2 * inv;
+        const double syx = b.s[3][i] - l1 * x0 * inv, syy = b.s[4][i] - l1 * x1 * inv, syz = b.s[5][i] - l1 * x2 * inv;
+        const double szx = b.s[6][i] - l2 * x0 * inv, szy = b.s[7][i] - l2 * x1 * inv, szz = b.s[8][i] - l2 * x2 * inv;
+        const double spread = b.spread[i] - (l0 * l0 + l1 * l1 + l2 * l2 + x0 * x0 + x1 * x1 + x2 * x2) * inv;
+
+        const double k00 = sxx + syy + szz;
+        const double k01 = syz - szy;
+        const double k02 = szx - sxz;
+        const double k03 = sxy - syx;
+        const double k11 = sxx - syy - szz;
+        const double k12 = sxy + syx;
+        const double k13 = szx + sxz;
+        const double k22 = -sxx + syy - szz;
+        const double k23 = syz + szy;
+        const double k33 = -sxx - syy + szz;
+        b.key[0][i] = k00;
+        b.key[1][i] = k01;
+        b.key[2][i] = k02;
+        b.key[3][i] = k03;
+        b.key[4][i] = k11;
+        b.key[5][i] = k12;
+        b.key[6][i] = k13;
+        b.key[7][i] = k22;
+        b.key[8][i] = k23;
+        b.key[9][i] = k33;
+
+        const double frob = sxx * sxx + sxy * sxy + sxz * sxz + syx * syx + syy * syy + syz * syz + szx * szx +
+                            szy * szy + szz * szz;
+        const double det3 = sxx * (syy * szz - syz * szy) - sxy * (syx * szz - syz * szx) + sxz * (syx * szy - syy * szx);
+        b.c2[i] = -2.0 * frob;
+        b.c1[i] = -8.0 * det3;
+        b.c0[i] = det4_sym(k00, k01, k02, k03, k11, k12, k13, k22, k23, k33);
+        b.lambda[i] = 0.5 * spread;
+        b.spread[i] = spread;
+    }
+}
+
+MM_ALWAYS_INLINE void newton_step(BlockLanes& b, int n) {
+    for (int i = 0; i < n; ++i) {
+        const double l = b.lambda[i];
+        const double l2 = l * l;
+        const double p = (l2 + b.c2[i]) * l2 + b.c1[i] * l + b.c0[i];
+        const double dp = (4.0 * l2 + 2.0 * b.c2[i]) * l + b.c1[i];
+        b.lambda[i] = dp != 0.0 ? l - p / dp : l;
+    }
+}
+
+/// Quaternion from the adjugate of (key - lambda I), whose columns are all
+/// parallel to the eigenvector; the largest is taken. A repeated largest
+/// eigenvalue (collinear markers) makes the adjugate vanish, which leaves a
+/// zero norm. Also yields the mean squared residual, (spread - 2 lambda) / w.
+MM_ALWAYS_INLINE void recover_quaternions(BlockLanes& b, int n) {
+    for (int i = 0; i < n; ++i) {
+        const double l = b.lambda[i];
+        const double a00 = b.key[0][i] - l, a01 = b.key[1][i], a02 = b.key[2][i], a03 = b.key[3][i];
+        const double a11 = b.key[4][i] - l, a12 = b.key[5][i], a13 = b.key[6][i];
+        const double a22 = b.key[7][i] - l, a23 = b.key[8][i];
+        const double a33 = b.key[9][i] - l;
+
+        const double s0 = a00 * a11 - a01 * a01;
+        const double s1 = a00 * a12 - a01 * a02;
+        const double s2 = a00 * a13 - a01 * a03;
+        const double s3 = a01 * a12 - a11 * a02;
+        const double s4 = a01 * a13 - a11 * a03;
+        const double c0 = a02 * a13 - a03 * a12;
+        const double c1 = a02 * a23 - a03 * a22;
+        const double c2 = a02 * a33 - a03 * a23;
+        const double c3 = a12 * a23 - a13 * a22;
+        const double c4 = a12 * a33 - a13 * a23;
+        const double c5 = a22 * a33 - a23 * a23;
+        // Adjugate columns; the matrix is symmetric, so is its adjugate.
+        const double j00 = a11 * c5 - a12 * c4 + a13 * c3;
+        const double j10 = -a01 * c5 + a12 * c2 - a13 * c1;
+        const double j20 = a01 * c4 - a11 * c2 + a13 * c0;
+        const double j30 = -a01 * c3 + a11 * c1 - a12 * c0;
+        const double j11 = a00 * c5 - a02 * c2 + a03 * c1;
+        const double j21 = -a00 * c4 + a01 * c2 - a03 * c0;
+        const double j31 = a00 * c3 - a01 * c1 + a02 * c0;
+        const double j22 = a03 * s4 - a13 * s2 + a33 * s0;
+        const double j32 = -a03 * s3 + a13 * s1 - a23 * s0;
+        const double j33 = a02 * s3 - a12 * s1 + a22 * s0;
+
+        const double n0 = j00 * j00 + j10 * j10 + j20 * j20 + j30 * j30;
+        const double n1 = j10 * j10 + j11 * j11 + j21 * j21 + j31 * j31;
+        const double n2 = j20 * j20 + j21 * j21 + j22 * j22 + j32 * j32;
+        const double n3 = j30 * j30 + j31 * j31 + j32 * j32 + j33 * j33;
+        double best = n0, q0 = j00, q1 = j10, q2 = j20, q3 = j30;
+        const bool pick1 = n1 > best;
+        best = pick1 ? n1 : best;
+        q0 = pick1 ? j10 : q0;
+        q1 = pick1 ? j11 : q1;
+        q2 = pick1 ? j21 : q2;
+        q3 = pick1 ? j31 : q3;
+        const bool pick2 = n2 > best;
+        best = pick2 ? n2 : best;
+        q0 = pick2 ? j20 : q0;
+        q1 = pick2 ? j21 : q1;
+        q2 = pick2 ? j22 : q2;
+        q3 = pick2 ? j32 : q3;
+        const bool pick3 = n3 > best;
+        best = pick3 ? n3 : best;
+        q0 = pick3 ? j30 : q0;
+        q1 = pick3 ? j31 : q1;
+        q2 = pick3 ? j32 : q2;
+        q3 = pick3 ? j33 : q3;
+
+        const double spread = b.spread[i];
+        const double g3 = 0.125 * spread * spread * spread;
+        const double inv = 1.0 / std::max(b.w[i], kMinWeight);
+        b.q[0][i] = q0;
+        b.q[1][i] = q1;
+        b.q[2][i] = q2;
+        b.q[3][i] = q3;
+        b.scale[i] = best > 1e-18 * g3 * g3 ? best : 0.0;
+        b.rms[i] = std::max(spread - 2.0 * l, 0.0) * inv;
+    }
+}
+
+/// The square roots, kept in their own loop so that the rest stays
+/// branch-free when sqrt may set errno.
+MM_ALWAYS_INLINE void normalise(BlockLanes& b, int n) {
+    for (int i = 0; i < n; ++i) {
+        const double norm2 = b.scale[i];
+        const double sign = b.q[0][i] < 0.0 ? -1.0 : 1.0;
+        b.scale[i] = (norm2 > 0.0 ? sign : 0.0) / std::sqrt(norm2 > 0.0 ? norm2 : 1.0);
+        b.rms[i] = std::sqrt(b.rms[i]);
+    }
+}
+
+MM_ALWAYS_INLINE void write_poses(const Job& job, int n) {
+    const BlockLanes& b = *job.lanes;
+    const HeadModel& model = *job.model;
+    HeadPoseTrack& out = *job.out;
+    const std::int64_t f0 = job.first;
+    float* MM_RESTRICT qw_out = out.orientation[0].data() + f0;
+    float* MM_RESTRICT qx_out = out.orientation[1].data() + f0;
+    float* MM_RESTRICT qy_out = out.orientation[2].data() + f0;
+    float* MM_RESTRICT qz_out = out.orientation[3].data() + f0;
+    float* MM_RESTRICT tx_out = out.position[0].data() + f0;
+    float* MM_RESTRICT ty_out = out.position[1].data() + f0;
+    float* MM_RESTRICT tz_out = out.position[2].data() + f0;
+    float* MM_RESTRICT ox_out = out.gaze_origin[0].data() + f0;
+    float* MM_RESTRICT oy_out = out.gaze_origin[1].data() + f0;
+    float* MM_RESTRICT oz_out = out.gaze_origin[2].data() + f0;
+    float* MM_RESTRICT dx_out = out.gaze_direction[0].data() + f0;
+    float* MM_RESTRICT dy_out = out.gaze_direction[1].data() + f0;
+    float* MM_RESTRICT dz_out = out.gaze_direction[2].data() + f0;
+    float* MM_RESTRICT rms_out = out.rms_error.data() + f0;
+    std::uint8_t* MM_RESTRICT used_out = out.markers_used.data() + f0;
+    const Vec3d go = model.gaze_origin;
+    const Vec3d gd = model.gaze_direction;
+    const double min_markers = job.params->min_markers;
+    const double max_rms = job.params->max_rms_error;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    for (int i = 0; i < n; ++i) {
+        const double scale = b.scale[i];
+        const double qw = b.q[0][i] * scale, qx = b.q[1][i] * scale, qy = b.q[2][i] * scale, qz = b.q[3][i] * scale;
+
+        const double r00 = qw * qw + qx * qx - qy * qy - qz * qz;
+        const double r01 = 2.0 * (qx * qy - qw * qz);
+        const double r02 = 2.0 * (qx * qz + qw * qy);
+        const double r10 = 2.0 * (qx * qy + qw * qz);
+        const double r11 = qw * qw - qx * qx + qy * qy - qz * qz;
+        const double r12 = 2.0 * (qy * qz - qw * qx);
+        const double r20 = 2.0 * (qx * qz - qw * qy);
+        const double r21 = 2.0 * (qy * qz + qw * qx);
+        const double r22 = qw * qw - qx * qx - qy * qy + qz * qz;
+
+        const double inv = 1.0 / std::max(b.w[i], kMinWeight);
+        const double lc0 = b.sl[0][i] * inv, lc1 = b.sl[1][i] * inv, lc2 = b.sl[2][i] * inv;
+        const double tx = b.sx[0][i] * inv - (r00 * lc0 + r01 * lc1 + r02 * lc2);
+        const double ty = b.sx[1][i] * inv - (r10 * lc0 + r11 * lc1 + r12 * lc2);
+        const double tz = b.sx[2][i] * inv - (r20 * lc0 + r21 * lc1 + r22 * lc2);
+        const double rms = b.rms[i];
+        // Adding NaN rather than selecting per output keeps the stores
+        // unconditional.
+        const bool ok = b.count[i] >= min_markers && scale != 0.0 && rms <= max_rms;
+        const double reject = ok ? 0.0 : nan;
+
+        qw_out[i] = static_cast<float>(qw + reject);
+        qx_out[i] = static_cast<float>(qx + reject);
+        qy_out[i] = static_cast<float>(qy + reject);
+        qz_out[i] = static_cast<float>(qz + reject);
+        tx_out[i] = static_cast<float>(tx + reject);
+        ty_out[i] = static_cast<float>(ty + reject);
+        tz_out[i] = static_cast<float>(tz + reject);
+        ox_out[i] = static_cast<float>(r00 * go.x + r01 * go.y + r02 * go.z + tx + reject);
+        oy_out[i] = static_cast<float>(r10 * go.x + r11 * go.y + r12 * go.z + ty + reject);
+        oz_out[i] = static_cast<float>(r20 * go.x + r21 * go.y + r22 * go.z + tz + reject);
+        dx_out[i] = static_cast<float>(r00 * gd.x + r01 * gd.y + r02 * gd.z + reject);
+        dy_out[i] = static_cast<float>(r10 * gd.x + r11 * gd.y + r12 * gd.z + reject);
+        dz_out[i] = static_cast<float>(r20 * gd.x + r21 * gd.y + r22 * gd.z + reject);
+        rms_out[i] = static_cast<float>(rms + reject);
+        used_out[i] = static_cast<std::uint8_t>(b.count[i]);
+    }
+}
+
+MM_ALWAYS_INLINE void run_kernels(const Job& job) {
+    BlockLanes& b = *job.lanes;
+    const int n = job.count;
+    for (int i = 0; i < n; ++i) {
+        b.w[i] = 0.0;
+        b.count[i] = 0.0;
+        b.spread[i] = 0.0;
+    }
+    for (int k = 0; k < 3; ++k)
+        for (int i = 0; i < n; ++i) b.sl[k][i] = b.sx[k][i] = 0.0;
+    for (int k = 0; k < 9; ++k)
+        for (int i = 0; i < n; ++i) b.s[k][i] = 0.0;
+
+    const std::vector<HeadModel::Marker>& markers = job.model->markers;
+    for (std::size_t m = 0; m < markers.size(); ++m) {
+        const float* const* c = job.columns + 3 * m;
+        accumulate_marker(c[0] + job.first, c[1] + job.first, c[2] + job.first, markers[m].local, markers[m].weight,
+                          b, n);
+    }
+    setup_frames(b, n);
+    for (int it = 0; it < kNewtonIterations; ++it) newton_step(b, n);
+    recover_quaternions(b, n);
+    normalise(b, n);
+    write_poses(job, n);
+}
+
+void run_scalar(const Job& job) { run_kernels(job); }
+#if MM_HAVE_X86_DISPATCH
+MM_TARGET_AVX2 void run_avx2(const Job& job) { run_kernels(job); }
+MM_TARGET_AVX512 void run_avx512(const Job& job) { run_kernels(job); }
+#endif
+
+}  // namespace
+
+RigidTransform HeadPoseTrack::pose(std::int64_t f) const {
+    const Mat3d r = rotation_from_quaternion(orientation[0][f], orientation[1][f], orientation[2][f],
+                                             orientation[3][f]);
+    return {r, {position[0][f], position[1][f], position[2][f]}};
+}
+
+HeadModel calibrate_head_model(const trajectory::TrajectorySet& set, std::int64_t frame,
+                               const std::vector<std::string>& marker_names, const Vec3d& eye_centre,
+                               const Vec3d& look_at) {
+    if (frame < 0 || frame >= set.frames()) throw std::invalid_argument("calibrate_head_model: frame out of range");
+    const Vec3d view = look_at - eye_centre;
+    if (!(norm(view) > 0.0)) throw std::invalid_argument("calibrate_head_model: look_at coincides with eye_centre");
+    HeadModel model;
+    for (const std::string& name : marker_names) {
+        const int index = set.marker_index(name);
+        if (index < 0) throw std::invalid_argument("calibrate_head_model: unknown marker " + name);
+        if (!set.present(index, frame))
+            throw std::invalid_argument("calibrate_head_model: marker " + name + " missing in calibration frame");
+        model.markers.push_back({name, set.position(index, frame) - eye_centre, 1.0});
+    }
+    model.gaze_origin = Vec3d{};
+    model.gaze_direction = normalized(view);
+    return model;
+}
+
+HeadPoseEstimator::HeadPoseEstimator(HeadModel model, HeadPoseParams params, SimdLevel level, WorkStealingPool* pool)
+    : model_(std::move(model)), params_(params), level_(clamp_simd_level(level)), pool_(pool) {
+    if (model_.markers.size() < 3) throw std::invalid_argument("HeadPoseEstimator: need at least three markers");
+    if (model_.markers.size() > 255) throw std::invalid_argument("HeadPoseEstimator: too many markers");
+    for (const HeadModel::Marker& m : model_.markers)
+        if (!(m.weight > 0.0)) throw std::invalid_argument("HeadPoseEstimator: marker weight must be positive");
+    if (!(norm(model_.gaze_direction) > 0.0)) throw std::invalid_argument("HeadPoseEstimator: zero gaze direction");
+    if (params_.min_markers < 3) throw std::invalid_argument("HeadPoseEstimator: min_markers must be at least 3");
+    model_.gaze_direction = normalized(model_.gaze_direction);
+}
+
+HeadPoseTrack HeadPoseEstimator::estimate(const trajectory::TrajectorySet& set) const {
+    MM_TRACE_SCOPE("head_pose");
+    std::vector<const float*> columns;
+    columns.reserve(model_.markers.size() * 3);
+    for (const HeadModel::Marker& m : model_.markers) {
+        const int index = set.marker_index(m.name);
+        if (index < 0) throw std::invalid_argument("HeadPoseEstimator: trial has no marker " + m.name);
+        for (int axis = 0; axis < 3; ++axis) columns.push_back(set.column(index, axis));
+    }
+
+    HeadPoseTrack out;
+    out.frames = set.frames();
+    const auto frames = static_cast<std::size_t>(out.frames);
+    for (auto& column : out.orientation) column.resize(frames);
+    for (auto& column : out.position) column.resize(frames);
+    for (auto& column : out.gaze_origin) column.resize(frames);
+    for (auto& column : out.gaze_direction) column.resize(frames);
+    out.rms_error.resize(frames);
+    out.markers_used.resize(frames);
+
+    const int blocks = static_cast<int>((out.frames + kBlock - 1) / kBlock);
+    std::vector<BlockLanes> scratch(pool_ ? pool_->size() + 1 : 1);
+    auto run = [&](int block) {
+        const std::int64_t first = static_cast<std::int64_t>(block) * kBlock;
+        const Job job{columns.data(), &model_, &params_, &scratch[pool_ ? pool_->current_slot() : 0], &out, first,
+                      static_cast<int>(std::min<std::int64_t>(kBlock, out.frames - first))};
+        switch (level_) {
+#if MM_HAVE_X86_DISPATCH
+            case SimdLevel::avx512: run_avx512(job); break;
+            case SimdLevel::avx2: run_avx2(job); break;
+#endif
+            default: run_scalar(job); break;
+        }
+    };
+    if (pool_)
+        pool_->parallel_for(0, blocks, 4, run);
+    else
+        for (int block = 0; block < blocks; ++block) run(block);
+    return out;
+}
+
+}  // namespace mm::gaze
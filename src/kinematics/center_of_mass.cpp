@@ -0,0 +1,207 @@
+#include "motionmetrics/kinematics/center_of_mass.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::kinematics {
+namespace {
+
+/// Frames per structure-of-arrays block.
+constexpr int kBlock = 64;
+
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+const std::vector<DeLevaRow> kDeLevaMale = {
+    {"head", 0.0694, 0.5976},         {"trunk", 0.4346, 0.4486},   {"upper_trunk", 0.1596, 0.5066},
+    {"middle_trunk", 0.1633, 0.4502}, {"lower_trunk", 0.1117, 0.6115}, {"upper_arm", 0.0271, 0.5772},
+    {"forearm", 0.0162, 0.4574},      {"hand", 0.0061, 0.7900},    {"thigh", 0.1416, 0.4095},
+    {"shank", 0.0433, 0.4459},        {"foot", 0.0137, 0.4415},
+};
+
+const std::vector<DeLevaRow> kDeLevaFemale = {
+    {"head", 0.0668, 0.5894},         {"trunk", 0.4257, 0.4151},   {"upper_trunk", 0.1545, 0.5050},
+    {"middle_trunk", 0.1465, 0.4512}, {"lower_trunk", 0.1247, 0.4920}, {"upper_arm", 0.0255, 0.5754},
+    {"forearm", 0.0138, 0.4559},      {"hand", 0.0056, 0.7474},    {"thigh", 0.1478, 0.3612},
+    {"shank", 0.0481, 0.4416},        {"foot", 0.0129, 0.4014},
+};
+
+/// Central difference of `x` over `t` at every frame, one-sided at the ends
+/// and next to missing samples.
+void differentiate(const std::vector<float>& x, const std::vector<TimestampNs>& t, std::vector<float>& out) {
+    const std::int64_t n = static_cast<std::int64_t>(x.size());
+    out.assign(n, kNaN);
+    for (std::int64_t f = 0; f < n; ++f) {
+        if (x[f] != x[f]) continue;
+        const bool back = f > 0 && x[f - 1] == x[f - 1];
+        const bool ahead = f + 1 < n && x[f + 1] == x[f + 1];
+        const std::int64_t a = back ? f - 1 : f;
+        const std::int64_t b = ahead ? f + 1 : f;
+        if (a == b) continue;
+        out[f] = static_cast<float>((static_cast<double>(x[b]) - x[a]) / (static_cast<double>(t[b] - t[a]) * 1e-9));
+    }
+}
+
+}  // namespace
+
+/// Pose of one segment for a block of frames, structure of arrays.
+struct alignas(64) CenterOfMassCalculator::BlockPose {
+    double r[9][kBlock];  // row-major rotation, per frame
+    double o[3][kBlock];
+};
+
+const std::vector<DeLevaRow>& de_leva_table(Sex sex) { return sex == Sex::male ? kDeLevaMale : kDeLevaFemale; }
+
+SegmentParameters de_leva_segment(const std::string& row, Sex sex, std::string segment, const Vec3d& proximal,
+                                  const Vec3d& distal) {
+    for (const DeLevaRow& r : de_leva_table(sex)) {
+        if (row != r.name) continue;
+        return {std::move(segment), r.mass_fraction, proximal, distal, r.com_fraction};
+    }
+    throw std::invalid_argument("de_leva_segment: unknown row " + row);
+}
+
+CenterOfMassCalculator::CenterOfMassCalculator(const SkeletonModel& model,
+                                               const AthleteAnthropometrics& anthropometrics)
+    : model_(model), mass_(model.num_segments(), 0.0), local_com_(model.num_segments()) {
+    // Mass-weighted sum of local centres per segment, normalised below.
+    for (const SegmentParameters& p : anthropometrics.segments) {
+        const int s = model.segment_index(p.segment);
+        if (s < 0) throw std::invalid_argument("CenterOfMassCalculator: unknown segment " + p.segment);
+        if (!(p.mass_fraction >= 0.0)) throw std::invalid_argument("CenterOfMassCalculator: negative mass");
+        mass_[s] += p.mass_fraction;
+        local_com_[s] += p.mass_fraction * (p.proximal + p.com_fraction * (p.distal - p.proximal));
+        total_fraction_ += p.mass_fraction;
+    }
+    if (!(total_fraction_ > 0.0)) throw std::invalid_argument("CenterOfMassCalculator: no segment mass");
+    for (int s = 0; s < model.num_segments(); ++s) {
+        if (mass_[s] > 0.0) local_com_[s] *= 1.0 / mass_[s];
+        mass_[s] /= total_fraction_;
+    }
+}
+
+Vec3d CenterOfMassCalculator::position(const double* q) const {
+    std::vector<SegmentPose> poses(model_.num_segments());
+    model_.forward(q, poses.data());
+    Vec3d com{};
+    for (int s = 0; s < model_.num_segments(); ++s)
+        if (mass_[s] > 0.0) com += mass_[s] * (poses[s].rotation * local_com_[s] + poses[s].origin);
+    return com;
+}
+
+CenterOfMassTrajectory CenterOfMassCalculator::compute(const IkTrial& trial, const std::vector<TimestampNs>& timestamps,
+                                                       WorkStealingPool* pool) const {
+    MM_TRACE_SCOPE("center_of_mass");
+    if (trial.num_dofs != model_.num_dofs()) throw std::invalid_argument("CenterOfMassCalculator: trial/model mismatch");
+    if (static_cast<std::int64_t>(timestamps.size()) != trial.frames)
+        throw std::invalid_argument("CenterOfMassCalculator: need one timestamp per frame");
+    CenterOfMassTrajectory out;
+    out.frames = trial.frames;
+    for (auto& column : out.position) column.resize(trial.frames);
+
+    const int blocks = static_cast<int>((trial.frames + kBlock - 1) / kBlock);
+    std::vector<std::vector<BlockPose>> scratch(pool ? pool->size() + 1 : 1,
+                                                std::vector<BlockPose>(model_.num_segments()));
+    auto run = [&](int b) {
+        const std::int64_t first = static_cast<std::int64_t>(b) * kBlock;
+        compute_block(trial, first, static_cast<int>(std::min<std::int64_t>(kBlock, trial.frames - first)),
+                      scratch[pool ? pool->current_slot() : 0].data(), out);
+    };
+    if (pool)
+        pool->parallel_for(0, blocks, 4, run);
+    else
+        for (int b = 0; b < blocks; ++b) run(b);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        differentiate(out.position[axis], timestamps, out.velocity[axis]);
+        differentiate(out.velocity[axis], timestamps, out.acceleration[axis]);
+    }
+    return out;
+}
+
+void CenterOfMassCalculator::compute_block(const IkTrial& trial, std::int64_t first, int count, BlockPose* poses,
+                                           CenterOfMassTrajectory& out) const {
+    const int n = model_.num_dofs();
+    double q[kBlock];
+    double com[3][kBlock] = {};
+
+    for (int s = 0; s < model_.num_segments(); ++s) {
+        const Segment& seg = model_.segment(s);
+        BlockPose& p = poses[s];
+        if (seg.parent >= 0) {
+            const BlockPose& parent = poses[seg.parent];
+            for (int row = 0; row < 3; ++row) {
+                const double* r0 = parent.r[row * 3];
+                const double* r1 = parent.r[row * 3 + 1];
+                const double* r2 = parent.r[row * 3 + 2];
+                const double* po = parent.o[row];
+                double* o = p.o[row];
+                for (int f = 0; f < count; ++f)
+                    o[f] = po[f] + r0[f] * seg.offset.x + r1[f] * seg.offset.y + r2[f] * seg.offset.z;
+            }
+            for (int k = 0; k < 9; ++k) std::copy_n(parent.r[k], count, p.r[k]);
+        } else {
+            for (int k = 0; k < 9; ++k) std::fill_n(p.r[k], count, k % 4 == 0 ? 1.0 : 0.0);
+            for (int row = 0; row < 3; ++row) std::fill_n(p.o[row], count, seg.offset[row]);
+        }
+
+        for (int d : seg.dofs) {
+            const Dof& dof = model_.dof(d);
+            for (int f = 0; f < count; ++f) q[f] = trial.angles[(first + f) * n + d];
+            const int k = dof.axis();
+            if (dof.is_rotation()) {
+                // Right-multiplying by a rotation about local axis k mixes
+                // the other two columns.
+                const int i = (k + 1) % 3;
+                const int j = (k + 2) % 3;
+                double c[kBlock];
+                double sn[kBlock];
+                for (int f = 0; f < count; ++f) {
+                    c[f] = std::cos(q[f]);
+                    sn[f] = std::sin(q[f]);
+                }
+                for (int row = 0; row < 3; ++row) {
+                    double* a = p.r[row * 3 + i];
+                    double* b = p.r[row * 3 + j];
+                    for (int f = 0; f < count; ++f) {
+                        const double x = a[f];
+                        const double y = b[f];
+                        a[f] = c[f] * x + sn[f] * y;
+                        b[f] = c[f] * y - sn[f] * x;
+                    }
+                }
+            } else {
+                for (int row = 0; row < 3; ++row) {
+                    const double* axis = p.r[row * 3 + k];
+                    double* o = p.o[row];
+                    for (int f = 0; f < count; ++f) o[f] += axis[f] * q[f];
+                }
+            }
+        }
+
+        if (mass_[s] > 0.0) {
+            const double m = mass_[s];
+            const Vec3d& l = local_com_[s];
+            for (int row = 0; row < 3; ++row) {
+                const double* r0 = p.r[row * 3];
+                const double* r1 = p.r[row * 3 + 1];
+                const double* r2 = p.r[row * 3 + 2];
+                const double* o = p.o[row];
+                double* acc = com[row];
+                for (int f = 0; f < count; ++f) acc[f] += m * (r0[f] * l.x + r1[f] * l.y + r2[f] * l.z + o[f]);
+            }
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+        for (int f = 0; f < count; ++f) {
+            const bool solved = trial.rms_error[first + f] == trial.rms_error[first + f];
+            out.position[axis][first + f] = solved ? static_cast<float>(com[axis][f]) : kNaN;
+        }
+}
+
+}  // namespace mm::kinematics
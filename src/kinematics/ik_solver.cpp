@@ -0,0 +1,204 @@
+#include "motionmetrics/kinematics/ik_solver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "motionmetrics/core/linear_algebra.hpp"
+#include "motionmetrics/core/rigid_transform.hpp"
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::kinematics {
+namespace {
+
+/// Angles (a, b, c) with r = R_i(a) R_j(b) R_k(c) for distinct axes i, j, k.
+void decompose_rotation(const Mat3d& r, int i, int j, int k, double angles[3]) {
+    const double s = (j - i + 3) % 3 == 1 ? 1.0 : -1.0;
+    angles[1] = std::asin(std::clamp(s * r(i, k), -1.0, 1.0));
+    angles[0] = std::atan2(-s * r(j, k), r(k, k));
+    angles[2] = std::atan2(-s * r(i, j), r(i, i));
+}
+
+}  // namespace
+
+IkSolver::IkSolver(SkeletonModel model, IkParams params) : model_(std::move(model)), params_(params) {
+    if (model_.num_segments() == 0) throw std::invalid_argument("IkSolver: empty skeleton");
+    if (params_.max_iterations < 1 || params_.cold_iterations < 1 || params_.chunk_frames < 1 ||
+        params_.warmup_frames < 0)
+        throw std::invalid_argument("IkSolver: invalid iteration or chunk settings");
+    chains_.resize(model_.num_segments());
+    for (int s = 0; s < model_.num_segments(); ++s) chains_[s] = model_.chain_dofs(s);
+
+    // Root placement needs translations along x, y, z followed by three
+    // rotations about distinct axes.
+    const std::vector<int>& root = model_.segment(0).dofs;
+    if (root.size() == 6) {
+        int translated = 0;
+        int rotated = 0;
+        for (int i = 0; i < 3; ++i) {
+            const Dof& t = model_.dof(root[i]);
+            const Dof& r = model_.dof(root[3 + i]);
+            if (!t.is_rotation()) translated |= 1 << t.axis();
+            if (r.is_rotation()) rotated |= 1 << r.axis();
+        }
+        root_placeable_ = translated == 7 && rotated == 7;
+    }
+
+    const int n = model_.num_dofs();
+    poses_.resize(model_.num_segments());
+    axes_.resize(n);
+    pivots_.resize(n);
+    residual_.resize(model_.num_markers());
+    normal_.resize(static_cast<std::size_t>(n) * n);
+    factor_.resize(static_cast<std::size_t>(n) * n);
+    gradient_.resize(n);
+    step_.resize(n);
+    columns_.resize(n);
+    trial_.resize(n);
+}
+
+void IkSolver::place_root(const float* xyz, double* q) const {
+    if (!root_placeable_) return;
+    std::vector<Vec3d> from;
+    std::vector<Vec3d> to;
+    std::vector<double> weights;
+    for (int m = 0; m < model_.num_markers(); ++m) {
+        const ModelMarker& marker = model_.marker(m);
+        if (marker.segment != 0 || xyz[m * 3] != xyz[m * 3]) continue;
+        from.push_back(marker.local);
+        to.push_back({xyz[m * 3], xyz[m * 3 + 1], xyz[m * 3 + 2]});
+        weights.push_back(marker.weight);
+    }
+    RigidTransform fit;
+    if (!fit_rigid_transform(from.data(), to.data(), weights.data(), static_cast<int>(from.size()), fit)) return;
+
+    const std::vector<int>& root = model_.segment(0).dofs;
+    const Vec3d shift = fit.translation - model_.segment(0).offset;
+    for (int i = 0; i < 3; ++i) q[root[i]] = shift[model_.dof(root[i]).axis()];
+    double angles[3];
+    decompose_rotation(fit.rotation, model_.dof(root[3]).axis(), model_.dof(root[4]).axis(),
+                       model_.dof(root[5]).axis(), angles);
+    for (int i = 0; i < 3; ++i) q[root[3 + i]] = angles[i];
+}
+
+double IkSolver::evaluate(const float* xyz, const double* q) {
+    model_.forward(q, poses_.data(), axes_.data(), pivots_.data());
+    double cost = 0.0;
+    for (int m = 0; m < model_.num_markers(); ++m) {
+        const float* z = xyz + m * 3;
+        if (z[0] != z[0]) continue;
+        residual_[m] = Vec3d{z[0], z[1], z[2]} - model_.marker_position(poses_.data(), m);
+        cost += model_.marker(m).weight * dot(residual_[m], residual_[m]);
+    }
+    return cost;
+}
+
+IkResult IkSolver::solve(const float* xyz, double* q, bool warm) {
+    MM_TRACE_SCOPE("ik_solve");
+    const int n = model_.num_dofs();
+    IkResult result;
+    double weight_sum = 0.0;
+    for (int m = 0; m < model_.num_markers(); ++m) {
+        if (xyz[m * 3] != xyz[m * 3]) continue;
+        ++result.markers_used;
+        weight_sum += model_.marker(m).weight;
+    }
+    if (!warm) {
+        const std::vector<double> neutral = model_.neutral_pose();
+        std::copy(neutral.begin(), neutral.end(), q);
+        if (result.markers_used > 0) place_root(xyz, q);
+    }
+    if (result.markers_used == 0) {
+        result.rms_error = std::numeric_limits<double>::quiet_NaN();
+        return result;
+    }
+    model_.clamp(q);
+
+    const int iterations = warm ? params_.max_iterations : params_.cold_iterations;
+    double cost = evaluate(xyz, q);
+    double lambda = params_.damping;
+    for (int it = 0; it < iterations && !result.converged; ++it) {
+        result.iterations = it + 1;
+
+        // Normal equations J^T W J dq = J^T W r, lower triangle only.
+        std::fill(normal_.begin(), normal_.end(), 0.0);
+        std::fill(gradient_.begin(), gradient_.end(), 0.0);
+        for (int m = 0; m < model_.num_markers(); ++m) {
+            if (xyz[m * 3] != xyz[m * 3]) continue;
+            const ModelMarker& marker = model_.marker(m);
+            const Vec3d p = model_.marker_position(poses_.data(), m);
+            const std::vector<int>& chain = chains_[marker.segment];
+            Vec3d* columns = columns_.data();
+            for (int a = 0; a < static_cast<int>(chain.size()); ++a) {
+                const int d = chain[a];
+                columns[a] = model_.dof(d).is_rotation() ? cross(axes_[d], p - pivots_[d]) : axes_[d];
+                gradient_[d] += marker.weight * dot(columns[a], residual_[m]);
+                for (int b = 0; b <= a; ++b) {
+                    const int e = chain[b];
+                    normal_[std::max(d, e) * n + std::min(d, e)] += marker.weight * dot(columns[a], columns[b]);
+                }
+            }
+        }
+
+        const auto factor = [&](double damping) {
+            factor_ = normal_;
+            for (int d = 0; d < n; ++d)
+                factor_[d * n + d] = normal_[d * n + d] * (1.0 + damping) + detail::kRegularisation;
+            return cholesky(factor_.data(), n, n);
+        };
+        const auto solve = [&] {
+            step_ = gradient_;
+            cholesky_solve(factor_.data(), n, n, step_.data());
+        };
+        if (!detail::damped_step(
+                n, q, trial_.data(), step_.data(), params_.tolerance, lambda, cost, result.converged, factor,
+                solve, [&](double* pose) { model_.clamp(pose); },
+                [&](const double* pose) { return evaluate(xyz, pose); }))
+            break;
+    }
+    result.rms_error = std::sqrt(cost / weight_sum);
+    return result;
+}
+
+IkTrial IkSolver::solve_trial(const trajectory::TrajectorySet& trial, WorkStealingPool* pool) const {
+    MM_TRACE_SCOPE("ik_solve_trial");
+    return detail::solve_trial(*this, model_, params_, trial, pool);
+}
+
+namespace detail {
+
+void unwrap_chunks(const SkeletonModel& model, std::int64_t chunk, IkTrial& out) {
+    const int n = out.num_dofs;
+    const int chunks = static_cast<int>((out.frames + chunk - 1) / chunk);
+    for (int d = 0; d < n; ++d) {
+        const Dof& dof = model.dof(d);
+        if (!dof.is_rotation() || dof.max - dof.min < 2.0 * M_PI) continue;
+        auto angle = [&](std::int64_t f) -> double& { return out.angles[f * n + d]; };
+        for (int c = 1; c < chunks; ++c) {
+            const std::int64_t begin = c * chunk;
+            const std::int64_t end = std::min(out.frames, begin + chunk);
+            // Continue from the last solved frame before the chunk to its
+            // first solved frame; unsolved frames are NaN.
+            std::int64_t previous = begin - 1;
+            while (previous >= 0 && std::isnan(angle(previous))) --previous;
+            std::int64_t first = begin;
+            while (first < end && std::isnan(angle(first))) ++first;
+            if (previous < 0 || first == end) continue;
+            const double shift = std::round((angle(previous) - angle(first)) / (2.0 * M_PI)) * 2.0 * M_PI;
+            if (shift == 0.0) continue;
+            // All or nothing: shifting only the frames the limits allow
+            // would leave a jump of a whole turn inside the chunk.
+            bool fits = true;
+            for (std::int64_t f = first; f < end && fits; ++f)
+                fits = std::isnan(angle(f)) || (angle(f) + shift >= dof.min && angle(f) + shift <= dof.max);
+            if (!fits) continue;
+            for (std::int64_t f = first; f < end; ++f) angle(f) += shift;
+        }
+    }
+}
+
+}  // namespace detail
+
+}  // namespace mm::kinematics
@@ -0,0 +1,115 @@
+#include "motionmetrics/kinematics/skeleton_model.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace mm::kinematics {
+namespace {
+
+/// Rotation by `angle` about coordinate axis `axis`.
+Mat3d axis_rotation(int axis, double angle) {
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    switch (axis) {
+        case 0:
+            return Mat3d{{1, 0, 0, 0, c, -s, 0, s, c}};
+        case 1:
+            return Mat3d{{c, 0, s, 0, 1, 0, -s, 0, c}};
+        default:
+            return Mat3d{{c, -s, 0, s, c, 0, 0, 0, 1}};
+    }
+}
+
+}  // namespace
+
+int SkeletonModel::add_segment(std::string name, int parent, const Vec3d& offset) {
+    if (segments_.empty() ? parent != -1 : (parent < 0 || parent >= num_segments()))
+        throw std::invalid_argument("SkeletonModel: segment " + name + " needs an existing parent (or -1 for the root)");
+    if (segment_index(name) >= 0) throw std::invalid_argument("SkeletonModel: duplicate segment " + name);
+    Segment s;
+    s.name = std::move(name);
+    s.parent = parent;
+    s.offset = offset;
+    segments_.push_back(std::move(s));
+    return num_segments() - 1;
+}
+
+int SkeletonModel::add_dof(int segment, DofType type, double min, double max, std::string name) {
+    if (segment < 0 || segment >= num_segments()) throw std::invalid_argument("SkeletonModel: unknown segment");
+    if (!(min <= max)) throw std::invalid_argument("SkeletonModel: empty joint range");
+    Dof d;
+    d.name = name.empty() ? segments_[segment].name + "." + std::to_string(segments_[segment].dofs.size()) : std::move(name);
+    d.segment = segment;
+    d.type = type;
+    d.min = min;
+    d.max = max;
+    dofs_.push_back(std::move(d));
+    segments_[segment].dofs.push_back(num_dofs() - 1);
+    return num_dofs() - 1;
+}
+
+int SkeletonModel::add_marker(std::string name, int segment, const Vec3d& local, double weight) {
+    if (segment < 0 || segment >= num_segments()) throw std::invalid_argument("SkeletonModel: unknown segment");
+    if (marker_index(name) >= 0) throw std::invalid_argument("SkeletonModel: duplicate marker " + name);
+    if (!(weight > 0.0)) throw std::invalid_argument("SkeletonModel: marker weight must be positive");
+    markers_.push_back({std::move(name), segment, local, weight});
+    return num_markers() - 1;
+}
+
+int SkeletonModel::segment_index(const std::string& name) const {
+    for (int i = 0; i < num_segments(); ++i)
+        if (segments_[i].name == name) return i;
+    return -1;
+}
+
+int SkeletonModel::marker_index(const std::string& name) const {
+    for (int i = 0; i < num_markers(); ++i)
+        if (markers_[i].name == name) return i;
+    return -1;
+}
+
+std::vector<int> SkeletonModel::chain_dofs(int segment) const {
+    std::vector<int> chain;
+    for (int s = segment; s >= 0; s = segments_[s].parent)
+        chain.insert(chain.begin(), segments_[s].dofs.begin(), segments_[s].dofs.end());
+    return chain;
+}
+
+std::vector<double> SkeletonModel::neutral_pose() const {
+    std::vector<double> q(dofs_.size(), 0.0);
+    clamp(q.data());
+    return q;
+}
+
+void SkeletonModel::clamp(double* q) const {
+    for (int d = 0; d < num_dofs(); ++d) q[d] = std::clamp(q[d], dofs_[d].min, dofs_[d].max);
+}
+
+void SkeletonModel::forward(const double* q, SegmentPose* poses, Vec3d* dof_axes, Vec3d* dof_pivots) const {
+    for (int s = 0; s < num_segments(); ++s) {
+        const Segment& seg = segments_[s];
+        SegmentPose pose;
+        if (seg.parent >= 0) {
+            const SegmentPose& parent = poses[seg.parent];
+            pose.rotation = parent.rotation;
+            pose.origin = parent.origin + parent.rotation * seg.offset;
+        } else {
+            pose.origin = seg.offset;
+        }
+        for (int d : seg.dofs) {
+            const Dof& dof = dofs_[d];
+            const Vec3d axis = pose.rotation.col(dof.axis());
+            if (dof_axes) dof_axes[d] = axis;
+            if (dof_pivots) dof_pivots[d] = pose.origin;
+            if (dof.is_rotation())
+                pose.rotation = pose.rotation * axis_rotation(dof.axis(), q[d]);
+            else
+                pose.origin += axis * q[d];
+        }
+        poses[s] = pose;
+    }
+}
+
+}  // namespace mm::kinematics
@@ -0,0 +1,70 @@
+#include "motionmetrics/labeling/assignment.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace mm::labeling {
+
+double AssignmentSolver::solve(const double* cost, int rows, int cols, std::vector<int>& row_to_col) {
+    if (rows > cols) throw std::invalid_argument("AssignmentSolver: more rows than columns");
+    constexpr double kInf = std::numeric_limits<double>::infinity();
+    // 1-based arrays; column 0 is the virtual start of each augmenting path.
+    u_.assign(rows + 1, 0.0);
+    v_.assign(cols + 1, 0.0);
+    match_.assign(cols + 1, 0);
+    way_.assign(cols + 1, 0);
+    min_slack_.resize(cols + 1);
+    used_.resize(cols + 1);
+
+    for (int row = 1; row <= rows; ++row) {
+        match_[0] = row;
+        int col0 = 0;
+        std::fill(min_slack_.begin(), min_slack_.end(), kInf);
+        std::fill(used_.begin(), used_.end(), 0);
+        do {
+            used_[col0] = 1;
+            const int i0 = match_[col0];
+            const double* cost_row = cost + static_cast<std::size_t>(i0 - 1) * cols;
+            double delta = kInf;
+            int col1 = 0;
+            for (int j = 1; j <= cols; ++j) {
+                if (used_[j]) continue;
+                const double slack = cost_row[j - 1] - u_[i0] - v_[j];
+                if (slack < min_slack_[j]) {
+                    min_slack_[j] = slack;
+                    way_[j] = col0;
+                }
+                if (min_slack_[j] < delta) {
+                    delta = min_slack_[j];
+                    col1 = j;
+                }
+            }
+            for (int j = 0; j <= cols; ++j) {
+                if (used_[j]) {
+                    u_[match_[j]] += delta;
+                    v_[j] -= delta;
+                } else {
+                    min_slack_[j] -= delta;
+                }
+            }
+            col0 = col1;
+        } while (match_[col0] != 0);
+        do {
+            const int col1 = way_[col0];
+            match_[col0] = match_[col1];
+            col0 = col1;
+        } while (col0 != 0);
+    }
+
+    row_to_col.assign(rows, -1);
+    double total = 0.0;
+    for (int j = 1; j <= cols; ++j) {
+        if (match_[j] == 0) continue;
+        row_to_col[match_[j] - 1] = j - 1;
+        total += cost[static_cast<std::size_t>(match_[j] - 1) * cols + (j - 1)];
+    }
+    return total;
+}
+
+}  // namespace mm::labeling
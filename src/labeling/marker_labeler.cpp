@@ -0,0 +1,505 @@
+#include "motionmetrics/labeling/marker_labeler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "motionmetrics/core/rigid_transform.hpp"
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::labeling {
+namespace {
+
+/// Cost of an assignment outside a marker's gate; far above any squared
+/// distance in metres, but finite so the solver's potentials stay exact.
+constexpr double kForbidden = 1.0e6;
+
+bool valid_point(const Vec3d& p) { return p.x == p.x && p.y == p.y && p.z == p.z; }
+
+double distance2(const Vec3d& a, const Vec3d& b) {
+    const Vec3d d = a - b;
+    return dot(d, d);
+}
+
+std::uint64_t cell_key(std::int64_t x, std::int64_t y, std::int64_t z) {
+    constexpr std::uint64_t kMask = (1u << 21) - 1;
+    return (static_cast<std::uint64_t>(x) & kMask) << 42 | (static_cast<std::uint64_t>(y) & kMask) << 21 |
+           (static_cast<std::uint64_t>(z) & kMask);
+}
+
+int find_root(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+}  // namespace
+
+void MarkerLabeler::PointGrid::build(const std::vector<Vec3d>& points, double cell_size) {
+    cell = cell_size;
+    entries.clear();
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        const Vec3d& p = points[i];
+        if (!valid_point(p)) continue;
+        entries.emplace_back(cell_key(static_cast<std::int64_t>(std::floor(p.x / cell)),
+                                      static_cast<std::int64_t>(std::floor(p.y / cell)),
+                                      static_cast<std::int64_t>(std::floor(p.z / cell))),
+                             static_cast<int>(i));
+    }
+    std::sort(entries.begin(), entries.end());
+}
+
+template <typename Fn>
+void MarkerLabeler::PointGrid::for_each_near(const Vec3d& p, double radius, Fn&& fn) const {
+    const auto x0 = static_cast<std::int64_t>(std::floor((p.x - radius) / cell));
+    const auto y0 = static_cast<std::int64_t>(std::floor((p.y - radius) / cell));
+    const auto z0 = static_cast<std::int64_t>(std::floor((p.z - radius) / cell));
+    const auto x1 = static_cast<std::int64_t>(std::floor((p.x + radius) / cell));
+    const auto y1 = static_cast<std::int64_t>(std::floor((p.y + radius) / cell));
+    const auto z1 = static_cast<std::int64_t>(std::floor((p.z + radius) / cell));
+    for (std::int64_t x = x0; x <= x1; ++x) {
+        for (std::int64_t y = y0; y <= y1; ++y) {
+            for (std::int64_t z = z0; z <= z1; ++z) {
+                const std::uint64_t key = cell_key(x, y, z);
+                auto it = std::lower_bound(entries.begin(), entries.end(), std::make_pair(key, -1));
+                for (; it != entries.end() && it->first == key; ++it) fn(it->second);
+            }
+        }
+    }
+}
+
+MarkerLabeler::MarkerLabeler(SkeletonTemplate skeleton, MarkerLabelerParams params)
+    : skeleton_(std::move(skeleton)), params_(params) {
+    if (!(params_.gate > 0.0)) throw std::invalid_argument("MarkerLabeler: gate must be positive");
+    if (!(params_.max_fit_residual > 0.0))
+        throw std::invalid_argument("MarkerLabeler: max_fit_residual must be positive");
+    if (params_.min_support < 3) throw std::invalid_argument("MarkerLabeler: min_support must be at least 3");
+    if (params_.cold_start_retry_frames < 0)
+        throw std::invalid_argument("MarkerLabeler: cold_start_retry_frames must not be negative");
+    const int m = skeleton_.num_markers();
+    const std::vector<SegmentConstraint>& segments = skeleton_.segments();
+
+    adjacency_start_.assign(m + 1, 0);
+    for (const SegmentConstraint& s : segments) {
+        ++adjacency_start_[s.a + 1];
+        ++adjacency_start_[s.b + 1];
+    }
+    for (int i = 0; i < m; ++i) adjacency_start_[i + 1] += adjacency_start_[i];
+    adjacency_.resize(adjacency_start_[m]);
+    std::vector<int> fill(adjacency_start_.begin(), adjacency_start_.end() - 1);
+    pair_segment_.assign(static_cast<std::size_t>(m) * m, -1);
+    for (int i = 0; i < static_cast<int>(segments.size()); ++i) {
+        adjacency_[fill[segments[i].a]++] = i;
+        adjacency_[fill[segments[i].b]++] = i;
+        pair_segment_[segments[i].a * m + segments[i].b] = i;
+        pair_segment_[segments[i].b * m + segments[i].a] = i;
+    }
+
+    for (int a = 0; a < m; ++a)
+        for (int b = a + 1; b < m; ++b) {
+            if (pair_segment_[a * m + b] < 0) continue;
+            for (int c = b + 1; c < m; ++c)
+                if (pair_segment_[a * m + c] >= 0 && pair_segment_[b * m + c] >= 0) triangles_.push_back({a, b, c});
+        }
+    if (triangles_.empty()) throw std::invalid_argument("MarkerLabeler: template has no constraint triangle");
+
+    component_.assign(m, -1);
+    for (int seed = 0; seed < m; ++seed) {
+        if (component_[seed] >= 0) continue;
+        queue_.assign(1, seed);
+        component_[seed] = num_components_;
+        for (std::size_t head = 0; head < queue_.size(); ++head) {
+            const int from = queue_[head];
+            for (int k = adjacency_start_[from]; k < adjacency_start_[from + 1]; ++k) {
+                const SegmentConstraint& s = segments[adjacency_[k]];
+                const int to = s.a == from ? s.b : s.a;
+                if (component_[to] >= 0) continue;
+                component_[to] = num_components_;
+                queue_.push_back(to);
+            }
+        }
+        component_size_.push_back(static_cast<int>(queue_.size()));
+        ++num_components_;
+    }
+    retry_after_.assign(num_components_, 0);
+    tracks_.resize(m);
+}
+
+void MarkerLabeler::reset() {
+    std::fill(tracks_.begin(), tracks_.end(), Track{});
+    std::fill(retry_after_.begin(), retry_after_.end(), 0);
+    stats_ = MarkerLabelerStats{};
+}
+
+void MarkerLabeler::clear_labels() {
+    result_.point_of_marker.assign(skeleton_.num_markers(), -1);
+    result_.marker_of_point.assign(points_->size(), -1);
+    result_.labelled = 0;
+}
+
+void MarkerLabeler::assign(int marker, int point) {
+    result_.point_of_marker[marker] = point;
+    result_.marker_of_point[point] = marker;
+    ++result_.labelled;
+}
+
+void MarkerLabeler::unassign(int marker) {
+    result_.marker_of_point[result_.point_of_marker[marker]] = -1;
+    result_.point_of_marker[marker] = -1;
+    --result_.labelled;
+}
+
+const LabelingResult& MarkerLabeler::label(const reconstruction::TriangulatedPoints& points, TimestampNs timestamp) {
+    point_scratch_.resize(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) point_scratch_[i] = points.point(i);
+    return label(point_scratch_, timestamp);
+}
+
+const LabelingResult& MarkerLabeler::label(const std::vector<Vec3d>& points, TimestampNs timestamp) {
+    MM_TRACE_SCOPE("label_markers");
+    points_ = &points;
+    clear_labels();
+    result_.rejected = 0;
+    result_.cold_start = false;
+    residual_.assign(skeleton_.num_markers(), 0.0);
+    ++stats_.frames;
+
+    warm_start(timestamp);
+    if (result_.labelled > 0) {
+        enforce_segments();
+        stats_.warm_labels += result_.labelled;
+        queue_.clear();
+        for (int m = 0; m < skeleton_.num_markers(); ++m)
+            if (result_.point_of_marker[m] >= 0) queue_.push_back(m);
+        propagate(queue_, true);
+    }
+    cold_start(result_.labelled < params_.min_labelled);
+    update_tracks(timestamp);
+    return result_;
+}
+
+void MarkerLabeler::warm_start(TimestampNs timestamp) {
+    const int m = skeleton_.num_markers();
+    const std::vector<Vec3d>& points = *points_;
+    predicted_.resize(m);
+    radius_.assign(m, -1.0);
+    bool any = false;
+    for (int i = 0; i < m; ++i) {
+        const Track& t = tracks_[i];
+        if (!t.active) continue;
+        const double dt = static_cast<double>(timestamp - t.last_seen) * 1e-9;
+        predicted_[i] = t.position + t.velocity * dt;
+        radius_[i] = params_.gate + params_.gate_growth * t.missed;
+        any = true;
+    }
+    if (!any) return;
+
+    grid_.build(points, params_.gate);
+    edges_.clear();
+    for (int i = 0; i < m; ++i) {
+        if (radius_[i] < 0.0) continue;
+        const double r2 = radius_[i] * radius_[i];
+        grid_.for_each_near(predicted_[i], radius_[i], [&](int p) {
+            if (distance2(points[p], predicted_[i]) <= r2) edges_.push_back({0, i, p});
+        });
+    }
+
+    // Connected clusters of the marker/point candidate graph; markers are
+    // nodes [0, m), points follow.
+    parent_.resize(m + points.size());
+    for (std::size_t i = 0; i < parent_.size(); ++i) parent_[i] = static_cast<int>(i);
+    for (const auto& e : edges_) {
+        const int a = find_root(parent_, e[1]);
+        const int b = find_root(parent_, m + e[2]);
+        if (a != b) parent_[a] = b;
+    }
+    for (auto& e : edges_) e[0] = find_root(parent_, e[1]);
+    std::sort(edges_.begin(), edges_.end());
+
+    for (std::size_t begin = 0; begin < edges_.size();) {
+        std::size_t end = begin + 1;
+        while (end < edges_.size() && edges_[end][0] == edges_[begin][0]) ++end;
+        if (end - begin == 1) {
+            const int marker = edges_[begin][1];
+            const int point = edges_[begin][2];
+            residual_[marker] = std::sqrt(distance2(points[point], predicted_[marker])) / radius_[marker];
+            assign(marker, point);
+        } else {
+            cluster_markers_.clear();
+            cluster_points_.clear();
+            for (std::size_t e = begin; e < end; ++e) {
+                cluster_markers_.push_back(edges_[e][1]);
+                cluster_points_.push_back(edges_[e][2]);
+            }
+            std::sort(cluster_points_.begin(), cluster_points_.end());
+            cluster_points_.erase(std::unique(cluster_points_.begin(), cluster_points_.end()), cluster_points_.end());
+            // Edges are sorted by marker within a cluster.
+            cluster_markers_.erase(std::unique(cluster_markers_.begin(), cluster_markers_.end()),
+                                   cluster_markers_.end());
+            solve_cluster();
+        }
+        begin = end;
+    }
+}
+
+void MarkerLabeler::solve_cluster() {
+    const std::vector<Vec3d>& points = *points_;
+    const int rows = static_cast<int>(cluster_markers_.size());
+    const int num_points = static_cast<int>(cluster_points_.size());
+    // One private "missing" column per marker, priced at the gate edge, so
+    // a marker only takes a point when that beats leaving it unlabelled.
+    const int cols = num_points + rows;
+    cost_.assign(static_cast<std::size_t>(rows) * cols, kForbidden);
+    for (int r = 0; r < rows; ++r) {
+        const int marker = cluster_markers_[r];
+        const double r2 = radius_[marker] * radius_[marker];
+        double* row = cost_.data() + static_cast<std::size_t>(r) * cols;
+        for (int c = 0; c < num_points; ++c) {
+            const double d2 = distance2(points[cluster_points_[c]], predicted_[marker]);
+            if (d2 <= r2) row[c] = d2;
+        }
+        row[num_points + r] = r2;
+    }
+    solver_.solve(cost_.data(), rows, cols, row_to_col_);
+    ++stats_.assignment_problems;
+    for (int r = 0; r < rows; ++r) {
+        const int c = row_to_col_[r];
+        if (c >= num_points) continue;
+        const int marker = cluster_markers_[r];
+        residual_[marker] = std::sqrt(cost_[static_cast<std::size_t>(r) * cols + c]) / radius_[marker];
+        assign(marker, cluster_points_[c]);
+    }
+}
+
+void MarkerLabeler::enforce_segments() {
+    const std::vector<Vec3d>& points = *points_;
+    const std::vector<SegmentConstraint>& segments = skeleton_.segments();
+    const int m = skeleton_.num_markers();
+    for (;;) {
+        violations_.assign(m, 0);
+        bool any = false;
+        for (const SegmentConstraint& s : segments) {
+            const int pa = result_.point_of_marker[s.a];
+            const int pb = result_.point_of_marker[s.b];
+            if (pa < 0 || pb < 0) continue;
+            if (std::abs(norm(points[pa] - points[pb]) - s.length) <= s.tolerance) continue;
+            ++violations_[s.a];
+            ++violations_[s.b];
+            any = true;
+        }
+        if (!any) return;
+        // Drop the marker in the most violations; among equals, the one
+        // that strayed furthest from its prediction.
+        int worst = -1;
+        for (int i = 0; i < m; ++i) {
+            if (violations_[i] == 0) continue;
+            if (worst < 0 || violations_[i] > violations_[worst] ||
+                (violations_[i] == violations_[worst] && residual_[i] > residual_[worst]))
+                worst = i;
+        }
+        unassign(worst);
+        ++result_.rejected;
+        ++stats_.rejected_labels;
+    }
+}
+
+bool MarkerLabeler::try_recover(int marker) {
+    const std::vector<Vec3d>& points = *points_;
+    const std::vector<SegmentConstraint>& segments = skeleton_.segments();
+    int constraints = 0;
+    for (int k = adjacency_start_[marker]; k < adjacency_start_[marker + 1]; ++k) {
+        const SegmentConstraint& s = segments[adjacency_[k]];
+        if (result_.point_of_marker[s.a == marker ? s.b : s.a] >= 0) ++constraints;
+    }
+    if (constraints == 0) return false;
+
+    int best = -1;
+    int candidates = 0;
+    double best_score = std::numeric_limits<double>::infinity();
+    double second_score = best_score;
+    for (int p = 0; p < static_cast<int>(points.size()); ++p) {
+        if (result_.marker_of_point[p] >= 0 || !valid_point(points[p])) continue;
+        double score = 0.0;
+        bool ok = true;
+        for (int k = adjacency_start_[marker]; k < adjacency_start_[marker + 1] && ok; ++k) {
+            const SegmentConstraint& s = segments[adjacency_[k]];
+            const int q = result_.point_of_marker[s.a == marker ? s.b : s.a];
+            if (q < 0) continue;
+            const double error = std::abs(norm(points[p] - points[q]) - s.length) / s.tolerance;
+            ok = error <= 1.0;
+            score += error * error;
+        }
+        if (!ok) continue;
+        ++candidates;
+        if (score < best_score) {
+            second_score = best_score;
+            best_score = score;
+            best = p;
+        } else if (score < second_score) {
+            second_score = score;
+        }
+    }
+    // A single length pins a point only to a sphere, so several fits are
+    // accepted only when more constraints make the best one stand out.
+    if (candidates == 0) return false;
+    if (candidates > 1 && !(constraints >= 2 && best_score < 0.5 * second_score)) return false;
+    assign(marker, best);
+    return true;
+}
+
+void MarkerLabeler::propagate(std::vector<int>& queue, bool record) {
+    const std::vector<SegmentConstraint>& segments = skeleton_.segments();
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const int from = queue[head];
+        for (int k = adjacency_start_[from]; k < adjacency_start_[from + 1]; ++k) {
+            const SegmentConstraint& s = segments[adjacency_[k]];
+            const int marker = s.a == from ? s.b : s.a;
+            if (result_.point_of_marker[marker] >= 0 || !try_recover(marker)) continue;
+            if (record) ++stats_.recovered_labels;
+            queue.push_back(marker);
+        }
+    }
+}
+
+double MarkerLabeler::rigid_residual(int component) {
+    fit_from_.clear();
+    fit_to_.clear();
+    for (int m = 0; m < skeleton_.num_markers(); ++m) {
+        const int p = result_.point_of_marker[m];
+        if (p < 0 || component_[m] != component) continue;
+        fit_from_.push_back(skeleton_.rest_position(m));
+        fit_to_.push_back((*points_)[p]);
+    }
+    RigidTransform fit;
+    const int n = static_cast<int>(fit_from_.size());
+    if (!fit_rigid_transform(fit_from_.data(), fit_to_.data(), nullptr, n, fit))
+        return std::numeric_limits<double>::infinity();
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) sum += distance2(fit.apply(fit_from_[i]), fit_to_[i]);
+    return std::sqrt(sum / n);
+}
+
+void MarkerLabeler::cold_start(bool all) {
+    const std::vector<Vec3d>& points = *points_;
+    const std::vector<SegmentConstraint>& segments = skeleton_.segments();
+    const int m = skeleton_.num_markers();
+
+    component_labels_.assign(num_components_, 0);
+    for (int i = 0; i < m; ++i)
+        if (result_.point_of_marker[i] >= 0) ++component_labels_[component_[i]];
+    if (all) {
+        clear_labels();
+        std::fill(component_labels_.begin(), component_labels_.end(), 0);
+    }
+    // Components still waiting out a failed attempt are left unlabelled.
+    auto due = [&](int component) {
+        return component_labels_[component] == 0 && stats_.frames >= retry_after_[component];
+    };
+    const bool any_due = std::any_of(triangles_.begin(), triangles_.end(),
+                                     [&](const std::array<int, 3>& tri) { return due(component_[tri[0]]); });
+    if (!any_due) return;
+    MM_TRACE_SCOPE("label_cold_start");
+    ++stats_.cold_starts;
+    result_.cold_start = true;
+
+    auto fits = [&](int a, int b, int pa, int pb) {
+        const SegmentConstraint& s = segments[pair_segment_[a * m + b]];
+        return std::abs(norm(points[pa] - points[pb]) - s.length) <= s.tolerance;
+    };
+    auto free_point = [&](int p) { return result_.marker_of_point[p] < 0 && valid_point(points[p]); };
+    const int num_points = static_cast<int>(points.size());
+
+    for (int component = 0; component < num_components_; ++component) {
+        if (!due(component)) continue;
+        snapshot_markers_ = result_.point_of_marker;
+        snapshot_points_ = result_.marker_of_point;
+        const int base = result_.labelled;
+        const int support = std::min(params_.min_support, component_size_[component]);
+        int best_count = 0;
+        double best_residual = std::numeric_limits<double>::infinity();
+        int seeds = 0;
+        for (const auto& tri : triangles_) {
+            if (component_[tri[0]] != component) continue;
+            for (int pa = 0; pa < num_points && seeds < params_.max_seeds; ++pa) {
+                if (!free_point(pa)) continue;
+                for (int pb = 0; pb < num_points && seeds < params_.max_seeds; ++pb) {
+                    if (pb == pa || !free_point(pb) || !fits(tri[0], tri[1], pa, pb)) continue;
+                    for (int pc = 0; pc < num_points && seeds < params_.max_seeds; ++pc) {
+                        if (pc == pa || pc == pb || !free_point(pc) || !fits(tri[0], tri[2], pa, pc) ||
+                            !fits(tri[1], tri[2], pb, pc))
+                            continue;
+                        ++seeds;
+                        assign(tri[0], pa);
+                        assign(tri[1], pb);
+                        assign(tri[2], pc);
+                        queue_.assign(tri.begin(), tri.end());
+                        propagate(queue_, false);
+                        const int count = result_.labelled - base;
+                        if (count >= support && count >= best_count) {
+                            const double residual = rigid_residual(component);
+                            if (residual <= params_.max_fit_residual &&
+                                (count > best_count || residual < best_residual)) {
+                                best_count = count;
+                                best_residual = residual;
+                                best_labels_ = result_.point_of_marker;
+                            }
+                        }
+                        result_.point_of_marker = snapshot_markers_;
+                        result_.marker_of_point = snapshot_points_;
+                        result_.labelled = base;
+                    }
+                }
+            }
+        }
+        if (best_count == 0) {
+            retry_after_[component] = stats_.frames + params_.cold_start_retry_frames;
+            ++stats_.cold_start_failures;
+            continue;
+        }
+        for (int i = 0; i < m; ++i)
+            if (component_[i] == component && best_labels_[i] >= 0) assign(i, best_labels_[i]);
+    }
+}
+
+void MarkerLabeler::update_tracks(TimestampNs timestamp) {
+    const std::vector<Vec3d>& points = *points_;
+    for (int m = 0; m < skeleton_.num_markers(); ++m) {
+        Track& t = tracks_[m];
+        const int p = result_.point_of_marker[m];
+        if (p < 0) {
+            if (t.active && ++t.missed > params_.max_missed) t.active = false;
+            continue;
+        }
+        // Velocity only from consecutive labels; after a gap it restarts.
+        if (t.active && t.missed == 0 && timestamp > t.last_seen)
+            t.velocity = (points[p] - t.position) * (1e9 / static_cast<double>(timestamp - t.last_seen));
+        else
+            t.velocity = Vec3d{};
+        t.position = points[p];
+        t.last_seen = timestamp;
+        t.missed = 0;
+        t.active = true;
+    }
+}
+
+void MarkerLabeler::gather(float* xyz) const {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (int m = 0; m < skeleton_.num_markers(); ++m) {
+        const int p = result_.point_of_marker[m];
+        float* out = xyz + 3 * m;
+        if (p < 0) {
+            out[0] = out[1] = out[2] = nan;
+            continue;
+        }
+        const Vec3d& v = (*points_)[p];
+        out[0] = static_cast<float>(v.x);
+        out[1] = static_cast<float>(v.y);
+        out[2] = static_cast<float>(v.z);
+    }
+}
+
+}  // namespace mm::labeling
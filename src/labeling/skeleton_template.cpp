@@ -0,0 +1,44 @@
+#include "motionmetrics/labeling/skeleton_template.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace mm::labeling {
+
+int SkeletonTemplate::add_marker(std::string name, const Vec3d& rest_position) {
+    if (marker_index(name) >= 0) throw std::invalid_argument("SkeletonTemplate: duplicate marker " + name);
+    names_.push_back(std::move(name));
+    rest_.push_back(rest_position);
+    return num_markers() - 1;
+}
+
+void SkeletonTemplate::connect(const std::string& a, const std::string& b, double tolerance) {
+    const int ia = marker_index(a);
+    const int ib = marker_index(b);
+    if (ia < 0 || ib < 0) throw std::invalid_argument("SkeletonTemplate: unknown marker " + (ia < 0 ? a : b));
+    connect(ia, ib, tolerance);
+}
+
+void SkeletonTemplate::connect(int a, int b, double tolerance) {
+    if (a < 0 || b < 0 || a >= num_markers() || b >= num_markers() || a == b)
+        throw std::invalid_argument("SkeletonTemplate: bad segment endpoints");
+    if (!(tolerance > 0.0)) throw std::invalid_argument("SkeletonTemplate: tolerance must be positive");
+    segments_.push_back({a, b, norm(rest_[a] - rest_[b]), tolerance});
+}
+
+void SkeletonTemplate::calibrate(const std::vector<Vec3d>& positions) {
+    if (static_cast<int>(positions.size()) != num_markers())
+        throw std::invalid_argument("SkeletonTemplate: calibration needs one position per marker");
+    for (SegmentConstraint& s : segments_) {
+        const double length = norm(positions[s.a] - positions[s.b]);
+        if (length == length) s.length = length;
+    }
+}
+
+int SkeletonTemplate::marker_index(const std::string& name) const {
+    for (int i = 0; i < num_markers(); ++i)
+        if (names_[i] == name) return i;
+    return -1;
+}
+
+}  // namespace mm::labeling
@@ -0,0 +1,337 @@
+#include "motionmetrics/reconstruction/correspondence.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::reconstruction {
+namespace {
+
+/// Upper bound on grid cells per axis; sparse frames get coarser cells.
+constexpr int kMaxGridDim = 256;
+
+double det3(const double m[3][3]) {
+    return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+           m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+double det4(const double m[4][4]) {
+    double det = 0.0;
+    for (int col = 0; col < 4; ++col) {
+        double minor[3][3];
+        for (int r = 1; r < 4; ++r)
+            for (int c = 0, k = 0; c < 4; ++c)
+                if (c != col) minor[r - 1][k++] = m[r][c];
+        det += (col % 2 == 0 ? 1.0 : -1.0) * m[0][col] * det3(minor);
+    }
+    return det;
+}
+
+}  // namespace
+
+Mat3d fundamental_from_projections(const Mat34d& a, const Mat34d& b) {
+    // Hartley & Zisserman eq. 17.3: F(j, i) = (-1)^(i+j) det[a without row i;
+    // b without row j].
+    Mat3d f;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            double m[4][4];
+            for (int r = 0, k = 0; r < 3; ++r) {
+                if (r == i) continue;
+                for (int c = 0; c < 4; ++c) m[k][c] = a(r, c);
+                ++k;
+            }
+            for (int r = 0, k = 2; r < 3; ++r) {
+                if (r == j) continue;
+                for (int c = 0; c < 4; ++c) m[k][c] = b(r, c);
+                ++k;
+            }
+            f(j, i) = ((i + j) % 2 == 0 ? 1.0 : -1.0) * det4(m);
+        }
+    }
+    return f;
+}
+
+// ---------------------------------------------------------------------------
+// PointGrid
+
+void CorrespondenceSolver::PointGrid::build(const std::vector<Vec2d>& pts, double cell_size) {
+    points = &pts;
+    cell_start.clear();
+    items.clear();
+    if (pts.empty()) {
+        cols = rows = 0;
+        return;
+    }
+    double x1 = pts[0].x, y1 = pts[0].y;
+    x0 = x1;
+    y0 = y1;
+    for (const Vec2d& p : pts) {
+        x0 = std::min(x0, p.x);
+        y0 = std::min(y0, p.y);
+        x1 = std::max(x1, p.x);
+        y1 = std::max(y1, p.y);
+    }
+    cell = std::max({cell_size, (x1 - x0) / (kMaxGridDim - 1), (y1 - y0) / (kMaxGridDim - 1), 1e-9});
+    cols = static_cast<int>((x1 - x0) / cell) + 1;
+    rows = static_cast<int>((y1 - y0) / cell) + 1;
+
+    // Counting sort of point indices by cell.
+    cell_start.assign(static_cast<std::size_t>(cols) * rows + 1, 0);
+    auto cell_of = [&](const Vec2d& p) {
+        const int cx = std::min(cols - 1, static_cast<int>((p.x - x0) / cell));
+        const int cy = std::min(rows - 1, static_cast<int>((p.y - y0) / cell));
+        return cy * cols + cx;
+    };
+    for (const Vec2d& p : pts) ++cell_start[cell_of(p) + 1];
+    for (std::size_t k = 1; k < cell_start.size(); ++k) cell_start[k] += cell_start[k - 1];
+    items.resize(pts.size());
+    std::vector<int> fill(cell_start.begin(), cell_start.end() - 1);
+    for (int i = 0; i < static_cast<int>(pts.size()); ++i) items[fill[cell_of(pts[i])]++] = i;
+}
+
+template <typename Fn>
+void CorrespondenceSolver::PointGrid::for_each_near_line(double a, double b, double c, double tol, Fn&& fn) const {
+    if (cols == 0) return;
+    const std::vector<Vec2d>& pts = *points;
+    auto visit_cell = [&](int cx, int cy) {
+        const int cell_index = cy * cols + cx;
+        for (int k = cell_start[cell_index]; k < cell_start[cell_index + 1]; ++k) {
+            const Vec2d& p = pts[items[k]];
+            if (std::fabs(a * p.x + b * p.y + c) <= tol) fn(items[k]);
+        }
+    };
+
+    // Walk along the dominant axis of the line; in each column (or row) of
+    // cells the band covers a contiguous range of cells on the other axis.
+    const bool walk_x = std::fabs(b) >= std::fabs(a);
+    const double along0 = walk_x ? x0 : y0;
+    const double across0 = walk_x ? y0 : x0;
+    const int along_n = walk_x ? cols : rows;
+    const int across_n = walk_x ? rows : cols;
+    const double pa = walk_x ? a : b;  // coefficient of the along coordinate
+    const double pb = walk_x ? b : a;  // coefficient of the across coordinate
+    const double half_band = tol / std::fabs(pb);
+
+    for (int i = 0; i < along_n; ++i) {
+        const double s0 = along0 + i * cell;
+        const double s1 = s0 + cell;
+        const double t0 = -(pa * s0 + c) / pb;
+        const double t1 = -(pa * s1 + c) / pb;
+        const double lo = std::min(t0, t1) - half_band - across0;
+        const double hi = std::max(t0, t1) + half_band - across0;
+        if (hi < 0.0 || lo > across_n * cell) continue;
+        const int j0 = std::max(0, static_cast<int>(std::floor(lo / cell)));
+        const int j1 = std::min(across_n - 1, static_cast<int>(std::floor(hi / cell)));
+        for (int j = j0; j <= j1; ++j) {
+            if (walk_x) visit_cell(i, j);
+            else visit_cell(j, i);
+        }
+    }
+}
+
+int CorrespondenceSolver::PointGrid::nearest(const Vec2d& p, double radius) const {
+    if (cols == 0) return -1;
+    const int cx0 = std::max(0, static_cast<int>(std::floor((p.x - radius - x0) / cell)));
+    const int cy0 = std::max(0, static_cast<int>(std::floor((p.y - radius - y0) / cell)));
+    const int cx1 = std::min(cols - 1, static_cast<int>(std::floor((p.x + radius - x0) / cell)));
+    const int cy1 = std::min(rows - 1, static_cast<int>(std::floor((p.y + radius - y0) / cell)));
+    int best = -1;
+    double best_d2 = radius * radius;
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            const int cell_index = cy * cols + cx;
+            for (int k = cell_start[cell_index]; k < cell_start[cell_index + 1]; ++k) {
+                const Vec2d& q = (*points)[items[k]];
+                const double d2 = (q.x - p.x) * (q.x - p.x) + (q.y - p.y) * (q.y - p.y);
+                if (d2 <= best_d2) {
+                    best_d2 = d2;
+                    best = items[k];
+                }
+            }
+        }
+    }
+    return best;
+}
+
+// ---------------------------------------------------------------------------
+// CorrespondenceSolver
+
+CorrespondenceSolver::CorrespondenceSolver(std::vector<Mat34d> projections, CorrespondenceParams params,
+                                           WorkStealingPool* pool)
+    : projections_(std::move(projections)),
+      params_(params),
+      pool_(pool),
+      triangulator_(projections_),
+      batch_(static_cast<int>(projections_.size()), 64) {
+    const int n = num_cameras();
+    if (n < 2) throw std::invalid_argument("CorrespondenceSolver: need at least two cameras");
+    if (params_.min_views < 2) throw std::invalid_argument("CorrespondenceSolver: min_views must be at least 2");
+
+    fundamentals_.resize(static_cast<std::size_t>(n) * n);
+    for (int a = 0; a < n; ++a)
+        for (int b = a + 1; b < n; ++b) fundamentals_[a * n + b] = fundamental_from_projections(projections_[a], projections_[b]);
+
+    grids_.resize(n);
+    scratch_.resize(pool_ != nullptr ? pool_->size() + 1 : 1);
+    for (Scratch& s : scratch_) {
+        s.members.resize(n);
+        s.projections.reserve(n);
+        s.observations.reserve(n);
+    }
+    used_.resize(n);
+}
+
+bool CorrespondenceSolver::refine(const std::vector<std::vector<Vec2d>>& points, Scratch& scratch, Vec3d& x,
+                                  double& residual, int& views) const {
+    const int n = num_cameras();
+    const double tol2 = params_.reprojection_tolerance_px * params_.reprojection_tolerance_px;
+    for (int pass = 0; pass < 2; ++pass) {
+        scratch.projections.clear();
+        scratch.observations.clear();
+        for (int c = 0; c < n; ++c) {
+            if (scratch.members[c] < 0) continue;
+            scratch.projections.push_back(&projections_[c]);
+            scratch.observations.push_back(points[c][scratch.members[c]]);
+        }
+        views = static_cast<int>(scratch.projections.size());
+        if (views < 2 || !triangulate_point(scratch.projections.data(), scratch.observations.data(), views, x))
+            return false;
+
+        // Drop views the joint solve cannot explain, then solve once more.
+        double sum = 0.0;
+        bool dropped = false;
+        for (int c = 0; c < n; ++c) {
+            if (scratch.members[c] < 0) continue;
+            double u, v;
+            const Vec2d& p = points[c][scratch.members[c]];
+            const double e2 = project(projections_[c], x, u, v) ? (u - p.x) * (u - p.x) + (v - p.y) * (v - p.y) : 1e300;
+            if (e2 > tol2) {
+                scratch.members[c] = -1;
+                dropped = true;
+                continue;
+            }
+            sum += e2;
+        }
+        if (!dropped) {
+            residual = std::sqrt(sum / views);
+            return true;
+        }
+    }
+    return false;
+}
+
+void CorrespondenceSolver::process_anchor(int anchor, const std::vector<std::vector<Vec2d>>& points) {
+    const int n = num_cameras();
+    const int a = static_cast<int>(std::upper_bound(anchor_camera_start_.begin(), anchor_camera_start_.end(), anchor) -
+                                   anchor_camera_start_.begin()) - 1;
+    const int i = anchor - anchor_camera_start_[a];
+    const Vec2d& xa = points[a][i];
+
+    AnchorOutput& out = anchors_[anchor];
+    out.candidates.clear();
+    out.members.clear();
+    out.pairs = 0;
+    Scratch& scratch = scratch_[pool_ != nullptr ? pool_->current_slot() : 0];
+
+    for (int b = a + 1; b < n; ++b) {
+        const Mat3d& f = fundamentals_[a * n + b];
+        const Vec3d line = f * Vec3d{xa.x, xa.y, 1.0};
+        const double scale = std::hypot(line.x, line.y);
+        if (scale == 0.0) continue;
+
+        grids_[b].for_each_near_line(line.x / scale, line.y / scale, line.z / scale, params_.epipolar_tolerance_px,
+                                     [&](int j) {
+            // A pair already explained by one of this anchor's candidates
+            // would only rediscover the same marker.
+            for (const Candidate& cand : out.candidates)
+                if (out.members[cand.offset + b] == j) return;
+            ++out.pairs;
+
+            const Mat34d* pair[2] = {&projections_[a], &projections_[b]};
+            const Vec2d obs[2] = {xa, points[b][j]};
+            Vec3d x;
+            double u, v;
+            if (!triangulate_point(pair, obs, 2, x)) return;
+            if (!project(projections_[a], x, u, v) || !project(projections_[b], x, u, v)) return;
+
+            int views = 2;
+            for (int c = 0; c < n; ++c) {
+                scratch.members[c] = -1;
+                if (c == a || c == b || !project(projections_[c], x, u, v)) continue;
+                scratch.members[c] = grids_[c].nearest(Vec2d{u, v}, params_.reprojection_tolerance_px);
+                views += scratch.members[c] >= 0;
+            }
+            if (views < params_.min_views) return;
+            scratch.members[a] = i;
+            scratch.members[b] = j;
+
+            double residual = 0.0;
+            if (!refine(points, scratch, x, residual, views) || views < params_.min_views) return;
+            if (scratch.members[a] != i) return;
+            out.candidates.push_back(Candidate{residual, views, anchor, static_cast<int>(out.members.size())});
+            out.members.insert(out.members.end(), scratch.members.begin(), scratch.members.end());
+        });
+    }
+}
+
+void CorrespondenceSolver::solve(const std::vector<std::vector<Vec2d>>& points, CorrespondenceResult& out) {
+    MM_TRACE_SCOPE("correspondence");
+    const int n = num_cameras();
+    if (static_cast<int>(points.size()) != n)
+        throw std::invalid_argument("CorrespondenceSolver: expected one point list per camera");
+
+    const double cell = std::max(2.0 * params_.epipolar_tolerance_px, 2.0 * params_.reprojection_tolerance_px);
+    for (int c = 0; c < n; ++c) grids_[c].build(points[c], cell);
+
+    // Every point of every camera but the last is an anchor.
+    anchor_camera_start_.assign(n, 0);
+    for (int c = 1; c < n; ++c) anchor_camera_start_[c] = anchor_camera_start_[c - 1] + static_cast<int>(points[c - 1].size());
+    const int num_anchors = anchor_camera_start_[n - 1];
+    if (static_cast<int>(anchors_.size()) < num_anchors) anchors_.resize(num_anchors);
+
+    auto task = [&](int anchor) { process_anchor(anchor, points); };
+    if (pool_ != nullptr) pool_->parallel_for(0, num_anchors, params_.grain, task);
+    else
+        for (int k = 0; k < num_anchors; ++k) task(k);
+
+    // Greedy acceptance: most views first, then lowest residual; each 2D
+    // point may belong to one marker only.
+    ranked_.clear();
+    for (int k = 0; k < num_anchors; ++k) {
+        stats_.pair_hypotheses += anchors_[k].pairs;
+        ranked_.insert(ranked_.end(), anchors_[k].candidates.begin(), anchors_[k].candidates.end());
+    }
+    stats_.candidates += ranked_.size();
+    std::sort(ranked_.begin(), ranked_.end(), [](const Candidate& x, const Candidate& y) {
+        if (x.views != y.views) return x.views > y.views;
+        return x.residual < y.residual;
+    });
+    for (int c = 0; c < n; ++c) used_[c].assign(points[c].size(), 0);
+
+    out.num_cameras = n;
+    out.assignment.clear();
+    for (const Candidate& cand : ranked_) {
+        const int* members = anchors_[cand.anchor].members.data() + cand.offset;
+        bool free = true;
+        for (int c = 0; c < n && free; ++c) free = members[c] < 0 || !used_[c][members[c]];
+        if (!free) continue;
+        for (int c = 0; c < n; ++c)
+            if (members[c] >= 0) used_[c][members[c]] = 1;
+        out.assignment.insert(out.assignment.end(), members, members + n);
+    }
+
+    const int markers = out.size();
+    batch_.reset(markers);
+    for (int m = 0; m < markers; ++m) {
+        for (int c = 0; c < n; ++c) {
+            const int k = out.point_index(m, c);
+            if (k >= 0) batch_.set(c, m, points[c][k].x, points[c][k].y);
+        }
+    }
+    triangulator_.triangulate(batch_, out.points);
+}
+
+}  // namespace mm::reconstruction
@@ -0,0 +1,262 @@
+#include "motionmetrics/reconstruction/triangulation.hpp"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::reconstruction {
+
+ObservationBatch::ObservationBatch(int num_cameras, int capacity)
+    : num_cameras_(num_cameras), capacity_(capacity) {
+    if (num_cameras <= 0 || capacity < 0) throw std::invalid_argument("ObservationBatch: invalid dimensions");
+    const std::size_t n = static_cast<std::size_t>(num_cameras) * capacity;
+    u_.assign(n, 0.0);
+    v_.assign(n, 0.0);
+    w_.assign(n, 0.0);
+}
+
+void ObservationBatch::reset(int num_markers) {
+    if (num_markers < 0) throw std::invalid_argument("ObservationBatch: negative marker count");
+    if (num_markers > capacity_) {
+        capacity_ = num_markers;
+        const std::size_t n = static_cast<std::size_t>(num_cameras_) * capacity_;
+        u_.resize(n);
+        v_.resize(n);
+        w_.resize(n);
+    }
+    size_ = num_markers;
+    for (int c = 0; c < num_cameras_; ++c) {
+        double* w = w_.data() + index(c, 0);
+        for (int m = 0; m < num_markers; ++m) w[m] = 0.0;
+    }
+}
+
+namespace {
+
+enum Lane { A00, A01, A02, A11, A12, A22, B0, B1, B2, ERR, VIEWS, kNumLanes };
+
+struct LanePtrs {
+    double* p[kNumLanes];
+};
+
+/// Adds one camera's two DLT rows, r1 = u*P2 - P0 and r2 = v*P2 - P1, to the
+/// normal equations of every marker. With `kReweight` each view is scaled
+/// by 1/depth^2 at the previous estimate (x, y, z). Lanes are passed as
+/// separate restrict pointers so the compiler can prove they do not alias.
+template <bool kReweight>
+MM_ALWAYS_INLINE void accumulate_camera(const Mat34d& P, const double* MM_RESTRICT u, const double* MM_RESTRICT v,
+                                        const double* MM_RESTRICT w, const double* MM_RESTRICT x,
+                                        const double* MM_RESTRICT y, const double* MM_RESTRICT z,
+                                        double* MM_RESTRICT a00, double* MM_RESTRICT a01, double* MM_RESTRICT a02,
+                                        double* MM_RESTRICT a11, double* MM_RESTRICT a12, double* MM_RESTRICT a22,
+                                        double* MM_RESTRICT b0, double* MM_RESTRICT b1, double* MM_RESTRICT b2,
+                                        int n) {
+    const double p00 = P.m[0], p01 = P.m[1], p02 = P.m[2], p03 = P.m[3];
+    const double p10 = P.m[4], p11 = P.m[5], p12 = P.m[6], p13 = P.m[7];
+    const double p20 = P.m[8], p21 = P.m[9], p22 = P.m[10], p23 = P.m[11];
+    for (int i = 0; i < n; ++i) {
+        double wi = w[i];
+        if constexpr (kReweight) {
+            const double depth = p20 * x[i] + p21 * y[i] + p22 * z[i] + p23;
+            const double scaled = wi / (depth * depth);
+            // Keep the algebraic weight when the previous estimate is unusable.
+            wi = (wi > 0.0 && scaled == scaled && depth != 0.0) ? scaled : wi;
+        }
+        const double r0 = u[i] * p20 - p00, r1 = u[i] * p21 - p01, r2 = u[i] * p22 - p02, r3 = u[i] * p23 - p03;
+        const double s0 = v[i] * p20 - p10, s1 = v[i] * p21 - p11, s2 = v[i] * p22 - p12, s3 = v[i] * p23 - p13;
+        a00[i] += wi * (r0 * r0 + s0 * s0);
+        a01[i] += wi * (r0 * r1 + s0 * s1);
+        a02[i] += wi * (r0 * r2 + s0 * s2);
+        a11[i] += wi * (r1 * r1 + s1 * s1);
+        a12[i] += wi * (r1 * r2 + s1 * s2);
+        a22[i] += wi * (r2 * r2 + s2 * s2);
+        b0[i] -= wi * (r0 * r3 + s0 * s3);
+        b1[i] -= wi * (r1 * r3 + s1 * s3);
+        b2[i] -= wi * (r2 * r3 + s2 * s3);
+    }
+}
+
+/// Closed-form symmetric 3x3 solve for every marker.
+MM_ALWAYS_INLINE void solve_lanes(const double* MM_RESTRICT a00_, const double* MM_RESTRICT a01_,
+                                  const double* MM_RESTRICT a02_, const double* MM_RESTRICT a11_,
+                                  const double* MM_RESTRICT a12_, const double* MM_RESTRICT a22_,
+                                  const double* MM_RESTRICT b0_, const double* MM_RESTRICT b1_,
+                                  const double* MM_RESTRICT b2_, const double* MM_RESTRICT views, double min_views,
+                                  double* MM_RESTRICT x, double* MM_RESTRICT y, double* MM_RESTRICT z, int n) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (int i = 0; i < n; ++i) {
+        const double a00 = a00_[i], a01 = a01_[i], a02 = a02_[i];
+        const double a11 = a11_[i], a12 = a12_[i], a22 = a22_[i];
+        const double c00 = a11 * a22 - a12 * a12;
+        const double c01 = a02 * a12 - a01 * a22;
+        const double c02 = a01 * a12 - a02 * a11;
+        const double c11 = a00 * a22 - a02 * a02;
+        const double c12 = a01 * a02 - a00 * a12;
+        const double c22 = a00 * a11 - a01 * a01;
+        const double det = a00 * c00 + a01 * c01 + a02 * c02;
+        const double scale = a00 * a11 * a22;
+        const bool ok = views[i] >= min_views && det * det > 1e-24 * scale * scale;
+        const double inv = 1.0 / det;
+        const double b0 = b0_[i], b1 = b1_[i], b2 = b2_[i];
+        x[i] = ok ? (c00 * b0 + c01 * b1 + c02 * b2) * inv : nan;
+        y[i] = ok ? (c01 * b0 + c11 * b1 + c12 * b2) * inv : nan;
+        z[i] = ok ? (c02 * b0 + c12 * b1 + c22 * b2) * inv : nan;
+    }
+}
+
+/// Adds one camera's squared reprojection error and view count.
+MM_ALWAYS_INLINE void accumulate_residual(const Mat34d& P, const double* MM_RESTRICT u, const double* MM_RESTRICT v,
+                                          const double* MM_RESTRICT w, const double* MM_RESTRICT x,
+                                          const double* MM_RESTRICT y, const double* MM_RESTRICT z,
+                                          double* MM_RESTRICT err, double* MM_RESTRICT views, int n) {
+    for (int i = 0; i < n; ++i) {
+        const double pw = P.m[8] * x[i] + P.m[9] * y[i] + P.m[10] * z[i] + P.m[11];
+        const double pu = (P.m[0] * x[i] + P.m[1] * y[i] + P.m[2] * z[i] + P.m[3]) / pw;
+        const double pv = (P.m[4] * x[i] + P.m[5] * y[i] + P.m[6] * z[i] + P.m[7]) / pw;
+        const double du = pu - u[i];
+        const double dv = pv - v[i];
+        const bool seen = w[i] > 0.0;
+        err[i] += seen ? du * du + dv * dv : 0.0;
+        views[i] += seen ? 1.0 : 0.0;
+    }
+}
+
+struct Job {
+    const std::vector<Mat34d>* projections;
+    const ObservationBatch* obs;
+    const TriangulationParams* params;
+    LanePtrs lanes;
+    TriangulatedPoints* out;
+};
+
+MM_ALWAYS_INLINE void run_kernels(const Job& job) {
+    const int n = job.obs->size();
+    const int cameras = job.obs->num_cameras();
+    TriangulatedPoints& out = *job.out;
+    double* x = out.x.data();
+    double* y = out.y.data();
+    double* z = out.z.data();
+    double* err = job.lanes.p[ERR];
+    double* views = job.lanes.p[VIEWS];
+
+    for (int i = 0; i < n; ++i) views[i] = 0.0;
+    for (int c = 0; c < cameras; ++c) {
+        const double* w = job.obs->w(c);
+        for (int i = 0; i < n; ++i) views[i] += w[i] > 0.0 ? 1.0 : 0.0;
+    }
+    const double min_views = job.params->min_views;
+
+    for (int pass = 0; pass <= job.params->reweight_iterations; ++pass) {
+        for (int lane = A00; lane <= B2; ++lane) {
+            double* p = job.lanes.p[lane];
+            for (int i = 0; i < n; ++i) p[i] = 0.0;
+        }
+        for (int c = 0; c < cameras; ++c) {
+            const Mat34d& P = (*job.projections)[c];
+            double* const* l = job.lanes.p;
+            if (pass == 0)
+                accumulate_camera<false>(P, job.obs->u(c), job.obs->v(c), job.obs->w(c), x, y, z, l[A00], l[A01],
+                                         l[A02], l[A11], l[A12], l[A22], l[B0], l[B1], l[B2], n);
+            else
+                accumulate_camera<true>(P, job.obs->u(c), job.obs->v(c), job.obs->w(c), x, y, z, l[A00], l[A01],
+                                        l[A02], l[A11], l[A12], l[A22], l[B0], l[B1], l[B2], n);
+        }
+        const double* const* l = job.lanes.p;
+        solve_lanes(l[A00], l[A01], l[A02], l[A11], l[A12], l[A22], l[B0], l[B1], l[B2], views, min_views, x, y, z,
+                    n);
+    }
+
+    for (int i = 0; i < n; ++i) {
+        err[i] = 0.0;
+        views[i] = 0.0;
+    }
+    for (int c = 0; c < cameras; ++c)
+        accumulate_residual((*job.projections)[c], job.obs->u(c), job.obs->v(c), job.obs->w(c), x, y, z, err, views,
+                            n);
+    for (int i = 0; i < n; ++i) {
+        out.residual[i] = views[i] > 0.0 ? std::sqrt(err[i] / views[i]) : 0.0;
+        out.num_views[i] = static_cast<int>(views[i]);
+    }
+}
+
+void run_scalar(const Job& job) { run_kernels(job); }
+#if MM_HAVE_X86_DISPATCH
+MM_TARGET_AVX2 void run_avx2(const Job& job) { run_kernels(job); }
+MM_TARGET_AVX512 void run_avx512(const Job& job) { run_kernels(job); }
+#endif
+
+}  // namespace
+
+bool triangulate_point(const Mat34d* const* projections, const Vec2d* points, int n, Vec3d& out) {
+    double a[6] = {};
+    double b[3] = {};
+    for (int k = 0; k < n; ++k) {
+        const Mat34d& P = *projections[k];
+        for (int row = 0; row < 2; ++row) {
+            const double coord = row == 0 ? points[k].x : points[k].y;
+            const double r0 = coord * P.m[8] - P.m[row * 4 + 0];
+            const double r1 = coord * P.m[9] - P.m[row * 4 + 1];
+            const double r2 = coord * P.m[10] - P.m[row * 4 + 2];
+            const double r3 = coord * P.m[11] - P.m[row * 4 + 3];
+            a[0] += r0 * r0;
+            a[1] += r0 * r1;
+            a[2] += r0 * r2;
+            a[3] += r1 * r1;
+            a[4] += r1 * r2;
+            a[5] += r2 * r2;
+            b[0] -= r0 * r3;
+            b[1] -= r1 * r3;
+            b[2] -= r2 * r3;
+        }
+    }
+    const double c00 = a[3] * a[5] - a[4] * a[4];
+    const double c01 = a[2] * a[4] - a[1] * a[5];
+    const double c02 = a[1] * a[4] - a[2] * a[3];
+    const double c11 = a[0] * a[5] - a[2] * a[2];
+    const double c12 = a[1] * a[2] - a[0] * a[4];
+    const double c22 = a[0] * a[3] - a[1] * a[1];
+    const double det = a[0] * c00 + a[1] * c01 + a[2] * c02;
+    if (n < 2 || !(std::fabs(det) > 1e-12 * std::fabs(a[0] * a[3] * a[5]))) return false;
+    const double inv = 1.0 / det;
+    out = Vec3d{(c00 * b[0] + c01 * b[1] + c02 * b[2]) * inv, (c01 * b[0] + c11 * b[1] + c12 * b[2]) * inv,
+                (c02 * b[0] + c12 * b[1] + c22 * b[2]) * inv};
+    return true;
+}
+
+BatchTriangulator::BatchTriangulator(std::vector<Mat34d> projections, TriangulationParams params, SimdLevel level)
+    : projections_(std::move(projections)), params_(params), level_(clamp_simd_level(level)) {
+    if (projections_.empty()) throw std::invalid_argument("BatchTriangulator: no cameras");
+    if (params_.min_views < 2) throw std::invalid_argument("BatchTriangulator: min_views must be at least 2");
+    if (params_.reweight_iterations < 0) throw std::invalid_argument("BatchTriangulator: negative reweight count");
+}
+
+void BatchTriangulator::triangulate(const ObservationBatch& observations, TriangulatedPoints& out) {
+    MM_TRACE_SCOPE("triangulation");
+    if (observations.num_cameras() != num_cameras())
+        throw std::invalid_argument("BatchTriangulator: observation batch has a different camera count");
+
+    const auto n = static_cast<std::size_t>(observations.size());
+    out.x.resize(n);
+    out.y.resize(n);
+    out.z.resize(n);
+    out.residual.resize(n);
+    out.num_views.resize(n);
+
+    const std::size_t stride = static_cast<std::size_t>(observations.capacity());
+    if (lanes_.size() < stride * kNumLanes) lanes_.resize(stride * kNumLanes);
+
+    Job job{&projections_, &observations, &params_, {}, &out};
+    for (int lane = 0; lane < kNumLanes; ++lane) job.lanes.p[lane] = lanes_.data() + lane * stride;
+
+    switch (level_) {
+#if MM_HAVE_X86_DISPATCH
+        case SimdLevel::avx512: run_avx512(job); break;
+        case SimdLevel::avx2: run_avx2(job); break;
+#endif
+        default: run_scalar(job); break;
+    }
+}
+
+}  // namespace mm::reconstruction
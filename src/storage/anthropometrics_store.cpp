@@ -0,0 +1,186 @@
+#include "motionmetrics/storage/anthropometrics_store.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "motionmetrics/core/atomic_file.hpp"
+#include "motionmetrics/core/types.hpp"
+
+namespace mm::storage {
+namespace {
+
+constexpr std::uint64_t kMagic = 0x4d4d'414e'5448'3031ull;  // "MMANTH01"
+constexpr std::uint32_t kVersion = 1;
+
+struct FileHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t num_athletes;
+    std::uint32_t num_segments;
+    std::uint32_t names_bytes;
+    std::uint64_t athletes_offset;
+    std::uint64_t segments_offset;
+    std::uint64_t names_offset;
+};
+static_assert(sizeof(FileHeader) == 48, "anthropometrics header layout");
+
+struct AthleteRecord {
+    std::uint64_t athlete_id;
+    double body_mass_kg;
+    std::uint32_t first_segment;
+    std::uint32_t num_segments;
+};
+static_assert(sizeof(AthleteRecord) == 24, "anthropometrics athlete layout");
+
+struct SegmentRecord {
+    double mass_fraction;
+    double com_fraction;
+    double proximal[3];
+    double distal[3];
+    std::uint32_t name_offset;
+    std::uint32_t name_bytes;
+};
+static_assert(sizeof(SegmentRecord) == 72, "anthropometrics segment layout");
+
+[[noreturn]] void corrupt(const std::string& path, const char* what) {
+    throw std::runtime_error("AnthropometricsStore: " + path + ": " + what);
+}
+
+}  // namespace
+
+AnthropometricsStoreWriter::AnthropometricsStoreWriter(const AnthropometricsStore& existing) {
+    for (std::size_t row = 0; row < existing.size(); ++row) add(existing.athlete(row));
+}
+
+void AnthropometricsStoreWriter::add(AthleteAnthropometrics athlete) {
+    const std::uint64_t id = athlete.athlete_id;
+    athletes_.insert_or_assign(id, std::move(athlete));
+}
+
+void AnthropometricsStoreWriter::write(const std::string& path) const {
+    std::vector<AthleteRecord> athletes;
+    std::vector<SegmentRecord> segments;
+    std::vector<char> names;
+    athletes.reserve(athletes_.size());
+    for (const auto& [id, a] : athletes_) {
+        if (segments.size() + a.segments.size() > std::numeric_limits<std::uint32_t>::max())
+            throw std::invalid_argument("AnthropometricsStoreWriter: too many segments");
+        athletes.push_back({id, a.body_mass_kg, static_cast<std::uint32_t>(segments.size()),
+                            static_cast<std::uint32_t>(a.segments.size())});
+        for (const SegmentParameters& s : a.segments) {
+            if (names.size() + s.segment.size() > std::numeric_limits<std::uint32_t>::max())
+                throw std::invalid_argument("AnthropometricsStoreWriter: segment names too large");
+            segments.push_back({s.mass_fraction,
+                                s.com_fraction,
+                                {s.proximal.x, s.proximal.y, s.proximal.z},
+                                {s.distal.x, s.distal.y, s.distal.z},
+                                static_cast<std::uint32_t>(names.size()),
+                                static_cast<std::uint32_t>(s.segment.size())});
+            names.insert(names.end(), s.segment.begin(), s.segment.end());
+        }
+    }
+
+    FileHeader header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.num_athletes = static_cast<std::uint32_t>(athletes.size());
+    header.num_segments = static_cast<std::uint32_t>(segments.size());
+    header.names_bytes = static_cast<std::uint32_t>(names.size());
+    header.athletes_offset = align_up(sizeof(FileHeader), kCacheLineSize);
+    header.segments_offset = align_up(header.athletes_offset + athletes.size() * sizeof(AthleteRecord), kCacheLineSize);
+    header.names_offset = align_up(header.segments_offset + segments.size() * sizeof(SegmentRecord), kCacheLineSize);
+
+    std::vector<char> image(header.names_offset + names.size());
+    std::memcpy(image.data(), &header, sizeof(header));
+    if (!athletes.empty())
+        std::memcpy(image.data() + header.athletes_offset, athletes.data(), athletes.size() * sizeof(AthleteRecord));
+    if (!segments.empty())
+        std::memcpy(image.data() + header.segments_offset, segments.data(), segments.size() * sizeof(SegmentRecord));
+    if (!names.empty()) std::memcpy(image.data() + header.names_offset, names.data(), names.size());
+    write_file_atomic(path, image.data(), image.size());
+}
+
+AnthropometricsStore::AnthropometricsStore(const std::string& path) : file_(path) {
+    const std::byte* base = file_.data();
+    const std::size_t size = file_.size();
+    if (size < sizeof(FileHeader)) corrupt(path, "truncated header");
+
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != kMagic) corrupt(path, "not an anthropometrics store");
+    if (header.version != kVersion) corrupt(path, "unsupported version");
+    if (header.athletes_offset > size || header.num_athletes > (size - header.athletes_offset) / sizeof(AthleteRecord))
+        corrupt(path, "athletes out of bounds");
+    if (header.segments_offset > size || header.num_segments > (size - header.segments_offset) / sizeof(SegmentRecord))
+        corrupt(path, "segments out of bounds");
+    if (header.names_offset > size || header.names_bytes > size - header.names_offset)
+        corrupt(path, "segment names out of bounds");
+
+    athletes_ = header.num_athletes;
+    segments_ = header.num_segments;
+    athlete_records_ = base + header.athletes_offset;
+    segment_records_ = base + header.segments_offset;
+    names_ = reinterpret_cast<const char*>(base + header.names_offset);
+
+    std::uint64_t previous = 0;
+    for (std::size_t row = 0; row < athletes_; ++row) {
+        AthleteRecord a;
+        std::memcpy(&a, athlete_records_ + row * sizeof(AthleteRecord), sizeof(a));
+        if (row > 0 && a.athlete_id <= previous) corrupt(path, "athletes out of order");
+        if (a.first_segment > segments_ || a.num_segments > segments_ - a.first_segment)
+            corrupt(path, "athlete segments out of range");
+        previous = a.athlete_id;
+    }
+    for (std::size_t i = 0; i < segments_; ++i) {
+        SegmentRecord s;
+        std::memcpy(&s, segment_records_ + i * sizeof(SegmentRecord), sizeof(s));
+        if (s.name_offset > header.names_bytes || s.name_bytes > header.names_bytes - s.name_offset)
+            corrupt(path, "segment name out of bounds");
+    }
+}
+
+std::uint64_t AnthropometricsStore::athlete_id(std::size_t row) const {
+    std::uint64_t id;
+    std::memcpy(&id, athlete_records_ + row * sizeof(AthleteRecord) + offsetof(AthleteRecord, athlete_id), sizeof(id));
+    return id;
+}
+
+AthleteAnthropometrics AnthropometricsStore::athlete(std::size_t row) const {
+    AthleteRecord a;
+    std::memcpy(&a, athlete_records_ + row * sizeof(AthleteRecord), sizeof(a));
+    AthleteAnthropometrics out;
+    out.athlete_id = a.athlete_id;
+    out.body_mass_kg = a.body_mass_kg;
+    out.segments.reserve(a.num_segments);
+    for (std::uint32_t i = 0; i < a.num_segments; ++i) {
+        SegmentRecord s;
+        std::memcpy(&s, segment_records_ + (a.first_segment + i) * sizeof(SegmentRecord), sizeof(s));
+        SegmentParameters p;
+        p.segment.assign(names_ + s.name_offset, s.name_bytes);
+        p.mass_fraction = s.mass_fraction;
+        p.proximal = {s.proximal[0], s.proximal[1], s.proximal[2]};
+        p.distal = {s.distal[0], s.distal[1], s.distal[2]};
+        p.com_fraction = s.com_fraction;
+        out.segments.push_back(std::move(p));
+    }
+    return out;
+}
+
+std::optional<AthleteAnthropometrics> AnthropometricsStore::find(std::uint64_t athlete_id) const {
+    std::size_t lo = 0;
+    std::size_t hi = athletes_;
+    while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (this->athlete_id(mid) < athlete_id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == athletes_ || this->athlete_id(lo) != athlete_id) return std::nullopt;
+    return athlete(lo);
+}
+
+}  // namespace mm::storage
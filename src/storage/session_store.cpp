@@ -0,0 +1,289 @@
+#include "motionmetrics/storage/session_store.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::storage {
+namespace {
+
+constexpr std::uint64_t kMagic = 0x4d4d'5345'5353'3031ull;  // "MMSESS01"
+constexpr std::uint32_t kVersion = 1;
+
+struct FileHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t num_markers;
+    std::int64_t frames;
+    std::uint64_t session_id;
+    std::uint64_t athlete_id;
+    std::uint64_t index_offset;
+    std::uint32_t num_chunks;
+    std::uint32_t names_bytes;
+    std::uint64_t names_offset;
+};
+static_assert(sizeof(FileHeader) == 64, "session header layout");
+
+struct IndexRecord {
+    std::uint64_t offset;
+    std::uint32_t frames;
+    std::uint32_t column_stride;
+    TimestampNs first_timestamp;
+    TimestampNs last_timestamp;
+};
+static_assert(sizeof(IndexRecord) == 32, "session index layout");
+
+std::size_t timestamp_bytes(int frames) {
+    return align_up(static_cast<std::size_t>(frames) * sizeof(TimestampNs), kCacheLineSize);
+}
+
+std::size_t column_stride_for(int frames) {
+    return align_up(static_cast<std::size_t>(frames) * sizeof(float), kCacheLineSize) / sizeof(float);
+}
+
+[[noreturn]] void corrupt(const std::string& path, const char* what) {
+    throw std::runtime_error("SessionReader: " + path + ": " + what);
+}
+
+}  // namespace
+
+SessionWriter::SessionWriter(std::string path, SessionInfo info) : info_(std::move(info)) {
+    if (info_.marker_names.empty()) throw std::invalid_argument("SessionWriter: no markers");
+    if (info_.chunk_frames <= 0) throw std::invalid_argument("SessionWriter: chunk_frames must be positive");
+    for (const std::string& name : info_.marker_names)
+        if (name.size() > std::numeric_limits<std::uint16_t>::max())
+            throw std::invalid_argument("SessionWriter: marker name too long");
+
+    file_ = AtomicFile(std::move(path));
+
+    column_stride_ = column_stride_for(info_.chunk_frames);
+    timestamps_ = AlignedBuffer(timestamp_bytes(info_.chunk_frames));
+    columns_ = AlignedBuffer(column_stride_ * sizeof(float) * 3 * info_.marker_names.size());
+
+    // Zero header until close(): an interrupted write is never a valid file.
+    const FileHeader blank{};
+    file_.write_at(&blank, sizeof(blank), 0);
+    end_offset_ = sizeof(FileHeader);
+}
+
+SessionWriter::SessionWriter(SessionWriter&& other) noexcept
+    : file_(std::move(other.file_)),
+      info_(std::move(other.info_)),
+      end_offset_(other.end_offset_),
+      frames_(other.frames_),
+      last_timestamp_(other.last_timestamp_),
+      buffered_(other.buffered_),
+      column_stride_(other.column_stride_),
+      timestamps_(std::move(other.timestamps_)),
+      columns_(std::move(other.columns_)),
+      index_(std::move(other.index_)) {}
+
+void SessionWriter::append(TimestampNs timestamp, const float* xyz) {
+    if (!file_.is_open()) throw std::logic_error("SessionWriter: append after close");
+    if (frames_ > 0 && timestamp < last_timestamp_)
+        throw std::invalid_argument("SessionWriter: timestamps must not decrease");
+
+    timestamps_.as<TimestampNs>()[buffered_] = timestamp;
+    float* columns = columns_.as<float>();
+    const int count = num_markers() * 3;
+    for (int k = 0; k < count; ++k) columns[k * column_stride_ + buffered_] = xyz[k];
+
+    last_timestamp_ = timestamp;
+    ++frames_;
+    if (++buffered_ == info_.chunk_frames) flush_chunk();
+}
+
+void SessionWriter::flush_chunk() {
+    if (buffered_ == 0) return;
+    MM_TRACE_SCOPE("session_write_chunk");
+    const TimestampNs* ts = timestamps_.as<TimestampNs>();
+    const std::size_t stride = column_stride_for(buffered_);
+    const int count = num_markers() * 3;
+    float* columns = columns_.as<float>();
+    if (stride != column_stride_) {
+        // Short final chunk: pack the columns to its own stride.
+        for (int k = 1; k < count; ++k)
+            std::memmove(columns + k * stride, columns + k * column_stride_, buffered_ * sizeof(float));
+    }
+    for (int k = 0; k < count; ++k)
+        std::fill(columns + k * stride + buffered_, columns + (k + 1) * stride, 0.0f);
+
+    const std::size_t ts_bytes = timestamp_bytes(buffered_);
+    std::memset(timestamps_.as<std::byte>() + buffered_ * sizeof(TimestampNs), 0,
+                ts_bytes - buffered_ * sizeof(TimestampNs));
+    const std::uint64_t offset = end_offset_;
+    file_.write_at(ts, ts_bytes, offset);
+    file_.write_at(columns, stride * count * sizeof(float), offset + ts_bytes);
+    end_offset_ = offset + ts_bytes + stride * count * sizeof(float);
+
+    index_.push_back(IndexEntry{offset, static_cast<std::uint32_t>(buffered_), static_cast<std::uint32_t>(stride),
+                                ts[0], ts[buffered_ - 1]});
+    buffered_ = 0;
+}
+
+void SessionWriter::close() {
+    if (!file_.is_open()) return;
+    flush_chunk();
+
+    std::vector<char> names;
+    for (const std::string& name : info_.marker_names) {
+        const auto len = static_cast<std::uint16_t>(name.size());
+        names.insert(names.end(), reinterpret_cast<const char*>(&len), reinterpret_cast<const char*>(&len) + 2);
+        names.insert(names.end(), name.begin(), name.end());
+    }
+    if (names.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::invalid_argument("SessionWriter: marker names too large");
+
+    FileHeader header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.num_markers = static_cast<std::uint32_t>(num_markers());
+    header.frames = frames_;
+    header.session_id = info_.session_id;
+    header.athlete_id = info_.athlete_id;
+    header.names_offset = end_offset_;
+    header.names_bytes = static_cast<std::uint32_t>(names.size());
+    header.index_offset = align_up(end_offset_ + names.size(), alignof(IndexRecord));
+    header.num_chunks = static_cast<std::uint32_t>(index_.size());
+
+    std::vector<IndexRecord> records;
+    records.reserve(index_.size());
+    for (const IndexEntry& e : index_)
+        records.push_back(IndexRecord{e.offset, e.frames, e.column_stride, e.first_timestamp, e.last_timestamp});
+
+    file_.write_at(names.data(), names.size(), header.names_offset);
+    file_.write_at(records.data(), records.size() * sizeof(IndexRecord), header.index_offset);
+    // The header goes last, after everything it points at is durable.
+    file_.sync();
+    file_.write_at(&header, sizeof(header), 0);
+    file_.commit();
+}
+
+SessionReader::SessionReader(const std::string& path) : file_(path) {
+    const std::byte* base = file_.data();
+    const std::size_t size = file_.size();
+    if (size < sizeof(FileHeader)) corrupt(path, "truncated header");
+
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != kMagic) corrupt(path, "not a session file");
+    if (header.version != kVersion) corrupt(path, "unsupported version");
+    if (header.names_offset > size || header.names_bytes > size - header.names_offset)
+        corrupt(path, "marker names out of bounds");
+    if (header.index_offset > size ||
+        header.num_chunks > (size - header.index_offset) / sizeof(IndexRecord))
+        corrupt(path, "chunk index out of bounds");
+
+    session_id_ = header.session_id;
+    athlete_id_ = header.athlete_id;
+    frames_ = header.frames;
+
+    const char* names = reinterpret_cast<const char*>(base + header.names_offset);
+    std::size_t pos = 0;
+    for (std::uint32_t m = 0; m < header.num_markers; ++m) {
+        std::uint16_t len;
+        if (header.names_bytes - pos < sizeof(len)) corrupt(path, "truncated marker names");
+        std::memcpy(&len, names + pos, sizeof(len));
+        pos += sizeof(len);
+        if (header.names_bytes - pos < len) corrupt(path, "truncated marker names");
+        marker_names_.emplace_back(names + pos, len);
+        pos += len;
+    }
+
+    const std::size_t count = static_cast<std::size_t>(header.num_markers) * 3;
+    std::int64_t first_frame = 0;
+    chunks_.reserve(header.num_chunks);
+    for (std::uint32_t i = 0; i < header.num_chunks; ++i) {
+        IndexRecord r;
+        std::memcpy(&r, base + header.index_offset + i * sizeof(IndexRecord), sizeof(r));
+        const std::size_t ts_bytes = timestamp_bytes(static_cast<int>(r.frames));
+        if (r.frames == 0 || r.column_stride < r.frames || r.offset % kCacheLineSize != 0 || r.offset > size ||
+            ts_bytes + count * r.column_stride * sizeof(float) > size - r.offset)
+            corrupt(path, "chunk out of bounds");
+
+        SessionChunk chunk;
+        chunk.first_frame = first_frame;
+        chunk.frames = static_cast<int>(r.frames);
+        chunk.timestamps = reinterpret_cast<const TimestampNs*>(base + r.offset);
+        chunk.columns = reinterpret_cast<const float*>(base + r.offset + ts_bytes);
+        chunk.column_stride = r.column_stride;
+        chunks_.push_back(chunk);
+        chunk_first_frame_.push_back(first_frame);
+        chunk_first_.push_back(r.first_timestamp);
+        chunk_last_.push_back(r.last_timestamp);
+        first_frame += r.frames;
+    }
+    if (first_frame != frames_) corrupt(path, "frame count does not match index");
+}
+
+int SessionReader::marker_index(const std::string& name) const {
+    const auto it = std::find(marker_names_.begin(), marker_names_.end(), name);
+    return it == marker_names_.end() ? -1 : static_cast<int>(it - marker_names_.begin());
+}
+
+TimestampNs SessionReader::first_timestamp() const { return chunk_first_.empty() ? 0 : chunk_first_.front(); }
+
+TimestampNs SessionReader::last_timestamp() const { return chunk_last_.empty() ? 0 : chunk_last_.back(); }
+
+std::pair<int, int> SessionReader::chunk_range(TimestampNs begin, TimestampNs end) const {
+    const auto first = std::lower_bound(chunk_last_.begin(), chunk_last_.end(), begin) - chunk_last_.begin();
+    const auto last = std::upper_bound(chunk_first_.begin(), chunk_first_.end(), end) - chunk_first_.begin();
+    return {static_cast<int>(first), static_cast<int>(std::max(first, last))};
+}
+
+std::int64_t SessionReader::frame_at(TimestampNs timestamp) const {
+    if (chunks_.empty()) return -1;
+    // Last chunk starting at or before the timestamp, then the last frame in it.
+    const auto next = std::upper_bound(chunk_first_.begin(), chunk_first_.end(), timestamp);
+    if (next == chunk_first_.begin()) return 0;
+    const SessionChunk& chunk = chunks_[next - chunk_first_.begin() - 1];
+    const TimestampNs* ts = chunk.timestamps;
+    const auto at = std::upper_bound(ts, ts + chunk.frames, timestamp) - ts;
+    return chunk.first_frame + std::max<std::ptrdiff_t>(at - 1, 0);
+}
+
+int SessionReader::chunk_of(std::int64_t frame) const {
+    if (frame < 0 || frame >= frames_) return -1;
+    const auto next = std::upper_bound(chunk_first_frame_.begin(), chunk_first_frame_.end(), frame);
+    return static_cast<int>(next - chunk_first_frame_.begin()) - 1;
+}
+
+void SessionReader::read_frame(std::int64_t frame, float* xyz) const {
+    const int c = chunk_of(frame);
+    if (c < 0) throw std::out_of_range("SessionReader: frame out of range");
+    const SessionChunk& chunk = chunks_[c];
+    const std::int64_t offset = frame - chunk.first_frame;
+    const int count = num_markers() * 3;
+    for (int k = 0; k < count; ++k) xyz[k] = chunk.columns[k * chunk.column_stride + offset];
+}
+
+void SessionReader::read_column(int marker, int axis, float* out) const {
+    if (marker < 0 || marker >= num_markers() || axis < 0 || axis > 2)
+        throw std::out_of_range("SessionReader: column out of range");
+    for (const SessionChunk& chunk : chunks_) {
+        std::memcpy(out, chunk.column(marker, axis), chunk.frames * sizeof(float));
+        out += chunk.frames;
+    }
+}
+
+void SessionReader::prefetch(int marker) const {
+    if (marker < 0 || marker >= num_markers()) throw std::out_of_range("SessionReader: marker out of range");
+    for (const SessionChunk& chunk : chunks_) {
+        const auto* begin = reinterpret_cast<const std::byte*>(chunk.column(marker, 0));
+        file_.advise(static_cast<std::size_t>(begin - file_.data()), 3 * chunk.column_stride * sizeof(float),
+                     MappedFile::Access::will_need);
+    }
+}
+
+void SessionReader::advise_chunk(int chunk, MappedFile::Access access) const {
+    if (chunk < 0 || chunk >= num_chunks()) throw std::out_of_range("SessionReader: chunk out of range");
+    const SessionChunk& c = chunks_[chunk];
+    const auto* begin = reinterpret_cast<const std::byte*>(c.timestamps);
+    const auto* end = reinterpret_cast<const std::byte*>(c.columns + num_markers() * 3 * c.column_stride);
+    file_.advise(static_cast<std::size_t>(begin - file_.data()), static_cast<std::size_t>(end - begin), access);
+}
+
+}  // namespace mm::storage
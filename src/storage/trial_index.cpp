@@ -0,0 +1,362 @@
+#include "motionmetrics/storage/trial_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+#include "motionmetrics/core/atomic_file.hpp"
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::storage {
+namespace {
+
+constexpr std::uint64_t kMagic = 0x4d4d'5449'4458'3031ull;  // "MMTIDX01"
+constexpr std::uint32_t kVersion = 1;
+
+/// File sections, in file order; each starts on a cache line.
+enum Section : std::uint32_t {
+    kAthletes,
+    kSessions,
+    kStarts,
+    kDates,
+    kTrials,
+    kTypeIds,
+    kPathOffsets,
+    kPaths,
+    kTypeNames,
+    kMetrics,                             // one per metric
+    kOrders = kMetrics + kNumTrialMetrics,  // one per metric
+    kNumSections = kOrders + kNumTrialMetrics,
+};
+
+struct FileHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t num_sections;
+    std::uint64_t rows;
+    std::uint32_t num_types;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(FileHeader) == 32, "trial index header layout");
+
+struct SectionRecord {
+    std::uint64_t offset;
+    std::uint64_t bytes;
+};
+static_assert(sizeof(SectionRecord) == 16, "trial index directory layout");
+
+[[noreturn]] void corrupt(const std::string& path, const char* what) {
+    throw std::runtime_error("TrialIndex: " + path + ": " + what);
+}
+
+/// Appends sections to an in-memory image of the file.
+class ImageBuilder {
+public:
+    ImageBuilder() : image_(align_up(sizeof(FileHeader) + kNumSections * sizeof(SectionRecord), kCacheLineSize)) {}
+
+    void add(Section section, const void* data, std::size_t bytes) {
+        const std::size_t offset = image_.size();
+        directory_[section] = {offset, bytes};
+        image_.resize(align_up(offset + bytes, kCacheLineSize));
+        if (bytes > 0) std::memcpy(image_.data() + offset, data, bytes);
+    }
+    template <typename T>
+    void add(Section section, const std::vector<T>& column) {
+        add(section, column.data(), column.size() * sizeof(T));
+    }
+
+    std::vector<char>& finish(const FileHeader& header) {
+        std::memcpy(image_.data(), &header, sizeof(header));
+        std::memcpy(image_.data() + sizeof(header), directory_, sizeof(directory_));
+        return image_;
+    }
+
+private:
+    std::vector<char> image_;
+    SectionRecord directory_[kNumSections]{};
+};
+
+}  // namespace
+
+const char* to_string(TrialMetric metric) {
+    switch (metric) {
+        case TrialMetric::jump_height: return "jump_height";
+        case TrialMetric::flight_time: return "flight_time";
+        case TrialMetric::contact_time: return "contact_time";
+        case TrialMetric::takeoff_velocity: return "takeoff_velocity";
+        case TrialMetric::jumps: return "jumps";
+        case TrialMetric::fixation_time: return "fixation_time";
+        case TrialMetric::target_dwell: return "target_dwell";
+    }
+    return "unknown";
+}
+
+TrialIndexWriter::TrialIndexWriter(const TrialIndex& existing) {
+    rows_.reserve(existing.size());
+    for (std::size_t row = 0; row < existing.size(); ++row) add(existing.summary(row));
+}
+
+void TrialIndexWriter::add(TrialSummary summary) {
+    if (summary.trial_type.size() > std::numeric_limits<std::uint16_t>::max())
+        throw std::invalid_argument("TrialIndexWriter: trial type too long");
+    std::vector<std::size_t>& trials = by_session_[summary.session_id];
+    for (std::size_t i : trials) {
+        if (rows_[i].trial == summary.trial) {
+            rows_[i] = std::move(summary);
+            return;
+        }
+    }
+    trials.push_back(rows_.size());
+    rows_.push_back(std::move(summary));
+}
+
+void TrialIndexWriter::write(const std::string& path) const {
+    MM_TRACE_SCOPE("trial_index_write");
+    if (rows_.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::invalid_argument("TrialIndexWriter: too many trials");
+
+    // Type ids follow name order, so equal rows sort the same in every file.
+    std::map<std::string, std::uint32_t> type_ids;
+    for (const TrialSummary& s : rows_) type_ids.emplace(s.trial_type, 0);
+    std::vector<char> type_names;
+    std::uint32_t next_id = 0;
+    for (auto& [name, id] : type_ids) {
+        id = next_id++;
+        const auto len = static_cast<std::uint16_t>(name.size());
+        type_names.insert(type_names.end(), reinterpret_cast<const char*>(&len),
+                          reinterpret_cast<const char*>(&len) + sizeof(len));
+        type_names.insert(type_names.end(), name.begin(), name.end());
+    }
+
+    const std::size_t n = rows_.size();
+    std::vector<std::uint32_t> row_type(n);
+    for (std::size_t i = 0; i < n; ++i) row_type[i] = type_ids.at(rows_[i].trial_type);
+    std::vector<std::uint32_t> sorted(n);
+    std::iota(sorted.begin(), sorted.end(), 0u);
+    std::sort(sorted.begin(), sorted.end(), [&](std::uint32_t a, std::uint32_t b) {
+        const TrialSummary& x = rows_[a];
+        const TrialSummary& y = rows_[b];
+        return std::tie(x.athlete_id, x.date, row_type[a], x.session_id, x.trial) <
+               std::tie(y.athlete_id, y.date, row_type[b], y.session_id, y.trial);
+    });
+
+    std::vector<std::uint64_t> athletes(n), sessions(n), path_offsets(n + 1);
+    std::vector<TimestampNs> starts(n);
+    std::vector<std::int32_t> dates(n);
+    std::vector<std::uint32_t> trials(n), types(n);
+    std::vector<char> paths;
+    std::vector<std::vector<float>> metrics(kNumTrialMetrics, std::vector<float>(n));
+    for (std::size_t r = 0; r < n; ++r) {
+        const TrialSummary& s = rows_[sorted[r]];
+        athletes[r] = s.athlete_id;
+        sessions[r] = s.session_id;
+        starts[r] = s.start;
+        dates[r] = s.date;
+        trials[r] = s.trial;
+        types[r] = row_type[sorted[r]];
+        path_offsets[r] = paths.size();
+        paths.insert(paths.end(), s.path.begin(), s.path.end());
+        for (int m = 0; m < kNumTrialMetrics; ++m) metrics[m][r] = s.metrics[m];
+    }
+    path_offsets[n] = paths.size();
+
+    ImageBuilder builder;
+    builder.add(kAthletes, athletes);
+    builder.add(kSessions, sessions);
+    builder.add(kStarts, starts);
+    builder.add(kDates, dates);
+    builder.add(kTrials, trials);
+    builder.add(kTypeIds, types);
+    builder.add(kPathOffsets, path_offsets);
+    builder.add(kPaths, paths);
+    builder.add(kTypeNames, type_names);
+    for (int m = 0; m < kNumTrialMetrics; ++m) builder.add(static_cast<Section>(kMetrics + m), metrics[m]);
+    for (int m = 0; m < kNumTrialMetrics; ++m) {
+        const std::vector<float>& values = metrics[m];
+        std::vector<std::uint32_t> order;
+        for (std::uint32_t r = 0; r < n; ++r)
+            if (!std::isnan(values[r])) order.push_back(r);
+        std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return values[a] < values[b] || (values[a] == values[b] && a < b);
+        });
+        builder.add(static_cast<Section>(kOrders + m), order);
+    }
+
+    FileHeader header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.num_sections = kNumSections;
+    header.rows = n;
+    header.num_types = next_id;
+    const std::vector<char>& image = builder.finish(header);
+
+    write_file_atomic(path, image.data(), image.size());
+}
+
+TrialIndex::TrialIndex(const std::string& path) : file_(path) {
+    const std::byte* base = file_.data();
+    const std::size_t size = file_.size();
+    if (size < sizeof(FileHeader) + kNumSections * sizeof(SectionRecord)) corrupt(path, "truncated header");
+
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != kMagic) corrupt(path, "not a trial index");
+    if (header.version != kVersion || header.num_sections != kNumSections) corrupt(path, "unsupported version");
+    if (header.rows > std::numeric_limits<std::uint32_t>::max()) corrupt(path, "too many rows");
+    rows_ = static_cast<std::size_t>(header.rows);
+
+    SectionRecord directory[kNumSections];
+    std::memcpy(directory, base + sizeof(header), sizeof(directory));
+    for (const SectionRecord& s : directory)
+        if (s.offset % kCacheLineSize != 0 || s.offset > size || s.bytes > size - s.offset)
+            corrupt(path, "section out of bounds");
+    auto column = [&](Section section, std::size_t element, std::size_t count) {
+        if (directory[section].bytes != element * count) corrupt(path, "column size does not match row count");
+        return base + directory[section].offset;
+    };
+
+    athletes_ = reinterpret_cast<const std::uint64_t*>(column(kAthletes, sizeof(std::uint64_t), rows_));
+    sessions_ = reinterpret_cast<const std::uint64_t*>(column(kSessions, sizeof(std::uint64_t), rows_));
+    starts_ = reinterpret_cast<const TimestampNs*>(column(kStarts, sizeof(TimestampNs), rows_));
+    dates_ = reinterpret_cast<const std::int32_t*>(column(kDates, sizeof(std::int32_t), rows_));
+    trials_ = reinterpret_cast<const std::uint32_t*>(column(kTrials, sizeof(std::uint32_t), rows_));
+    type_ids_ = reinterpret_cast<const std::uint32_t*>(column(kTypeIds, sizeof(std::uint32_t), rows_));
+    path_offsets_ = reinterpret_cast<const std::uint64_t*>(column(kPathOffsets, sizeof(std::uint64_t), rows_ + 1));
+    paths_ = reinterpret_cast<const char*>(base + directory[kPaths].offset);
+    for (int m = 0; m < kNumTrialMetrics; ++m) {
+        metrics_[m] = reinterpret_cast<const float*>(column(static_cast<Section>(kMetrics + m), sizeof(float), rows_));
+        const SectionRecord& order = directory[kOrders + m];
+        if (order.bytes % sizeof(std::uint32_t) != 0 || order.bytes / sizeof(std::uint32_t) > rows_)
+            corrupt(path, "metric order size does not match row count");
+        orders_[m] = reinterpret_cast<const std::uint32_t*>(base + order.offset);
+        order_sizes_[m] = order.bytes / sizeof(std::uint32_t);
+        for (std::size_t i = 0; i < order_sizes_[m]; ++i)
+            if (orders_[m][i] >= rows_) corrupt(path, "metric order out of range");
+    }
+
+    const char* names = reinterpret_cast<const char*>(base + directory[kTypeNames].offset);
+    const std::size_t names_bytes = directory[kTypeNames].bytes;
+    std::size_t pos = 0;
+    for (std::uint32_t t = 0; t < header.num_types; ++t) {
+        std::uint16_t len;
+        if (names_bytes - pos < sizeof(len)) corrupt(path, "truncated trial types");
+        std::memcpy(&len, names + pos, sizeof(len));
+        pos += sizeof(len);
+        if (names_bytes - pos < len) corrupt(path, "truncated trial types");
+        types_.emplace_back(names + pos, len);
+        pos += len;
+        if (t > 0 && !(types_[t - 1] < types_[t])) corrupt(path, "trial types out of order");
+    }
+
+    // Queries binary-search the key columns and walk the metric orders, so
+    // a file that is not sorted would answer them wrongly rather than fail.
+    auto key = [&](std::size_t r) {
+        return std::tie(athletes_[r], dates_[r], type_ids_[r], sessions_[r], trials_[r]);
+    };
+    for (std::size_t r = 0; r < rows_; ++r) {
+        if (type_ids_[r] >= header.num_types) corrupt(path, "trial type out of range");
+        if (path_offsets_[r] > path_offsets_[r + 1]) corrupt(path, "path offsets out of order");
+        if (r > 0 && !(key(r - 1) < key(r))) corrupt(path, "rows out of key order");
+    }
+    if (path_offsets_[rows_] > directory[kPaths].bytes) corrupt(path, "paths out of bounds");
+    for (int m = 0; m < kNumTrialMetrics; ++m) {
+        const float* values = metrics_[m];
+        const std::uint32_t* order = orders_[m];
+        const auto measured = static_cast<std::size_t>(
+            std::count_if(values, values + rows_, [](float v) { return !std::isnan(v); }));
+        if (order_sizes_[m] != measured) corrupt(path, "metric order does not cover the measured rows");
+        for (std::size_t i = 0; i < order_sizes_[m]; ++i) {
+            if (std::isnan(values[order[i]])) corrupt(path, "metric order lists an unmeasured row");
+            if (i > 0 && !(values[order[i - 1]] < values[order[i]] ||
+                           (values[order[i - 1]] == values[order[i]] && order[i - 1] < order[i])))
+                corrupt(path, "metric order out of order");
+        }
+    }
+}
+
+TrialSummary TrialIndex::summary(std::size_t row) const {
+    TrialSummary s;
+    s.athlete_id = athletes_[row];
+    s.session_id = sessions_[row];
+    s.trial = trials_[row];
+    s.date = dates_[row];
+    s.start = starts_[row];
+    s.trial_type = types_[type_ids_[row]];
+    s.path.assign(paths_ + path_offsets_[row], paths_ + path_offsets_[row + 1]);
+    for (int m = 0; m < kNumTrialMetrics; ++m) s.metrics[m] = metrics_[m][row];
+    return s;
+}
+
+std::pair<std::size_t, std::size_t> TrialIndex::key_range(const TrialQuery& query) const {
+    if (!query.athlete_id) return {0, rows_};
+    const auto athletes = std::equal_range(athletes_, athletes_ + rows_, *query.athlete_id);
+    const std::size_t first = athletes.first - athletes_;
+    const std::size_t last = athletes.second - athletes_;
+    const std::int32_t* begin = std::lower_bound(dates_ + first, dates_ + last, query.first_date);
+    const std::int32_t* end = std::upper_bound(begin, dates_ + last, query.last_date);
+    return {static_cast<std::size_t>(begin - dates_), static_cast<std::size_t>(end - dates_)};
+}
+
+int TrialIndex::type_filter(const TrialQuery& query) const {
+    if (query.trial_type.empty()) return -1;
+    const auto it = std::lower_bound(types_.begin(), types_.end(), query.trial_type);
+    return it != types_.end() && *it == query.trial_type ? static_cast<int>(it - types_.begin()) : -2;
+}
+
+std::vector<std::uint32_t> TrialIndex::find(const TrialQuery& query) const {
+    std::vector<std::uint32_t> out;
+    const int type = type_filter(query);
+    if (type == -2) return out;
+    const auto [first, last] = key_range(query);
+    for (std::size_t r = first; r < last; ++r) {
+        if (dates_[r] < query.first_date || dates_[r] > query.last_date) continue;
+        if (type >= 0 && type_ids_[r] != static_cast<std::uint32_t>(type)) continue;
+        out.push_back(static_cast<std::uint32_t>(r));
+    }
+    return out;
+}
+
+std::vector<std::uint32_t> TrialIndex::top(const TrialQuery& query, TrialMetric metric, std::size_t k,
+                                           Rank rank) const {
+    MM_TRACE_SCOPE("trial_index_top");
+    std::vector<std::uint32_t> out;
+    const int type = type_filter(query);
+    if (type == -2 || k == 0) return out;
+    const int m = static_cast<int>(metric);
+    const float* values = metrics_[m];
+
+    if (query.athlete_id) {
+        // One athlete's season is small: rank its rows directly.
+        out = find(query);
+        out.erase(std::remove_if(out.begin(), out.end(), [&](std::uint32_t r) { return std::isnan(values[r]); }),
+                  out.end());
+        auto better = [&](std::uint32_t a, std::uint32_t b) {
+            // Same ranking as walking the metric order from either end.
+            if (rank == Rank::highest) return values[a] > values[b] || (values[a] == values[b] && a > b);
+            return values[a] < values[b] || (values[a] == values[b] && a < b);
+        };
+        const std::size_t count = std::min(k, out.size());
+        std::partial_sort(out.begin(), out.begin() + count, out.end(), better);
+        out.resize(count);
+        return out;
+    }
+
+    // Otherwise walk the metric order from the best end until k rows match.
+    const std::uint32_t* order = orders_[m];
+    const std::size_t n = order_sizes_[m];
+    auto matches = [&](std::uint32_t r) {
+        return dates_[r] >= query.first_date && dates_[r] <= query.last_date &&
+               (type < 0 || type_ids_[r] == static_cast<std::uint32_t>(type));
+    };
+    for (std::size_t i = 0; i < n && out.size() < k; ++i) {
+        const std::uint32_t r = rank == Rank::highest ? order[n - 1 - i] : order[i];
+        if (matches(r)) out.push_back(r);
+    }
+    return out;
+}
+
+}  // namespace mm::storage
@@ -0,0 +1,335 @@
+#include "motionmetrics/tracking/blob_detector.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if MM_HAVE_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::tracking {
+namespace {
+
+using Run = BlobDetector::Run;
+
+/// Appends the runs encoded in a foreground bit mask covering pixels
+/// [base, base + nbits). A run still open at the end of the chunk stays open
+/// via `open_start` (-1 when closed) and continues into the next chunk.
+inline void emit_runs(std::uint64_t mask, int nbits, int base, int y, int& open_start, std::vector<Run>& runs) {
+    int pos = 0;
+    while (pos < nbits) {
+        if (open_start < 0) {
+            const std::uint64_t rest = mask >> pos;
+            if (rest == 0) return;
+            pos += __builtin_ctzll(rest);
+            open_start = base + pos;
+        }
+        // A run reaching the chunk end stays open; bits above nbits are zero
+        // in `mask`, so `~mask` never scans past the chunk.
+        const std::uint64_t background = ~mask >> pos;
+        if (background == 0) return;
+        pos += __builtin_ctzll(background);
+        if (pos >= nbits) return;
+        runs.push_back(Run{y, open_start, base + pos, 0, 0, 0, 0, 0, 0, 0, 0});
+        open_start = -1;
+    }
+}
+
+inline void close_row(int width, int y, int& open_start, std::vector<Run>& runs) {
+    if (open_start >= 0) runs.push_back(Run{y, open_start, width, 0, 0, 0, 0, 0, 0, 0, 0});
+    open_start = -1;
+}
+
+/// SWAR test: does any byte of `word` reach `threshold`? Lets the scalar
+/// fallback skip background eight pixels at a time.
+inline bool any_byte_at_least(std::uint64_t word, std::uint8_t threshold) {
+    constexpr std::uint64_t kLow7 = 0x7f7f'7f7f'7f7f'7f7full;
+    constexpr std::uint64_t kHigh = 0x8080'8080'8080'8080ull;
+    constexpr std::uint64_t kOnes = 0x0101'0101'0101'0101ull;
+    // (b & 0x7f) + bias cannot carry into the next byte since bias <= 128.
+    if (threshold < 128) return (((word & kLow7) + kOnes * (128u - threshold)) | word) & kHigh;
+    return (((word & kLow7) + kOnes * (256u - threshold)) & word) & kHigh;
+}
+
+void scan_row_scalar(const std::uint8_t* row, int width, std::uint8_t threshold, int y, std::vector<Run>& runs) {
+    int open_start = -1;
+    for (int base = 0; base < width; base += 64) {
+        const int n = std::min(64, width - base);
+        if (n == 64 && open_start < 0) {
+            bool any = false;
+            for (int i = 0; i < 64 && !any; i += 8) {
+                std::uint64_t word;
+                std::memcpy(&word, row + base + i, sizeof(word));
+                any = any_byte_at_least(word, threshold);
+            }
+            if (!any) continue;
+        }
+        std::uint64_t mask = 0;
+        for (int i = 0; i < n; ++i) mask |= static_cast<std::uint64_t>(row[base + i] >= threshold) << i;
+        if (mask == 0 && open_start < 0) continue;
+        emit_runs(mask, n, base, y, open_start, runs);
+    }
+    close_row(width, y, open_start, runs);
+}
+
+#if MM_HAVE_X86_DISPATCH
+
+MM_TARGET_AVX2 void scan_row_avx2(const std::uint8_t* row, int width, std::uint8_t threshold, int y,
+                                  std::vector<Run>& runs) {
+    const __m256i thr = _mm256_set1_epi8(static_cast<char>(threshold));
+    int open_start = -1;
+    int base = 0;
+    for (; base + 32 <= width; base += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + base));
+        // Unsigned v >= thr  <=>  max(v, thr) == v.
+        const __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(v, thr), v);
+        const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(ge));
+        if (mask == 0 && open_start < 0) continue;
+        if (mask == 0xffff'ffffu && open_start >= 0) continue;
+        emit_runs(mask, 32, base, y, open_start, runs);
+    }
+    if (base < width) {
+        std::uint64_t mask = 0;
+        for (int i = 0; base + i < width; ++i) mask |= static_cast<std::uint64_t>(row[base + i] >= threshold) << i;
+        emit_runs(mask, width - base, base, y, open_start, runs);
+    }
+    close_row(width, y, open_start, runs);
+}
+
+MM_TARGET_AVX512 void scan_row_avx512(const std::uint8_t* row, int width, std::uint8_t threshold, int y,
+                                      std::vector<Run>& runs) {
+    const __m512i thr = _mm512_set1_epi8(static_cast<char>(threshold));
+    int open_start = -1;
+    for (int base = 0; base < width; base += 64) {
+        const int n = std::min(64, width - base);
+        const __mmask64 valid = n == 64 ? ~__mmask64{0} : (__mmask64{1} << n) - 1;
+        const __m512i v = _mm512_maskz_loadu_epi8(valid, row + base);
+        const std::uint64_t mask = _mm512_mask_cmpge_epu8_mask(valid, v, thr);
+        if (mask == 0 && open_start < 0) continue;
+        if (mask == ~std::uint64_t{0} && open_start >= 0) continue;
+        emit_runs(mask, n, base, y, open_start, runs);
+    }
+    close_row(width, y, open_start, runs);
+}
+
+#endif
+
+/// Fills the per-run weighted sums. Runs are short (a marker is a few
+/// pixels wide), so this stays scalar.
+void accumulate_run(const std::uint8_t* row, int bias, Run& run) {
+    std::int64_t sum_w = 0;
+    std::int64_t sum_wx = 0;
+    for (int x = run.x0; x < run.x1; ++x) {
+        const int w = row[x] - bias;
+        sum_w += w;
+        sum_wx += static_cast<std::int64_t>(w) * x;
+    }
+    run.area = run.x1 - run.x0;
+    run.sum_w = sum_w;
+    run.sum_wx = sum_wx;
+    run.sum_wy = sum_w * run.y;
+    run.min_x = run.x0;
+    run.max_x = run.x1 - 1;
+    run.min_y = run.y;
+    run.max_y = run.y;
+}
+
+/// Pixel weight bias: a pixel exactly at threshold has weight 1.
+int weight_bias(std::uint8_t threshold) { return static_cast<int>(threshold) - 1; }
+
+Blob make_blob(int area, std::int64_t sum_w, std::int64_t sum_wx, std::int64_t sum_wy, int min_x, int min_y,
+               int max_x, int max_y, int origin_x, int origin_y) {
+    Blob blob;
+    const double inv = 1.0 / static_cast<double>(sum_w);
+    blob.x = static_cast<float>(static_cast<double>(sum_wx) * inv + origin_x);
+    blob.y = static_cast<float>(static_cast<double>(sum_wy) * inv + origin_y);
+    blob.weight = static_cast<float>(sum_w);
+    blob.area = area;
+    blob.min_x = min_x + origin_x;
+    blob.min_y = min_y + origin_y;
+    blob.max_x = max_x + origin_x;
+    blob.max_y = max_y + origin_y;
+    return blob;
+}
+
+void sort_blobs(std::vector<Blob>& blobs) {
+    std::sort(blobs.begin(), blobs.end(), [](const Blob& a, const Blob& b) {
+        if (a.min_y != b.min_y) return a.min_y < b.min_y;
+        if (a.min_x != b.min_x) return a.min_x < b.min_x;
+        if (a.y != b.y) return a.y < b.y;
+        return a.x < b.x;
+    });
+}
+
+}  // namespace
+
+BlobDetector::BlobDetector(BlobDetectorParams params, SimdLevel level)
+    : params_(params), level_(clamp_simd_level(level)) {}
+
+int BlobDetector::find(int run) {
+    while (parent_[run] != run) {
+        parent_[run] = parent_[parent_[run]];
+        run = parent_[run];
+    }
+    return run;
+}
+
+void BlobDetector::detect(const ImageView& image, std::vector<Blob>& out, int origin_x, int origin_y) {
+    MM_TRACE_SCOPE("detect_markers");
+    out.clear();
+    runs_.clear();
+    if (image.empty()) return;
+
+    const std::uint8_t threshold = params_.threshold;
+    const int bias = weight_bias(threshold);
+
+    int prev_begin = 0;
+    int prev_end = 0;
+    for (int y = 0; y < image.height; ++y) {
+        const std::uint8_t* row = image.row(y);
+        const int row_begin = static_cast<int>(runs_.size());
+        switch (level_) {
+#if MM_HAVE_X86_DISPATCH
+            case SimdLevel::avx512: scan_row_avx512(row, image.width, threshold, y, runs_); break;
+            case SimdLevel::avx2: scan_row_avx2(row, image.width, threshold, y, runs_); break;
+#endif
+            default: scan_row_scalar(row, image.width, threshold, y, runs_); break;
+        }
+        const int row_end = static_cast<int>(runs_.size());
+        if (row_end == row_begin) {
+            prev_begin = prev_end = row_end;
+            continue;
+        }
+
+        parent_.resize(runs_.size());
+        for (int r = row_begin; r < row_end; ++r) {
+            accumulate_run(row, bias, runs_[r]);
+            parent_[r] = r;
+        }
+
+        // Merge with 8-connected runs of the previous row. Both rows are
+        // sorted by x, so a single merge sweep visits every overlap.
+        int i = prev_begin;
+        int j = row_begin;
+        while (i < prev_end && j < row_end) {
+            const Run& a = runs_[i];
+            const Run& b = runs_[j];
+            if (a.x0 <= b.x1 && b.x0 <= a.x1) {
+                const int ra = find(i);
+                const int rb = find(j);
+                if (ra != rb) parent_[std::max(ra, rb)] = std::min(ra, rb);
+            }
+            if (a.x1 < b.x1) ++i;
+            else ++j;
+        }
+        prev_begin = row_begin;
+        prev_end = row_end;
+    }
+
+    // Roots always have the smallest index of their component, so folding
+    // in run order accumulates every component into its root in place.
+    const int num_runs = static_cast<int>(runs_.size());
+    for (int r = 0; r < num_runs; ++r) {
+        const int root = find(r);
+        if (root == r) continue;
+        Run& dst = runs_[root];
+        const Run& src = runs_[r];
+        dst.area += src.area;
+        dst.sum_w += src.sum_w;
+        dst.sum_wx += src.sum_wx;
+        dst.sum_wy += src.sum_wy;
+        dst.min_x = std::min(dst.min_x, src.min_x);
+        dst.max_x = std::max(dst.max_x, src.max_x);
+        dst.max_y = std::max(dst.max_y, src.max_y);
+    }
+    for (int r = 0; r < num_runs; ++r) {
+        if (parent_[r] != r) continue;
+        const Run& c = runs_[r];
+        if (c.area < params_.min_area || c.area > params_.max_area) continue;
+        out.push_back(make_blob(c.area, c.sum_w, c.sum_wx, c.sum_wy, c.min_x, c.min_y, c.max_x, c.max_y,
+                                origin_x, origin_y));
+    }
+    sort_blobs(out);
+}
+
+void detect_blobs_reference(const ImageView& image, const BlobDetectorParams& params, std::vector<Blob>& out,
+                            int origin_x, int origin_y) {
+    out.clear();
+    if (image.empty()) return;
+
+    const int w = image.width;
+    const int h = image.height;
+    const int bias = weight_bias(params.threshold);
+    std::vector<int> labels(static_cast<std::size_t>(w) * h, 0);
+    std::vector<int> parent(1, 0);
+
+    auto find = [&](int l) {
+        while (parent[l] != l) l = parent[l] = parent[parent[l]];
+        return l;
+    };
+    auto unite = [&](int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) parent[std::max(a, b)] = std::min(a, b);
+    };
+
+    // Pass 1: provisional labels from the already-visited 8-neighbours.
+    for (int y = 0; y < h; ++y) {
+        const std::uint8_t* row = image.row(y);
+        for (int x = 0; x < w; ++x) {
+            if (row[x] < params.threshold) continue;
+            int label = 0;
+            const int neighbours[4][2] = {{x - 1, y}, {x - 1, y - 1}, {x, y - 1}, {x + 1, y - 1}};
+            for (const auto& n : neighbours) {
+                if (n[0] < 0 || n[0] >= w || n[1] < 0) continue;
+                const int nl = labels[static_cast<std::size_t>(n[1]) * w + n[0]];
+                if (nl == 0) continue;
+                if (label == 0) label = nl;
+                else unite(label, nl);
+            }
+            if (label == 0) {
+                label = static_cast<int>(parent.size());
+                parent.push_back(label);
+            }
+            labels[static_cast<std::size_t>(y) * w + x] = label;
+        }
+    }
+
+    // Pass 2: accumulate moments per resolved label.
+    struct Acc {
+        int area = 0;
+        std::int64_t sum_w = 0, sum_wx = 0, sum_wy = 0;
+        int min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+    };
+    std::vector<Acc> acc(parent.size());
+    for (int y = 0; y < h; ++y) {
+        const std::uint8_t* row = image.row(y);
+        for (int x = 0; x < w; ++x) {
+            const int label = labels[static_cast<std::size_t>(y) * w + x];
+            if (label == 0) continue;
+            Acc& a = acc[find(label)];
+            const int weight = row[x] - bias;
+            if (a.area == 0) {
+                a.min_x = a.max_x = x;
+                a.min_y = a.max_y = y;
+            }
+            ++a.area;
+            a.sum_w += weight;
+            a.sum_wx += static_cast<std::int64_t>(weight) * x;
+            a.sum_wy += static_cast<std::int64_t>(weight) * y;
+            a.min_x = std::min(a.min_x, x);
+            a.max_x = std::max(a.max_x, x);
+            a.max_y = std::max(a.max_y, y);
+        }
+    }
+    for (const Acc& a : acc) {
+        if (a.area == 0 || a.area < params.min_area || a.area > params.max_area) continue;
+        out.push_back(make_blob(a.area, a.sum_w, a.sum_wx, a.sum_wy, a.min_x, a.min_y, a.max_x, a.max_y, origin_x,
+                                origin_y));
+    }
+    sort_blobs(out);
+}
+
+}  // namespace mm::tracking
@@ -0,0 +1,241 @@
+#include "motionmetrics/tracking/marker_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::tracking {
+namespace {
+
+/// Initial velocity variance of a newly spawned track, (px/s)^2.
+constexpr float kInitialVelocityVariance = 2000.0f * 2000.0f;
+
+bool overlaps(int a0, int a1, int b0, int b1) { return a0 < b1 && b0 < a1; }
+
+}  // namespace
+
+MarkerTracker::MarkerTracker(MarkerTrackerParams params, SimdLevel level)
+    : params_(params), detector_(params.detector, level) {}
+
+void MarkerTracker::reset() {
+    markers_.clear();
+    filters_.clear();
+    last_timestamp_.reset();
+    frames_since_full_scan_ = 0;
+    last_full_scan_ = false;
+}
+
+void MarkerTracker::predict(float dt) {
+    const float q = params_.process_noise;
+    const float dt2 = dt * dt;
+    for (std::size_t i = 0; i < markers_.size(); ++i) {
+        TrackedMarker& m = markers_[i];
+        Filter& f = filters_[i];
+        m.x += m.vx * dt;
+        m.y += m.vy * dt;
+        const float p00 = f.p00 + 2.0f * dt * f.p01 + dt2 * f.p11 + q * dt2 * dt / 3.0f;
+        const float p01 = f.p01 + dt * f.p11 + q * dt2 / 2.0f;
+        const float p11 = f.p11 + q * dt;
+        f.p00 = p00;
+        f.p01 = p01;
+        f.p11 = p11;
+    }
+}
+
+void MarkerTracker::scan_windows(const ImageView& frame) {
+    windows_.clear();
+    blobs_.clear();
+    const float gate_sigma = std::sqrt(params_.gate);
+    const int max_half = params_.max_window / 2;
+    for (std::size_t i = 0; i < markers_.size(); ++i) {
+        const TrackedMarker& m = markers_[i];
+        const Filter& f = filters_[i];
+        const float radius = gate_sigma * std::sqrt(f.p00 + params_.measurement_noise) + f.half_extent;
+        const int half = std::min(max_half, static_cast<int>(std::ceil(radius)) + params_.window_margin);
+        const int cx = static_cast<int>(std::lround(m.x));
+        const int cy = static_cast<int>(std::lround(m.y));
+        Window w{std::max(0, cx - half), std::max(0, cy - half), std::min(frame.width, cx + half + 1),
+                 std::min(frame.height, cy + half + 1)};
+        if (w.x0 < w.x1 && w.y0 < w.y1) windows_.push_back(w);
+    }
+
+    // Merge overlapping windows so no pixel is scanned twice and blobs
+    // straddling two windows are seen whole.
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (std::size_t a = 0; a < windows_.size() && !merged; ++a) {
+            for (std::size_t b = a + 1; b < windows_.size(); ++b) {
+                Window& wa = windows_[a];
+                const Window& wb = windows_[b];
+                if (!overlaps(wa.x0, wa.x1, wb.x0, wb.x1) || !overlaps(wa.y0, wa.y1, wb.y0, wb.y1)) continue;
+                wa = Window{std::min(wa.x0, wb.x0), std::min(wa.y0, wb.y0), std::max(wa.x1, wb.x1),
+                            std::max(wa.y1, wb.y1)};
+                windows_.erase(windows_.begin() + static_cast<std::ptrdiff_t>(b));
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    for (Window w : windows_) {
+        // A blob cut by an interior window edge would report a biased
+        // centroid; grow the window over it and scan again (once).
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            detector_.detect(frame.crop(w.x0, w.y0, w.x1 - w.x0, w.y1 - w.y0), scratch_, w.x0, w.y0);
+            stats_.pixels_scanned += static_cast<std::uint64_t>(w.x1 - w.x0) * (w.y1 - w.y0);
+            Window grown = w;
+            for (const Blob& b : scratch_) {
+                if (b.min_x == w.x0 && w.x0 > 0) grown.x0 = std::max(0, w.x0 - params_.max_window / 4);
+                if (b.min_y == w.y0 && w.y0 > 0) grown.y0 = std::max(0, w.y0 - params_.max_window / 4);
+                if (b.max_x == w.x1 - 1 && w.x1 < frame.width)
+                    grown.x1 = std::min(frame.width, w.x1 + params_.max_window / 4);
+                if (b.max_y == w.y1 - 1 && w.y1 < frame.height)
+                    grown.y1 = std::min(frame.height, w.y1 + params_.max_window / 4);
+            }
+            if (attempt == 1 || std::tie(grown.x0, grown.y0, grown.x1, grown.y1) == std::tie(w.x0, w.y0, w.x1, w.y1))
+                break;
+            w = grown;
+        }
+        blobs_.insert(blobs_.end(), scratch_.begin(), scratch_.end());
+    }
+
+    // Grown windows may have picked up the same blob twice.
+    std::sort(blobs_.begin(), blobs_.end(), [](const Blob& a, const Blob& b) {
+        return std::tie(a.min_y, a.min_x, a.area) < std::tie(b.min_y, b.min_x, b.area);
+    });
+    blobs_.erase(std::unique(blobs_.begin(), blobs_.end(),
+                             [](const Blob& a, const Blob& b) {
+                                 return a.min_y == b.min_y && a.min_x == b.min_x && a.area == b.area;
+                             }),
+                 blobs_.end());
+}
+
+void MarkerTracker::scan_full(const ImageView& frame) {
+    detector_.detect(frame, blobs_);
+    stats_.pixels_scanned += static_cast<std::uint64_t>(frame.width) * frame.height;
+    ++stats_.full_scans;
+    frames_since_full_scan_ = 0;
+    last_full_scan_ = true;
+}
+
+void MarkerTracker::associate() {
+    struct Candidate {
+        float cost;
+        int track;
+        int blob;
+    };
+    std::vector<Candidate> candidates;
+    for (std::size_t i = 0; i < markers_.size(); ++i) {
+        const float s = filters_[i].p00 + params_.measurement_noise;
+        for (std::size_t j = 0; j < blobs_.size(); ++j) {
+            const float dx = blobs_[j].x - markers_[i].x;
+            const float dy = blobs_[j].y - markers_[i].y;
+            const float cost = (dx * dx + dy * dy) / s;
+            if (cost <= params_.gate) candidates.push_back({cost, static_cast<int>(i), static_cast<int>(j)});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.cost < b.cost; });
+
+    assignment_.assign(markers_.size(), -1);
+    blob_owner_.assign(blobs_.size(), -1);
+    for (const Candidate& c : candidates) {
+        if (assignment_[c.track] >= 0 || blob_owner_[c.blob] >= 0) continue;
+        assignment_[c.track] = c.blob;
+        blob_owner_[c.blob] = c.track;
+    }
+}
+
+void MarkerTracker::update_tracks() {
+    const float r = params_.measurement_noise;
+    for (std::size_t i = 0; i < markers_.size(); ++i) {
+        TrackedMarker& m = markers_[i];
+        Filter& f = filters_[i];
+        if (assignment_[i] < 0) {
+            m.observed = false;
+            ++m.missed;
+            continue;
+        }
+        const Blob& blob = blobs_[assignment_[i]];
+        const float s = f.p00 + r;
+        const float k0 = f.p00 / s;
+        const float k1 = f.p01 / s;
+        const float ex = blob.x - m.x;
+        const float ey = blob.y - m.y;
+        m.x += k0 * ex;
+        m.y += k0 * ey;
+        m.vx += k1 * ex;
+        m.vy += k1 * ey;
+        const float p00 = (1.0f - k0) * f.p00;
+        const float p01 = (1.0f - k0) * f.p01;
+        const float p11 = f.p11 - k1 * f.p01;
+        f.p00 = p00;
+        f.p01 = p01;
+        f.p11 = p11;
+        f.half_extent = 0.5f * static_cast<float>(std::max(blob.max_x - blob.min_x, blob.max_y - blob.min_y) + 1);
+        m.blob = blob;
+        m.observed = true;
+        m.missed = 0;
+    }
+}
+
+void MarkerTracker::spawn_tracks() {
+    for (std::size_t j = 0; j < blobs_.size(); ++j) {
+        if (blob_owner_[j] >= 0) continue;
+        const Blob& blob = blobs_[j];
+        TrackedMarker m;
+        m.id = next_id_++;
+        m.x = blob.x;
+        m.y = blob.y;
+        m.blob = blob;
+        m.observed = true;
+        markers_.push_back(m);
+        Filter f;
+        f.p00 = params_.measurement_noise;
+        f.p11 = kInitialVelocityVariance;
+        f.half_extent = 0.5f * static_cast<float>(std::max(blob.max_x - blob.min_x, blob.max_y - blob.min_y) + 1);
+        filters_.push_back(f);
+    }
+}
+
+const std::vector<TrackedMarker>& MarkerTracker::track(const ImageView& frame, TimestampNs timestamp) {
+    MM_TRACE_SCOPE("track_markers");
+    const float dt = last_timestamp_ ? static_cast<float>(timestamp - *last_timestamp_) * 1e-9f : 0.0f;
+    last_timestamp_ = timestamp;
+    ++stats_.frames;
+    ++frames_since_full_scan_;
+    last_full_scan_ = false;
+
+    predict(dt);
+
+    bool full = markers_.empty() ||
+                (params_.full_scan_interval > 0 && frames_since_full_scan_ >= params_.full_scan_interval) ||
+                (params_.expected_markers > 0 && static_cast<int>(markers_.size()) < params_.expected_markers);
+    if (!full) {
+        scan_windows(frame);
+        associate();
+        full = std::find(assignment_.begin(), assignment_.end(), -1) != assignment_.end();
+    }
+    if (full) {
+        scan_full(frame);
+        associate();
+    }
+
+    update_tracks();
+    if (full) spawn_tracks();
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < markers_.size(); ++i) {
+        if (markers_[i].missed > params_.max_missed) continue;
+        markers_[kept] = markers_[i];
+        filters_[kept] = filters_[i];
+        ++kept;
+    }
+    markers_.resize(kept);
+    filters_.resize(kept);
+    return markers_;
+}
+
+}  // namespace mm::tracking
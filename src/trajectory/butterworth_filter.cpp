@@ -0,0 +1,357 @@
+#include "motionmetrics/trajectory/butterworth_filter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::trajectory {
+namespace {
+
+/// Channels filtered together, one per lane.
+constexpr int kLanes = 8;
+constexpr int kMaxOrder = 16;
+constexpr int kMaxSections = kMaxOrder / 2;
+
+/// Per-lane coefficients of one section: b0, b1, b2, a1, a2, each kLanes wide.
+constexpr int kCoeffStride = 5 * kLanes;
+
+/// Runs the biquad cascade over `n` interleaved samples, forwards or
+/// backwards, starting every section at its steady state for the first
+/// sample. Lanes are independent, so each inner loop is one vector op.
+MM_ALWAYS_INLINE void cascade_kernel(double* MM_RESTRICT data, std::ptrdiff_t n, const double* MM_RESTRICT coeffs,
+                                     int sections, bool backward) {
+    double z1[kMaxSections * kLanes];
+    double z2[kMaxSections * kLanes];
+    const std::ptrdiff_t step = backward ? -kLanes : kLanes;
+    double* p = backward ? data + (n - 1) * kLanes : data;
+
+    // Sections have unity DC gain, so a constant input x0 passes through
+    // every section unchanged and the steady state follows directly.
+    for (int s = 0; s < sections; ++s) {
+        const double* c = coeffs + s * kCoeffStride;
+        for (int l = 0; l < kLanes; ++l) {
+            const double x0 = p[l];
+            z2[s * kLanes + l] = (c[2 * kLanes + l] - c[4 * kLanes + l]) * x0;
+            z1[s * kLanes + l] = (c[kLanes + l] - c[3 * kLanes + l]) * x0 + z2[s * kLanes + l];
+        }
+    }
+
+    for (std::ptrdiff_t t = 0; t < n; ++t, p += step) {
+        double x[kLanes];
+        for (int l = 0; l < kLanes; ++l) x[l] = p[l];
+        for (int s = 0; s < sections; ++s) {
+            const double* c = coeffs + s * kCoeffStride;
+            double* a = z1 + s * kLanes;
+            double* b = z2 + s * kLanes;
+            for (int l = 0; l < kLanes; ++l) {
+                const double y = c[l] * x[l] + a[l];
+                a[l] = c[kLanes + l] * x[l] - c[3 * kLanes + l] * y + b[l];
+                b[l] = c[2 * kLanes + l] * x[l] - c[4 * kLanes + l] * y;
+                x[l] = y;
+            }
+        }
+        for (int l = 0; l < kLanes; ++l) p[l] = x[l];
+    }
+}
+
+MM_ALWAYS_INLINE void filtfilt_kernel(double* data, std::ptrdiff_t n, const double* coeffs, int sections) {
+    cascade_kernel(data, n, coeffs, sections, false);
+    cascade_kernel(data, n, coeffs, sections, true);
+}
+
+void filtfilt_scalar(double* data, std::ptrdiff_t n, const double* coeffs, int sections) {
+    filtfilt_kernel(data, n, coeffs, sections);
+}
+#if MM_HAVE_X86_DISPATCH
+MM_TARGET_AVX2 void filtfilt_avx2(double* data, std::ptrdiff_t n, const double* coeffs, int sections) {
+    filtfilt_kernel(data, n, coeffs, sections);
+}
+MM_TARGET_AVX512 void filtfilt_avx512(double* data, std::ptrdiff_t n, const double* coeffs, int sections) {
+    filtfilt_kernel(data, n, coeffs, sections);
+}
+#endif
+
+void filtfilt(SimdLevel level, double* data, std::ptrdiff_t n, const double* coeffs, int sections) {
+    switch (level) {
+#if MM_HAVE_X86_DISPATCH
+        case SimdLevel::avx512:
+            filtfilt_avx512(data, n, coeffs, sections);
+            break;
+        case SimdLevel::avx2:
+            filtfilt_avx2(data, n, coeffs, sections);
+            break;
+#endif
+        default:
+            filtfilt_scalar(data, n, coeffs, sections);
+            break;
+    }
+}
+
+/// Writes the sections of one lane; a non-finite cutoff gives identity
+/// sections, leaving the channel unfiltered.
+void set_lane(double* coeffs, int lane, const std::vector<Biquad>& design, int sections) {
+    for (int s = 0; s < sections; ++s) {
+        const Biquad q = s < static_cast<int>(design.size()) ? design[s] : Biquad{};
+        double* c = coeffs + s * kCoeffStride + lane;
+        c[0] = q.b0;
+        c[kLanes] = q.b1;
+        c[2 * kLanes] = q.b2;
+        c[3 * kLanes] = q.a1;
+        c[4 * kLanes] = q.a2;
+    }
+}
+
+}  // namespace
+
+std::vector<Biquad> design_butterworth_lowpass(int order, double cutoff_hz, double sample_rate_hz, bool zero_phase) {
+    if (order < 2 || order > kMaxOrder || order % 2 != 0)
+        throw std::invalid_argument("design_butterworth_lowpass: order must be even and at most 16");
+    if (!(cutoff_hz > 0.0 && cutoff_hz < 0.5 * sample_rate_hz))
+        throw std::invalid_argument("design_butterworth_lowpass: cutoff must lie in (0, Nyquist)");
+    double k = std::tan(M_PI * cutoff_hz / sample_rate_hz);
+    // Two passes square the magnitude response; moving the analog cutoff by
+    // (sqrt(2) - 1)^(-1 / 2N) puts the combined -3 dB point back at k.
+    if (zero_phase) k /= std::pow(std::sqrt(2.0) - 1.0, 1.0 / (2.0 * order));
+    std::vector<Biquad> sections(order / 2);
+    for (int i = 0; i < order / 2; ++i) {
+        const double q = 2.0 * std::sin(M_PI * (2 * i + 1) / (2.0 * order));
+        const double norm = 1.0 / (1.0 + q * k + k * k);
+        Biquad& s = sections[i];
+        s.b0 = k * k * norm;
+        s.b1 = 2.0 * s.b0;
+        s.b2 = s.b0;
+        s.a1 = 2.0 * (k * k - 1.0) * norm;
+        s.a2 = (1.0 - q * k + k * k) * norm;
+    }
+    return sections;
+}
+
+struct ButterworthFilterBank::Group {
+    int first_column = 0;
+    int lanes = 0;  // columns in use, the rest are zero
+    std::int64_t pad = 0;
+    std::vector<double> data;      // (frames + 2 pad) x kLanes
+    std::vector<double> original;  // copy for residual analysis
+    std::vector<double> coeffs;    // sections x kCoeffStride
+
+    double* sample(std::int64_t frame) { return data.data() + (pad + frame) * kLanes; }
+
+    /// Interleaves the group's columns, bridging missing samples linearly
+    /// (held constant before the first and after the last sample) and
+    /// padding both ends by odd reflection. Copies run frame-major so each
+    /// output cache line is written once.
+    void gather(const TrajectorySet& set, int first, std::int64_t padding) {
+        const std::int64_t n = set.frames();
+        first_column = first;
+        lanes = std::min(kLanes, 3 * set.num_markers() - first);
+        pad = std::min(padding, n - 1);
+        data.resize(static_cast<std::size_t>(n + 2 * pad) * kLanes);
+        const float* src[kLanes];
+        for (int l = 0; l < lanes; ++l) src[l] = set.column((first + l) / 3, (first + l) % 3);
+        bool gaps[kLanes] = {};
+        for (std::int64_t f = 0; f < n; ++f) {
+            double* out = sample(f);
+            for (int l = 0; l < lanes; ++l) {
+                const float v = src[l][f];
+                gaps[l] |= v != v;
+                out[l] = v;
+            }
+            for (int l = lanes; l < kLanes; ++l) out[l] = 0.0;
+        }
+        for (int l = 0; l < lanes; ++l)
+            if (gaps[l]) bridge(l, n);
+        for (std::int64_t k = 1; k <= pad; ++k) {
+            double* before = sample(-k);
+            double* after = sample(n - 1 + k);
+            const double* head = sample(0);
+            const double* tail = sample(n - 1);
+            const double* inner_head = sample(k);
+            const double* inner_tail = sample(n - 1 - k);
+            for (int l = 0; l < kLanes; ++l) {
+                before[l] = 2.0 * head[l] - inner_head[l];
+                after[l] = 2.0 * tail[l] - inner_tail[l];
+            }
+        }
+    }
+
+    /// Replaces the NaN samples of one lane by linear interpolation.
+    void bridge(int l, std::int64_t n) {
+        std::int64_t last = -1;
+        for (std::int64_t f = 0; f < n; ++f) {
+            const double v = sample(f)[l];
+            if (v != v) continue;
+            if (f > last + 1) {
+                const double from = last < 0 ? v : sample(last)[l];
+                for (std::int64_t g = last + 1; g < f; ++g)
+                    sample(g)[l] = last < 0 ? v : from + (v - from) * static_cast<double>(g - last) / (f - last);
+            }
+            last = f;
+        }
+        const double hold = last < 0 ? 0.0 : sample(last)[l];
+        for (std::int64_t g = last + 1; g < n; ++g) sample(g)[l] = hold;
+    }
+
+    /// Writes filtered samples back where the input was present.
+    void scatter(TrajectorySet& set) {
+        float* dst[kLanes];
+        for (int l = 0; l < lanes; ++l) dst[l] = set.column((first_column + l) / 3, (first_column + l) % 3);
+        for (std::int64_t f = 0; f < set.frames(); ++f) {
+            const double* in = sample(f);
+            for (int l = 0; l < lanes; ++l)
+                if (dst[l][f] == dst[l][f]) dst[l][f] = static_cast<float>(in[l]);
+        }
+    }
+};
+
+ButterworthFilterBank::ButterworthFilterBank(ButterworthParams params, SimdLevel level, WorkStealingPool* pool)
+    : params_(params), level_(clamp_simd_level(level)), pool_(pool) {
+    if (params_.order < 2 || params_.order > kMaxOrder || params_.order % 2 != 0)
+        throw std::invalid_argument("ButterworthFilterBank: order must be even and at most 16");
+}
+
+double ButterworthFilterBank::sample_rate(const TrajectorySet& set) const {
+    if (params_.sample_rate_hz > 0.0) return params_.sample_rate_hz;
+    const std::vector<TimestampNs>& ts = set.timestamps();
+    std::vector<TimestampNs> steps;
+    for (std::size_t i = 1; i < ts.size(); ++i) steps.push_back(ts[i] - ts[i - 1]);
+    if (steps.empty()) throw std::invalid_argument("ButterworthFilterBank: too few frames for a sample rate");
+    std::nth_element(steps.begin(), steps.begin() + steps.size() / 2, steps.end());
+    const TimestampNs median = steps[steps.size() / 2];
+    if (median <= 0) throw std::invalid_argument("ButterworthFilterBank: timestamps give no sample rate");
+    return 1e9 / static_cast<double>(median);
+}
+
+template <typename Fn>
+void ButterworthFilterBank::for_each_group(const TrajectorySet& set, Fn&& fn) const {
+    const int groups = (3 * set.num_markers() + kLanes - 1) / kLanes;
+    std::vector<Group> scratch(pool_ != nullptr ? pool_->size() + 1 : 1);
+    auto task = [&](int g) { fn(g, scratch[pool_ != nullptr ? pool_->current_slot() : 0]); };
+    if (pool_ != nullptr) {
+        pool_->parallel_for(0, groups, 1, task);
+    } else {
+        for (int g = 0; g < groups; ++g) task(g);
+    }
+}
+
+void ButterworthFilterBank::filter(TrajectorySet& set, double cutoff_hz) const {
+    filter(set, std::vector<double>(set.num_markers(), cutoff_hz));
+}
+
+void ButterworthFilterBank::filter(TrajectorySet& set, const std::vector<double>& cutoffs_hz) const {
+    MM_TRACE_SCOPE("butterworth_filter");
+    if (static_cast<int>(cutoffs_hz.size()) != set.num_markers())
+        throw std::invalid_argument("ButterworthFilterBank: one cutoff per marker required");
+    if (set.frames() < 2) return;
+    const double fs = sample_rate(set);
+    const int sections = params_.order / 2;
+    std::vector<std::vector<Biquad>> designs(set.num_markers());
+    double lowest = std::numeric_limits<double>::infinity();
+    for (int m = 0; m < set.num_markers(); ++m) {
+        if (!std::isfinite(cutoffs_hz[m])) continue;
+        designs[m] = design_butterworth_lowpass(params_.order, cutoffs_hz[m], fs);
+        lowest = std::min(lowest, cutoffs_hz[m]);
+    }
+    if (!std::isfinite(lowest)) return;
+    // Long enough for the slowest filter's edge transient to die out.
+    const auto padding = static_cast<std::int64_t>(std::max(3.0 * (params_.order + 1), std::ceil(fs / lowest)));
+
+    for_each_group(set, [&](int g, Group& group) {
+        group.gather(set, g * kLanes, padding);
+        group.coeffs.assign(static_cast<std::size_t>(sections) * kCoeffStride, 0.0);
+        for (int l = 0; l < kLanes; ++l) {
+            const int column = g * kLanes + l;
+            set_lane(group.coeffs.data(), l, l < group.lanes ? designs[column / 3] : std::vector<Biquad>{}, sections);
+        }
+        filtfilt(level_, group.data.data(), set.frames() + 2 * group.pad, group.coeffs.data(), sections);
+        group.scatter(set);
+    });
+}
+
+std::vector<double> ButterworthFilterBank::residual_analysis(const TrajectorySet& set,
+                                                             const ResidualAnalysisParams& params) const {
+    MM_TRACE_SCOPE("butterworth_residual_analysis");
+    const double fs = sample_rate(set);
+    if (!(params.step_hz > 0.0 && params.min_hz > 0.0 && params.max_hz > params.min_hz))
+        throw std::invalid_argument("ButterworthFilterBank: bad residual sweep");
+    std::vector<double> cutoffs;
+    for (double fc = params.min_hz; fc <= params.max_hz + 1e-9 && fc < 0.5 * fs; fc += params.step_hz)
+        cutoffs.push_back(fc);
+    const int num_cutoffs = static_cast<int>(cutoffs.size());
+    const int columns = 3 * set.num_markers();
+    std::vector<double> result(set.num_markers(), std::numeric_limits<double>::quiet_NaN());
+    if (num_cutoffs < 3 || set.frames() < 2) return result;
+
+    // Squared residual sums per column and cutoff, plus sample counts.
+    std::vector<double> sums(static_cast<std::size_t>(columns) * num_cutoffs, 0.0);
+    std::vector<std::int64_t> counts(columns, 0);
+    const int sections = params_.order / 2;
+    const auto padding = static_cast<std::int64_t>(std::max(3.0 * (params_.order + 1), std::ceil(fs / cutoffs[0])));
+
+    for_each_group(set, [&](int g, Group& group) {
+        group.gather(set, g * kLanes, padding);
+        group.original = group.data;
+        group.coeffs.assign(static_cast<std::size_t>(sections) * kCoeffStride, 0.0);
+        for (int l = group.lanes; l < kLanes; ++l) set_lane(group.coeffs.data(), l, {}, sections);
+        for (int l = 0; l < group.lanes; ++l) {
+            const float* src = set.column((g * kLanes + l) / 3, (g * kLanes + l) % 3);
+            for (std::int64_t f = 0; f < set.frames(); ++f) counts[g * kLanes + l] += src[f] == src[f];
+        }
+        for (int i = 0; i < num_cutoffs; ++i) {
+            const std::vector<Biquad> design = design_butterworth_lowpass(params_.order, cutoffs[i], fs);
+            for (int l = 0; l < group.lanes; ++l) set_lane(group.coeffs.data(), l, design, sections);
+            std::copy(group.original.begin(), group.original.end(), group.data.begin());
+            filtfilt(level_, group.data.data(), set.frames() + 2 * group.pad, group.coeffs.data(), sections);
+            for (int l = 0; l < group.lanes; ++l) {
+                const float* src = set.column((g * kLanes + l) / 3, (g * kLanes + l) % 3);
+                double sum = 0.0;
+                for (std::int64_t f = 0; f < set.frames(); ++f) {
+                    if (src[f] != src[f]) continue;
+                    const double d = group.sample(f)[l] - src[f];
+                    sum += d * d;
+                }
+                sums[static_cast<std::size_t>(g * kLanes + l) * num_cutoffs + i] = sum;
+            }
+        }
+    });
+
+    const double fit_from = params.noise_fit_from_hz > 0.0 ? params.noise_fit_from_hz
+                                                           : 0.5 * (cutoffs.front() + cutoffs.back());
+    std::vector<double> residual(num_cutoffs);
+    for (int m = 0; m < set.num_markers(); ++m) {
+        const std::int64_t n = counts[3 * m] + counts[3 * m + 1] + counts[3 * m + 2];
+        if (n == 0) continue;
+        for (int i = 0; i < num_cutoffs; ++i) {
+            double sum = 0.0;
+            for (int axis = 0; axis < 3; ++axis) sum += sums[static_cast<std::size_t>(3 * m + axis) * num_cutoffs + i];
+            residual[i] = std::sqrt(sum / static_cast<double>(n));
+        }
+        // Least-squares line through the noise-dominated tail.
+        double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+        int k = 0;
+        for (int i = 0; i < num_cutoffs; ++i) {
+            if (cutoffs[i] < fit_from) continue;
+            sx += cutoffs[i];
+            sy += residual[i];
+            sxx += cutoffs[i] * cutoffs[i];
+            sxy += cutoffs[i] * residual[i];
+            ++k;
+        }
+        const double denom = k * sxx - sx * sx;
+        const double intercept = k >= 2 && denom > 0.0 ? (sy * sxx - sx * sxy) / denom : residual.back();
+        double chosen = cutoffs.back();
+        for (int i = 0; i < num_cutoffs; ++i) {
+            if (residual[i] > intercept) continue;
+            chosen = i == 0 ? cutoffs[0]
+                            : cutoffs[i - 1] + (residual[i - 1] - intercept) / (residual[i - 1] - residual[i]) *
+                                                   (cutoffs[i] - cutoffs[i - 1]);
+            break;
+        }
+        result[m] = chosen;
+    }
+    return result;
+}
+
+}  // namespace mm::trajectory
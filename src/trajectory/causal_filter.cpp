@@ -0,0 +1,188 @@
+#include "motionmetrics/trajectory/causal_filter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::trajectory {
+namespace {
+
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+/// Smoothing factor of a first-order low-pass at `cutoff_hz` for step `dt`.
+double smoothing(double cutoff_hz, double dt) {
+    const double r = 2.0 * M_PI * cutoff_hz * dt;
+    return r / (r + 1.0);
+}
+
+}  // namespace
+
+CausalMarkerFilter::CausalMarkerFilter(int num_markers, CausalFilterParams params)
+    : num_markers_(num_markers), params_(params) {
+    if (num_markers < 0) throw std::invalid_argument("CausalMarkerFilter: negative marker count");
+    if (params.min_cutoff_hz <= 0.0 || params.derivative_cutoff_hz <= 0.0 || params.beta < 0.0)
+        throw std::invalid_argument("CausalMarkerFilter: invalid one-euro parameters");
+    if (params.process_noise <= 0.0 || params.measurement_noise <= 0.0)
+        throw std::invalid_argument("CausalMarkerFilter: noise variances must be positive");
+    const std::size_t channels = static_cast<std::size_t>(num_markers) * 3;
+    x_.resize(channels);
+    v_.resize(channels);
+    a_.resize(channels);
+    for (auto* p : {&p00_, &p01_, &p02_, &p11_, &p12_, &p22_, &elapsed_}) p->resize(num_markers);
+    missed_.resize(num_markers);
+    active_.resize(num_markers);
+    out_position_.resize(channels);
+    out_velocity_.resize(channels);
+    out_acceleration_.resize(channels);
+    reset();
+}
+
+void CausalMarkerFilter::reset() {
+    last_timestamp_.reset();
+    std::fill(active_.begin(), active_.end(), 0);
+    std::fill(missed_.begin(), missed_.end(), 0);
+    std::fill(out_position_.begin(), out_position_.end(), kNaN);
+    std::fill(out_velocity_.begin(), out_velocity_.end(), kNaN);
+    std::fill(out_acceleration_.begin(), out_acceleration_.end(), kNaN);
+}
+
+void CausalMarkerFilter::update(TimestampNs timestamp, const float* xyz) {
+    MM_TRACE_SCOPE("causal_filter");
+    if (last_timestamp_ && timestamp <= *last_timestamp_) return;
+    const double dt = last_timestamp_ ? static_cast<double>(timestamp - *last_timestamp_) * 1e-9 : 0.0;
+    last_timestamp_ = timestamp;
+    if (params_.mode == CausalFilterMode::kalman)
+        update_kalman(dt, xyz);
+    else
+        update_one_euro(dt, xyz);
+}
+
+void CausalMarkerFilter::update_one_euro(double dt, const float* xyz) {
+    for (int m = 0; m < num_markers_; ++m) {
+        const float* z = xyz + m * 3;
+        const bool observed = z[0] == z[0];
+        if (!observed) {
+            elapsed_[m] += dt;
+            if (active_[m] && ++missed_[m] > params_.max_missed) active_[m] = 0;
+            publish(m, false);
+            continue;
+        }
+        double* x = &x_[m * 3];
+        double* v = &v_[m * 3];
+        double* a = &a_[m * 3];
+        if (!active_[m]) {
+            for (int k = 0; k < 3; ++k) {
+                x[k] = z[k];
+                v[k] = 0.0;
+                a[k] = 0.0;
+            }
+            active_[m] = 1;
+        } else {
+            // A step across missed frames spans the whole interval.
+            const double step = elapsed_[m] + dt;
+            const double alpha_d = smoothing(params_.derivative_cutoff_hz, step);
+            const double speed = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            const double alpha = smoothing(params_.min_cutoff_hz + params_.beta * speed, step);
+            for (int k = 0; k < 3; ++k) {
+                const double x_new = x[k] + alpha * (z[k] - x[k]);
+                const double v_new = v[k] + alpha_d * ((x_new - x[k]) / step - v[k]);
+                a[k] += alpha_d * ((v_new - v[k]) / step - a[k]);
+                v[k] = v_new;
+                x[k] = x_new;
+            }
+        }
+        missed_[m] = 0;
+        elapsed_[m] = 0.0;
+        publish(m, true);
+    }
+}
+
+void CausalMarkerFilter::update_kalman(double dt, const float* xyz) {
+    // Transition F = [1 t h; 0 1 t; 0 0 1] with h = t^2 / 2 and the
+    // white-jerk process noise, the same for every marker this frame.
+    const double t = dt;
+    const double h = 0.5 * t * t;
+    const double q = params_.process_noise;
+    const double t2 = t * t;
+    const double t3 = t2 * t;
+    const double q00 = q * t3 * t2 / 20.0, q01 = q * t2 * t2 / 8.0, q02 = q * t3 / 6.0;
+    const double q11 = q * t3 / 3.0, q12 = q * t2 / 2.0, q22 = q * t;
+    const double r = params_.measurement_noise;
+
+    for (int m = 0; m < num_markers_; ++m) {
+        const float* z = xyz + m * 3;
+        const bool observed = z[0] == z[0];
+        double* x = &x_[m * 3];
+        double* v = &v_[m * 3];
+        double* a = &a_[m * 3];
+
+        if (active_[m] && dt > 0.0) {
+            for (int k = 0; k < 3; ++k) {
+                x[k] += t * v[k] + h * a[k];
+                v[k] += t * a[k];
+            }
+            // F P F^T + Q, via the rows of F P.
+            const double r00 = p00_[m] + t * p01_[m] + h * p02_[m];
+            const double r01 = p01_[m] + t * p11_[m] + h * p12_[m];
+            const double r02 = p02_[m] + t * p12_[m] + h * p22_[m];
+            const double r11 = p11_[m] + t * p12_[m];
+            const double r12 = p12_[m] + t * p22_[m];
+            p00_[m] = r00 + t * r01 + h * r02 + q00;
+            p01_[m] = r01 + t * r02 + q01;
+            p02_[m] = r02 + q02;
+            p11_[m] = r11 + t * r12 + q11;
+            p12_[m] = r12 + q12;
+            p22_[m] += q22;
+        }
+
+        if (!observed) {
+            if (active_[m] && ++missed_[m] > params_.max_missed) active_[m] = 0;
+            publish(m, active_[m] != 0);
+            continue;
+        }
+        if (!active_[m]) {
+            for (int k = 0; k < 3; ++k) {
+                x[k] = z[k];
+                v[k] = 0.0;
+                a[k] = 0.0;
+            }
+            p00_[m] = r;
+            p01_[m] = p02_[m] = p12_[m] = 0.0;
+            p11_[m] = params_.initial_velocity_variance;
+            p22_[m] = params_.initial_acceleration_variance;
+            active_[m] = 1;
+        } else {
+            const double s = 1.0 / (p00_[m] + r);
+            const double k0 = p00_[m] * s, k1 = p01_[m] * s, k2 = p02_[m] * s;
+            for (int k = 0; k < 3; ++k) {
+                const double innovation = z[k] - x[k];
+                x[k] += k0 * innovation;
+                v[k] += k1 * innovation;
+                a[k] += k2 * innovation;
+            }
+            const double p00 = p00_[m], p01 = p01_[m], p02 = p02_[m];
+            p00_[m] -= k0 * p00;
+            p01_[m] -= k0 * p01;
+            p02_[m] -= k0 * p02;
+            p11_[m] -= k1 * p01;
+            p12_[m] -= k1 * p02;
+            p22_[m] -= k2 * p02;
+        }
+        missed_[m] = 0;
+        publish(m, true);
+    }
+}
+
+void CausalMarkerFilter::publish(int marker, bool has_estimate) {
+    for (int k = 0; k < 3; ++k) {
+        const int c = marker * 3 + k;
+        out_position_[c] = has_estimate ? static_cast<float>(x_[c]) : kNaN;
+        out_velocity_[c] = has_estimate ? static_cast<float>(v_[c]) : kNaN;
+        out_acceleration_[c] = has_estimate ? static_cast<float>(a_[c]) : kNaN;
+    }
+}
+
+}  // namespace mm::trajectory
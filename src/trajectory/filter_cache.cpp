@@ -0,0 +1,237 @@
+#include "motionmetrics/trajectory/filter_cache.hpp"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "motionmetrics/core/atomic_file.hpp"
+#include "motionmetrics/core/mapped_file.hpp"
+#include "motionmetrics/core/trace.hpp"
+#include "motionmetrics/storage/session_store.hpp"
+
+namespace mm::trajectory {
+namespace {
+
+constexpr std::uint64_t kCutoffsMagic = 0x4d4d'4355'5446'3031ull;  // "MMCUTF01"
+
+struct CutoffsHeader {
+    std::uint64_t magic;
+    std::uint64_t key;
+    std::uint32_t count;
+    std::uint32_t reserved;
+};
+
+/// FNV-1a, fed field by field.
+class KeyHasher {
+public:
+    template <typename T>
+    void add(const T& value) {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        for (unsigned char b : bytes) hash_ = (hash_ ^ b) * 0x100'0000'01b3ull;
+    }
+    std::uint64_t value() const { return hash_; }
+
+private:
+    std::uint64_t hash_ = 0xcbf2'9ce4'8422'2325ull;
+};
+
+void add_spec(KeyHasher& h, const FilterSpec& spec) {
+    h.add(spec.butterworth.order);
+    h.add(spec.butterworth.sample_rate_hz);
+    h.add(spec.residual_analysis);
+    if (spec.residual_analysis) {
+        h.add(spec.residual.min_hz);
+        h.add(spec.residual.max_hz);
+        h.add(spec.residual.step_hz);
+        h.add(spec.residual.noise_fit_from_hz);
+    } else {
+        h.add(spec.cutoff_hz);
+    }
+}
+
+void add_version(KeyHasher& h, const struct ::stat& source) {
+    h.add(static_cast<std::int64_t>(source.st_size));
+    h.add(static_cast<std::int64_t>(source.st_mtim.tv_sec));
+    h.add(static_cast<std::int64_t>(source.st_mtim.tv_nsec));
+}
+
+/// Key of the persisted entry; independent of where the source lives.
+std::uint64_t spec_key(const struct ::stat& source, std::uint64_t session_id, const FilterSpec& spec) {
+    KeyHasher h;
+    add_version(h, source);
+    h.add(session_id);
+    add_spec(h, spec);
+    return h.value();
+}
+
+/// Key of the in-memory entry, computable from a stat alone.
+std::uint64_t memory_key(const struct ::stat& source, const FilterSpec& spec) {
+    KeyHasher h;
+    h.add(static_cast<std::uint64_t>(source.st_dev));
+    h.add(static_cast<std::uint64_t>(source.st_ino));
+    add_version(h, source);
+    add_spec(h, spec);
+    return h.value();
+}
+
+std::size_t session_bytes(const FilteredSession& session) {
+    const TrajectorySet& set = session.trajectories;
+    return static_cast<std::size_t>(set.frames()) *
+               (static_cast<std::size_t>(set.num_markers()) * 3 * sizeof(float) + sizeof(TimestampNs)) +
+           session.cutoffs_hz.size() * sizeof(double);
+}
+
+bool file_exists(const std::string& path) {
+    struct ::stat st;
+    return ::stat(path.c_str(), &st) == 0;
+}
+
+}  // namespace
+
+FilteredSessionCache::FilteredSessionCache(std::string directory, SimdLevel level, WorkStealingPool* pool,
+                                           std::size_t max_memory_bytes)
+    : directory_(std::move(directory)), level_(clamp_simd_level(level)), pool_(pool),
+      max_memory_bytes_(max_memory_bytes) {}
+
+std::shared_ptr<const FilteredSession> FilteredSessionCache::get(const std::string& session_path,
+                                                                 const FilterSpec& spec) {
+    MM_TRACE_SCOPE("filter_cache_get");
+    struct ::stat st;
+    if (::stat(session_path.c_str(), &st) != 0)
+        throw std::system_error(errno, std::generic_category(), "stat " + session_path);
+    const std::uint64_t mem_key = memory_key(st, spec);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            auto it = entries_.find(mem_key);
+            if (it != entries_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second->session;
+            }
+            // Another caller is producing this entry; wait for it rather than
+            // filtering and writing the same files twice.
+            if (in_flight_.insert(mem_key).second) break;
+            computed_.wait(lock);
+        }
+    }
+
+    std::shared_ptr<const FilteredSession> result;
+    try {
+        const storage::SessionReader reader(session_path);
+        const std::uint64_t key = spec_key(st, reader.session_id(), spec);
+        char name[40];
+        std::snprintf(name, sizeof(name), "%016" PRIx64 "-%016" PRIx64, reader.session_id(), key);
+        const std::string base = directory_ + "/" + name;
+
+        result = load(base, key);
+        if (result) {
+            disk_hits_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            auto session = std::make_shared<FilteredSession>();
+            session->trajectories = TrajectorySet::from_session(reader);
+            const ButterworthFilterBank bank(spec.butterworth, level_, pool_);
+            session->cutoffs_hz = spec.residual_analysis
+                                      ? bank.residual_analysis(session->trajectories, spec.residual)
+                                      : std::vector<double>(session->trajectories.num_markers(), spec.cutoff_hz);
+            bank.filter(session->trajectories, session->cutoffs_hz);
+            store(base, key, reader, *session);
+            result = std::move(session);
+        }
+    } catch (...) {
+        // Let a waiting caller try instead.
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_.erase(mem_key);
+        computed_.notify_all();
+        throw;
+    }
+
+    const std::size_t bytes = session_bytes(*result);
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_flight_.erase(mem_key);
+    computed_.notify_all();
+    lru_.push_front(Entry{mem_key, result, bytes});
+    entries_.emplace(mem_key, lru_.begin());
+    memory_bytes_ += bytes;
+    // Callers still holding an evicted result keep it alive.
+    while (memory_bytes_ > max_memory_bytes_ && lru_.size() > 1) {
+        const Entry& oldest = lru_.back();
+        memory_bytes_ -= oldest.bytes;
+        entries_.erase(oldest.key);
+        lru_.pop_back();
+    }
+    return result;
+}
+
+void FilteredSessionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+    memory_bytes_ = 0;
+}
+
+std::size_t FilteredSessionCache::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_bytes_;
+}
+
+std::shared_ptr<const FilteredSession> FilteredSessionCache::load(const std::string& base, std::uint64_t key) const {
+    // The cutoffs are published after the trajectories, so their presence
+    // means both are complete.
+    const std::string cutoffs_path = base + ".cutoffs";
+    if (!file_exists(cutoffs_path)) return nullptr;
+    try {
+        const MappedFile cutoffs(cutoffs_path);
+        CutoffsHeader header;
+        if (cutoffs.size() < sizeof(header)) return nullptr;
+        std::memcpy(&header, cutoffs.data(), sizeof(header));
+        if (header.magic != kCutoffsMagic || header.key != key ||
+            cutoffs.size() != sizeof(header) + header.count * sizeof(double))
+            return nullptr;
+
+        const storage::SessionReader reader(base + ".mms");
+        if (reader.num_markers() != static_cast<int>(header.count)) return nullptr;
+        auto session = std::make_shared<FilteredSession>();
+        session->trajectories = TrajectorySet::from_session(reader);
+        session->cutoffs_hz.resize(header.count);
+        std::memcpy(session->cutoffs_hz.data(), cutoffs.data() + sizeof(header), header.count * sizeof(double));
+        return session;
+    } catch (const std::runtime_error&) {
+        // Unreadable or corrupt entry: recompute and overwrite it.
+        return nullptr;
+    }
+}
+
+void FilteredSessionCache::store(const std::string& base, std::uint64_t key, const storage::SessionReader& source,
+                                 const FilteredSession& session) const {
+    const TrajectorySet& set = session.trajectories;
+    storage::SessionInfo info;
+    info.session_id = source.session_id();
+    info.athlete_id = source.athlete_id();
+    info.marker_names = set.marker_names();
+    storage::SessionWriter writer(base + ".mms", std::move(info));
+    std::vector<float> row(static_cast<std::size_t>(set.num_markers()) * 3);
+    for (std::int64_t f = 0; f < set.frames(); ++f) {
+        for (int m = 0; m < set.num_markers(); ++m)
+            for (int axis = 0; axis < 3; ++axis) row[m * 3 + axis] = set.column(m, axis)[f];
+        writer.append(set.timestamps()[f], row.data());
+    }
+    writer.close();
+
+    // Published last: its presence marks the entry complete.
+    const CutoffsHeader header{kCutoffsMagic, key, static_cast<std::uint32_t>(session.cutoffs_hz.size()), 0};
+    AtomicFile cutoffs(base + ".cutoffs");
+    cutoffs.write(&header, sizeof(header));
+    cutoffs.write(session.cutoffs_hz.data(), session.cutoffs_hz.size() * sizeof(double));
+    cutoffs.commit();
+}
+
+}  // namespace mm::trajectory
@@ -0,0 +1,338 @@
+#include "motionmetrics/trajectory/gap_filling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include "motionmetrics/core/linear_algebra.hpp"
+#include "motionmetrics/core/rigid_transform.hpp"
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::trajectory {
+namespace {
+
+/// Training frames below which no PCA model is built.
+constexpr int kMinTrainingFrames = 20;
+
+}  // namespace
+
+struct GapFiller::PcaModel {
+    std::vector<int> markers;  // modelled markers
+    std::vector<int> slot;     // per marker: index into `markers`, or -1
+    int dims = 0;
+    int components = 0;
+    std::vector<double> mean;        // dims
+    std::vector<double> basis;       // dims x components, row-major
+    std::vector<double> prior;       // noise variance / eigenvalue, per component
+};
+
+namespace {
+
+/// Per-worker state of the PCA pass. Consecutive frames usually share one
+/// missing pattern, so the factorised normal matrix is kept until it changes.
+struct PcaScratch {
+    std::vector<char> mask;
+    std::vector<char> factor_mask;
+    bool factor_valid = false;
+    std::vector<double> normal;
+    std::vector<double> rhs;
+    std::vector<Vec3d> estimate;
+};
+
+}  // namespace
+
+GapFiller::GapFiller(GapFillParams params, WorkStealingPool* pool) : params_(std::move(params)), pool_(pool) {
+    if (params_.max_spline_gap < 0 || params_.max_gap < 1)
+        throw std::invalid_argument("GapFiller: gap limits out of range");
+    if (!(params_.pca_variance > 0.0 && params_.pca_variance <= 1.0))
+        throw std::invalid_argument("GapFiller: pca_variance must be in (0, 1]");
+    if (!(params_.pca_min_presence >= 0.0 && params_.pca_min_presence <= 1.0))
+        throw std::invalid_argument("GapFiller: pca_min_presence must be in [0, 1]");
+    if (params_.pca_max_training_frames <= 0)
+        throw std::invalid_argument("GapFiller: pca_max_training_frames must be positive");
+}
+
+void GapFiller::find_gaps(const TrajectorySet& set, GapFillReport& report) {
+    const std::int64_t frames = set.frames();
+    present_.resize(static_cast<std::size_t>(set.num_markers()) * frames);
+    for (int m = 0; m < set.num_markers(); ++m) {
+        const float* x = set.column(m, 0);
+        std::uint8_t* present = present_.data() + static_cast<std::size_t>(m) * frames;
+        std::int64_t gap_begin = -1;
+        for (std::int64_t f = 0; f < frames; ++f) {
+            present[f] = x[f] == x[f];
+            if (!present[f] && gap_begin < 0) gap_begin = f;
+            if (present[f] && gap_begin >= 0) {
+                report.gaps.push_back({m, gap_begin, f, FillMethod::none});
+                gap_begin = -1;
+            }
+        }
+        if (gap_begin >= 0) report.gaps.push_back({m, gap_begin, frames, FillMethod::none});
+    }
+    for (const TrajectoryGap& gap : report.gaps) report.frames_missing += gap.length();
+}
+
+template <typename Fn>
+void GapFiller::run_pass(TrajectorySet& set, GapFillReport& report, FillMethod method, Fn&& fn) {
+    std::vector<int> open;
+    for (int i = 0; i < static_cast<int>(report.gaps.size()); ++i) {
+        const TrajectoryGap& gap = report.gaps[i];
+        if (gap.method == FillMethod::none && gap.begin > 0 && gap.end < set.frames() && gap.length() <= params_.max_gap)
+            open.push_back(i);
+    }
+    filled_.assign(open.size(), 0);
+    auto task = [&](int i) { filled_[i] = fn(report.gaps[open[i]]); };
+    const int n = static_cast<int>(open.size());
+    if (pool_ != nullptr) {
+        pool_->parallel_for(0, n, params_.grain, task);
+    } else {
+        for (int i = 0; i < n; ++i) task(i);
+    }
+    // Samples filled by this pass become inputs of the next one.
+    for (int i = 0; i < n; ++i) {
+        if (!filled_[i]) continue;
+        TrajectoryGap& gap = report.gaps[open[i]];
+        gap.method = method;
+        std::fill(present_.begin() + gap.marker * set.frames() + gap.begin,
+                  present_.begin() + gap.marker * set.frames() + gap.end, 1);
+        report.frames_filled += gap.length();
+    }
+}
+
+bool GapFiller::fill_spline(TrajectorySet& set, const TrajectoryGap& gap) const {
+    if (gap.length() > params_.max_spline_gap) return false;
+    const std::uint8_t* present = present_.data() + static_cast<std::size_t>(gap.marker) * set.frames();
+    const std::int64_t a = gap.begin - 1;
+    const std::int64_t b = gap.end;
+    const double span = static_cast<double>(b - a);
+    const Vec3d p0 = set.position(gap.marker, a);
+    const Vec3d p1 = set.position(gap.marker, b);
+    // Per-frame velocities at the edges from one-sided differences, falling
+    // back to the chord when the neighbouring sample is missing too.
+    const Vec3d chord = (p1 - p0) * (1.0 / span);
+    const Vec3d v0 = a > 0 && present[a - 1] ? p0 - set.position(gap.marker, a - 1) : chord;
+    const Vec3d v1 = b + 1 < set.frames() && present[b + 1] ? set.position(gap.marker, b + 1) - p1 : chord;
+    for (std::int64_t f = gap.begin; f < gap.end; ++f) {
+        const double t = static_cast<double>(f - a) / span;
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+        const double h00 = 2.0 * t3 - 3.0 * t2 + 1.0;
+        const double h10 = t3 - 2.0 * t2 + t;
+        const double h01 = -2.0 * t3 + 3.0 * t2;
+        const double h11 = t3 - t2;
+        set.set_position(gap.marker, f, p0 * h00 + v0 * (h10 * span) + p1 * h01 + v1 * (h11 * span));
+    }
+    return true;
+}
+
+bool GapFiller::fill_rigid(TrajectorySet& set, const TrajectoryGap& gap) const {
+    if (gap.marker >= static_cast<int>(segment_of_.size()) || segment_of_[gap.marker] < 0) return false;
+    const std::vector<int>& segment = params_.segments[segment_of_[gap.marker]];
+    const std::int64_t frames = set.frames();
+    auto present = [&](int marker, std::int64_t f) { return present_[static_cast<std::size_t>(marker) * frames + f] != 0; };
+
+    std::vector<Vec3d> from;
+    std::vector<Vec3d> to;
+    std::vector<Vec3d> estimate(gap.length());
+    // Carries the marker from reference frame `ref` to frame `f` with the
+    // motion of the segment markers visible in both.
+    auto carry = [&](std::int64_t ref, std::int64_t f, Vec3d& out) {
+        from.clear();
+        to.clear();
+        for (const int other : segment) {
+            if (other == gap.marker || !present(other, ref) || !present(other, f)) continue;
+            from.push_back(set.position(other, ref));
+            to.push_back(set.position(other, f));
+        }
+        RigidTransform motion;
+        if (!fit_rigid_transform(from.data(), to.data(), nullptr, static_cast<int>(from.size()), motion)) return false;
+        out = motion.apply(set.position(gap.marker, ref));
+        return true;
+    };
+
+    const std::int64_t a = gap.begin - 1;
+    const std::int64_t b = gap.end;
+    for (std::int64_t f = gap.begin; f < gap.end; ++f) {
+        Vec3d from_a;
+        Vec3d from_b;
+        const bool ok_a = carry(a, f, from_a);
+        const bool ok_b = carry(b, f, from_b);
+        if (!ok_a && !ok_b) return false;
+        const double w = static_cast<double>(f - a) / static_cast<double>(b - a);
+        estimate[f - gap.begin] = ok_a && ok_b ? from_a * (1.0 - w) + from_b * w : (ok_a ? from_a : from_b);
+    }
+    for (std::int64_t f = gap.begin; f < gap.end; ++f) set.set_position(gap.marker, f, estimate[f - gap.begin]);
+    return true;
+}
+
+void GapFiller::build_pca(const TrajectorySet& set, PcaModel& model) const {
+    MM_TRACE_SCOPE("gap_fill_pca_model");
+    const std::int64_t frames = set.frames();
+    model.slot.assign(set.num_markers(), -1);
+    for (int m = 0; m < set.num_markers(); ++m) {
+        const std::uint8_t* present = present_.data() + static_cast<std::size_t>(m) * frames;
+        const std::int64_t count = std::count(present, present + frames, std::uint8_t{1});
+        if (count >= params_.pca_min_presence * static_cast<double>(frames) && count > 0) {
+            model.slot[m] = static_cast<int>(model.markers.size());
+            model.markers.push_back(m);
+        }
+    }
+    model.dims = 3 * static_cast<int>(model.markers.size());
+    if (model.dims == 0) return;
+
+    std::vector<std::int64_t> training;
+    for (std::int64_t f = 0; f < frames; ++f) {
+        bool complete = true;
+        for (const int m : model.markers) complete = complete && present_[static_cast<std::size_t>(m) * frames + f];
+        if (complete) training.push_back(f);
+    }
+    if (static_cast<int>(training.size()) < kMinTrainingFrames) return;
+    const std::size_t step = (training.size() + params_.pca_max_training_frames - 1) / params_.pca_max_training_frames;
+
+    const int d = model.dims;
+    model.mean.assign(d, 0.0);
+    std::vector<double> row(d);
+    std::vector<double> cov(static_cast<std::size_t>(d) * d, 0.0);
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < training.size(); i += step, ++n)
+        for (int k = 0; k < d; ++k) model.mean[k] += set.column(model.markers[k / 3], k % 3)[training[i]];
+    for (double& x : model.mean) x /= static_cast<double>(n);
+    for (std::size_t i = 0; i < training.size(); i += step) {
+        for (int k = 0; k < d; ++k) row[k] = set.column(model.markers[k / 3], k % 3)[training[i]] - model.mean[k];
+        for (int r = 0; r < d; ++r)
+            for (int c = r; c < d; ++c) cov[r * d + c] += row[r] * row[c];
+    }
+    for (int r = 0; r < d; ++r)
+        for (int c = r; c < d; ++c) cov[c * d + r] = cov[r * d + c] /= static_cast<double>(n);
+
+    std::vector<double> vectors(static_cast<std::size_t>(d) * d);
+    jacobi_eigen(cov.data(), d, vectors.data());
+    std::vector<int> order(d);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return cov[a * d + a] > cov[b * d + b]; });
+    double total = 0.0;
+    for (int k = 0; k < d; ++k) total += std::max(0.0, cov[k * d + k]);
+    if (!(total > 0.0)) return;
+    int kept = 0;
+    double explained = 0.0;
+    while (kept < d && explained < params_.pca_variance * total) {
+        const int e = order[kept++];
+        explained += std::max(0.0, cov[e * d + e]);
+    }
+
+    // Probabilistic PCA: the discarded variance, spread over the remaining
+    // dimensions, is the observation noise that the component priors are
+    // weighed against when fitting a partial frame.
+    const double noise = std::max((total - explained) / std::max(1, d - kept), 1e-10);
+    model.components = kept;
+    model.basis.resize(static_cast<std::size_t>(d) * kept);
+    model.prior.resize(kept);
+    for (int j = 0; j < kept; ++j) {
+        const int e = order[j];
+        for (int k = 0; k < d; ++k) model.basis[k * kept + j] = vectors[k * d + e];
+        model.prior[j] = noise / std::max(cov[e * d + e], noise);
+    }
+}
+
+GapFillReport GapFiller::fill(TrajectorySet& set) {
+    MM_TRACE_SCOPE("gap_fill");
+    GapFillReport report;
+    find_gaps(set, report);
+
+    segment_of_.assign(set.num_markers(), -1);
+    for (int s = 0; s < static_cast<int>(params_.segments.size()); ++s) {
+        for (const int m : params_.segments[s]) {
+            if (m < 0 || m >= set.num_markers()) throw std::out_of_range("GapFiller: segment marker out of range");
+            segment_of_[m] = s;
+        }
+    }
+
+    run_pass(set, report, FillMethod::spline, [&](const TrajectoryGap& gap) { return fill_spline(set, gap); });
+    if (!params_.segments.empty())
+        run_pass(set, report, FillMethod::rigid, [&](const TrajectoryGap& gap) { return fill_rigid(set, gap); });
+
+    const bool pending = std::any_of(report.gaps.begin(), report.gaps.end(), [&](const TrajectoryGap& gap) {
+        return gap.method == FillMethod::none && gap.begin > 0 && gap.end < set.frames();
+    });
+    if (!pending) return report;
+    PcaModel model;
+    build_pca(set, model);
+    report.pca_components = model.components;
+    if (model.components == 0) return report;
+
+    std::vector<PcaScratch> scratch(pool_ != nullptr ? pool_->size() + 1 : 1);
+    const std::int64_t frames = set.frames();
+    const int k = model.components;
+    run_pass(set, report, FillMethod::pca, [&](const TrajectoryGap& gap) {
+        const int slot = model.slot[gap.marker];
+        if (slot < 0) return false;
+        PcaScratch& s = scratch[pool_ != nullptr ? pool_->current_slot() : 0];
+        s.factor_valid = false;
+        s.mask.resize(model.markers.size());
+        s.rhs.resize(k);
+        s.estimate.resize(gap.length() + 2);
+
+        // Estimates the marker at frame f from the other modelled markers.
+        auto estimate = [&](std::int64_t f, Vec3d& out) {
+            int observed = 0;
+            for (std::size_t i = 0; i < model.markers.size(); ++i) {
+                s.mask[i] = static_cast<int>(i) != slot &&
+                            present_[static_cast<std::size_t>(model.markers[i]) * frames + f];
+                observed += s.mask[i];
+            }
+            if (3 * observed < k) return false;
+            if (!s.factor_valid || s.mask != s.factor_mask) {
+                s.normal.assign(static_cast<std::size_t>(k) * k, 0.0);
+                for (std::size_t i = 0; i < model.markers.size(); ++i) {
+                    if (!s.mask[i]) continue;
+                    for (int r = 3 * static_cast<int>(i); r < 3 * static_cast<int>(i) + 3; ++r) {
+                        const double* w = model.basis.data() + static_cast<std::size_t>(r) * k;
+                        for (int a = 0; a < k; ++a)
+                            for (int b = 0; b <= a; ++b) s.normal[a * k + b] += w[a] * w[b];
+                    }
+                }
+                for (int a = 0; a < k; ++a) s.normal[a * k + a] += model.prior[a];
+                if (!cholesky(s.normal.data(), k, k)) return false;
+                s.factor_mask = s.mask;
+                s.factor_valid = true;
+            }
+            std::fill(s.rhs.begin(), s.rhs.end(), 0.0);
+            for (std::size_t i = 0; i < model.markers.size(); ++i) {
+                if (!s.mask[i]) continue;
+                for (int axis = 0; axis < 3; ++axis) {
+                    const int r = 3 * static_cast<int>(i) + axis;
+                    const double y = set.column(model.markers[i], axis)[f] - model.mean[r];
+                    const double* w = model.basis.data() + static_cast<std::size_t>(r) * k;
+                    for (int a = 0; a < k; ++a) s.rhs[a] += w[a] * y;
+                }
+            }
+            cholesky_solve(s.normal.data(), k, k, s.rhs.data());
+            for (int axis = 0; axis < 3; ++axis) {
+                const int r = 3 * slot + axis;
+                const double* w = model.basis.data() + static_cast<std::size_t>(r) * k;
+                double v = model.mean[r];
+                for (int a = 0; a < k; ++a) v += w[a] * s.rhs[a];
+                out[axis] = v;
+            }
+            return true;
+        };
+
+        // Estimates at both edges, where the true position is known, give
+        // the model's offset; it is cross-faded across the gap.
+        const std::int64_t a = gap.begin - 1;
+        const std::int64_t b = gap.end;
+        for (std::int64_t f = a; f <= b; ++f)
+            if (!estimate(f, s.estimate[f - a])) return false;
+        const Vec3d offset_a = set.position(gap.marker, a) - s.estimate.front();
+        const Vec3d offset_b = set.position(gap.marker, b) - s.estimate.back();
+        for (std::int64_t f = gap.begin; f < gap.end; ++f) {
+            const double w = static_cast<double>(f - a) / static_cast<double>(b - a);
+            set.set_position(gap.marker, f, s.estimate[f - a] + offset_a * (1.0 - w) + offset_b * w);
+        }
+        return true;
+    });
+    return report;
+}
+
+}  // namespace mm::trajectory
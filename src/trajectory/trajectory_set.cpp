@@ -0,0 +1,36 @@
+#include "motionmetrics/trajectory/trajectory_set.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace mm::trajectory {
+
+TrajectorySet::TrajectorySet(std::vector<std::string> marker_names, std::int64_t frames)
+    : marker_names_(std::move(marker_names)), frames_(frames) {
+    if (frames < 0) throw std::invalid_argument("TrajectorySet: negative frame count");
+    stride_ = align_up(static_cast<std::size_t>(frames) * sizeof(float), kCacheLineSize) / sizeof(float);
+    columns_ = AlignedBuffer(stride_ * marker_names_.size() * 3 * sizeof(float));
+    std::fill_n(columns_.as<float>(), stride_ * marker_names_.size() * 3, std::numeric_limits<float>::quiet_NaN());
+    timestamps_.assign(frames, 0);
+}
+
+TrajectorySet TrajectorySet::from_session(const storage::SessionReader& reader) {
+    TrajectorySet set(reader.marker_names(), reader.frames());
+    for (int m = 0; m < set.num_markers(); ++m)
+        for (int axis = 0; axis < 3; ++axis) reader.read_column(m, axis, set.column(m, axis));
+    for (int c = 0; c < reader.num_chunks(); ++c) {
+        const storage::SessionChunk& chunk = reader.chunk(c);
+        std::copy_n(chunk.timestamps, chunk.frames, set.timestamps_.begin() + chunk.first_frame);
+    }
+    return set;
+}
+
+int TrajectorySet::marker_index(const std::string& name) const {
+    for (int i = 0; i < num_markers(); ++i)
+        if (marker_names_[i] == name) return i;
+    return -1;
+}
+
+}  // namespace mm::trajectory
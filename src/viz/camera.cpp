@@ -0,0 +1,71 @@
+#include "motionmetrics/viz/camera.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace mm::viz {
+
+Camera::Camera(const Vec3d& eye, const Vec3d& target, double vertical_fov, int width, int height, double near,
+               double far, const Vec3d& up)
+    : eye_(eye), width_(width), height_(height), near_(near), far_(far) {
+    if (width <= 0 || height <= 0) throw std::invalid_argument("Camera: non-positive viewport");
+    if (!(vertical_fov > 0.0 && vertical_fov < 3.1) || !(near > 0.0) || !(far > near))
+        throw std::invalid_argument("Camera: invalid field of view or clip range");
+    const Vec3d view = target - eye;
+    if (!(norm(view) > 0.0)) throw std::invalid_argument("Camera: eye and target coincide");
+    forward_ = normalized(view);
+    right_ = cross(forward_, up);
+    if (!(norm(right_) > 1e-9)) throw std::invalid_argument("Camera: up vector along the view");
+    right_ = normalized(right_);
+    up_ = cross(right_, forward_);
+
+    const double tan_v = std::tan(vertical_fov * 0.5);
+    const double tan_h = tan_v * width / height;
+    focal_ = height * 0.5 / tan_v;
+    cx_ = width * 0.5;
+    cy_ = height * 0.5;
+    planes_ = {normalized(Vec3d{1.0, 0.0, tan_h}), normalized(Vec3d{-1.0, 0.0, tan_h}),
+               normalized(Vec3d{0.0, 1.0, tan_v}), normalized(Vec3d{0.0, -1.0, tan_v})};
+}
+
+bool Camera::project(const Vec3d& p, float& x, float& y, float& depth) const {
+    const Vec3d v = to_view(p);
+    if (!(v.z >= near_)) return false;
+    to_screen(v, x, y);
+    depth = static_cast<float>(v.z);
+    return true;
+}
+
+bool Camera::sphere_visible(const Vec3d& centre, double radius) const {
+    const Vec3d v = to_view(centre);
+    if (v.z + radius < near_ || v.z - radius > far_) return false;
+    for (const Vec3d& n : planes_)
+        if (dot(n, v) < -radius) return false;
+    return true;
+}
+
+std::array<float, 16> Camera::view_projection() const {
+    // Rows of the view matrix: right, up, -forward (GL looks down -z).
+    const Vec3d rows[3] = {right_, up_, -forward_};
+    const double f = focal_ / cy_;
+    const double sx = f * cy_ / cx_;
+    const double a = (far_ + near_) / (near_ - far_);
+    const double b = 2.0 * far_ * near_ / (near_ - far_);
+    double view[3][4];
+    for (int r = 0; r < 3; ++r) {
+        view[r][0] = rows[r].x;
+        view[r][1] = rows[r].y;
+        view[r][2] = rows[r].z;
+        view[r][3] = -dot(rows[r], eye_);
+    }
+    std::array<float, 16> out{};
+    for (int c = 0; c < 4; ++c) {
+        out[c * 4 + 0] = static_cast<float>(sx * view[0][c]);
+        out[c * 4 + 1] = static_cast<float>(f * view[1][c]);
+        out[c * 4 + 2] = static_cast<float>(a * view[2][c] + (c == 3 ? b : 0.0));
+        out[c * 4 + 3] = static_cast<float>(-view[2][c]);
+    }
+    return out;
+}
+
+}  // namespace mm::viz
@@ -0,0 +1,178 @@
+#include "motionmetrics/viz/playback_cursor.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::viz {
+namespace {
+
+/// Faults in every page of a chunk so the UI thread never waits on the disk
+/// for it; the kernel read-ahead hint alone is asynchronous.
+void touch_pages(const storage::SessionChunk& chunk, int num_markers) {
+    static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    // Step from the start of the page holding the chunk's first byte so the
+    // last page is reached too; the mapping itself is page aligned.
+    const auto first = reinterpret_cast<std::uintptr_t>(chunk.timestamps);
+    const auto* begin = reinterpret_cast<const volatile std::byte*>(first - first % page);
+    const auto* end = reinterpret_cast<const volatile std::byte*>(chunk.column(num_markers, 0));
+    for (const volatile std::byte* p = begin; p < end; p += page) static_cast<void>(*p);
+}
+
+}  // namespace
+
+PlaybackCursor::PlaybackCursor(const storage::SessionReader& session, PlaybackConfig config)
+    : session_(session), config_(config) {
+    if (config_.chunks_ahead < 0 || config_.chunks_behind < 0)
+        throw std::invalid_argument("PlaybackCursor: negative prefetch window");
+    thread_ = std::thread([this] { prefetch_loop(); });
+}
+
+PlaybackCursor::~PlaybackCursor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+int PlaybackCursor::add_video(std::unique_ptr<capture::VideoDecoder> decoder) {
+    if (!decoder) throw std::invalid_argument("PlaybackCursor: null decoder");
+    Video video;
+    const std::int64_t frames = decoder->frame_count();
+    video.timestamps.reserve(static_cast<std::size_t>(frames));
+    for (std::int64_t f = 0; f < frames; ++f) {
+        video.timestamps.push_back(decoder->timestamp(f));
+        if (decoder->is_keyframe(f)) video.keyframes.push_back(f);
+    }
+    video.stride = static_cast<std::ptrdiff_t>(align_up(static_cast<std::size_t>(decoder->width()), kCacheLineSize));
+    video.image = AlignedBuffer(video.stride * decoder->height());
+    video.decoder = std::move(decoder);
+    videos_.push_back(std::move(video));
+    return num_videos() - 1;
+}
+
+std::int64_t PlaybackCursor::seek(TimestampNs timestamp) {
+    MM_TRACE_SCOPE("playback_seek");
+    ++seeks_;
+    timestamp_ = timestamp;
+    const std::int64_t frame = session_.frame_at(timestamp);
+    const std::int64_t previous = frame_;
+    frame_ = frame;
+    if (frame < 0) return frame;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        target_chunk_ = session_.chunk_of(frame);
+        if (previous >= 0 && frame != previous) direction_ = frame > previous ? 1 : -1;
+        ++request_;
+    }
+    wake_.notify_one();
+    return frame;
+}
+
+void PlaybackCursor::read_pose(float* xyz) const {
+    if (frame_ < 0) throw std::logic_error("PlaybackCursor: no frame at the playhead");
+    session_.read_frame(frame_, xyz);
+}
+
+bool PlaybackCursor::read_video(int index, std::uint8_t* out, std::ptrdiff_t stride) {
+    Video& video = videos_.at(index);
+    const auto after = std::upper_bound(video.timestamps.begin(), video.timestamps.end(), timestamp_);
+    if (after == video.timestamps.begin()) return false;
+    const std::int64_t target = after - video.timestamps.begin() - 1;
+    const auto key_after = std::upper_bound(video.keyframes.begin(), video.keyframes.end(), target);
+    if (key_after == video.keyframes.begin()) return false;  // nothing decodable before the first keyframe
+    const std::int64_t keyframe = *(key_after - 1);
+
+    if (target != video.current) {
+        // Keep decoding forward when that is no further than from the keyframe.
+        if (!(video.next > keyframe && video.next <= target)) {
+            video.decoder->seek(keyframe);
+            video.next = keyframe;
+        }
+        MM_TRACE_SCOPE("playback_decode_video");
+        while (video.next <= target) {
+            if (!video.decoder->decode(video.image.as<std::uint8_t>(), video.stride)) {
+                video.next = video.current = -1;
+                return false;
+            }
+            ++video.next;
+            ++video_frames_decoded_;
+        }
+        video.current = target;
+    }
+    const std::uint8_t* image = video.image.as<std::uint8_t>();
+    const auto width = static_cast<std::size_t>(video.decoder->width());
+    for (int y = 0; y < video.decoder->height(); ++y) std::memcpy(out + y * stride, image + y * video.stride, width);
+    return true;
+}
+
+PlaybackStats PlaybackCursor::stats() const {
+    PlaybackStats s;
+    s.seeks = seeks_;
+    s.chunks_prefetched = chunks_prefetched_.load(std::memory_order_relaxed);
+    s.chunks_released = chunks_released_.load(std::memory_order_relaxed);
+    s.video_frames_decoded = video_frames_decoded_;
+    return s;
+}
+
+void PlaybackCursor::prefetch_loop() {
+    const int chunks = session_.num_chunks();
+    const int markers = session_.num_markers();
+    std::vector<char> resident(static_cast<std::size_t>(chunks), 0);
+    std::vector<int> resident_list;
+    std::uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [&] { return stop_ || request_ != seen; });
+        if (stop_) return;
+        seen = request_;
+        const int centre = target_chunk_;
+        const int direction = direction_;
+        lock.unlock();
+
+        // Window of chunks to hold, ordered nearest first in the direction
+        // of travel, then the few behind.
+        const int ahead_lo = direction > 0 ? centre : centre - config_.chunks_ahead;
+        const int ahead_hi = direction > 0 ? centre + config_.chunks_ahead : centre;
+        const int lo = std::max(0, direction > 0 ? ahead_lo - config_.chunks_behind : ahead_lo);
+        const int hi = std::min(chunks - 1, direction > 0 ? ahead_hi : ahead_hi + config_.chunks_behind);
+
+        // Release what fell out of the window first, so memory stays bounded
+        // during long scrubs.
+        resident_list.erase(std::remove_if(resident_list.begin(), resident_list.end(),
+                                           [&](int c) {
+                                               if (c >= lo && c <= hi) return false;
+                                               session_.advise_chunk(c, MappedFile::Access::dont_need);
+                                               resident[c] = 0;
+                                               chunks_released_.fetch_add(1, std::memory_order_relaxed);
+                                               return true;
+                                           }),
+                            resident_list.end());
+
+        const int ahead_count = config_.chunks_ahead + 1;
+        for (int step = 0; step < ahead_count + config_.chunks_behind; ++step) {
+            // centre, centre +- 1, ... in the direction of travel, then behind.
+            const int c = step < ahead_count ? centre + direction * step
+                                             : centre - direction * (step - ahead_count + 1);
+            if (c < lo || c > hi || resident[c]) continue;
+            session_.advise_chunk(c, MappedFile::Access::will_need);
+            touch_pages(session_.chunk(c), markers);
+            resident[c] = 1;
+            resident_list.push_back(c);
+            chunks_prefetched_.fetch_add(1, std::memory_order_relaxed);
+            // A newer seek replaces this plan.
+            std::lock_guard<std::mutex> check(mutex_);
+            if (request_ != seen || stop_) break;
+        }
+        lock.lock();
+    }
+}
+
+}  // namespace mm::viz
@@ -0,0 +1,152 @@
+#include "motionmetrics/viz/render_batch.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace mm::viz {
+
+bool RenderBatch::begin_strip() {
+    end_strip();
+    if (num_trail_strips_ == capacity_.trail_strips) {
+        ++overflow_;
+        return false;
+    }
+    trail_strips_[num_trail_strips_++] = {num_trail_vertices_, 0};
+    strip_open_ = true;
+    return true;
+}
+
+void RenderBatch::end_strip() {
+    if (!strip_open_) return;
+    strip_open_ = false;
+    const TrailStrip& strip = trail_strips_[num_trail_strips_ - 1];
+    if (strip.count < 2) {
+        num_trail_vertices_ = strip.first;
+        --num_trail_strips_;
+    }
+}
+
+RenderBatch::Layout RenderBatch::layout_for(const BatchCapacity& capacity) {
+    Layout layout;
+    std::size_t offset = 0;
+    auto take = [&](std::size_t bytes) {
+        const std::size_t at = offset;
+        offset = align_up(offset + bytes, kCacheLineSize);
+        return at;
+    };
+    layout.markers = take(std::size_t{capacity.markers} * sizeof(MarkerInstance));
+    layout.bones = take(std::size_t{capacity.bones} * sizeof(BoneInstance));
+    layout.trail_vertices = take(std::size_t{capacity.trail_vertices} * sizeof(TrailVertex));
+    layout.trail_strips = take(std::size_t{capacity.trail_strips} * sizeof(TrailStrip));
+    layout.bytes = offset;
+    return layout;
+}
+
+std::size_t BatchRing::storage_bytes(const BatchCapacity& capacity, int slots) {
+    return RenderBatch::layout_for(capacity).bytes * static_cast<std::size_t>(slots);
+}
+
+BatchRing::BatchRing(const BatchCapacity& capacity, int slots) {
+    if (slots < 2) throw std::invalid_argument("BatchRing: need at least two slots");
+    owned_ = AlignedBuffer(storage_bytes(capacity, slots));
+    bind(capacity, slots, owned_.data());
+}
+
+BatchRing::BatchRing(const BatchCapacity& capacity, int slots, std::byte* storage) {
+    if (slots < 2) throw std::invalid_argument("BatchRing: need at least two slots");
+    if (storage == nullptr || reinterpret_cast<std::uintptr_t>(storage) % kCacheLineSize != 0)
+        throw std::invalid_argument("BatchRing: storage must be cache-line aligned");
+    bind(capacity, slots, storage);
+}
+
+void BatchRing::bind(const BatchCapacity& capacity, int slots, std::byte* storage) {
+    storage_ = storage;
+    const RenderBatch::Layout layout = RenderBatch::layout_for(capacity);
+    batches_.resize(static_cast<std::size_t>(slots));
+    slots_ = std::make_unique<Slot[]>(static_cast<std::size_t>(slots));
+    for (int i = 0; i < slots; ++i) {
+        RenderBatch& b = batches_[i];
+        b.capacity_ = capacity;
+        b.layout_ = layout;
+        b.offset_ = layout.bytes * static_cast<std::size_t>(i);
+        std::byte* base = storage + b.offset_;
+        b.markers_ = reinterpret_cast<MarkerInstance*>(base + layout.markers);
+        b.bones_ = reinterpret_cast<BoneInstance*>(base + layout.bones);
+        b.trail_vertices_ = reinterpret_cast<TrailVertex*>(base + layout.trail_vertices);
+        b.trail_strips_ = reinterpret_cast<TrailStrip*>(base + layout.trail_strips);
+    }
+}
+
+int BatchRing::slot_of(const RenderBatch* batch) const {
+    const std::ptrdiff_t i = batch - batches_.data();
+    if (batch == nullptr || i < 0 || i >= num_slots()) throw std::invalid_argument("BatchRing: foreign batch");
+    return static_cast<int>(i);
+}
+
+RenderBatch* BatchRing::begin_frame() {
+    for (;;) {
+        for (int i = 0; i < num_slots(); ++i) {
+            std::uint32_t expected = kFree;
+            if (slots_[i].state.compare_exchange_strong(expected, kWriting, std::memory_order_acquire)) {
+                batches_[i].clear();
+                return &batches_[i];
+            }
+        }
+        // Reclaim the oldest frame that is ready but superseded by a newer one.
+        int stale = -1;
+        std::uint64_t stale_sequence = next_sequence_ - 1;
+        for (int i = 0; i < num_slots(); ++i) {
+            const std::uint64_t seq = slots_[i].sequence.load(std::memory_order_relaxed);
+            if (slots_[i].state.load(std::memory_order_relaxed) == kReady && seq < stale_sequence) {
+                stale = i;
+                stale_sequence = seq;
+            }
+        }
+        if (stale < 0) return nullptr;
+        std::uint32_t expected = kReady;
+        if (slots_[stale].state.compare_exchange_strong(expected, kWriting, std::memory_order_acquire)) {
+            skipped_.fetch_add(1, std::memory_order_relaxed);
+            batches_[stale].clear();
+            return &batches_[stale];
+        }
+        // The drawer took the stale frame after the scans, so it has released
+        // the slot it held before: look again rather than report a full ring.
+    }
+}
+
+void BatchRing::publish(RenderBatch* batch) {
+    const int i = slot_of(batch);
+    batch->end_strip();
+    batch->sequence_ = next_sequence_++;
+    slots_[i].sequence.store(batch->sequence_, std::memory_order_relaxed);
+    slots_[i].state.store(kReady, std::memory_order_release);
+}
+
+const RenderBatch* BatchRing::acquire() {
+    for (;;) {
+        int newest = -1;
+        std::uint64_t newest_sequence = last_acquired_;
+        for (int i = 0; i < num_slots(); ++i) {
+            const std::uint64_t seq = slots_[i].sequence.load(std::memory_order_relaxed);
+            if (slots_[i].state.load(std::memory_order_relaxed) == kReady && seq > newest_sequence) {
+                newest = i;
+                newest_sequence = seq;
+            }
+        }
+        if (newest < 0) return nullptr;
+        std::uint32_t expected = kReady;
+        // Fails only if the builder reclaimed a frame that was just superseded.
+        if (slots_[newest].state.compare_exchange_strong(expected, kReading, std::memory_order_acquire)) {
+            // The slot may have been reclaimed and republished between the
+            // scan and the CAS; record the frame actually taken.
+            last_acquired_ = batches_[newest].sequence_;
+            return &batches_[newest];
+        }
+    }
+}
+
+void BatchRing::release(const RenderBatch* batch) {
+    slots_[slot_of(batch)].state.store(kFree, std::memory_order_release);
+}
+
+}  // namespace mm::viz
@@ -0,0 +1,83 @@
+#include "motionmetrics/viz/skeleton_batcher.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::viz {
+
+int SkeletonBatcher::add_layer(const trajectory::TrajectorySet& set, const StickFigure& figure, std::uint32_t colour,
+                               const std::vector<std::string>& trail_markers) {
+    auto index_of = [&](const std::string& name) {
+        const int m = set.marker_index(name);
+        if (m < 0) throw std::invalid_argument("SkeletonBatcher: trial has no marker " + name);
+        return m;
+    };
+    Layer layer;
+    layer.set = &set;
+    for (const auto& [a, b] : figure.bones) layer.bones.emplace_back(index_of(a), index_of(b));
+    layer.marker_radius = figure.marker_radius;
+    layer.bone_radius = figure.bone_radius;
+    layer.colour = colour;
+    for (const std::string& name : trail_markers) layer.trails.emplace_back(set, index_of(name));
+    layers_.push_back(std::move(layer));
+    return num_layers() - 1;
+}
+
+BatchStats SkeletonBatcher::build(std::int64_t frame, const Camera& camera, const TrailOptions& trails,
+                                  RenderBatch& batch) {
+    MM_TRACE_SCOPE("skeleton_batch");
+    BatchStats stats;
+    const std::uint32_t trail_start = batch.num_trail_vertices();
+    for (const Layer& layer : layers_) {
+        if (!layer.visible) continue;
+        const trajectory::TrajectorySet& set = *layer.set;
+        const std::int64_t f = frame + layer.frame_offset;
+        if (f < 0 || f >= set.frames()) continue;
+
+        const int markers = set.num_markers();
+        positions_.resize(markers);
+        present_.resize(markers);
+        Vec3d lo{INFINITY, INFINITY, INFINITY};
+        Vec3d hi{-INFINITY, -INFINITY, -INFINITY};
+        for (int m = 0; m < markers; ++m) {
+            present_[m] = set.present(m, f);
+            if (!present_[m]) continue;
+            const Vec3d p = set.position(m, f) + layer.translation;
+            positions_[m] = p;
+            for (int k = 0; k < 3; ++k) {
+                lo[k] = std::min(lo[k], p[k]);
+                hi[k] = std::max(hi[k], p[k]);
+            }
+        }
+        if (!(lo.x <= hi.x)) continue;  // nothing present
+
+        const Vec3d centre = (lo + hi) * 0.5;
+        const double radius = norm(hi - lo) * 0.5 + layer.marker_radius;
+        if (camera.sphere_visible(centre, radius)) {
+            ++stats.layers_drawn;
+            for (int m = 0; m < markers; ++m)
+                if (present_[m]) batch.add_marker(positions_[m], layer.marker_radius, layer.colour);
+            for (const auto& [a, b] : layer.bones)
+                if (present_[a] && present_[b])
+                    batch.add_bone(positions_[a], positions_[b], layer.bone_radius, layer.colour);
+        } else {
+            ++stats.layers_culled;
+        }
+
+        // Trails reach beyond the current pose and are not culled with it.
+        if (trails.frames > 0 && !layer.trails.empty()) {
+            const double depth = std::max(camera.to_view(centre).z, camera.near());
+            const double tolerance = trails.pixel_tolerance * camera.pixel_size(depth);
+            const std::uint32_t trail_colour = (layer.colour & 0x00ffffffu) | 0xa0000000u;
+            for (const TrailLod& trail : layer.trails)
+                trail.emit(f - trails.frames, f, tolerance, trail_colour, batch, layer.translation);
+        }
+    }
+    stats.trail_vertices = batch.num_trail_vertices() - trail_start;
+    return stats;
+}
+
+}  // namespace mm::viz
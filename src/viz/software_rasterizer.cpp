@@ -0,0 +1,247 @@
+#include "motionmetrics/viz/software_rasterizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::viz {
+namespace {
+
+constexpr std::size_t kInstancesPerTask = 1024;
+constexpr float kLineHalfWidth = 0.75f;
+
+/// Scales the colour channels of `c` by `shade` in [0, 1].
+std::uint32_t shade_colour(std::uint32_t c, float shade) {
+    const auto scale = [&](int shift) {
+        return static_cast<std::uint32_t>(static_cast<float>((c >> shift) & 0xffu) * shade) << shift;
+    };
+    return (c & 0xff000000u) | scale(16) | scale(8) | scale(0);
+}
+
+std::uint32_t blend(std::uint32_t dst, std::uint32_t src) {
+    const std::uint32_t a = src >> 24;
+    const auto mix = [&](int shift) {
+        const std::uint32_t s = (src >> shift) & 0xffu;
+        const std::uint32_t d = (dst >> shift) & 0xffu;
+        return ((s * a + d * (255 - a) + 127) / 255) << shift;
+    };
+    return 0xff000000u | mix(16) | mix(8) | mix(0);
+}
+
+}  // namespace
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, WorkStealingPool* pool)
+    : width_(width), height_(height), pool_(pool) {
+    if (width <= 0 || height <= 0) throw std::invalid_argument("SoftwareRasterizer: non-positive size");
+    stride_ = static_cast<std::ptrdiff_t>(align_up(width * sizeof(std::uint32_t), kCacheLineSize) /
+                                          sizeof(std::uint32_t));
+    tiles_x_ = (width + (1 << kTileShift) - 1) >> kTileShift;
+    tiles_y_ = (height + (1 << kTileShift) - 1) >> kTileShift;
+    colour_ = AlignedBuffer(stride_ * height * sizeof(std::uint32_t));
+    depth_ = AlignedBuffer(stride_ * height * sizeof(float));
+}
+
+void SoftwareRasterizer::project(const RenderBatch& batch, const Camera& camera, std::size_t first, std::size_t last) {
+    const std::size_t markers = batch.num_markers();
+    const std::size_t bones = batch.num_bones();
+    const float focal = static_cast<float>(camera.focal());
+    const double near = camera.near();
+    for (std::size_t i = first; i < last; ++i) {
+        Primitive& p = primitives_[i];
+        p.kind = Kind::none;
+        if (i < markers) {
+            const MarkerInstance& m = batch.markers()[i];
+            float x, y, depth;
+            if (!camera.project({m.position[0], m.position[1], m.position[2]}, x, y, depth)) continue;
+            p = {x, y, x, y, std::max(focal * m.radius / depth, 0.75f), depth, m.radius, m.colour, Kind::disc};
+            continue;
+        }
+
+        Vec3d a, b;
+        float radius;
+        std::uint32_t colour;
+        Kind kind;
+        if (i < markers + bones) {
+            const BoneInstance& bone = batch.bones()[i - markers];
+            a = {bone.from[0], bone.from[1], bone.from[2]};
+            b = {bone.to[0], bone.to[1], bone.to[2]};
+            radius = bone.radius;
+            colour = bone.colour;
+            kind = Kind::capsule;
+        } else {
+            // Trail segment from this vertex to the next; strip ends have none.
+            const std::size_t v = i - markers - bones;
+            if (v + 1 >= batch.num_trail_vertices() || strip_end_[v]) continue;
+            const TrailVertex& t0 = batch.trail_vertices()[v];
+            const TrailVertex& t1 = batch.trail_vertices()[v + 1];
+            a = {t0.position[0], t0.position[1], t0.position[2]};
+            b = {t1.position[0], t1.position[1], t1.position[2]};
+            radius = 0.0f;
+            colour = t0.colour;
+            kind = Kind::line;
+        }
+        Vec3d va = camera.to_view(a);
+        Vec3d vb = camera.to_view(b);
+        // Clip to the near plane.
+        if (va.z < near && vb.z < near) continue;
+        if (va.z < near) va = vb + (va - vb) * ((vb.z - near) / (vb.z - va.z));
+        if (vb.z < near) vb = va + (vb - va) * ((va.z - near) / (va.z - vb.z));
+        camera.to_screen(va, p.x0, p.y0);
+        camera.to_screen(vb, p.x1, p.y1);
+        p.depth0 = static_cast<float>(va.z);
+        p.depth1 = static_cast<float>(vb.z);
+        p.radius = kind == Kind::line ? kLineHalfWidth
+                                      : std::max(focal * radius * 2.0f / (p.depth0 + p.depth1), kLineHalfWidth);
+        p.colour = colour;
+        p.kind = kind;
+    }
+}
+
+void SoftwareRasterizer::bin() {
+    const int tiles = tiles_x_ * tiles_y_;
+    bin_start_.assign(static_cast<std::size_t>(tiles) + 1, 0);
+    auto tile_range = [&](const Primitive& p, int& tx0, int& ty0, int& tx1, int& ty1) {
+        const float r = p.radius + 1.0f;
+        const float x0 = std::max(std::min(p.x0, p.x1) - r, 0.0f);
+        const float y0 = std::max(std::min(p.y0, p.y1) - r, 0.0f);
+        const float x1 = std::min(std::max(p.x0, p.x1) + r, static_cast<float>(width_ - 1));
+        const float y1 = std::min(std::max(p.y0, p.y1) + r, static_cast<float>(height_ - 1));
+        if (!(x0 <= x1 && y0 <= y1)) return false;
+        tx0 = static_cast<int>(x0) >> kTileShift;
+        ty0 = static_cast<int>(y0) >> kTileShift;
+        tx1 = static_cast<int>(x1) >> kTileShift;
+        ty1 = static_cast<int>(y1) >> kTileShift;
+        return true;
+    };
+
+    for (const Primitive& p : primitives_) {
+        int tx0, ty0, tx1, ty1;
+        if (p.kind == Kind::none || !tile_range(p, tx0, ty0, tx1, ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ++ty)
+            for (int tx = tx0; tx <= tx1; ++tx) ++bin_start_[ty * tiles_x_ + tx + 1];
+    }
+    for (int t = 0; t < tiles; ++t) bin_start_[t + 1] += bin_start_[t];
+    bins_.resize(bin_start_[tiles]);
+    bin_fill_.assign(bin_start_.begin(), bin_start_.end() - 1);
+    for (std::size_t i = 0; i < primitives_.size(); ++i) {
+        const Primitive& p = primitives_[i];
+        int tx0, ty0, tx1, ty1;
+        if (p.kind == Kind::none || !tile_range(p, tx0, ty0, tx1, ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ++ty)
+            for (int tx = tx0; tx <= tx1; ++tx) bins_[bin_fill_[ty * tiles_x_ + tx]++] = static_cast<std::uint32_t>(i);
+    }
+}
+
+void SoftwareRasterizer::raster_tile(int tile) {
+    const int x_begin = (tile % tiles_x_) << kTileShift;
+    const int y_begin = (tile / tiles_x_) << kTileShift;
+    const int x_end = std::min(x_begin + (1 << kTileShift), width_);
+    const int y_end = std::min(y_begin + (1 << kTileShift), height_);
+    std::uint32_t* colour = colour_.as<std::uint32_t>();
+    float* depth = depth_.as<float>();
+    for (int y = y_begin; y < y_end; ++y) {
+        std::fill(colour + y * stride_ + x_begin, colour + y * stride_ + x_end, background_);
+        std::fill(depth + y * stride_ + x_begin, depth + y * stride_ + x_end, std::numeric_limits<float>::infinity());
+    }
+
+    for (std::uint32_t k = bin_start_[tile]; k < bin_start_[tile + 1]; ++k) {
+        const Primitive& p = primitives_[bins_[k]];
+        const float r = p.radius;
+        // Clamp in float: near-plane projections can be far outside int range.
+        const auto clamp_to = [](float v, int lo, int hi) {
+            return static_cast<int>(std::clamp(v, static_cast<float>(lo), static_cast<float>(hi)));
+        };
+        const int px0 = clamp_to(std::floor(std::min(p.x0, p.x1) - r), x_begin, x_end);
+        const int py0 = clamp_to(std::floor(std::min(p.y0, p.y1) - r), y_begin, y_end);
+        const int px1 = clamp_to(std::ceil(std::max(p.x0, p.x1) + r) + 1.0f, x_begin, x_end);
+        const int py1 = clamp_to(std::ceil(std::max(p.y0, p.y1) + r) + 1.0f, y_begin, y_end);
+        const float r2 = r * r;
+        const float inv_r2 = 1.0f / r2;
+
+        if (p.kind == Kind::disc) {
+            // Shaded like a sphere, with the depth of its front surface.
+            for (int y = py0; y < py1; ++y) {
+                const float dy = static_cast<float>(y) + 0.5f - p.y0;
+                std::uint32_t* crow = colour + y * stride_;
+                float* drow = depth + y * stride_;
+                for (int x = px0; x < px1; ++x) {
+                    const float dx = static_cast<float>(x) + 0.5f - p.x0;
+                    const float d2 = dx * dx + dy * dy;
+                    if (d2 > r2) continue;
+                    const float h = std::sqrt(1.0f - d2 * inv_r2);
+                    const float z = p.depth0 - h * p.depth1;
+                    if (z >= drow[x]) continue;
+                    drow[x] = z;
+                    crow[x] = shade_colour(p.colour, 0.45f + 0.55f * h);
+                }
+            }
+            continue;
+        }
+
+        const float ex = p.x1 - p.x0;
+        const float ey = p.y1 - p.y0;
+        const float len2 = ex * ex + ey * ey;
+        const float inv_len2 = len2 > 0.0f ? 1.0f / len2 : 0.0f;
+        const bool opaque = p.kind == Kind::capsule;
+        for (int y = py0; y < py1; ++y) {
+            const float dy = static_cast<float>(y) + 0.5f - p.y0;
+            std::uint32_t* crow = colour + y * stride_;
+            float* drow = depth + y * stride_;
+            for (int x = px0; x < px1; ++x) {
+                const float dx = static_cast<float>(x) + 0.5f - p.x0;
+                const float t = std::clamp((dx * ex + dy * ey) * inv_len2, 0.0f, 1.0f);
+                const float qx = dx - t * ex;
+                const float qy = dy - t * ey;
+                const float d2 = qx * qx + qy * qy;
+                if (d2 > r2) continue;
+                const float z = p.depth0 + t * (p.depth1 - p.depth0);
+                if (z >= drow[x]) continue;
+                if (opaque) {
+                    drow[x] = z;
+                    crow[x] = shade_colour(p.colour, 1.0f - 0.45f * d2 * inv_r2);
+                } else {
+                    crow[x] = blend(crow[x], p.colour);
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::render(const RenderBatch& batch, const Camera& camera) {
+    MM_TRACE_SCOPE("rasterize");
+    if (camera.width() != width_ || camera.height() != height_)
+        throw std::invalid_argument("SoftwareRasterizer: camera viewport does not match");
+
+    const std::size_t vertices = batch.num_trail_vertices();
+    strip_end_.assign(vertices, 0);
+    for (std::uint32_t s = 0; s < batch.num_trail_strips(); ++s) {
+        const TrailStrip& strip = batch.trail_strips()[s];
+        if (strip.count > 0) strip_end_[strip.first + strip.count - 1] = 1;
+    }
+    const std::size_t count = std::size_t{batch.num_markers()} + batch.num_bones() + vertices;
+    primitives_.resize(count);
+    const int tasks = static_cast<int>((count + kInstancesPerTask - 1) / kInstancesPerTask);
+    auto project_task = [&](int task) {
+        const std::size_t first = static_cast<std::size_t>(task) * kInstancesPerTask;
+        project(batch, camera, first, std::min(count, first + kInstancesPerTask));
+    };
+    // Markers and bones go before trails in primitive order, so within a tile
+    // the trails blend over the finished opaque pixels.
+    if (pool_)
+        pool_->parallel_for(0, tasks, 1, project_task);
+    else
+        for (int task = 0; task < tasks; ++task) project_task(task);
+
+    bin();
+
+    const int tiles = tiles_x_ * tiles_y_;
+    if (pool_)
+        pool_->parallel_for(0, tiles, 1, [&](int tile) { raster_tile(tile); });
+    else
+        for (int tile = 0; tile < tiles; ++tile) raster_tile(tile);
+}
+
+}  // namespace mm::viz
@@ -0,0 +1,120 @@
+#include "motionmetrics/viz/trail_lod.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "motionmetrics/core/trace.hpp"
+
+namespace mm::viz {
+
+TrailLod::TrailLod(const trajectory::TrajectorySet& set, int marker) : frames_(set.frames()) {
+    MM_TRACE_SCOPE("trail_lod");
+    if (marker < 0 || marker >= set.num_markers()) throw std::out_of_range("TrailLod: marker out of range");
+    x_ = set.column(marker, 0);
+    y_ = set.column(marker, 1);
+    z_ = set.column(marker, 2);
+    level_.assign(static_cast<std::size_t>(frames_), -1.0f);
+
+    std::int64_t start = -1;
+    for (std::int64_t f = 0; f <= frames_; ++f) {
+        const bool present = f < frames_ && set.present(marker, f);
+        if (present && start < 0) start = f;
+        if (!present && start >= 0) {
+            build_run(start, f - 1);
+            runs_.emplace_back(start, f - 1);
+            start = -1;
+        }
+    }
+
+    const std::int64_t blocks = (frames_ + (std::int64_t{1} << kBlockShift) - 1) >> kBlockShift;
+    block_level_.assign(static_cast<std::size_t>(blocks), -1.0f);
+    for (std::int64_t f = 0; f < frames_; ++f) {
+        float& b = block_level_[f >> kBlockShift];
+        b = std::max(b, level_[f]);
+    }
+}
+
+void TrailLod::build_run(std::int64_t a, std::int64_t b) {
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+    level_[a] = level_[b] = kInf;
+    struct Span {
+        std::int64_t a, b;
+        float level;
+    };
+    std::vector<Span> stack{{a, b, kInf}};
+    while (!stack.empty()) {
+        const Span s = stack.back();
+        stack.pop_back();
+        if (s.b - s.a < 2) continue;
+        const Vec3d pa{x_[s.a], y_[s.a], z_[s.a]};
+        const Vec3d axis = Vec3d{x_[s.b], y_[s.b], z_[s.b]} - pa;
+        const double length2 = dot(axis, axis);
+        const double inv_length2 = length2 > 0.0 ? 1.0 / length2 : 0.0;
+        // Largest squared distance from the chord (from pa when the ends meet).
+        double best = -1.0;
+        std::int64_t split = s.a + 1;
+        for (std::int64_t k = s.a + 1; k < s.b; ++k) {
+            const Vec3d d = Vec3d{x_[k], y_[k], z_[k]} - pa;
+            const double along = dot(d, axis);
+            const double dist2 = dot(d, d) - along * along * inv_length2;
+            if (dist2 > best) {
+                best = dist2;
+                split = k;
+            }
+        }
+        const float level = std::min(s.level, static_cast<float>(std::sqrt(std::max(best, 0.0))));
+        level_[split] = level;
+        stack.push_back({s.a, split, level});
+        stack.push_back({split, s.b, level});
+    }
+}
+
+template <typename Fn>
+void TrailLod::walk(std::size_t run, std::int64_t first, std::int64_t last, float tolerance, Fn&& fn) const {
+    const std::int64_t a = std::max(first, runs_[run].first);
+    const std::int64_t b = std::min(last, runs_[run].second);
+    fn(a);
+    std::int64_t f = a + 1;
+    while (f < b) {
+        const std::int64_t block_end = std::min(b, ((f >> kBlockShift) + 1) << kBlockShift);
+        if (block_level_[f >> kBlockShift] > tolerance) {
+            for (; f < block_end; ++f)
+                if (level_[f] > tolerance) fn(f);
+        }
+        f = block_end;
+    }
+    if (b > a) fn(b);
+}
+
+void TrailLod::select(std::int64_t first, std::int64_t last, double tolerance, std::vector<std::int64_t>& out) const {
+    first = std::max<std::int64_t>(first, 0);
+    last = std::min(last, frames_ - 1);
+    auto run = std::lower_bound(runs_.begin(), runs_.end(), first,
+                                [](const auto& r, std::int64_t f) { return r.second < f; });
+    for (; run != runs_.end() && run->first <= last; ++run)
+        walk(static_cast<std::size_t>(run - runs_.begin()), first, last, static_cast<float>(tolerance),
+             [&](std::int64_t f) { out.push_back(f); });
+}
+
+std::size_t TrailLod::emit(std::int64_t first, std::int64_t last, double tolerance, std::uint32_t colour,
+                           RenderBatch& batch, const Vec3d& translation) const {
+    first = std::max<std::int64_t>(first, 0);
+    last = std::min(last, frames_ - 1);
+    const std::uint32_t before = batch.num_trail_vertices();
+    const float tx = static_cast<float>(translation.x);
+    const float ty = static_cast<float>(translation.y);
+    const float tz = static_cast<float>(translation.z);
+    auto run = std::lower_bound(runs_.begin(), runs_.end(), first,
+                                [](const auto& r, std::int64_t f) { return r.second < f; });
+    for (; run != runs_.end() && run->first <= last; ++run) {
+        if (!batch.begin_strip()) break;
+        walk(static_cast<std::size_t>(run - runs_.begin()), first, last, static_cast<float>(tolerance),
+             [&](std::int64_t f) { batch.add_trail_vertex(x_[f] + tx, y_[f] + ty, z_[f] + tz, colour); });
+        batch.end_strip();
+    }
+    return batch.num_trail_vertices() - before;
+}
+
+}  // namespace mm::viz
@@ -0,0 +1,69 @@
+// Hungarian assignment against exhaustive search on random rectangular
+// problems, with one solver reused across sizes as the labeler does.
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "motionmetrics/labeling/assignment.hpp"
+
+using mm::labeling::AssignmentSolver;
+
+namespace {
+
+/// Minimum total over every injective row -> column map.
+double brute_force(const std::vector<double>& cost, int rows, int cols) {
+    std::vector<int> columns(cols);
+    std::iota(columns.begin(), columns.end(), 0);
+    double best = std::numeric_limits<double>::infinity();
+    // Every permutation of the columns; the first `rows` form the map.
+    do {
+        double total = 0.0;
+        for (int r = 0; r < rows; ++r) total += cost[r * cols + columns[r]];
+        best = std::min(best, total);
+    } while (std::next_permutation(columns.begin(), columns.end()));
+    return best;
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(7);
+    AssignmentSolver solver;
+    std::vector<int> row_to_col;
+
+    for (int trial = 0; trial < 300; ++trial) {
+        const int cols = 1 + static_cast<int>(rng() % 6);
+        const int rows = 1 + static_cast<int>(rng() % cols);
+        std::vector<double> cost(static_cast<std::size_t>(rows) * cols);
+        // Integer costs make ties, which the potentials must handle too.
+        const bool ties = trial % 2 == 0;
+        std::uniform_real_distribution<double> real(0.0, 10.0);
+        for (double& c : cost) c = ties ? static_cast<double>(rng() % 4) : real(rng);
+
+        const double total = solver.solve(cost.data(), rows, cols, row_to_col);
+        MM_CHECK(static_cast<int>(row_to_col.size()) == rows);
+        std::vector<char> taken(cols, 0);
+        double sum = 0.0;
+        for (int r = 0; r < rows; ++r) {
+            const int c = row_to_col[r];
+            MM_CHECK(c >= 0 && c < cols);
+            if (c < 0 || c >= cols) continue;
+            MM_CHECK(!taken[c]);
+            taken[c] = 1;
+            sum += cost[r * cols + c];
+        }
+        MM_CHECK_NEAR(total, sum, 1e-9);
+        MM_CHECK_NEAR(total, brute_force(cost, rows, cols), 1e-9);
+    }
+
+    // A diagonal optimum that a greedy row-by-row choice misses.
+    const double greedy_trap[] = {1.0, 2.0, 1.0, 100.0};
+    MM_CHECK_NEAR(solver.solve(greedy_trap, 2, 2, row_to_col), 3.0, 0.0);
+    MM_CHECK(row_to_col[0] == 1 && row_to_col[1] == 0);
+
+    return mm::test::result();
+}
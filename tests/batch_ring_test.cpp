@@ -0,0 +1,134 @@
+// BatchRing between a builder and a drawing thread: the drawer must only
+// ever see whole frames, newest first and never one twice, and with three
+// slots the builder must never be refused a batch.
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "motionmetrics/core/aligned_buffer.hpp"
+#include "motionmetrics/viz/render_batch.hpp"
+
+using mm::viz::BatchCapacity;
+using mm::viz::BatchRing;
+using mm::viz::RenderBatch;
+
+namespace {
+
+constexpr std::uint64_t kFrames = 200000;
+
+/// Element count of frame `sequence`, so a frame mixing two builds shows;
+/// at least two, as shorter trail strips are dropped.
+std::uint32_t count_of(std::uint64_t sequence) { return static_cast<std::uint32_t>(sequence % 37 + 2); }
+
+void fill(RenderBatch& batch, std::uint64_t sequence) {
+    const double s = static_cast<double>(sequence);
+    for (std::uint32_t i = 0; i < count_of(sequence); ++i) {
+        batch.add_marker({s, static_cast<double>(i), 0.0}, 0.01f, static_cast<std::uint32_t>(sequence));
+        batch.add_bone({s, 0.0, 0.0}, {s, 1.0, 0.0}, 0.02f, static_cast<std::uint32_t>(sequence));
+    }
+    batch.begin_strip();
+    for (std::uint32_t i = 0; i < count_of(sequence); ++i)
+        batch.add_trail_vertex(static_cast<float>(s), static_cast<float>(i), 0.0f, static_cast<std::uint32_t>(sequence));
+}
+
+bool whole(const RenderBatch& batch) {
+    const std::uint64_t sequence = batch.sequence();
+    const std::uint32_t n = count_of(sequence);
+    if (batch.num_markers() != n || batch.num_bones() != n || batch.num_trail_strips() != 1 ||
+        batch.num_trail_vertices() != n || batch.overflow() != 0)
+        return false;
+    for (std::uint32_t i = 0; i < n; ++i) {
+        if (batch.markers()[i].position[0] != static_cast<float>(sequence) || batch.markers()[i].colour !=
+                                                                                   static_cast<std::uint32_t>(sequence))
+            return false;
+        if (batch.bones()[i].to[0] != static_cast<float>(sequence)) return false;
+        if (batch.trail_vertices()[i].colour != static_cast<std::uint32_t>(sequence)) return false;
+    }
+    return batch.trail_strips()[0].count == n;
+}
+
+void stress(BatchRing& ring) {
+    std::atomic<bool> done{false};
+    std::atomic<int> refused{0};
+    std::thread builder([&] {
+        for (std::uint64_t sequence = 1; sequence <= kFrames; ++sequence) {
+            RenderBatch* batch = ring.begin_frame();
+            if (!batch) {
+                refused.fetch_add(1);
+                continue;
+            }
+            fill(*batch, sequence);
+            ring.publish(batch);
+            if (batch->sequence() != sequence) refused.fetch_add(1);
+        }
+        done.store(true);
+    });
+
+    std::uint64_t drawn = 0, last = 0;
+    int broken = 0, repeated = 0;
+    for (;;) {
+        const bool finished = done.load();
+        const RenderBatch* batch = ring.acquire();
+        if (!batch) {
+            if (finished) break;
+            continue;
+        }
+        if (batch->sequence() <= last) ++repeated;
+        last = batch->sequence();
+        if (!whole(*batch)) ++broken;
+        ++drawn;
+        ring.release(batch);
+    }
+    builder.join();
+
+    MM_CHECK(refused.load() == 0);
+    MM_CHECK(broken == 0);
+    MM_CHECK(repeated == 0);
+    MM_CHECK(last == kFrames);
+    MM_CHECK(drawn + ring.skipped() <= kFrames);
+    MM_CHECK(drawn > 0);
+}
+
+}  // namespace
+
+int main() {
+    BatchCapacity capacity;
+    capacity.markers = capacity.bones = 64;
+    capacity.trail_vertices = 64;
+    capacity.trail_strips = 4;
+
+    BatchRing owned(capacity);
+    stress(owned);
+
+    // Caller-supplied storage, as for a mapped GPU buffer.
+    mm::AlignedBuffer storage(BatchRing::storage_bytes(capacity, 4));
+    BatchRing external(capacity, 4, storage.data());
+    MM_CHECK(external.storage() == storage.data());
+    stress(external);
+
+    // Two slots: while one is drawn and the other is being filled, the
+    // builder is refused.
+    BatchRing pair(capacity, 2);
+    RenderBatch* first = pair.begin_frame();
+    pair.publish(first);
+    const RenderBatch* drawing = pair.acquire();
+    MM_CHECK(drawing == first);
+    RenderBatch* second = pair.begin_frame();
+    MM_CHECK(second != nullptr && second != first);
+    MM_CHECK(pair.begin_frame() == nullptr);
+    pair.publish(second);
+    pair.release(drawing);
+    MM_CHECK(pair.acquire() == second);
+
+    // Overflow drops elements and counts them.
+    RenderBatch* batch = owned.begin_frame();
+    for (int i = 0; i < 70; ++i) batch->add_marker({}, 0.01f, 0);
+    MM_CHECK(batch->num_markers() == 64 && batch->overflow() == 6);
+
+    MM_CHECK_THROWS(BatchRing(capacity, 1), std::invalid_argument);
+    return mm::test::result();
+}
@@ -0,0 +1,114 @@
+// Zero-phase Butterworth: the designed sections against the analytic
+// response, including the cutoff correction for forward-backward use, and
+// the filter bank's measured gain per marker at each instruction set.
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "motionmetrics/trajectory/butterworth_filter.hpp"
+
+using mm::trajectory::Biquad;
+using mm::trajectory::ButterworthFilterBank;
+using mm::trajectory::TrajectorySet;
+
+namespace {
+
+constexpr double kRate = 200.0;
+
+/// |H| of the cascade at `hz`.
+double gain(const std::vector<Biquad>& sections, double hz) {
+    const std::complex<double> z1 = std::polar(1.0, -2.0 * M_PI * hz / kRate);
+    const std::complex<double> z2 = z1 * z1;
+    std::complex<double> h = 1.0;
+    for (const Biquad& s : sections) h *= (s.b0 + s.b1 * z1 + s.b2 * z2) / (1.0 + s.a1 * z1 + s.a2 * z2);
+    return std::abs(h);
+}
+
+void test_design() {
+    for (int order : {2, 4, 8}) {
+        for (double cutoff : {2.0, 6.0, 25.0}) {
+            const auto single = mm::trajectory::design_butterworth_lowpass(order, cutoff, kRate, false);
+            const auto zero_phase = mm::trajectory::design_butterworth_lowpass(order, cutoff, kRate, true);
+            MM_CHECK(static_cast<int>(single.size()) == order / 2);
+            MM_CHECK_NEAR(gain(single, 0.0), 1.0, 1e-12);
+            MM_CHECK_NEAR(gain(zero_phase, 0.0), 1.0, 1e-12);
+            // One pass is 3 dB down at the cutoff; the corrected design is
+            // 3 dB down there only after both passes.
+            MM_CHECK_NEAR(gain(single, cutoff), std::sqrt(0.5), 1e-9);
+            MM_CHECK_NEAR(gain(zero_phase, cutoff) * gain(zero_phase, cutoff), std::sqrt(0.5), 1e-9);
+            MM_CHECK(gain(zero_phase, 4.0 * cutoff < 0.5 * kRate ? 4.0 * cutoff : 0.45 * kRate) < 0.2);
+        }
+    }
+    MM_CHECK_THROWS(mm::trajectory::design_butterworth_lowpass(3, 6.0, kRate), std::invalid_argument);
+    MM_CHECK_THROWS(mm::trajectory::design_butterworth_lowpass(4, 120.0, kRate), std::invalid_argument);
+}
+
+/// Peak amplitude over the middle half of a column, away from the ends.
+double amplitude(const float* column, std::int64_t frames) {
+    double peak = 0.0;
+    for (std::int64_t f = frames / 4; f < 3 * frames / 4; ++f) peak = std::max(peak, std::abs(double{column[f]}));
+    return peak;
+}
+
+/// Marker m carries a unit sine at frequencies[m] on every axis.
+TrajectorySet sines(const std::vector<double>& frequencies, std::int64_t frames) {
+    std::vector<std::string> names;
+    for (std::size_t m = 0; m < frequencies.size(); ++m) names.push_back(std::to_string(m));
+    TrajectorySet set(names, frames);
+    for (std::int64_t f = 0; f < frames; ++f) {
+        set.timestamps()[f] = f * 5'000'000;  // 200 Hz
+        for (std::size_t m = 0; m < frequencies.size(); ++m) {
+            const double v = std::sin(2.0 * M_PI * frequencies[m] * f / kRate);
+            set.set_position(static_cast<int>(m), f, {v, v, v});
+        }
+    }
+    return set;
+}
+
+/// The bank must pass each marker at its own cutoff's gain; eleven markers
+/// make 33 columns, so the last group is partial.
+void test_bank(mm::SimdLevel level) {
+    const std::int64_t frames = 4000;
+    const double cutoff = 6.0;
+    std::vector<double> frequencies, cutoffs, expected;
+    for (int m = 0; m < 11; ++m) {
+        // Each marker at a quarter, one or four times its own cutoff.
+        const double c = cutoff * (1.0 + 0.25 * m);
+        const double ratio = m % 3 == 0 ? 0.25 : (m % 3 == 1 ? 1.0 : 4.0);
+        frequencies.push_back(c * ratio);
+        cutoffs.push_back(c);
+        const auto design = mm::trajectory::design_butterworth_lowpass(4, c, kRate, true);
+        expected.push_back(gain(design, c * ratio) * gain(design, c * ratio));
+    }
+    TrajectorySet set = sines(frequencies, frames);
+    const ButterworthFilterBank bank({}, level);
+    MM_CHECK_NEAR(bank.sample_rate(set), kRate, 1e-9);
+    bank.filter(set, cutoffs);
+    for (int m = 0; m < 11; ++m)
+        for (int axis = 0; axis < 3; ++axis) MM_CHECK_NEAR(amplitude(set.column(m, axis), frames), expected[m], 0.01);
+
+    // A gap is bridged for the filter but stays missing.
+    TrajectorySet gappy = sines({1.0}, frames);
+    for (std::int64_t f = 1000; f < 1010; ++f)
+        gappy.set_position(0, f, {std::numeric_limits<double>::quiet_NaN(), 0.0, 0.0});
+    bank.filter(gappy, cutoff);
+    MM_CHECK(!gappy.present(0, 1005));
+    MM_CHECK(gappy.present(0, 999) && gappy.present(0, 1010));
+    MM_CHECK_NEAR(gappy.column(0, 0)[2000], std::sin(2.0 * M_PI * 2000 / kRate), 0.01);
+}
+
+}  // namespace
+
+int main() {
+    test_design();
+    test_bank(mm::SimdLevel::scalar);
+    if (mm::detect_simd_level() != mm::SimdLevel::scalar) test_bank(mm::detect_simd_level());
+    return mm::test::result();
+}
@@ -0,0 +1,198 @@
+// Causal marker filter: the unrolled Kalman update against a textbook
+// matrix implementation, tracking of a ballistic marker, coasting through
+// short gaps and dropping after long ones, and the one-euro mode.
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "motionmetrics/trajectory/causal_filter.hpp"
+
+using mm::trajectory::CausalFilterMode;
+using mm::trajectory::CausalFilterParams;
+using mm::trajectory::CausalMarkerFilter;
+
+namespace {
+
+using Mat = std::array<std::array<double, 3>, 3>;
+
+Mat multiply(const Mat& a, const Mat& b) {
+    Mat r{};
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            for (int k = 0; k < 3; ++k) r[i][j] += a[i][k] * b[k][j];
+    return r;
+}
+
+Mat transpose(const Mat& a) {
+    Mat r{};
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j) r[i][j] = a[j][i];
+    return r;
+}
+
+/// Constant-acceleration Kalman filter of one axis, written out with full
+/// matrices: x' = F x, P' = F P F^T + Q, then the position update.
+struct ReferenceKalman {
+    CausalFilterParams params;
+    std::array<double, 3> x{};
+    Mat p{};
+    bool active = false;
+    int missed = 0;
+
+    void predict(double t) {
+        const Mat f{{{1.0, t, 0.5 * t * t}, {0.0, 1.0, t}, {0.0, 0.0, 1.0}}};
+        const double q = params.process_noise;
+        const Mat noise{{{q * std::pow(t, 5) / 20.0, q * std::pow(t, 4) / 8.0, q * std::pow(t, 3) / 6.0},
+                         {q * std::pow(t, 4) / 8.0, q * std::pow(t, 3) / 3.0, q * t * t / 2.0},
+                         {q * std::pow(t, 3) / 6.0, q * t * t / 2.0, q * t}}};
+        std::array<double, 3> next{};
+        for (int i = 0; i < 3; ++i)
+            for (int k = 0; k < 3; ++k) next[i] += f[i][k] * x[k];
+        x = next;
+        p = multiply(multiply(f, p), transpose(f));
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j) p[i][j] += noise[i][j];
+    }
+
+    void observe(double z) {
+        const double s = p[0][0] + params.measurement_noise;
+        const std::array<double, 3> gain{p[0][0] / s, p[1][0] / s, p[2][0] / s};
+        const double innovation = z - x[0];
+        for (int i = 0; i < 3; ++i) x[i] += gain[i] * innovation;
+        const Mat before = p;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j) p[i][j] -= gain[i] * before[0][j];
+    }
+
+    void step(double dt, double z) {
+        if (active && dt > 0.0) predict(dt);
+        if (z != z) {
+            if (active && ++missed > params.max_missed) active = false;
+            return;
+        }
+        if (!active) {
+            x = {z, 0.0, 0.0};
+            p = Mat{{{params.measurement_noise, 0.0, 0.0},
+                     {0.0, params.initial_velocity_variance, 0.0},
+                     {0.0, 0.0, params.initial_acceleration_variance}}};
+            active = true;
+        } else {
+            observe(z);
+        }
+        missed = 0;
+    }
+};
+
+void test_against_reference() {
+    CausalFilterParams params;
+    params.mode = CausalFilterMode::kalman;
+    CausalMarkerFilter filter(2, params);
+    std::array<ReferenceKalman, 6> reference;
+    for (ReferenceKalman& r : reference) r.params = params;
+
+    std::mt19937 rng(3);
+    std::normal_distribution<double> noise(0.0, 1e-3);
+    std::uniform_int_distribution<int> jitter(-200'000, 200'000);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    mm::TimestampNs last = 0;
+    for (int f = 0; f < 600; ++f) {
+        // 250 Hz with timing jitter; marker 1 has a short and a long gap.
+        const mm::TimestampNs timestamp = mm::TimestampNs{f} * 4'000'000 + (f > 0 ? jitter(rng) : 0);
+        const double t = timestamp * 1e-9;
+        std::array<float, 6> xyz;
+        for (int k = 0; k < 3; ++k) {
+            xyz[k] = static_cast<float>(0.3 * std::sin(3.0 * t + k) + noise(rng));
+            xyz[3 + k] = static_cast<float>(1.0 + 0.5 * t * k - 4.9 * t * t * (k == 2) + noise(rng));
+        }
+        if ((f >= 100 && f < 103) || (f >= 300 && f < 320)) xyz[3] = xyz[4] = xyz[5] = nan;
+        filter.update(timestamp, xyz.data());
+
+        const double dt = f > 0 ? (timestamp - last) * 1e-9 : 0.0;
+        last = timestamp;
+        for (int c = 0; c < 6; ++c) reference[c].step(dt, xyz[c]);
+        for (int m = 0; m < 2; ++m) {
+            MM_CHECK(filter.valid(m) == reference[m * 3].active);
+            if (!reference[m * 3].active) {
+                MM_CHECK(filter.positions()[m * 3] != filter.positions()[m * 3]);
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) {
+                const ReferenceKalman& r = reference[m * 3 + k];
+                MM_CHECK_NEAR(filter.positions()[m * 3 + k], r.x[0], 1e-5 * (1.0 + std::abs(r.x[0])));
+                MM_CHECK_NEAR(filter.velocities()[m * 3 + k], r.x[1], 1e-4 * (1.0 + std::abs(r.x[1])));
+                MM_CHECK_NEAR(filter.accelerations()[m * 3 + k], r.x[2], 1e-3 * (1.0 + std::abs(r.x[2])));
+            }
+        }
+    }
+}
+
+void test_tracking() {
+    // A ball in flight: once settled, the estimates are unbiased and the
+    // position is better than the measurements.
+    CausalMarkerFilter filter(1);
+    std::mt19937 rng(5);
+    std::normal_distribution<double> noise(0.0, 1e-3);
+    const double v0 = 3.0, g = -9.81;
+    double position_error = 0.0, velocity_bias = 0.0, velocity_error = 0.0, acceleration = 0.0;
+    int samples = 0;
+    for (int f = 0; f <= 600; ++f) {
+        const double t = f / 300.0;
+        const double z = v0 * t + 0.5 * g * t * t;
+        const float xyz[3] = {static_cast<float>(0.5 * t + noise(rng)), static_cast<float>(noise(rng)),
+                              static_cast<float>(z + noise(rng))};
+        filter.update(static_cast<mm::TimestampNs>(std::llround(t * 1e9)), xyz);
+        if (f < 150) continue;
+        const double dz = filter.position(0).z - z;
+        const double dv = filter.velocity(0).z - (v0 + g * t);
+        position_error += dz * dz;
+        velocity_bias += dv;
+        velocity_error += dv * dv;
+        acceleration += filter.acceleration(0).z;
+        ++samples;
+    }
+    MM_CHECK(std::sqrt(position_error / samples) < 0.9e-3);
+    MM_CHECK_NEAR(velocity_bias / samples, 0.0, 0.01);
+    MM_CHECK(std::sqrt(velocity_error / samples) < 0.15);
+    MM_CHECK_NEAR(acceleration / samples, g, 0.5);
+
+    // Out-of-order frames are ignored.
+    const mm::Vec3d before = filter.position(0);
+    const float stale[3] = {5.0f, 5.0f, 5.0f};
+    filter.update(0, stale);
+    MM_CHECK(filter.position(0).x == before.x);
+}
+
+void test_one_euro() {
+    CausalFilterParams params;
+    params.mode = CausalFilterMode::one_euro;
+    CausalMarkerFilter filter(1, params);
+    std::mt19937 rng(9);
+    std::normal_distribution<double> noise(0.0, 1e-3);
+    double raw = 0.0, smoothed = 0.0;
+    for (int f = 0; f < 500; ++f) {
+        const float xyz[3] = {static_cast<float>(noise(rng)), 0.0f, 0.0f};
+        filter.update(mm::TimestampNs{f} * 4'000'000, xyz);
+        if (f < 100) continue;
+        raw += double{xyz[0]} * xyz[0];
+        smoothed += filter.position(0).x * filter.position(0).x;
+    }
+    // At rest the low cutoff removes most of the noise.
+    MM_CHECK(smoothed < 0.25 * raw);
+    const float missing[3] = {std::numeric_limits<float>::quiet_NaN(), 0.0f, 0.0f};
+    filter.update(mm::TimestampNs{500} * 4'000'000, missing);
+    MM_CHECK(filter.positions()[0] != filter.positions()[0]);
+    MM_CHECK(filter.valid(0));
+}
+
+}  // namespace
+
+int main() {
+    test_against_reference();
+    test_tracking();
+    test_one_euro();
+    return mm::test::result();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+namespace mm::test {
+
+/// Failed checks so far. A failed check is reported and counted but does
+/// not stop the test, and unlike assert it survives release builds.
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* what) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    ++failures();
+}
+
+inline void check_near(const char* file, int line, const char* what, double actual, double expected,
+                       double tolerance) {
+    if (std::abs(actual - expected) <= tolerance) return;
+    std::fprintf(stderr, "%s:%d: check failed: %s (%.9g vs %.9g, tolerance %.3g)\n", file, line, what, actual,
+                 expected, tolerance);
+    ++failures();
+}
+
+/// Return value of a test's main.
+inline int result() {
+    if (failures() != 0) std::fprintf(stderr, "%d check(s) failed\n", failures());
+    return failures() == 0 ? 0 : 1;
+}
+
+}  // namespace mm::test
+
+#define MM_CHECK(cond) ((cond) ? void() : mm::test::fail(__FILE__, __LINE__, #cond))
+#define MM_CHECK_NEAR(actual, expected, tolerance) \
+    mm::test::check_near(__FILE__, __LINE__, #actual " ~ " #expected, (actual), (expected), (tolerance))
+#define MM_CHECK_THROWS(expr, type)                                                 \
+    do {                                                                            \
+        bool thrown_ = false;                                                       \
+        try {                                                                       \
+            (void)(expr);                                                           \
+        } catch (const type&) {                                                     \
+            thrown_ = true;                                                         \
+        }                                                                           \
+        if (!thrown_) mm::test::fail(__FILE__, __LINE__, #expr " throws " #type);  \
+    } while (0)
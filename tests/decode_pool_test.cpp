@@ -0,0 +1,133 @@
+// DecodePool with several decoder threads per camera writing into a small
+// ring: every frame must arrive exactly once, intact, in timestamp order
+// across cameras, both frame by frame and through the synchronizer, for a
+// range of decoder counts and chunk sizes.
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "check.hpp"
+#include "motionmetrics/capture/decode_pool.hpp"
+
+using namespace mm::capture;
+
+namespace {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 8;
+constexpr int kFrames = 300;
+constexpr mm::TimestampNs kInterval = 10'000'000;
+
+std::uint8_t pattern(int camera, std::int64_t frame) { return static_cast<std::uint8_t>(frame * 3 + camera * 50); }
+
+/// Camera c's frame f is filled with pattern(c, f) and stamped f * kInterval
+/// plus a small per-camera skew, so cameras interleave in a fixed order.
+std::vector<std::string> write_cameras(const std::filesystem::path& dir, int cameras) {
+    std::vector<std::string> paths;
+    std::vector<std::uint8_t> pixels(kWidth * kHeight);
+    for (int c = 0; c < cameras; ++c) {
+        paths.push_back((dir / ("cam" + std::to_string(c) + ".raw")).string());
+        RawVideoWriter writer(paths.back(), kWidth, kHeight);
+        for (int f = 0; f < kFrames; ++f) {
+            std::fill(pixels.begin(), pixels.end(), pattern(c, f));
+            writer.append(mm::ImageView{pixels.data(), kWidth, kHeight, kWidth}, f * kInterval + c * 1000);
+        }
+        writer.close();
+    }
+    return paths;
+}
+
+bool intact(const FramePin& pin) {
+    const std::uint8_t expected = pattern(pin.camera(), pin.timestamp() / kInterval);
+    for (int y = 0; y < pin.view().height; ++y)
+        for (int x = 0; x < pin.view().width; ++x)
+            if (pin.view().row(y)[x] != expected) return false;
+    return true;
+}
+
+void test_frames(const std::vector<std::string>& paths, int decoders, int chunk_frames) {
+    const int cameras = static_cast<int>(paths.size());
+    DecodePoolConfig config;
+    config.decoders_per_camera = decoders;
+    config.chunk_frames = chunk_frames;
+    config.reader_slots = 1;
+    config.pin_threads = false;
+    FrameRing ring(FrameRingConfig{cameras, chunk_frames * 2 + 1, kWidth, kHeight});
+    DecodePool pool(paths, ring, config);
+
+    std::vector<std::int64_t> next_frame(cameras, 0);
+    mm::TimestampNs last = -1;
+    int bad = 0;
+    FramePin pin;
+    while (pool.next(pin)) {
+        const int c = pin.camera();
+        if (pin.timestamp() != next_frame[c] * kInterval + c * 1000 || pin.timestamp() < last || !intact(pin)) ++bad;
+        ++next_frame[c];
+        last = pin.timestamp();
+        pin = FramePin();
+    }
+    MM_CHECK(bad == 0);
+    for (int c = 0; c < cameras; ++c) MM_CHECK(next_frame[c] == kFrames);
+    MM_CHECK(pool.stats().frames_delivered == static_cast<std::uint64_t>(cameras) * kFrames);
+    MM_CHECK(pool.stats().frames_decoded == static_cast<std::uint64_t>(cameras) * kFrames);
+}
+
+void test_sets(const std::vector<std::string>& paths) {
+    const int cameras = static_cast<int>(paths.size());
+    FrameSynchronizerConfig sync_config;
+    sync_config.num_cameras = cameras;
+    DecodePoolConfig config;
+    config.decoders_per_camera = 3;
+    config.chunk_frames = 8;
+    config.pin_threads = false;
+    config.reader_slots = DecodePool::reader_slots_for(sync_config);
+    FrameRing ring(FrameRingConfig{cameras, config.reader_slots + 8, kWidth, kHeight});
+
+    DecodePool pool(paths, ring, config);
+    FrameSynchronizer sync(sync_config);
+    FrameSet set;
+    int sets = 0, bad = 0;
+    while (pool.next_set(sync, set)) {
+        ++sets;
+        if (!set.complete()) ++bad;
+        for (const FramePin& pin : set.frames)
+            if (pin && !intact(pin)) ++bad;
+    }
+    MM_CHECK(sets == kFrames);
+    MM_CHECK(bad == 0);
+
+    // Too few reader slots for the synchronizer's pins is refused up front.
+    DecodePoolConfig tight = config;
+    tight.reader_slots = DecodePool::reader_slots_for(sync_config) - 1;
+    DecodePool refused(paths, ring, tight);
+    FrameSynchronizer other(sync_config);
+    MM_CHECK_THROWS(refused.next_set(other, set), std::invalid_argument);
+}
+
+}  // namespace
+
+int main() {
+    const std::filesystem::path dir =
+        std::filesystem::temp_directory_path() / ("motionmetrics_decode_pool_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(dir);
+    const std::vector<std::string> paths = write_cameras(dir, 3);
+
+    for (int decoders : {1, 2, 4})
+        for (int chunk_frames : {1, 7, 32}) test_frames(paths, decoders, chunk_frames);
+    test_sets(paths);
+
+    // The ring must hold a whole chunk besides the reader slots.
+    FrameRing small(FrameRingConfig{3, 4, kWidth, kHeight});
+    DecodePoolConfig config;
+    config.chunk_frames = 8;
+    MM_CHECK_THROWS(DecodePool(paths, small, config), std::invalid_argument);
+
+    std::filesystem::remove_all(dir);
+    return mm::test::result();
+}
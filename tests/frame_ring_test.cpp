@@ -0,0 +1,131 @@
+// FrameRing under contention: two producers per camera claiming slots by
+// CAS while readers pin, share and hold frames. Every pinned frame must be
+// complete and stay unchanged while pinned, `latest` must never go back in
+// publication order, and every claim must be either published or counted
+// as an overrun.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "motionmetrics/capture/frame_ring.hpp"
+
+using mm::capture::FramePin;
+using mm::capture::FrameRing;
+using mm::capture::FrameRingConfig;
+using mm::capture::FrameWriter;
+
+namespace {
+
+constexpr int kCameras = 2;
+constexpr int kProducersPerCamera = 2;
+constexpr int kFramesPerProducer = 20000;
+constexpr int kWidth = 64;
+constexpr int kHeight = 16;
+
+/// Pixel value of every pixel in the frame of `camera` at `timestamp`.
+std::uint8_t pattern(int camera, mm::TimestampNs timestamp) {
+    return static_cast<std::uint8_t>(timestamp * 7 + camera * 101 + (timestamp >> 8));
+}
+
+bool intact(const FramePin& pin) {
+    const std::uint8_t expected = pattern(pin.camera(), pin.timestamp());
+    const mm::ImageView view = pin.view();
+    for (int y = 0; y < view.height; ++y)
+        for (int x = 0; x < view.width; ++x)
+            if (view.row(y)[x] != expected) return false;
+    return true;
+}
+
+void stress(FrameRing& ring) {
+    std::atomic<int> producers_left{kCameras * kProducersPerCamera};
+    std::atomic<int> torn{0};
+    std::atomic<int> reordered{0};
+    std::vector<std::atomic<std::uint64_t>> attempts(kCameras);
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < kCameras; ++c) {
+        for (int p = 0; p < kProducersPerCamera; ++p) {
+            threads.emplace_back([&, c, p] {
+                for (int i = 0; i < kFramesPerProducer; ++i) {
+                    // Timestamps are unique per camera across its producers.
+                    const mm::TimestampNs timestamp = (static_cast<mm::TimestampNs>(i) * kProducersPerCamera + p) * 1000;
+                    attempts[c].fetch_add(1, std::memory_order_relaxed);
+                    FrameWriter writer = ring.begin_write(c);
+                    if (!writer) continue;
+                    for (int y = 0; y < writer.height(); ++y)
+                        std::memset(writer.data() + y * writer.stride(), pattern(c, timestamp), writer.width());
+                    if (i % 5 == 4) continue;  // abandoned unpublished
+                    writer.publish(timestamp);
+                }
+                producers_left.fetch_sub(1);
+            });
+        }
+    }
+    for (int r = 0; r < 3; ++r) {
+        threads.emplace_back([&, r] {
+            std::vector<std::uint64_t> last_sequence(kCameras, 0);
+            std::vector<FramePin> held;
+            while (producers_left.load() > 0) {
+                for (int c = 0; c < kCameras; ++c) {
+                    FramePin pin = ring.latest(c);
+                    if (!pin) continue;
+                    if (pin.sequence() < last_sequence[c]) reordered.fetch_add(1);
+                    last_sequence[c] = pin.sequence();
+                    if (!intact(pin)) torn.fetch_add(1);
+                    // Look up a neighbour by timestamp as the synchronizer does.
+                    FramePin near = ring.find(c, pin.timestamp() - 1500, 1000);
+                    if (near && !intact(near)) torn.fetch_add(1);
+                    // Hold a few frames across iterations; they must not change.
+                    if ((r + c) % 2 == 0) held.push_back(pin.share());
+                }
+                if (held.size() > 2) {
+                    for (const FramePin& pin : held)
+                        if (!intact(pin)) torn.fetch_add(1);
+                    held.clear();
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+
+    MM_CHECK(torn.load() == 0);
+    MM_CHECK(reordered.load() == 0);
+    for (int c = 0; c < kCameras; ++c) {
+        const mm::capture::FrameRingStats stats = ring.stats(c);
+        const std::uint64_t abandoned = kProducersPerCamera * (kFramesPerProducer / 5);
+        MM_CHECK(stats.published > 0);
+        // Abandoned writers that got a slot are neither published nor overruns.
+        MM_CHECK(stats.published + stats.overruns <= attempts[c].load());
+        MM_CHECK(stats.published + stats.overruns + abandoned >= attempts[c].load());
+    }
+}
+
+}  // namespace
+
+int main() {
+    const FrameRingConfig config{kCameras, 6, kWidth, kHeight};
+    FrameRing ring(config);
+    MM_CHECK(ring.stride() >= kWidth && ring.stride() % 64 == 0);
+    stress(ring);
+
+    // Pins keep their slot: with every slot pinned, a writer overruns.
+    FrameRing small(FrameRingConfig{1, 2, kWidth, kHeight});
+    std::vector<FramePin> pins;
+    for (int i = 0; i < 2; ++i) {
+        FrameWriter writer = small.begin_write(0);
+        MM_CHECK(static_cast<bool>(writer));
+        writer.publish(i + 1);
+        pins.push_back(small.find(0, i + 1));
+        MM_CHECK(static_cast<bool>(pins.back()));
+    }
+    MM_CHECK(!small.begin_write(0));
+    MM_CHECK(small.stats(0).overruns == 1);
+    pins.clear();
+    MM_CHECK(static_cast<bool>(small.begin_write(0)));
+
+    return mm::test::result();
+}
@@ -0,0 +1,195 @@
+// Levenberg-Marquardt inverse kinematics: exact recovery of a spinning,
+// flexing two-segment model through a chunked parallel trial solve (with
+// the unwrap of whole turns between chunks and unsolved frames), and the
+// compile-time solver's tree-ordered factorisation against the generic
+// solver's dense Cholesky on the full body.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+#include "motionmetrics/kinematics/ik_solver.hpp"
+#include "motionmetrics/kinematics/skeleton_definitions.hpp"
+#include "motionmetrics/kinematics/static_ik_solver.hpp"
+
+using mm::Vec3d;
+using mm::kinematics::DofType;
+using mm::kinematics::IkParams;
+using mm::kinematics::IkSolver;
+using mm::kinematics::IkTrial;
+using mm::kinematics::SegmentPose;
+using mm::kinematics::SkeletonModel;
+
+namespace {
+
+/// Pelvis with a free root joint and a thigh on a limited hinge.
+SkeletonModel two_segment_model() {
+    SkeletonModel model;
+    const int pelvis = model.add_segment("pelvis", -1, {0.0, 0.0, 1.0});
+    model.add_dof(pelvis, DofType::translate_x);
+    model.add_dof(pelvis, DofType::translate_y);
+    model.add_dof(pelvis, DofType::translate_z);
+    model.add_dof(pelvis, DofType::rotate_z);
+    model.add_dof(pelvis, DofType::rotate_x);
+    model.add_dof(pelvis, DofType::rotate_y);
+    const int thigh = model.add_segment("thigh", pelvis, {0.1, 0.0, -0.05});
+    model.add_dof(thigh, DofType::rotate_x, -2.0, 0.5);
+    model.add_marker("asis_l", pelvis, {0.12, 0.08, 0.05});
+    model.add_marker("asis_r", pelvis, {-0.12, 0.08, 0.05});
+    model.add_marker("sacrum", pelvis, {0.0, -0.1, 0.08});
+    model.add_marker("crest", pelvis, {0.1, 0.0, 0.15});
+    model.add_marker("thigh_a", thigh, {0.05, 0.0, -0.15});
+    model.add_marker("thigh_b", thigh, {0.0, 0.06, -0.3});
+    return model;
+}
+
+/// Generating pose of frame f: the pelvis turns 0.05 rad per frame, so a
+/// trial of several chunks spans several whole turns.
+std::array<double, 7> true_pose(int f) {
+    const double t = f / 100.0;
+    return {0.2 * std::sin(t), 0.1 * t, 0.05 * std::cos(2.0 * t), 0.05 * f, 0.2 * std::sin(3.0 * t),
+            0.15 * std::cos(2.5 * t), -0.8 + 0.6 * std::sin(4.0 * t)};
+}
+
+void test_trial() {
+    const SkeletonModel model = two_segment_model();
+    const int frames = 500;
+    std::vector<std::string> names;
+    for (int m = 0; m < model.num_markers(); ++m) names.push_back(model.marker(m).name);
+    names.push_back("unused");
+    mm::trajectory::TrajectorySet set(names, frames);
+    std::vector<SegmentPose> poses(model.num_segments());
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (int f = 0; f < frames; ++f) {
+        set.timestamps()[f] = mm::TimestampNs{f} * 10'000'000;
+        const std::array<double, 7> q = true_pose(f);
+        model.forward(q.data(), poses.data());
+        for (int m = 0; m < model.num_markers(); ++m) set.set_position(m, f, model.marker_position(poses.data(), m));
+        set.column(model.num_markers(), 0)[f] = nan;
+    }
+    // A dropout inside one chunk and another covering a chunk's first frames.
+    for (int f : {200, 201, 202, 203, 204, 320, 321, 322})
+        for (int m = 0; m < model.num_markers(); ++m)
+            for (int axis = 0; axis < 3; ++axis) set.column(m, axis)[f] = nan;
+
+    IkParams params;
+    params.chunk_frames = 64;
+    mm::WorkStealingPool pool(3);
+    const IkSolver solver(model, params);
+    const IkTrial trial = solver.solve_trial(set, &pool);
+    MM_CHECK(trial.frames == frames && trial.num_dofs == 7);
+    for (int f = 0; f < frames; ++f) {
+        const bool dropped = (f >= 200 && f <= 204) || (f >= 320 && f <= 322);
+        if (dropped) {
+            MM_CHECK(trial.rms_error[f] != trial.rms_error[f]);
+            for (int d = 0; d < 7; ++d) MM_CHECK(std::isnan(trial.pose(f)[d]));
+            continue;
+        }
+        MM_CHECK(trial.rms_error[f] < 1e-5f);
+        // Whole turns included: chunks start cold and must be unwrapped.
+        const std::array<double, 7> q = true_pose(f);
+        for (int d = 0; d < 7; ++d) MM_CHECK_NEAR(trial.pose(f)[d], q[d], 1e-4);
+    }
+
+    // A frame without markers is not solved and leaves the pose alone.
+    IkSolver single(model, params);
+    std::vector<float> row(model.num_markers() * 3, nan);
+    std::vector<double> q(7, 0.25);
+    const mm::kinematics::IkResult r = single.solve(row.data(), q.data(), true);
+    MM_CHECK(r.markers_used == 0 && r.iterations == 0);
+    MM_CHECK(std::all_of(q.begin(), q.end(), [](double v) { return v == 0.25; }));
+}
+
+void test_unwrap() {
+    // A limited dof cannot take a whole-turn shift, so its chunk stays put.
+    SkeletonModel model;
+    const int root = model.add_segment("root", -1, {});
+    model.add_dof(root, DofType::rotate_z);
+    model.add_dof(root, DofType::rotate_x, -3.5, 3.5);
+    IkTrial trial;
+    trial.num_dofs = 2;
+    trial.frames = 9;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    // Chunks of three frames: solved, starting with an unsolved frame, and
+    // entirely unsolved. Each row is one frame of both dofs.
+    trial.angles = {3.0, 3.0, 3.1, 3.1, 3.1, 3.1,       //
+                    nan, nan, -3.1, -3.1, -2.5, -2.5,   //
+                    nan, nan, nan, nan, nan, nan};
+    mm::kinematics::detail::unwrap_chunks(model, 3, trial);
+    MM_CHECK(std::isnan(trial.angles[6]));
+    MM_CHECK_NEAR(trial.angles[8], -3.1 + 2.0 * M_PI, 1e-12);
+    MM_CHECK_NEAR(trial.angles[10], -2.5 + 2.0 * M_PI, 1e-12);
+    // -2.5 + 2 pi is past the limit, so the whole chunk stays.
+    MM_CHECK(trial.angles[9] == -3.1 && trial.angles[11] == -2.5);
+    MM_CHECK(std::isnan(trial.angles[12]));
+}
+
+using FullBody = mm::kinematics::StaticSkeleton<mm::kinematics::FullBodySkeleton>;
+
+/// Adult proportions as in the IK benchmark, three markers per segment.
+FullBody full_body() {
+    const std::array<Vec3d, FullBody::kSegments> offsets{{
+        {0.0, 0.0, 1.0},     {0.09, 0.0, -0.05}, {0.0, 0.0, -0.42}, {0.0, 0.0, -0.41}, {-0.09, 0.0, -0.05},
+        {0.0, 0.0, -0.42},   {0.0, 0.0, -0.41},  {0.0, 0.0, 0.1},   {0.18, 0.0, 0.42}, {0.0, 0.0, -0.29},
+        {0.0, 0.0, -0.26},   {-0.18, 0.0, 0.42}, {0.0, 0.0, -0.29}, {0.0, 0.0, -0.26},
+    }};
+    FullBody skeleton(offsets);
+    for (int s = 0; s < FullBody::kSegments; ++s) {
+        const std::string name = mm::kinematics::FullBodySkeleton::joints[s].segment;
+        skeleton.add_marker(name + "_a", s, {0.05, 0.0, -0.1});
+        skeleton.add_marker(name + "_b", s, {-0.05, 0.03, -0.15});
+        skeleton.add_marker(name + "_c", s, {0.0, 0.06, -0.05});
+    }
+    return skeleton;
+}
+
+void test_static_matches_generic() {
+    constexpr int kDofs = FullBody::kDofs;
+    const FullBody skeleton = full_body();
+    IkSolver generic(skeleton.to_model());
+    mm::kinematics::StaticIkSolver<mm::kinematics::FullBodySkeleton> specialised(skeleton);
+
+    std::mt19937 rng(21);
+    std::normal_distribution<double> noise(0.0, 0.002);
+    const int markers = skeleton.num_markers();
+    std::vector<float> row(markers * 3);
+    std::array<SegmentPose, FullBody::kSegments> poses;
+    std::array<double, kDofs> truth, q_generic{}, q_static{};
+    double max_difference = 0.0;
+    for (int f = 0; f < 300; ++f) {
+        for (int d = 0; d < kDofs; ++d) {
+            const auto& dof = mm::kinematics::FullBodySkeleton::dofs[d];
+            const double lo = std::isfinite(dof.min) ? dof.min : -0.5;
+            const double hi = std::isfinite(dof.max) ? dof.max : 0.5;
+            truth[d] = 0.5 * (lo + hi) + 0.4 * (hi - lo) * std::sin(0.02 * f + d);
+        }
+        skeleton.forward(truth.data(), poses.data());
+        for (int m = 0; m < markers; ++m) {
+            const Vec3d p = skeleton.marker_position(poses.data(), m);
+            for (int axis = 0; axis < 3; ++axis) row[m * 3 + axis] = static_cast<float>(p[axis] + noise(rng));
+        }
+        // Occlusions change which chains carry markers from frame to frame.
+        if (f % 7 == 3) row[(f % markers) * 3] = std::numeric_limits<float>::quiet_NaN();
+        const auto a = generic.solve(row.data(), q_generic.data(), f > 0);
+        const auto b = specialised.solve(row.data(), q_static.data(), f > 0);
+        MM_CHECK(a.iterations == b.iterations);
+        MM_CHECK(a.rms_error < 0.01);
+        for (int d = 0; d < kDofs; ++d) max_difference = std::max(max_difference, std::abs(q_generic[d] - q_static[d]));
+    }
+    MM_CHECK_NEAR(max_difference, 0.0, 1e-6);
+}
+
+}  // namespace
+
+int main() {
+    test_trial();
+    test_unwrap();
+    test_static_matches_generic();
+    return mm::test::result();
+}
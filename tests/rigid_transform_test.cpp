@@ -0,0 +1,135 @@
+// Absolute orientation: Horn's method in fit_rigid_transform and the
+// batched QCP solve of the head pose estimator, on exact and noisy data,
+// half-turns, reflections and degenerate point sets.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "motionmetrics/core/rigid_transform.hpp"
+#include "motionmetrics/gaze/head_pose.hpp"
+
+using mm::Mat3d;
+using mm::RigidTransform;
+using mm::Vec3d;
+
+namespace {
+
+double determinant(const Mat3d& r) { return dot(r.row(0), cross(r.row(1), r.row(2))); }
+
+double max_difference(const Mat3d& a, const Mat3d& b) {
+    double d = 0.0;
+    for (int i = 0; i < 9; ++i) d = std::max(d, std::abs(a.m[i] - b.m[i]));
+    return d;
+}
+
+/// Random rotations, with every fourth one a half-turn, where the key
+/// matrix has a repeated eigenvalue structure that trips naive solvers.
+Mat3d random_rotation(std::mt19937& rng, int index) {
+    std::normal_distribution<double> normal;
+    const Vec3d axis = mm::normalized({normal(rng), normal(rng), normal(rng)});
+    std::uniform_real_distribution<double> angle(-3.1, 3.1);
+    return mm::rotation_from_axis_angle(axis * (index % 4 == 0 ? M_PI : angle(rng)));
+}
+
+void test_horn(std::mt19937& rng) {
+    std::uniform_real_distribution<double> coord(-0.2, 0.2);
+    std::normal_distribution<double> noise(0.0, 1e-4);
+    for (int trial = 0; trial < 200; ++trial) {
+        const int n = 3 + trial % 6;
+        const Mat3d r = random_rotation(rng, trial);
+        const Vec3d t{coord(rng) * 10.0, coord(rng) * 10.0, coord(rng) * 10.0};
+        std::vector<Vec3d> from(n), to(n), noisy(n);
+        for (int i = 0; i < n; ++i) {
+            from[i] = {coord(rng), coord(rng), coord(rng)};
+            to[i] = r * from[i] + t;
+            noisy[i] = to[i] + Vec3d{noise(rng), noise(rng), noise(rng)};
+        }
+        RigidTransform fit;
+        MM_CHECK(mm::fit_rigid_transform(from.data(), to.data(), nullptr, n, fit));
+        MM_CHECK_NEAR(max_difference(fit.rotation, r), 0.0, 1e-9);
+        MM_CHECK_NEAR(norm(fit.translation - t), 0.0, 1e-9);
+
+        MM_CHECK(mm::fit_rigid_transform(from.data(), noisy.data(), nullptr, n, fit));
+        MM_CHECK_NEAR(determinant(fit.rotation), 1.0, 1e-9);
+        double rms = 0.0;
+        for (int i = 0; i < n; ++i) rms += dot(fit.apply(from[i]) - to[i], fit.apply(from[i]) - to[i]);
+        MM_CHECK(std::sqrt(rms / n) < 1e-3);
+    }
+
+    // A zero-weight outlier is ignored.
+    const Vec3d from[] = {{0, 0, 0}, {0.1, 0, 0}, {0, 0.1, 0}, {0, 0, 0.1}};
+    const Mat3d r = mm::rotation_from_axis_angle({0.3, -0.2, 0.5});
+    Vec3d to[4];
+    for (int i = 0; i < 4; ++i) to[i] = r * from[i];
+    to[3] = {5, 5, 5};
+    const double weights[] = {1.0, 2.0, 0.5, 0.0};
+    RigidTransform fit;
+    MM_CHECK(mm::fit_rigid_transform(from, to, weights, 4, fit));
+    MM_CHECK_NEAR(max_difference(fit.rotation, r), 0.0, 1e-9);
+
+    // A mirrored cloud is fitted by a rotation, never a reflection.
+    Vec3d mirrored[4];
+    for (int i = 0; i < 4; ++i) mirrored[i] = {-from[i].x, from[i].y, from[i].z};
+    MM_CHECK(mm::fit_rigid_transform(from, mirrored, nullptr, 4, fit));
+    MM_CHECK_NEAR(determinant(fit.rotation), 1.0, 1e-9);
+
+    // Degenerate sets.
+    const Vec3d line[] = {{0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {3, 0, 0}};
+    MM_CHECK(!mm::fit_rigid_transform(line, line, nullptr, 4, fit));
+    MM_CHECK(!mm::fit_rigid_transform(from, to, nullptr, 2, fit));
+    const double two_weighted[] = {1.0, 1.0, 0.0, 0.0};
+    MM_CHECK(!mm::fit_rigid_transform(from, to, two_weighted, 4, fit));
+}
+
+/// Every frame of a head track against the generating poses, at `level`.
+void test_head_pose(std::mt19937& rng, mm::SimdLevel level) {
+    mm::gaze::HeadModel model;
+    model.markers = {{"front", {0.0, 0.09, 0.02}, 1.0},
+                     {"left", {0.07, 0.0, 0.03}, 1.0},
+                     {"right", {-0.07, 0.0, 0.03}, 1.0},
+                     {"top", {0.0, -0.02, 0.1}, 0.5}};
+    const int frames = 203;  // not a multiple of any block width
+    mm::trajectory::TrajectorySet set({"front", "left", "right", "top"}, frames);
+    std::vector<Mat3d> rotations(frames);
+    std::vector<Vec3d> origins(frames);
+    std::uniform_real_distribution<double> coord(-1.0, 1.0);
+    for (int f = 0; f < frames; ++f) {
+        set.timestamps()[f] = mm::TimestampNs{f} * 10'000'000;
+        rotations[f] = f == 0 ? Mat3d::identity() : random_rotation(rng, f);
+        origins[f] = {coord(rng), coord(rng), 1.5 + coord(rng) * 0.1};
+        for (int m = 0; m < 4; ++m) set.set_position(m, f, rotations[f] * model.markers[m].local + origins[f]);
+    }
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    // Frame 7 keeps three markers; frame 8 has too few for a pose.
+    set.column(3, 0)[7] = set.column(3, 1)[7] = set.column(3, 2)[7] = nan;
+    for (int m = 0; m < 2; ++m) set.column(m, 0)[8] = set.column(m, 1)[8] = set.column(m, 2)[8] = nan;
+
+    const mm::gaze::HeadPoseEstimator estimator(model, {}, level);
+    const mm::gaze::HeadPoseTrack track = estimator.estimate(set);
+    MM_CHECK(track.frames == frames);
+    MM_CHECK(!track.valid(8));
+    for (int f = 0; f < frames; ++f) {
+        if (f == 8) continue;
+        MM_CHECK(track.valid(f));
+        const RigidTransform pose = track.pose(f);
+        // Float columns limit the agreement.
+        MM_CHECK_NEAR(max_difference(pose.rotation, rotations[f]), 0.0, 1e-4);
+        MM_CHECK_NEAR(norm(pose.translation - origins[f]), 0.0, 1e-5);
+        MM_CHECK(track.orientation[0][f] >= 0.0f);
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(11);
+    test_horn(rng);
+    test_head_pose(rng, mm::SimdLevel::scalar);
+    if (mm::detect_simd_level() != mm::SimdLevel::scalar) test_head_pose(rng, mm::detect_simd_level());
+    return mm::test::result();
+}
@@ -0,0 +1,52 @@
+// WorkStealingPool with several outside threads calling parallel_for at
+// once, with nested calls: every index runs exactly once, no two tasks of
+// one call share a slot at the same time, and exceptions reach the caller.
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "motionmetrics/core/work_stealing_pool.hpp"
+
+int main() {
+    mm::WorkStealingPool pool(3);
+    std::atomic<int> overlapping{0};
+    std::atomic<int> wrong_sum{0};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; ++t) {
+        callers.emplace_back([&] {
+            for (int rep = 0; rep < 200; ++rep) {
+                // Per-call scratch indexed by slot, as the trial solvers use it.
+                std::vector<long> sums(pool.size() + 1, 0);
+                std::vector<int> busy(pool.size() + 1, 0);
+                pool.parallel_for(0, 256, 4, [&](int i) {
+                    const int slot = pool.current_slot();
+                    if (busy[slot]++) overlapping.fetch_add(1);
+                    sums[slot] += i;
+                    if (i % 64 == 0) pool.parallel_for(0, 16, 1, [](int) {});
+                    --busy[slot];
+                });
+                long total = 0;
+                for (long s : sums) total += s;
+                if (total != 255L * 256 / 2) wrong_sum.fetch_add(1);
+            }
+        });
+    }
+    for (std::thread& t : callers) t.join();
+    MM_CHECK(overlapping.load() == 0);
+    MM_CHECK(wrong_sum.load() == 0);
+
+    std::atomic<int> ran{0};
+    MM_CHECK_THROWS(pool.parallel_for(0, 100, 1,
+                                      [&](int i) {
+                                          ran.fetch_add(1);
+                                          if (i == 37) throw std::runtime_error("task failed");
+                                      }),
+                    std::runtime_error);
+    // The remaining tasks still finish before the rethrow.
+    MM_CHECK(ran.load() == 100);
+
+    return mm::test::result();
+}